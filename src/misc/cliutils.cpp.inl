@@ -532,7 +532,11 @@ bool readFile(const QString &pFileNameOrUrl, QByteArray &pFileContents,
         return false;
     }
 
-    static SynchronousFileDownloader synchronousFileDownloader;
+    // Note: we use our own downloader, rather than a shared one, so that its
+    //       handling of SSL errors happens in our thread, which may not be the
+    //       main thread (e.g. when retrieving CellML imports in parallel)...
+
+    SynchronousFileDownloader synchronousFileDownloader;
 
     return synchronousFileDownloader.download(fileNameOrUrl, pFileContents, pErrorMessage);
 }
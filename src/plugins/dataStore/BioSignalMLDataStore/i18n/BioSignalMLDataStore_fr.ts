@@ -38,6 +38,14 @@
         <source>Description:</source>
         <translation>Description :</translation>
     </message>
+    <message>
+        <source>One signal per variable (faster to export)</source>
+        <translation>Un signal par variable (plus rapide à exporter)</translation>
+    </message>
+    <message>
+        <source>Layout:</source>
+        <translation>Disposition :</translation>
+    </message>
 </context>
 <context>
     <name>OpenCOR::BioSignalMLDataStore::BiosignalmlDataStoreExporterWorker</name>
@@ -52,5 +60,9 @@
         <source>The data could not be imported from BioSignalML (%1).</source>
         <translation>Les données n&apos;ont pas pu être importées à partir de BioSignalML (%1).</translation>
     </message>
+    <message>
+        <source>The data could not be fully imported from BioSignalML.</source>
+        <translation>Les données n&apos;ont pas pu être complètement importées à partir de BioSignalML.</translation>
+    </message>
 </context>
 </TS>
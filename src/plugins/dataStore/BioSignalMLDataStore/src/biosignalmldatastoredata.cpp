@@ -35,13 +35,15 @@ BiosignalmlDataStoreData::BiosignalmlDataStoreData(const QString &pFileName,
                                                    const QString &pAuthor,
                                                    const QString &pDescription,
                                                    const QString &pComment,
+                                                   bool pColumnMajor,
                                                    DataStore::DataStore *pDataStore,
                                                    const DataStore::DataStoreVariables &pVariables) :
     DataStore::DataStoreExportData(pFileName, pDataStore, pVariables),
     mName(pName),
     mAuthor(pAuthor),
     mDescription(pDescription),
-    mComment(pComment)
+    mComment(pComment),
+    mColumnMajor(pColumnMajor)
 {
 }
 
@@ -87,6 +89,52 @@ QString BiosignalmlDataStoreData::comment() const
 
 //==============================================================================
 
+bool BiosignalmlDataStoreData::columnMajor() const
+{
+    // Return whether each variable is to be exported as its own signal, rather
+    // than as part of a signal array
+
+    return mColumnMajor;
+}
+
+//==============================================================================
+
+BiosignalmlDataStoreImportData::BiosignalmlDataStoreImportData(const QString &pFileName,
+                                                               DataStore::DataStore *pImportDataStore,
+                                                               DataStore::DataStore *pResultsDataStore,
+                                                               const QStringList &pSignalUris,
+                                                               quint64 pFirstDataPoint,
+                                                               quint64 pNbOfDataPoints,
+                                                               const QList<quint64> &pRunSizes) :
+    DataStore::DataStoreImportData(pFileName, pImportDataStore,
+                                   pResultsDataStore, pSignalUris.count(),
+                                   pNbOfDataPoints, pRunSizes),
+    mSignalUris(pSignalUris),
+    mFirstDataPoint(pFirstDataPoint)
+{
+}
+
+//==============================================================================
+
+QStringList BiosignalmlDataStoreImportData::signalUris() const
+{
+    // Return the URI of the signals to import
+
+    return mSignalUris;
+}
+
+//==============================================================================
+
+quint64 BiosignalmlDataStoreImportData::firstDataPoint() const
+{
+    // Return the position, in our BioSignalML file, of the first data point to
+    // import
+
+    return mFirstDataPoint;
+}
+
+//==============================================================================
+
 } // namespace BioSignalMLDataStore
 } // namespace OpenCOR
 
@@ -42,6 +42,7 @@ public:
                                       const QString &pAuthor,
                                       const QString &pDescription,
                                       const QString &pComment,
+                                      bool pColumnMajor,
                                       DataStore::DataStore *pDataStore,
                                       const DataStore::DataStoreVariables &pVariables);
     ~BiosignalmlDataStoreData() override;
@@ -50,12 +51,35 @@ public:
     QString author() const;
     QString description() const;
     QString comment() const;
+    bool columnMajor() const;
 
 private:
     QString mName;
     QString mAuthor;
     QString mDescription;
     QString mComment;
+    bool mColumnMajor;
+};
+
+//==============================================================================
+
+class BiosignalmlDataStoreImportData : public DataStore::DataStoreImportData
+{
+public:
+    explicit BiosignalmlDataStoreImportData(const QString &pFileName,
+                                            DataStore::DataStore *pImportDataStore,
+                                            DataStore::DataStore *pResultsDataStore,
+                                            const QStringList &pSignalUris,
+                                            quint64 pFirstDataPoint,
+                                            quint64 pNbOfDataPoints,
+                                            const QList<quint64> &pRunSizes);
+
+    QStringList signalUris() const;
+    quint64 firstDataPoint() const;
+
+private:
+    QStringList mSignalUris;
+    quint64 mFirstDataPoint;
 };
 
 //==============================================================================
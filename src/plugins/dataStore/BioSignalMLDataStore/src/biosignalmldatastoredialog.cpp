@@ -27,6 +27,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QCheckBox>
 #include <QFormLayout>
 #include <QLabel>
 #include <QLineEdit>
@@ -82,6 +83,14 @@ BiosignalmlDataStoreDialog::BiosignalmlDataStoreDialog(DataStore::DataStore *pDa
 
     formLayout->addRow(boldLabel(tr("Description:")), mDescriptionValue);
 
+    // Add a label/field for our layout
+    // Note: exporting each variable as its own signal means that our data can
+    //       be written as is, i.e. without first having to be transposed...
+
+    mColumnMajorValue = new QCheckBox(tr("One signal per variable (faster to export)"), this);
+
+    formLayout->addRow(boldLabel(tr("Layout:")), mColumnMajorValue);
+
     // Make our short name value our focus proxy and add our widget to ourselves
 
     widget->setFocusProxy(mNameValue);
@@ -118,6 +127,15 @@ QString BiosignalmlDataStoreDialog::description() const
 
 //==============================================================================
 
+bool BiosignalmlDataStoreDialog::columnMajor() const
+{
+    // Return whether each variable should be exported as its own signal
+
+    return mColumnMajorValue->isChecked();
+}
+
+//==============================================================================
+
 QLabel * BiosignalmlDataStoreDialog::boldLabel(const QString &pText)
 {
     // Create and return a label after having made it bold
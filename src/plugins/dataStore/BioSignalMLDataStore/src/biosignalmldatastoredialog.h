@@ -29,6 +29,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+class QCheckBox;
 class QLabel;
 class QTextEdit;
 
@@ -51,11 +52,13 @@ public:
     QString name() const;
     QString author() const;
     QString description() const;
+    bool columnMajor() const;
 
 private:
     QLineEdit *mNameValue;
     QLineEdit *mAuthorValue;
     QTextEdit *mDescriptionValue;
+    QCheckBox *mColumnMajorValue;
 
     QLabel * boldLabel(const QString &pText);
 };
@@ -27,6 +27,8 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include <QFile>
+#include <QThread>
+#include <QThreadPool>
 #include <QUrl>
 
 //==============================================================================
@@ -42,6 +44,97 @@ namespace BioSignalMLDataStore {
 
 //==============================================================================
 
+BiosignalmlDataStoreExporterBlock::BiosignalmlDataStoreExporterBlock()
+{
+    // We are going to be run several times, so we must not be auto deleted
+
+    setAutoDelete(false);
+}
+
+//==============================================================================
+
+void BiosignalmlDataStoreExporterBlock::setRows(const QVector<double *> &pValues,
+                                                const QVector<double> &pConstantValues,
+                                                quint64 pFirstRow,
+                                                quint64 pNbOfRows)
+{
+    // Keep track of the values of our variables (or of their constant value,
+    // if they don't have any values) and of the rows that we are to transpose,
+    // and make sure that we have enough room for them
+    // Note: resizing our data doesn't free its memory, so we don't reallocate
+    //       it every time we are reused...
+
+    mValues = pValues;
+    mConstantValues = pConstantValues;
+
+    mFirstRow = pFirstRow;
+    mNbOfRows = pNbOfRows;
+
+    mData.resize(int(quint64(mValues.count())*mNbOfRows));
+}
+
+//==============================================================================
+
+quint64 BiosignalmlDataStoreExporterBlock::nbOfRows() const
+{
+    // Return our number of rows
+
+    return mNbOfRows;
+}
+
+//==============================================================================
+
+const double * BiosignalmlDataStoreExporterBlock::data() const
+{
+    // Return our (transposed) data
+
+    return mData.constData();
+}
+
+//==============================================================================
+
+void BiosignalmlDataStoreExporterBlock::run()
+{
+    // Transpose our rows, i.e. go from one array of values per variable to one
+    // array of rows
+    // Note: we do this a tile of rows at a time, so that the part of our data
+    //       that we are writing to remains in the cache while we go through
+    //       our variables...
+
+    static const quint64 TileSize = 64;
+
+    quint64 nbOfVariables = quint64(mValues.count());
+    double *data = mData.data();
+
+    for (quint64 i = 0; i < mNbOfRows; i += TileSize) {
+        quint64 iMax = qMin(i+TileSize, mNbOfRows);
+
+        for (quint64 j = 0; j < nbOfVariables; ++j) {
+            double *dataPointer = data+i*nbOfVariables+j;
+
+            if (mValues[int(j)] == nullptr) {
+                double constantValue = mConstantValues[int(j)];
+
+                for (quint64 k = i; k < iMax; ++k) {
+                    *dataPointer = constantValue;
+
+                    dataPointer += nbOfVariables;
+                }
+            } else {
+                const double *values = mValues[int(j)]+mFirstRow;
+
+                for (quint64 k = i; k < iMax; ++k) {
+                    *dataPointer = values[k];
+
+                    dataPointer += nbOfVariables;
+                }
+            }
+        }
+    }
+}
+
+//==============================================================================
+
 BiosignalmlDataStoreExporterWorker::BiosignalmlDataStoreExporterWorker(DataStore::DataStoreExportData *pDataStoreData) :
     DataStore::DataStoreExporterWorker(pDataStoreData)
 {
@@ -56,14 +149,31 @@ void BiosignalmlDataStoreExporterWorker::run()
     auto dataStoreData = static_cast<BiosignalmlDataStoreData *>(mDataStoreData);
     DataStore::DataStore *dataStore = dataStoreData->dataStore();
     int nbOfRuns = dataStore->runsCount();
-    int nbOfSteps = 0;
+    quint64 nbOfSteps = 0;
 
     for (int i = 0; i < nbOfRuns; ++i) {
         nbOfSteps += dataStore->size(i);
     }
 
-    double oneOverNbOfSteps = 1.0/nbOfSteps;
-    int stepNb = 0;
+    double oneOverNbOfSteps = 1.0/double(nbOfSteps);
+    quint64 stepNb = 0;
+
+    // Our blocks of rows, which get transposed in parallel (using one of our
+    // two thread pools) while the previous set of blocks is being written
+    // Note: they are created here rather than in our try block, so that we can
+    //       safely wait for them and delete them should something go wrong...
+
+    static const int NbOfSets = 2;
+
+    int nbOfThreads = QThread::idealThreadCount();
+    QThreadPool threadPools[NbOfSets];
+    QList<BiosignalmlDataStoreExporterBlock *> blocks[NbOfSets];
+
+    for (int i = 0; i < NbOfSets; ++i) {
+        for (int j = 0; j < nbOfThreads; ++j) {
+            blocks[i] << new BiosignalmlDataStoreExporterBlock();
+        }
+    }
 
     // Export our data store to a BioSignalML file
 
@@ -111,52 +221,133 @@ void BiosignalmlDataStoreExporterWorker::run()
 
             std::vector<std::string> uris;
             std::vector<rdf::URI> units;
+            QVector<double *> values;
+            QVector<double> constantValues;
 
             for (auto variable : qAsConst(variables)) {
                 uris.emplace_back(std::string().append(recordingUri).append("/signal/").append(variable->uri().toStdString()).append(runNb));
                 units.emplace_back(rdf::URI(baseUnits+variable->unit().toStdString()));
+
+                // Use the value of a constant variable rather than its values,
+                // so that they don't need to be created
+
+                if (variable->isConstant(i)) {
+                    values << nullptr;
+                    constantValues << variable->value(0, i);
+                } else {
+                    values << variable->values(i);
+                    constantValues << qQNaN();
+                }
             }
 
-            // Create and populate a signal array
+            quint64 runSize = dataStore->size(i);
 
-            enum {
-                BufferRows = 50000
-            };
+            if (dataStoreData->columnMajor()) {
+                // Create and populate one signal per variable, straight from
+                // our data store, which is column-major
 
-            bsml::HDF5::SignalArray::Ptr signalArray = recording->new_signalarray(uris, units, clock);
-            bsml::HDF5::SignalArray::size_type n = 0;
+                double oneOverNbOfVariables = 1.0/variables.count();
+                size_t n = 0;
 
-            for (auto variable : qAsConst(variables)) {
-                (*signalArray)[n]->set_label(variable->name().toStdString());
+                for (auto variable : qAsConst(variables)) {
+                    bsml::HDF5::Signal::Ptr signal = recording->new_signal(uris[n], units[n], clock);
 
-                ++n;
-            }
+                    signal->set_label(variable->name().toStdString());
+
+                    if (values[int(n)] != nullptr) {
+                        signal->extend(values[int(n)], size_t(runSize));
+                    } else {
+                        static const quint64 ChunkSize = 1 << 16;
 
-            auto data = new double[quint64(variables.count()*BufferRows)] {};
-            double *dataPointer = data;
-            size_t rowCount = 0;
+                        QVector<double> constantValue(int(qMin(runSize, ChunkSize)), constantValues[int(n)]);
+
+                        for (quint64 j = 0; j < runSize; j += ChunkSize) {
+                            signal->extend(constantValue.constData(), size_t(qMin(ChunkSize, runSize-j)));
+                        }
+                    }
+
+                    ++n;
+
+                    emit progress(mDataStoreData, (double(stepNb)+double(n)*oneOverNbOfVariables*double(runSize))*oneOverNbOfSteps);
+                }
+
+                stepNb += runSize;
+            } else {
+                // Create and populate a signal array
+
+                bsml::HDF5::SignalArray::Ptr signalArray = recording->new_signalarray(uris, units, clock);
+                bsml::HDF5::SignalArray::size_type n = 0;
 
-            for (quint64 j = 0, jMax = dataStore->size(i); j < jMax; ++j) {
                 for (auto variable : qAsConst(variables)) {
-                    *dataPointer++ = variable->value(j, i);
+                    (*signalArray)[n]->set_label(variable->name().toStdString());
+
+                    ++n;
                 }
 
-                ++rowCount;
+                // Populate our signal array, one block of rows at a time
+                // Note: a signal array is row-major while our data store is
+                //       column-major, so our rows need to be transposed. This
+                //       is done in parallel, one block of rows per thread, and
+                //       while the previous set of blocks is being written...
+
+                static const quint64 BlockSize = 1 << 20;
 
-                if (rowCount >= BufferRows) {
-                    signalArray->extend(data, size_t(variables.count())*BufferRows);
+                size_t nbOfVariables = size_t(variables.count());
+                quint64 nbOfBlockRows = qMax(BlockSize/qMax(quint64(nbOfVariables), quint64(1)), quint64(1));
+                quint64 nextRow = 0;
+                int set = 0;
 
-                    dataPointer = data;
+                for (auto block : qAsConst(blocks[set])) {
+                    quint64 nbOfRows = qMin(nbOfBlockRows, runSize-nextRow);
 
-                    rowCount = 0;
+                    block->setRows(values, constantValues, nextRow, nbOfRows);
+
+                    threadPools[set].start(block);
+
+                    nextRow += nbOfRows;
                 }
 
-                emit progress(mDataStoreData, ++stepNb*oneOverNbOfSteps);
-            }
+                forever {
+                    threadPools[set].waitForDone();
+
+                    // Start transposing our next set of blocks, if needed,
+                    // before writing our current one
+
+                    if (nextRow < runSize) {
+                        for (auto block : qAsConst(blocks[1-set])) {
+                            quint64 nbOfRows = qMin(nbOfBlockRows, runSize-nextRow);
+
+                            block->setRows(values, constantValues, nextRow, nbOfRows);
+
+                            threadPools[1-set].start(block);
+
+                            nextRow += nbOfRows;
+                        }
+                    }
+
+                    quint64 nbOfWrittenRows = 0;
+
+                    for (auto block : qAsConst(blocks[set])) {
+                        if (block->nbOfRows() != 0) {
+                            signalArray->extend(block->data(), nbOfVariables*size_t(block->nbOfRows()));
+
+                            nbOfWrittenRows += block->nbOfRows();
 
-            signalArray->extend(data, size_t(variables.count())*rowCount);
+                            block->setRows(values, constantValues, 0, 0);
+                        }
+                    }
 
-            delete[] data;
+                    if (nbOfWrittenRows == 0) {
+                        break;
+                    }
+
+                    stepNb += nbOfWrittenRows;
+
+                    emit progress(mDataStoreData, double(stepNb)*oneOverNbOfSteps);
+
+                    set = 1-set;
+                }
+            }
         }
     } catch (bsml::data::Exception &exception) {
         // Something went wrong, so retrieve the error message and delete our
@@ -167,6 +358,16 @@ void BiosignalmlDataStoreExporterWorker::run()
         QFile::remove(dataStoreData->fileName());
     }
 
+    // Delete our blocks, once we know that none of them is still running
+
+    for (int i = 0; i < NbOfSets; ++i) {
+        threadPools[i].waitForDone();
+
+        for (auto block : qAsConst(blocks[i])) {
+            delete block;
+        }
+    }
+
     // Close and delete our recording, if any
 
     if (recording != nullptr) {
@@ -29,11 +29,41 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QRunnable>
+
+//==============================================================================
+
 namespace OpenCOR {
 namespace BioSignalMLDataStore {
 
 //==============================================================================
 
+class BiosignalmlDataStoreExporterBlock : public QRunnable
+{
+public:
+    BiosignalmlDataStoreExporterBlock();
+
+    void setRows(const QVector<double *> &pValues,
+                 const QVector<double> &pConstantValues, quint64 pFirstRow,
+                 quint64 pNbOfRows);
+
+    quint64 nbOfRows() const;
+    const double * data() const;
+
+    void run() override;
+
+private:
+    QVector<double *> mValues;
+    QVector<double> mConstantValues;
+
+    quint64 mFirstRow = 0;
+    quint64 mNbOfRows = 0;
+
+    QVector<double> mData;
+};
+
+//==============================================================================
+
 class BiosignalmlDataStoreExporterWorker : public DataStore::DataStoreExporterWorker
 {
     Q_OBJECT
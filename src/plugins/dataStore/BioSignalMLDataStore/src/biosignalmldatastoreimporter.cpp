@@ -21,10 +21,15 @@ along with this program. If not, see <https://gnu.org/licenses>.
 // BioSignalML data store importer
 //==============================================================================
 
+#include "biosignalmldatastoredata.h"
 #include "biosignalmldatastoreimporter.h"
 
 //==============================================================================
 
+#include <algorithm>
+
+//==============================================================================
+
 #include "libbiosignalmlbegin.h"
     #include "biosignalml/data/hdf5.h"
 #include "libbiosignalmlend.h"
@@ -46,42 +51,84 @@ BiosignalmlDataStoreImporterWorker::BiosignalmlDataStoreImporterWorker(DataStore
 void BiosignalmlDataStoreImporterWorker::run()
 {
     // Import our BioSignalML file in our data store
+    // Note: we only read the signals and time window that were asked for, and
+    //       we do so a chunk of data points at a time, copying them straight
+    //       into the arrays of our data store. This means that both the time
+    //       and the memory needed depend on what gets imported rather than on
+    //       the size of our BioSignalML file...
 
+    static const quint64 ChunkSize = 1 << 16;
+
+    auto importData = static_cast<BiosignalmlDataStoreImportData *>(mImportData);
     QString errorMessage;
 
     try {
-        // Retrieve our clock and determine our number of data points
+        // Retrieve our clock and the signals that we want to import
 
-        auto recording = new bsml::HDF5::Recording(mImportData->fileName().toStdString(), true);
-        std::vector<double> clockTicks = recording->get_clock(recording->get_clock_uris().front())->read();
+        auto recording = new bsml::HDF5::Recording(importData->fileName().toStdString(), true);
+        bsml::HDF5::Clock::Ptr clock = recording->get_clock(recording->get_clock_uris().front());
+        std::vector<bsml::HDF5::Signal::Ptr> recordingSignals;
 
-        // Retrieve the values of our different variables
+        for (const auto &signalUri : importData->signalUris()) {
+            recordingSignals.push_back(recording->get_signal(signalUri.toStdString()));
+        }
 
-        int nbOfVariables = mImportData->nbOfVariables();
-        auto variables = new bsml::data::TimeSeries::Ptr[nbOfVariables] {};
-        bsml::data::TimeSeries::Ptr *variable = variables-1;
+        // Retrieve the arrays of our data store, which already have room for
+        // all of our data points
 
-        for (const auto &signalUri : recording->get_signal_uris()) {
-            *(++variable) = recording->get_signal(signalUri)->read();
+        DataStore::DataStore *importDataStore = importData->importDataStore();
+        double *voiValues = importDataStore->voi()->values();
+        QVector<double *> variablesValues;
+
+        for (auto variable : importData->importVariables()) {
+            variablesValues << variable->values();
         }
 
-        // Add a run to our data store and store the values of our different
-        // variables to it
+        // Read our clock ticks and signal values, one chunk at a time, and
+        // copy them to our data store
+
+        quint64 firstDataPoint = importData->firstDataPoint();
+        quint64 nbOfDataPoints = importData->nbOfDataPoints();
+
+        // Note: we make sure that we get as many clock ticks and signal values
+        //       as we asked for, since our data store would otherwise end up
+        //       with uninitialised data points...
+
+        for (quint64 i = 0; i < nbOfDataPoints; i += ChunkSize) {
+            auto position = size_t(firstDataPoint+i);
+            quint64 length = qMin(ChunkSize, nbOfDataPoints-i);
+            std::vector<double> clockTicks = clock->read(position, intmax_t(length));
 
-        DataStore::DataStore *importDataStore = mImportData->importDataStore();
-        double *importValues = mImportData->importValues();
+            if (quint64(clockTicks.size()) != length) {
+                errorMessage = tr("The data could not be fully imported from BioSignalML.");
 
-        for (quint64 i = 0, iMax = mImportData->nbOfDataPoints(); i < iMax; ++i) {
-            for (int j = 0; j < nbOfVariables; ++j) {
-                importValues[j] = variables[j]->data()[i];
+                break;
             }
 
-            importDataStore->addValues(clockTicks[i]);
+            std::copy_n(clockTicks.begin(), length, voiValues+i);
 
-            emit progress(mImportData, mImportData->progress());
+            for (size_t j = 0, jMax = recordingSignals.size(); j < jMax; ++j) {
+                bsml::data::TimeSeries::Ptr timeSeries = recordingSignals[j]->read(position, intmax_t(length));
+
+                if (quint64(timeSeries->data().size()) != length) {
+                    errorMessage = tr("The data could not be fully imported from BioSignalML.");
+
+                    break;
+                }
+
+                std::copy_n(&timeSeries->data()[0], length, variablesValues[int(j)]+i);
+            }
+
+            if (!errorMessage.isEmpty()) {
+                break;
+            }
+
+            emit progress(mImportData, mImportData->progress(length));
         }
 
-        delete[] variables;
+        if (errorMessage.isEmpty()) {
+            importDataStore->setSize(nbOfDataPoints);
+        }
 
         recording->close();
 
@@ -70,15 +70,37 @@ BioSignalMLDataStorePlugin::BioSignalMLDataStorePlugin()
     Core::globalInstance(BiosignalmlInterfaceDataSignature, &data);
 }
 
-//==============================================================================
-// Data store interface
 //==============================================================================
 
-QString BioSignalMLDataStorePlugin::dataStoreName() const
+static quint64 clockTickIndex(const bsml::HDF5::Clock::Ptr &pClock,
+                              quint64 pClockSize, double pTime, bool pAfter)
 {
-    // Return the name of the data store
+    // Return the index of the first clock tick that is not before the given
+    // time or, if pAfter is true, that is after it, or the size of our clock if
+    // there is no such clock tick
+    // Note: our clock may be too big to be read in one go, so we binary search
+    //       it, reading only one of its ticks at a time, and never beyond its
+    //       end...
+
+    quint64 low = 0;
+    quint64 high = pClockSize;
+
+    while (low < high) {
+        quint64 middle = low+(high-low)/2;
+        std::vector<double> clockTick = pClock->read(size_t(middle), 1);
+
+        if (clockTick.empty()) {
+            throw std::exception();
+        }
 
-    return "BioSignalML";
+        if (pAfter?clockTick.front() <= pTime:clockTick.front() < pTime) {
+            low = middle+1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return low;
 }
 
 //==============================================================================
@@ -86,19 +108,41 @@ QString BioSignalMLDataStorePlugin::dataStoreName() const
 DataStore::DataStoreImportData * BioSignalMLDataStorePlugin::getImportData(const QString &pFileName,
                                                                            DataStore::DataStore *pImportDataStore,
                                                                            DataStore::DataStore *pResultsDataStore,
-                                                                           const QList<quint64> &pRunSizes) const
+                                                                           const QList<quint64> &pRunSizes,
+                                                                           const QStringList &pSignalUris,
+                                                                           double pStartTime,
+                                                                           double pEndTime) const
 {
-    // Determine the number of variables in our BioSignalML file
+    // Determine which signals in our BioSignalML file are to be imported (all
+    // of them, if none is given) and which of its data points fall within the
+    // given time window
+    // Note: only a few ticks of our clock get read here, since we only need
+    //       to locate our time window, our signals being read by our importer,
+    //       and only over that time window...
 
     DataStore::DataStoreImportData *res = nullptr;
 
     try {
         auto recording = new bsml::HDF5::Recording(pFileName.toStdString(), true);
+        QStringList signalUris;
+
+        for (const auto &signalUri : recording->get_signal_uris()) {
+            QString uri = QString::fromStdString(signalUri);
+
+            if (pSignalUris.isEmpty() || pSignalUris.contains(uri)) {
+                signalUris << uri;
+            }
+        }
+
+        bsml::HDF5::Clock::Ptr clock = recording->get_clock(recording->get_clock_uris().front());
+        auto clockSize = quint64(clock->get_dataset()->size());
+        quint64 firstClockTick = clockTickIndex(clock, clockSize, pStartTime, false);
+        quint64 lastClockTick = qMax(firstClockTick, clockTickIndex(clock, clockSize, pEndTime, true));
 
-        res = new DataStore::DataStoreImportData(pFileName, pImportDataStore,
-                                                 pResultsDataStore,
-                                                 int(recording->get_signal_uris().size()),
-                                                 recording->get_clock(recording->get_clock_uris().front())->read().size(),
+        res = new BiosignalmlDataStoreImportData(pFileName, pImportDataStore,
+                                                 pResultsDataStore, signalUris,
+                                                 firstClockTick,
+                                                 lastClockTick-firstClockTick,
                                                  pRunSizes);
 
         recording->close();
@@ -112,6 +156,30 @@ DataStore::DataStoreImportData * BioSignalMLDataStorePlugin::getImportData(const
     return res;
 }
 
+//==============================================================================
+// Data store interface
+//==============================================================================
+
+QString BioSignalMLDataStorePlugin::dataStoreName() const
+{
+    // Return the name of the data store
+
+    return "BioSignalML";
+}
+
+//==============================================================================
+
+DataStore::DataStoreImportData * BioSignalMLDataStorePlugin::getImportData(const QString &pFileName,
+                                                                           DataStore::DataStore *pImportDataStore,
+                                                                           DataStore::DataStore *pResultsDataStore,
+                                                                           const QList<quint64> &pRunSizes) const
+{
+    // Import all of our signals over their whole time range
+
+    return getImportData(pFileName, pImportDataStore, pResultsDataStore,
+                         pRunSizes, {}, -qInf(), qInf());
+}
+
 //==============================================================================
 
 DataStore::DataStoreExportData * BioSignalMLDataStorePlugin::getExportData(const QString &pFileName,
@@ -141,6 +209,7 @@ DataStore::DataStoreExportData * BioSignalMLDataStorePlugin::getExportData(const
                                                 tr("Generated by %1 at %2 from %3.").arg(Core::version(),
                                                                                          QDateTime::currentDateTimeUtc().toString(Qt::ISODate),
                                                                                          pDataStore->uri()),
+                                                biosignalmlDataStoreDialog.columnMajor(),
                                                 pDataStore,
                                                 biosignalmlDataStoreDialog.selectedData());
         }
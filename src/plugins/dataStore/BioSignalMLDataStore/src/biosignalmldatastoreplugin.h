@@ -61,6 +61,14 @@ class BioSignalMLDataStorePlugin : public QObject, public DataStoreInterface,
 public:
     explicit BioSignalMLDataStorePlugin();
 
+    DataStore::DataStoreImportData * getImportData(const QString &pFileName,
+                                                   DataStore::DataStore *pImportDataStore,
+                                                   DataStore::DataStore *pResultsDataStore,
+                                                   const QList<quint64> &pRunSizes,
+                                                   const QStringList &pSignalUris,
+                                                   double pStartTime,
+                                                   double pEndTime) const;
+
 #include "datastoreinterface.inl"
 #include "filetypeinterface.inl"
 #include "i18ninterface.inl"
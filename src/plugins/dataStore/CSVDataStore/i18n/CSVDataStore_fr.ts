@@ -33,5 +33,13 @@
         <source>The file could not be opened.</source>
         <translation>Le fichier n&apos;a pas pu être ouvert.</translation>
     </message>
+    <message>
+        <source>The file could not be mapped into memory.</source>
+        <translation>Le fichier n&apos;a pas pu être projeté en mémoire.</translation>
+    </message>
+    <message>
+        <source>The file is not a valid CSV file.</source>
+        <translation>Le fichier n&apos;est pas un fichier CSV valide.</translation>
+    </message>
 </context>
 </TS>
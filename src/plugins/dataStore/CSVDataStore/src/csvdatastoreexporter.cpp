@@ -27,7 +27,8 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include <QDir>
-#include <QSet>
+#include <QThread>
+#include <QThreadPool>
 
 //==============================================================================
 
@@ -36,6 +37,123 @@ namespace CSVDataStore {
 
 //==============================================================================
 
+static void appendNumber(QByteArray &pData, double pNumber)
+{
+    // Append the given number to the given data
+    // Note: we use 15 significant digits, as we have always done, unless the
+    //       number cannot be converted back to the exact same double, in which
+    //       case we use 17 significant digits, which is always enough. This
+    //       means that numbers that used to be exported exactly are still
+    //       exported the same way (e.g. 1000000 rather than 1e+06, as would be
+    //       the case with QLocale::FloatingPointShortest), while the others
+    //       are now exported exactly...
+
+    QByteArray number = QByteArray::number(pNumber, 'g', 15);
+    double numberValue = number.toDouble();
+
+    if (memcmp(&numberValue, &pNumber, sizeof(double)) != 0) {
+        number = QByteArray::number(pNumber, 'g', 17);
+    }
+
+    pData += number;
+}
+
+//==============================================================================
+
+CsvDataStoreExporterBlock::CsvDataStoreExporterBlock(DataStore::DataStoreVariable *pVoi,
+                                                     const DataStore::DataStoreVariables &pVariables,
+                                                     int pNbOfRuns) :
+    mVoi(pVoi),
+    mVariables(pVariables),
+    mNbOfRuns(pNbOfRuns)
+{
+    // We are going to be run several times, so we must not be auto deleted
+
+    setAutoDelete(false);
+}
+
+//==============================================================================
+
+void CsvDataStoreExporterBlock::reset()
+{
+    // Reset our rows and data, but keep their capacity since we are going to
+    // be reused
+
+    mVoiValues.resize(0);
+    mRunsIndex.resize(0);
+
+    mData.resize(0);
+}
+
+//==============================================================================
+
+int CsvDataStoreExporterBlock::nbOfRows() const
+{
+    // Return our number of rows
+
+    return mVoiValues.count();
+}
+
+//==============================================================================
+
+void CsvDataStoreExporterBlock::addRow(double pVoiValue,
+                                       const QVector<quint64> &pRunsIndex)
+{
+    // Add a row, i.e. a VOI value and, for each run, the index of its values
+    // for that VOI value, if any
+
+    mVoiValues << pVoiValue;
+    mRunsIndex << pRunsIndex;
+}
+
+//==============================================================================
+
+QByteArray CsvDataStoreExporterBlock::data() const
+{
+    // Return our data
+
+    return mData;
+}
+
+//==============================================================================
+
+void CsvDataStoreExporterBlock::run()
+{
+    // Format our rows
+
+    static const char CrLf[] = "\r\n";
+
+    for (int i = 0, iMax = mVoiValues.count(); i < iMax; ++i) {
+        bool firstField = true;
+
+        if (mVoi != nullptr) {
+            appendNumber(mData, mVoiValues[i]);
+
+            firstField = false;
+        }
+
+        const quint64 *runsIndex = mRunsIndex.constData()+i*mNbOfRuns;
+
+        for (auto variable : qAsConst(mVariables)) {
+            for (int j = 0; j < mNbOfRuns; ++j) {
+                if (firstField) {
+                    firstField = false;
+                } else {
+                    mData += ',';
+                }
+
+                if (runsIndex[j] != NoIndex) {
+                    appendNumber(mData, variable->value(runsIndex[j], j));
+                }
+            }
+        }
+
+        mData += CrLf;
+    }
+}
+
+//==============================================================================
+
 CsvDataStoreExporterWorker::CsvDataStoreExporterWorker(DataStore::DataStoreExportData *pDataStoreData) :
     DataStore::DataStoreExporterWorker(pDataStoreData)
 {
@@ -52,7 +170,10 @@ void CsvDataStoreExporterWorker::run()
     //       amounts of data to export, this can crash OpenCOR if we really have
     //       a lot of data to write. So, instead, we do what Core::writeFile()
     //       does, but rather than writing one potentially humongous string, we
-    //       first write our header and then our data, one row at a time...
+    //       first write our header and then our data, one block of rows at a
+    //       time...
+
+    static const int BlockSize = 4096;
 
     QFile file(Core::temporaryFileName());
     QString errorMessage;
@@ -67,54 +188,21 @@ void CsvDataStoreExporterWorker::run()
 
         variables.removeOne(voi);
 
-        // Retrieve the different values for our VOI and sets of variables
-        // Note #1: this is needed when we have two runs with different
-        //          starting/ending points and/or point intervals...
-        // Note #2: after our for loop, our list may contain duplicates and may
-        //          not be sorted. When it comes to removing duplicates, we do
-        //          this by converting our list to a set and back. Indeed, this
-        //          is much faster than preventing ourselves from adding
-        //          duplicates in the first place...
-
-        QList<DataStore::DataStoreVariables> variablesRuns;
-
-        for (int i = 0, iMax = variables.count(); i < iMax; ++i) {
-            variablesRuns << DataStore::DataStoreVariables();
-        }
+        // Determine the size of our different runs, as well as the number of
+        // steps to export everything, i.e. one for our header and then one for
+        // each data point of each of our runs
 
         int nbOfRuns = dataStore->runsCount();
-        QList<quint64> runsIndex;
-        QDoubleList voiValues;
+        QVector<quint64> runsSize(nbOfRuns);
+        quint64 nbOfDataPoints = 0;
 
         for (int i = 0; i < nbOfRuns; ++i) {
-            // Original index for the current run
-
-            runsIndex << 0;
-
-            // VOI values
-
-            for (quint64 j = 0, jMax = dataStore->size(i); j < jMax; ++j) {
-                voiValues << dataStore->voi()->value(j, i);
-            }
-
-            // Variables
-
-            int j = -1;
+            runsSize[i] = dataStore->size(i);
 
-            for (auto variable : qAsConst(variables)) {
-                variablesRuns[++j] << variable;
-            }
+            nbOfDataPoints += runsSize[i];
         }
 
-        voiValues = voiValues.toSet().toList();
-
-        std::sort(voiValues.begin(), voiValues.end());
-
-        // Determine the number of steps to export everything, i.e. one for our
-        // header and then some for our number of VOI values
-
-        double oneOverNbOfSteps = 1.0/(1+voiValues.count());
-        int stepNb = 0;
+        double oneOverNbOfSteps = 1.0/double(1+nbOfDataPoints);
 
         // Output our header
 
@@ -148,63 +236,101 @@ void CsvDataStoreExporterWorker::run()
 
         bool res = file.write(header.toUtf8()) != -1;
 
-        // Output our different sets of data, one row at a time, if we were able
-        // to output our header
+        // Output our different sets of data, if we were able to output our
+        // header
+        // Note #1: we may have several runs with different starting/ending
+        //          points and/or point intervals, so we need to merge the
+        //          (sorted) VOI values of our runs. For this, we keep track of
+        //          where we are in each run and, for each row, we look for the
+        //          smallest VOI value among our runs. Looking for it is not
+        //          worse than formatting the row itself, so there is no need
+        //          for a heap...
+        // Note #2: the rows are formatted in parallel, one block of rows per
+        //          thread, and then written in order...
 
         if (res) {
-            emit progress(mDataStoreData, ++stepNb*oneOverNbOfSteps);
+            emit progress(mDataStoreData, oneOverNbOfSteps);
 
-            for (int i = 0, iMax = voiValues.count(); i < iMax; ++i) {
-                QString rowData;
-                double voiValue = voiValues[i];
+            DataStore::DataStoreVariable *dataStoreVoi = dataStore->voi();
+            QVector<quint64> runsIndex(nbOfRuns, 0);
+            QVector<quint64> rowRunsIndex(nbOfRuns);
+            quint64 nbOfExportedDataPoints = 0;
+            QThreadPool threadPool;
+            QList<CsvDataStoreExporterBlock *> blocks;
 
-                if (voi != nullptr) {
-                    rowData += QString::number(voiValue, 'g', 15);
-                }
+            for (int i = 0, iMax = QThread::idealThreadCount(); i < iMax; ++i) {
+                blocks << new CsvDataStoreExporterBlock(voi, variables, nbOfRuns);
+            }
 
-                bool firstRowData = true;
-                QBoolList updateRunsIndex;
+            forever {
+                // Fill our blocks with the next rows, if any, and format them
 
-                for (int j = 0; j < nbOfRuns; ++j) {
-                    updateRunsIndex << false;
-                }
+                int nbOfBlocks = 0;
+
+                for (auto block : qAsConst(blocks)) {
+                    block->reset();
 
-                for (const auto &variableRuns : qAsConst(variablesRuns)) {
-                    int j = 0;
+                    while (block->nbOfRows() < BlockSize) {
+                        int minimumRun = -1;
+                        double minimumVoiValue = 0.0;
 
-                    for (auto variableRun : variableRuns) {
-                        if (firstRowData && rowData.isEmpty()) {
-                            firstRowData = false;
-                        } else {
-                            rowData += ',';
+                        for (int i = 0; i < nbOfRuns; ++i) {
+                            if (runsIndex[i] < runsSize[i]) {
+                                double voiValue = dataStoreVoi->value(runsIndex[i], i);
+
+                                if ((minimumRun == -1) || (voiValue < minimumVoiValue)) {
+                                    minimumRun = i;
+                                    minimumVoiValue = voiValue;
+                                }
+                            }
+                        }
+
+                        if (minimumRun == -1) {
+                            break;
                         }
 
-                        if (   (runsIndex[j] < dataStore->size(j))
-                            && qFuzzyCompare(dataStore->voi()->value(runsIndex[j], j), voiValue)) {
-                            rowData += QString::number(variableRun->value(runsIndex[j], j), 'g', 15);
+                        for (int i = 0; i < nbOfRuns; ++i) {
+                            if (   (i == minimumRun)
+                                || (   (runsIndex[i] < runsSize[i])
+                                    && qFuzzyCompare(dataStoreVoi->value(runsIndex[i], i), minimumVoiValue))) {
+                                rowRunsIndex[i] = runsIndex[i]++;
 
-                            updateRunsIndex[j] = true;
+                                ++nbOfExportedDataPoints;
+                            } else {
+                                rowRunsIndex[i] = CsvDataStoreExporterBlock::NoIndex;
+                            }
                         }
 
-                        ++j;
+                        block->addRow(minimumVoiValue, rowRunsIndex);
                     }
-                }
 
-                for (int j = 0; j < nbOfRuns; ++j) {
-                    if (updateRunsIndex[j]) {
-                        ++runsIndex[j];
+                    if (block->nbOfRows() == 0) {
+                        break;
                     }
+
+                    threadPool.start(block);
+
+                    ++nbOfBlocks;
                 }
 
-                rowData += CrLf;
+                threadPool.waitForDone();
+
+                // Write our formatted blocks and let people know about our
+                // progress
 
-                res = file.write(rowData.toUtf8()) != -1;
+                for (int i = 0; res && (i < nbOfBlocks); ++i) {
+                    res = file.write(blocks[i]->data()) != -1;
+                }
 
-                if (!res) {
+                if (!res || (nbOfBlocks == 0)) {
                     break;
                 }
 
-                emit progress(mDataStoreData, ++stepNb*oneOverNbOfSteps);
+                emit progress(mDataStoreData, double(1+nbOfExportedDataPoints)*oneOverNbOfSteps);
+            }
+
+            for (auto block : qAsConst(blocks)) {
+                delete block;
             }
         }
 
@@ -29,11 +29,46 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QRunnable>
+
+//==============================================================================
+
 namespace OpenCOR {
 namespace CSVDataStore {
 
 //==============================================================================
 
+class CsvDataStoreExporterBlock : public QRunnable
+{
+public:
+    static const quint64 NoIndex = quint64(-1);
+
+    explicit CsvDataStoreExporterBlock(DataStore::DataStoreVariable *pVoi,
+                                       const DataStore::DataStoreVariables &pVariables,
+                                       int pNbOfRuns);
+
+    void reset();
+
+    int nbOfRows() const;
+    void addRow(double pVoiValue, const QVector<quint64> &pRunsIndex);
+
+    QByteArray data() const;
+
+    void run() override;
+
+private:
+    DataStore::DataStoreVariable *mVoi;
+    DataStore::DataStoreVariables mVariables;
+    int mNbOfRuns;
+
+    QVector<double> mVoiValues;
+    QVector<quint64> mRunsIndex;
+
+    QByteArray mData;
+};
+
+//==============================================================================
+
 class CsvDataStoreExporterWorker : public DataStore::DataStoreExporterWorker
 {
     Q_OBJECT
@@ -26,7 +26,12 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include <QFile>
-#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+
+//==============================================================================
+
+#include <array>
 
 //==============================================================================
 
@@ -35,6 +40,424 @@ namespace CSVDataStore {
 
 //==============================================================================
 
+static bool isSpace(char pChar)
+{
+    // Return whether the given character is a white space
+
+    return    (pChar == ' ') || (pChar == '\t') || (pChar == '\n')
+           || (pChar == '\v') || (pChar == '\f') || (pChar == '\r');
+}
+
+//==============================================================================
+
+static bool isDigit(char pChar)
+{
+    // Return whether the given character is a digit
+
+    return (pChar >= '0') && (pChar <= '9');
+}
+
+//==============================================================================
+
+static const char * lineEnd(const char *pBegin, const char *pEnd)
+{
+    // Return the end of the line that starts at the given position
+
+    auto res = static_cast<const char *>(memchr(pBegin, '\n', size_t(pEnd-pBegin)));
+
+    return (res != nullptr)?res:pEnd;
+}
+
+//==============================================================================
+
+static bool isEmptyLine(const char *pBegin, const char *pEnd)
+{
+    // Return whether the given line is empty, i.e. only contains white spaces
+
+    for (const char *position = pBegin; position < pEnd; ++position) {
+        if (!isSpace(*position)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+
+double fieldValue(const char *pBegin, const char *pEnd)
+{
+    // Return the value of the given field
+    // Note: we handle the most common case ourselves, i.e. a number with no
+    //       more than 19 significant digits and which value can be computed
+    //       exactly using a single multiplication or division by a power of
+    //       ten (i.e. Clinger's fast path). Anything else (e.g. a NaN, an
+    //       infinity or a number with many significant digits) is handled by
+    //       Qt, which is slower but also locale independent...
+
+    static const std::array<double, 23> PowersOfTen = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+        1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    static const quint64 MaximumExactMantissa = quint64(1) << 53;
+
+    while ((pBegin < pEnd) && isSpace(*pBegin)) {
+        ++pBegin;
+    }
+
+    while ((pEnd > pBegin) && isSpace(*(pEnd-1))) {
+        --pEnd;
+    }
+
+    const char *position = pBegin;
+    bool negative = false;
+
+    if ((position < pEnd) && ((*position == '-') || (*position == '+'))) {
+        negative = *position == '-';
+
+        ++position;
+    }
+
+    quint64 mantissa = 0;
+    int nbOfSignificantDigits = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+
+    for (; (position < pEnd) && isDigit(*position); ++position) {
+        mantissa = 10*mantissa+quint64(*position-'0');
+        hasDigits = true;
+
+        if ((mantissa != 0) && (++nbOfSignificantDigits > 19)) {
+            break;
+        }
+    }
+
+    if ((position < pEnd) && (*position == '.')) {
+        for (++position; (position < pEnd) && isDigit(*position); ++position) {
+            mantissa = 10*mantissa+quint64(*position-'0');
+            hasDigits = true;
+
+            --exponent;
+
+            if ((mantissa != 0) && (++nbOfSignificantDigits > 19)) {
+                break;
+            }
+        }
+    }
+
+    if (hasDigits && (position < pEnd) && ((*position == 'e') || (*position == 'E'))) {
+        bool negativeExponent = false;
+        int exponentValue = 0;
+
+        if ((++position < pEnd) && ((*position == '-') || (*position == '+'))) {
+            negativeExponent = *position == '-';
+
+            ++position;
+        }
+
+        if ((position == pEnd) || !isDigit(*position)) {
+            hasDigits = false;
+        }
+
+        for (; (position < pEnd) && isDigit(*position) && (exponentValue < 1000); ++position) {
+            exponentValue = 10*exponentValue+(*position-'0');
+        }
+
+        exponent += negativeExponent?-exponentValue:exponentValue;
+    }
+
+    if (   hasDigits && (position == pEnd)
+        && (mantissa <= MaximumExactMantissa)
+        && (exponent >= -22) && (exponent <= 22)) {
+        double res = (exponent < 0)?
+                         double(mantissa)/PowersOfTen[size_t(-exponent)]:
+                         double(mantissa)*PowersOfTen[size_t(exponent)];
+
+        return negative?-res:res;
+    }
+
+    return QByteArray::fromRawData(pBegin, int(pEnd-pBegin)).toDouble();
+}
+
+//==============================================================================
+
+CsvDataStoreImportData::CsvDataStoreImportData(const QString &pFileName,
+                                               DataStore::DataStore *pImportDataStore,
+                                               DataStore::DataStore *pResultsDataStore,
+                                               int pNbOfVariables,
+                                               qint64 pFileSize,
+                                               const QVector<qint64> &pChunkBoundaries,
+                                               const QVector<quint64> &pChunksNbOfRows,
+                                               quint64 pNbOfDataPoints,
+                                               const QList<quint64> &pRunSizes) :
+    DataStore::DataStoreImportData(pFileName, pImportDataStore,
+                                   pResultsDataStore, pNbOfVariables,
+                                   pNbOfDataPoints, pRunSizes),
+    mFileSize(pFileSize),
+    mChunkBoundaries(pChunkBoundaries),
+    mChunksNbOfRows(pChunksNbOfRows)
+{
+}
+
+//==============================================================================
+
+qint64 CsvDataStoreImportData::fileSize() const
+{
+    // Return our file size
+
+    return mFileSize;
+}
+
+//==============================================================================
+
+QVector<qint64> CsvDataStoreImportData::chunkBoundaries() const
+{
+    // Return the boundaries of our chunks, i.e. the offset of the beginning of
+    // each of our chunks followed by the offset of the end of our last chunk
+
+    return mChunkBoundaries;
+}
+
+//==============================================================================
+
+QVector<quint64> CsvDataStoreImportData::chunksNbOfRows() const
+{
+    // Return the number of rows in each of our chunks
+
+    return mChunksNbOfRows;
+}
+
+//==============================================================================
+
+DataStore::DataStoreImportData * importData(const QString &pFileName,
+                                            DataStore::DataStore *pImportDataStore,
+                                            DataStore::DataStore *pResultsDataStore,
+                                            const QList<quint64> &pRunSizes)
+{
+    // Map our CSV file into memory, determine our number of variables from our
+    // header (i.e. our first non-empty line), split the rest of our CSV file
+    // into row-aligned chunks and count the rows in each of them, in parallel
+    // Note #1: our number of variables is the number of commas in our header
+    //          since its first field is our VOI...
+    // Note #2: our chunks and their number of rows are kept with our import
+    //          data, so that our worker knows straightaway where the values of
+    //          each chunk should go (see CsvDataStoreImporterWorker::run())...
+
+    static const qint64 MinimumChunkSize = 1 << 20;
+
+    QFile file(pFileName);
+
+    if (!file.open(QIODevice::ReadOnly)) {
+        return nullptr;
+    }
+
+    qint64 fileSize = file.size();
+    auto data = reinterpret_cast<const char *>((fileSize != 0)?file.map(0, fileSize):nullptr);
+
+    if (data == nullptr) {
+        return nullptr;
+    }
+
+    const char *dataEnd = data+fileSize;
+    const char *header = data;
+    const char *headerEnd = dataEnd;
+
+    for (const char *end; header < dataEnd; header = end+1) {
+        end = lineEnd(header, dataEnd);
+
+        if (!isEmptyLine(header, end)) {
+            headerEnd = end;
+
+            break;
+        }
+    }
+
+    int nbOfVariables = (header < dataEnd)?
+                            QByteArray::fromRawData(header, int(headerEnd-header)).count(','):
+                            0;
+    const char *begin = qMin(headerEnd+1, dataEnd);
+    int nbOfThreads = QThread::idealThreadCount();
+    qint64 chunkSize = qMax((dataEnd-begin)/(4*nbOfThreads), MinimumChunkSize);
+    QAtomicInteger<quint64> nbOfParsedRows(0);
+    QList<CsvDataStoreImporterChunk *> chunks;
+    QVector<qint64> chunkBoundaries = { qint64(begin-data) };
+    QThreadPool threadPool;
+
+    threadPool.setMaxThreadCount(nbOfThreads);
+
+    for (const char *chunkBegin = begin, *chunkEnd; chunkBegin < dataEnd; chunkBegin = chunkEnd) {
+        chunkEnd = (dataEnd-chunkBegin > chunkSize)?
+                       lineEnd(chunkBegin+chunkSize, dataEnd):
+                       dataEnd;
+
+        if (chunkEnd < dataEnd) {
+            ++chunkEnd;
+        }
+
+        chunks << new CsvDataStoreImporterChunk(chunkBegin, chunkEnd, nullptr,
+                                                {}, nbOfParsedRows);
+        chunkBoundaries << qint64(chunkEnd-data);
+
+        threadPool.start(chunks.last());
+    }
+
+    threadPool.waitForDone();
+
+    QVector<quint64> chunksNbOfRows;
+    quint64 nbOfRows = 0;
+
+    for (auto chunk : qAsConst(chunks)) {
+        chunksNbOfRows << chunk->nbOfRows();
+
+        nbOfRows += chunk->nbOfRows();
+
+        delete chunk;
+    }
+
+    file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data)));
+
+    return new CsvDataStoreImportData(pFileName, pImportDataStore,
+                                      pResultsDataStore, nbOfVariables,
+                                      fileSize, chunkBoundaries, chunksNbOfRows,
+                                      nbOfRows, pRunSizes);
+}
+
+//==============================================================================
+
+CsvDataStoreImporterChunk::CsvDataStoreImporterChunk(const char *pBegin,
+                                                     const char *pEnd,
+                                                     double *pVoiValues,
+                                                     const QVector<double *> &pVariablesValues,
+                                                     QAtomicInteger<quint64> &pNbOfParsedRows) :
+    mBegin(pBegin),
+    mEnd(pEnd),
+    mVoiValues(pVoiValues),
+    mVariablesValues(pVariablesValues),
+    mNbOfParsedRows(pNbOfParsedRows)
+{
+    // We are going to be run several times, so we must not be auto deleted
+
+    setAutoDelete(false);
+}
+
+//==============================================================================
+
+void CsvDataStoreImporterChunk::setTask(Task pTask)
+{
+    // Set our task
+
+    mTask = pTask;
+}
+
+//==============================================================================
+
+quint64 CsvDataStoreImporterChunk::nbOfRows() const
+{
+    // Return our number of rows
+
+    return mNbOfRows;
+}
+
+//==============================================================================
+
+void CsvDataStoreImporterChunk::setFirstRow(quint64 pFirstRow)
+{
+    // Set our first row, i.e. the index at which our values are to be stored
+
+    mFirstRow = pFirstRow;
+}
+
+//==============================================================================
+
+void CsvDataStoreImporterChunk::run()
+{
+    // Carry out our task
+
+    if (mTask == Task::CountRows) {
+        countRows();
+    } else {
+        parseRows();
+    }
+}
+
+//==============================================================================
+
+void CsvDataStoreImporterChunk::countRows()
+{
+    // Count our number of rows, i.e. our number of non-empty lines
+
+    mNbOfRows = 0;
+
+    for (const char *line = mBegin, *end; line < mEnd; line = end+1) {
+        end = lineEnd(line, mEnd);
+
+        if (!isEmptyLine(line, end)) {
+            ++mNbOfRows;
+        }
+    }
+}
+
+//==============================================================================
+
+void CsvDataStoreImporterChunk::parseRows()
+{
+    // Parse our rows and store their values straight into our arrays
+    // Note: a missing value is considered to be a NaN and we let people know
+    //       about our progress every so often...
+
+    static const quint64 ProgressStep = 65536;
+
+    int nbOfVariables = mVariablesValues.count();
+    quint64 row = mFirstRow;
+    quint64 nbOfParsedRows = 0;
+
+    for (const char *line = mBegin, *end; line < mEnd; line = end+1) {
+        end = lineEnd(line, mEnd);
+
+        if (isEmptyLine(line, end)) {
+            continue;
+        }
+
+        const char *field = line;
+
+        for (int i = -1; i < nbOfVariables; ++i) {
+            double value = qQNaN();
+
+            if (field != nullptr) {
+                auto fieldEnd = static_cast<const char *>(memchr(field, ',', size_t(end-field)));
+
+                if (fieldEnd != nullptr) {
+                    value = fieldValue(field, fieldEnd);
+
+                    field = fieldEnd+1;
+                } else {
+                    value = fieldValue(field, end);
+
+                    field = nullptr;
+                }
+            }
+
+            if (i == -1) {
+                mVoiValues[row] = value;
+            } else {
+                mVariablesValues[i][row] = value;
+            }
+        }
+
+        ++row;
+
+        if (++nbOfParsedRows == ProgressStep) {
+            mNbOfParsedRows.fetchAndAddRelaxed(nbOfParsedRows);
+
+            nbOfParsedRows = 0;
+        }
+    }
+
+    mNbOfParsedRows.fetchAndAddRelaxed(nbOfParsedRows);
+}
+
+//==============================================================================
+
 CsvDataStoreImporterWorker::CsvDataStoreImporterWorker(DataStore::DataStoreImportData *pImportData) :
     DataStore::DataStoreImporterWorker(pImportData)
 {
@@ -45,30 +468,93 @@ CsvDataStoreImporterWorker::CsvDataStoreImporterWorker(DataStore::DataStoreImpor
 void CsvDataStoreImporterWorker::run()
 {
     // Import our CSV file in our data store
-    // Note: we rely on our CSV file to be well-formed...
+    // Note: we map our CSV file into memory and parse the row-aligned chunks
+    //       that were determined when our import data was created (see
+    //       importData()), in parallel. We therefore know where the values of
+    //       each chunk should go...
+
+    static const int ProgressInterval = 100;
 
-    QFile file(mImportData->fileName());
+    auto importData = static_cast<CsvDataStoreImportData *>(mImportData);
+    QFile file(importData->fileName());
     QString errorMessage;
 
-    if (file.open(QIODevice::ReadOnly|QIODevice::Text)) {
-        QTextStream in(&file);
-        QString line = in.readLine(); // Header, which we ignore
-        DataStore::DataStore *importDataStore = mImportData->importDataStore();
-        double *importValues = mImportData->importValues();
-        int nbOfVariables = mImportData->nbOfVariables();
+    if (file.open(QIODevice::ReadOnly)) {
+        qint64 fileSize = file.size();
+        auto data = reinterpret_cast<const char *>((fileSize != 0)?file.map(0, fileSize):nullptr);
 
-        for (quint64 i = 0, iMax = mImportData->nbOfDataPoints(); i < iMax; ++i) {
-            line = in.readLine().trimmed();
+        if (data != nullptr) {
+            // Make sure that our CSV file hasn't changed since our import data
+            // was created and create our chunks
 
-            QStringList fields = line.split(",");
+            if (fileSize == importData->fileSize()) {
+                DataStore::DataStore *importDataStore = importData->importDataStore();
+                double *voiValues = importDataStore->voi()->values();
+                const DataStore::DataStoreVariables importVariables = importData->importVariables();
+                QVector<double *> variablesValues;
 
-            for (int j = 0; j < nbOfVariables; ++j) {
-                importValues[j] = fields[j+1].toDouble();
-            }
+                for (auto variable : importVariables) {
+                    variablesValues << variable->values();
+                }
+
+                const QVector<qint64> chunkBoundaries = importData->chunkBoundaries();
+                const QVector<quint64> chunksNbOfRows = importData->chunksNbOfRows();
+                QAtomicInteger<quint64> nbOfParsedRows(0);
+                QList<CsvDataStoreImporterChunk *> chunks;
+                quint64 nbOfRows = 0;
+
+                for (int i = 0, iMax = chunksNbOfRows.count(); i < iMax; ++i) {
+                    auto chunk = new CsvDataStoreImporterChunk(data+chunkBoundaries[i],
+                                                               data+chunkBoundaries[i+1],
+                                                               voiValues, variablesValues,
+                                                               nbOfParsedRows);
+
+                    chunk->setTask(CsvDataStoreImporterChunk::Task::ParseRows);
+                    chunk->setFirstRow(nbOfRows);
 
-            importDataStore->addValues(fields[0].toDouble());
+                    chunks << chunk;
+
+                    nbOfRows += chunksNbOfRows[i];
+                }
+
+                // Parse our chunks and let people know about our progress every
+                // so often
+
+                QThreadPool threadPool;
+
+                threadPool.setMaxThreadCount(QThread::idealThreadCount());
+
+                for (auto chunk : qAsConst(chunks)) {
+                    threadPool.start(chunk);
+                }
+
+                quint64 nbOfReportedRows = 0;
+                bool done;
+
+                do {
+                    done = threadPool.waitForDone(ProgressInterval);
+
+                    quint64 nbOfNewlyParsedRows = nbOfParsedRows.loadAcquire();
+
+                    if (nbOfNewlyParsedRows != nbOfReportedRows) {
+                        emit progress(mImportData, mImportData->progress(nbOfNewlyParsedRows-nbOfReportedRows));
+
+                        nbOfReportedRows = nbOfNewlyParsedRows;
+                    }
+                } while (!done);
+
+                importDataStore->setSize(nbOfRows);
+
+                for (auto chunk : qAsConst(chunks)) {
+                    delete chunk;
+                }
+            } else {
+                errorMessage = tr("The file is not a valid CSV file.");
+            }
 
-            emit progress(mImportData, mImportData->progress());
+            file.unmap(reinterpret_cast<uchar *>(const_cast<char *>(data)));
+        } else {
+            errorMessage = tr("The file could not be mapped into memory.");
         }
 
         file.close();
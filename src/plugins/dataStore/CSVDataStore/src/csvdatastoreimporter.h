@@ -29,11 +29,93 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QAtomicInteger>
+#include <QRunnable>
+
+//==============================================================================
+
 namespace OpenCOR {
 namespace CSVDataStore {
 
 //==============================================================================
 
+double fieldValue(const char *pBegin, const char *pEnd);
+
+//==============================================================================
+
+class CsvDataStoreImportData : public DataStore::DataStoreImportData
+{
+public:
+    explicit CsvDataStoreImportData(const QString &pFileName,
+                                    DataStore::DataStore *pImportDataStore,
+                                    DataStore::DataStore *pResultsDataStore,
+                                    int pNbOfVariables, qint64 pFileSize,
+                                    const QVector<qint64> &pChunkBoundaries,
+                                    const QVector<quint64> &pChunksNbOfRows,
+                                    quint64 pNbOfDataPoints,
+                                    const QList<quint64> &pRunSizes);
+
+    qint64 fileSize() const;
+
+    QVector<qint64> chunkBoundaries() const;
+    QVector<quint64> chunksNbOfRows() const;
+
+private:
+    qint64 mFileSize;
+
+    QVector<qint64> mChunkBoundaries;
+    QVector<quint64> mChunksNbOfRows;
+};
+
+//==============================================================================
+
+DataStore::DataStoreImportData * importData(const QString &pFileName,
+                                            DataStore::DataStore *pImportDataStore,
+                                            DataStore::DataStore *pResultsDataStore,
+                                            const QList<quint64> &pRunSizes);
+
+//==============================================================================
+
+class CsvDataStoreImporterChunk : public QRunnable
+{
+public:
+    enum class Task {
+        CountRows,
+        ParseRows
+    };
+
+    explicit CsvDataStoreImporterChunk(const char *pBegin, const char *pEnd,
+                                       double *pVoiValues,
+                                       const QVector<double *> &pVariablesValues,
+                                       QAtomicInteger<quint64> &pNbOfParsedRows);
+
+    void setTask(Task pTask);
+
+    quint64 nbOfRows() const;
+    void setFirstRow(quint64 pFirstRow);
+
+    void run() override;
+
+private:
+    const char *mBegin;
+    const char *mEnd;
+
+    double *mVoiValues;
+    QVector<double *> mVariablesValues;
+
+    QAtomicInteger<quint64> &mNbOfParsedRows;
+
+    Task mTask = Task::CountRows;
+
+    quint64 mNbOfRows = 0;
+    quint64 mFirstRow = 0;
+
+    void countRows();
+    void parseRows();
+};
+
+//==============================================================================
+
 class CsvDataStoreImporterWorker : public DataStore::DataStoreImporterWorker
 {
     Q_OBJECT
@@ -83,43 +83,12 @@ DataStore::DataStoreImportData * CSVDataStorePlugin::getImportData(const QString
                                                                    DataStore::DataStore *pResultsDataStore,
                                                                    const QList<quint64> &pRunSizes) const
 {
-    // Determine the number of variables in our CSV file
+    // Return some information about the data we want to import, i.e. our
+    // number of variables and of data points, as well as how our CSV file can
+    // be imported in parallel
 
-    DataStore::DataStoreImportData *res = nullptr;
-    QFile file(pFileName);
-
-    if (file.open(QIODevice::ReadOnly|QIODevice::Text)) {
-        // Determine our number of variables and data points
-        // Note #1: we subtract 1 for our number of variables because otherwise
-        //          it would include the VOI, which we don't want...
-        // Note #2: nbOfDataPoints starts at -1 because we are going to count
-        //          the header of our CSV file...
-
-        QTextStream in(&file);
-        QString line;
-        auto nbOfDataPoints = quint64(-1);
-
-        while (!in.atEnd()) {
-            line = in.readLine().trimmed();
-
-            if (!line.isEmpty()) {
-                ++nbOfDataPoints;
-            }
-        }
-
-        in.seek(0);
-
-        res = new DataStore::DataStoreImportData(pFileName, pImportDataStore,
-                                                 pResultsDataStore,
-                                                 in.readLine().trimmed().split(",").count()-1,
-                                                 nbOfDataPoints, pRunSizes);
-
-        file.close();
-    }
-
-    // Return some information about the data we want to import
-
-    return res;
+    return importData(pFileName, pImportDataStore, pResultsDataStore,
+                      pRunSizes);
 }
 
 //==============================================================================
@@ -0,0 +1,213 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// CSV data store tests
+//==============================================================================
+
+#include "csvdatastoreexporter.h"
+#include "csvdatastoreimporter.h"
+#include "tests.h"
+
+//==============================================================================
+
+#include <QtTest/QtTest>
+
+//==============================================================================
+
+#include <QTemporaryDir>
+
+//==============================================================================
+
+static double fieldValue(const char *pField)
+{
+    // Return the value of the given field
+
+    return OpenCOR::CSVDataStore::fieldValue(pField, pField+strlen(pField));
+}
+
+//==============================================================================
+
+void Tests::fieldValueTests()
+{
+    // Fields that can be converted using Clinger's fast path, i.e. which
+    // mantissa has no more than 53 bits and which exponent is between -22 and
+    // 22
+
+    QCOMPARE(fieldValue("0"), 0.0);
+    QCOMPARE(fieldValue("123"), 123.0);
+    QCOMPARE(fieldValue("-123"), -123.0);
+    QCOMPARE(fieldValue("+123"), 123.0);
+    QCOMPARE(fieldValue("0.1"), 0.1);
+    QCOMPARE(fieldValue("-0.001"), -0.001);
+    QCOMPARE(fieldValue(".5"), 0.5);
+    QCOMPARE(fieldValue("5."), 5.0);
+    QCOMPARE(fieldValue("1e6"), 1e6);
+    QCOMPARE(fieldValue("1E+06"), 1e6);
+    QCOMPARE(fieldValue("2.5e-3"), 2.5e-3);
+    QCOMPARE(fieldValue("1e22"), 1e22);
+    QCOMPARE(fieldValue("1e-22"), 1e-22);
+    QCOMPARE(fieldValue("9007199254740992"), 9007199254740992.0);
+    QCOMPARE(fieldValue("  3.14  "), 3.14);
+    QCOMPARE(fieldValue("\t42\r"), 42.0);
+
+    // Fields that cannot be converted using Clinger's fast path and are
+    // therefore converted by Qt, i.e. which mantissa has more than 53 bits,
+    // which exponent is beyond -22 or 22, or which has more than 19
+    // significant digits
+
+    QCOMPARE(fieldValue("9007199254740993"), 9007199254740993.0);
+    QCOMPARE(fieldValue("1e23"), 1e23);
+    QCOMPARE(fieldValue("1e-23"), 1e-23);
+    QCOMPARE(fieldValue("1.7976931348623157e308"), 1.7976931348623157e308);
+    QCOMPARE(fieldValue("0.30000000000000000000001"), 0.30000000000000000000001);
+    QCOMPARE(fieldValue("123456789012345678901234567890"), 123456789012345678901234567890.0);
+    QCOMPARE(fieldValue("0.000000000000000000000000123"), 0.000000000000000000000000123);
+
+    // Fields that are not numbers, or not only numbers, and which are therefore
+    // handled by Qt
+
+    QVERIFY(qIsNaN(fieldValue("nan")));
+    QVERIFY(qIsInf(fieldValue("inf")));
+    QVERIFY(qIsInf(fieldValue("-inf")));
+    QCOMPARE(fieldValue(""), 0.0);
+    QCOMPARE(fieldValue("   "), 0.0);
+    QCOMPARE(fieldValue("abc"), 0.0);
+    QCOMPARE(fieldValue("1e"), 0.0);
+    QCOMPARE(fieldValue("-"), 0.0);
+    QCOMPARE(fieldValue("1.2.3"), 0.0);
+}
+
+//==============================================================================
+
+void Tests::exportTests()
+{
+    // Create a data store with two variables and three runs, each of which has
+    // a different point interval, so that their VOI values need to be merged
+    // and so that there are many more rows than fit in one batch of blocks
+
+    static const int NbOfRuns = 3;
+    static const int NbOfVariables = 2;
+    static const double PointIntervals[NbOfRuns] = { 1.0, 2.0, 0.5 };
+    static const double EndingPoints[NbOfRuns] = { 20000.0, 100000.0, 5000.0 };
+
+    OpenCOR::DataStore::DataStore dataStore(nullptr);
+    double values[NbOfVariables];
+    OpenCOR::DataStore::DataStoreVariables variables = dataStore.addVariables(values, NbOfVariables);
+
+    for (int i = 0; i < NbOfRuns; ++i) {
+        quint64 nbOfPoints = quint64(EndingPoints[i]/PointIntervals[i])+1;
+
+        QVERIFY(dataStore.addRun(nbOfPoints));
+
+        for (quint64 j = 0; j < nbOfPoints; ++j) {
+            double voiValue = double(j)*PointIntervals[i];
+
+            values[0] = voiValue/3.0+i;
+            values[1] = 1e6*(i+1)+0.1*voiValue;
+
+            dataStore.addValues(voiValue);
+        }
+    }
+
+    // Export our data store
+
+    QTemporaryDir temporaryDir;
+    QString fileName = temporaryDir.filePath("export.csv");
+    OpenCOR::DataStore::DataStoreExportData exportData(fileName, &dataStore,
+                                                       dataStore.voiAndVariables());
+    OpenCOR::CSVDataStore::CsvDataStoreExporterWorker worker(&exportData);
+    QString errorMessage = "not done";
+
+    QObject::connect(&worker, &OpenCOR::DataStore::DataStoreExporterWorker::done,
+                     [&errorMessage](OpenCOR::DataStore::DataStoreExportData *pDataStoreData,
+                                     const QString &pErrorMessage) {
+        Q_UNUSED(pDataStoreData)
+
+        errorMessage = pErrorMessage;
+    });
+
+    worker.run();
+
+    QVERIFY(errorMessage.isEmpty());
+
+    // Read back our export and check that its header has the expected number
+    // of fields, that numbers are exported in the same format as before, and
+    // that all the data points of all our runs can be found, in order and with
+    // their exact value
+
+    QFile file(fileName);
+
+    QVERIFY(file.open(QIODevice::ReadOnly));
+
+    QList<QByteArray> lines = file.readAll().split('\n');
+
+    file.close();
+
+    QCOMPARE(lines.takeLast(), QByteArray());
+    QCOMPARE(lines.takeFirst().count(','), NbOfRuns*NbOfVariables);
+    QCOMPARE(lines.first(), QByteArray("0,0,1,2,1000000,2000000,3000000\r"));
+
+    quint64 runsIndex[NbOfRuns] = { 0, 0, 0 };
+    double previousVoiValue = -1.0;
+
+    for (const auto &line : qAsConst(lines)) {
+        QList<QByteArray> fields = line.trimmed().split(',');
+
+        QCOMPARE(fields.count(), 1+NbOfRuns*NbOfVariables);
+
+        double voiValue = fieldValue(fields[0].constData());
+
+        QVERIFY(voiValue > previousVoiValue);
+
+        previousVoiValue = voiValue;
+
+        for (int i = 0; i < NbOfRuns; ++i) {
+            double runVoiValue = double(runsIndex[i])*PointIntervals[i];
+            bool hasValues = (runVoiValue <= EndingPoints[i]) && qFuzzyCompare(runVoiValue, voiValue);
+
+            for (int j = 0; j < NbOfVariables; ++j) {
+                const QByteArray &field = fields[1+j*NbOfRuns+i];
+
+                if (hasValues) {
+                    QCOMPARE(fieldValue(field.constData()),
+                             variables[j]->value(runsIndex[i], i));
+                } else {
+                    QVERIFY(field.isEmpty());
+                }
+            }
+
+            if (hasValues) {
+                ++runsIndex[i];
+            }
+        }
+    }
+
+    for (int i = 0; i < NbOfRuns; ++i) {
+        QCOMPARE(runsIndex[i], dataStore.size(i));
+    }
+}
+
+//==============================================================================
+
+QTEST_GUILESS_MAIN(Tests)
+
+//==============================================================================
+// End of file
+//==============================================================================
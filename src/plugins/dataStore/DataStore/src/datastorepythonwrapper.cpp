@@ -463,6 +463,64 @@ PyObject * DataStorePythonWrapper::values(DataStoreVariable *pDataStoreVariable,
 
 //==============================================================================
 
+PyObject * DataStorePythonWrapper::matrix(DataStore *pDataStore, int pRun)
+{
+    // Create and return a two-dimensional NumPy array for the given data store
+    // and run, with one row per variable (see matrix_rows()) and one column per
+    // data point
+    // Note #1: the NumPy array is a view onto our contiguous array, i.e. no
+    //          data gets copied, and it remains valid even if the run is still
+    //          in progress. Its number of columns is the size of the run at the
+    //          time it gets created, so getting a new NumPy array is all it
+    //          takes to see the data points that have been added since then...
+    // Note #2: our contiguous array may have more rows than we have contiguous
+    //          variables (e.g. if it is stored in a file, see
+    //          DataStore::addRun()), so its row stride is the capacity of the
+    //          run rather than its size divided by our number of rows...
+
+    DataStoreArray *dataStoreArray = pDataStore->contiguousArray(pRun);
+    auto rowsCount = quint64(pDataStore->contiguousVariables(pRun).count());
+
+    if ((dataStoreArray != nullptr) && (rowsCount != 0)) {
+        auto numPyArray = new NumPyPythonWrapper(dataStoreArray, rowsCount,
+                                                 pDataStore->capacity(pRun),
+                                                 pDataStore->size(pRun));
+
+        pDataStore->mSimulation->mNumPyArrays << numPyArray;
+
+        return numPyArray->mNumPyArray;
+    }
+
+#include "pythonbegin.h"
+    Py_RETURN_NONE;
+#include "pythonend.h"
+}
+
+//==============================================================================
+
+PyObject * DataStorePythonWrapper::matrix_rows(DataStore *pDataStore, int pRun)
+{
+    // Return a Python dictionary that maps the URI of each variable in the
+    // given data store and run to its row in matrix()
+
+    PyObject *res = PyDict_New();
+    const DataStoreVariables variables = pDataStore->contiguousVariables(pRun);
+
+    for (int i = 0, iMax = variables.count(); i < iMax; ++i) {
+        PyObject *row = PyLong_FromLong(i);
+
+        PyDict_SetItemString(res, variables[i]->uri().toUtf8().constData(), row);
+
+#include "pythonbegin.h"
+        Py_DECREF(row);
+#include "pythonend.h"
+    }
+
+    return res;
+}
+
+//==============================================================================
+
 NumPyPythonWrapper::NumPyPythonWrapper(DataStoreArray *pDataStoreArray,
                                        quint64 pSize) :
     mArray(pDataStoreArray)
@@ -485,6 +543,35 @@ NumPyPythonWrapper::NumPyPythonWrapper(DataStoreArray *pDataStoreArray,
 
 //==============================================================================
 
+NumPyPythonWrapper::NumPyPythonWrapper(DataStoreArray *pDataStoreArray,
+                                       quint64 pRowsCount,
+                                       quint64 pRowCapacity, quint64 pSize) :
+    mArray(pDataStoreArray)
+{
+    // Tell our array that we are holding it
+
+    mArray->hold();
+
+    // Initialise ourselves as a view onto the first pSize values of each of the
+    // pRowsCount rows of our array, each of which has a capacity of
+    // pRowCapacity values
+
+    std::array<npy_intp, 2> dims = { npy_intp(pRowsCount), npy_intp(pSize) };
+    std::array<npy_intp, 2> strides = { npy_intp(pRowCapacity*Solver::SizeOfDouble),
+                                        npy_intp(Solver::SizeOfDouble) };
+
+#include "pythonbegin.h"
+    mNumPyArray = PyArray_New(&PyArray_Type, 2, dims.data(), NPY_DOUBLE, strides.data(), // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+                              static_cast<void *>(mArray->data()), 0,
+                              NPY_ARRAY_ALIGNED|NPY_ARRAY_WRITEABLE, nullptr);
+
+    PyArray_SetBaseObject(reinterpret_cast<PyArrayObject *>(mNumPyArray), // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+                          PythonQtSupport::wrapQObject(this));
+#include "pythonend.h"
+}
+
+//==============================================================================
+
 NumPyPythonWrapper::~NumPyPythonWrapper()
 {
     // Tell our array that we are releasing it
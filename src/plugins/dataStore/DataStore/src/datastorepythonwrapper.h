@@ -78,6 +78,11 @@ public slots:
                  quint64 pPosition, int pRun = -1) const;
     PyObject * values(OpenCOR::DataStore::DataStoreVariable *pDataStoreVariable,
                       int pRun = -1);
+
+    PyObject * matrix(OpenCOR::DataStore::DataStore *pDataStore,
+                      int pRun = -1);
+    PyObject * matrix_rows(OpenCOR::DataStore::DataStore *pDataStore,
+                           int pRun = -1);
 };
 
 //==============================================================================
@@ -92,6 +97,9 @@ class NumPyPythonWrapper : public QObject
 public:
     explicit NumPyPythonWrapper(DataStoreArray *pDataStoreArray,
                                 quint64 pSize = 0);
+    explicit NumPyPythonWrapper(DataStoreArray *pDataStoreArray,
+                                quint64 pRowsCount, quint64 pRowCapacity,
+                                quint64 pSize);
     ~NumPyPythonWrapper() override;
 
 private:
@@ -0,0 +1,101 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Data store tests
+//==============================================================================
+
+#include "datastoreinterface.h"
+#include "tests.h"
+
+//==============================================================================
+
+#include <QtTest/QtTest>
+
+//==============================================================================
+
+void Tests::growRunTests()
+{
+    // Make sure that the current run of a data store, be it contiguous or not,
+    // can be grown and that it keeps its values, including those of a variable
+    // that only records the changes in its values
+    // Note: our third data store only becomes contiguous once its run has been
+    //       added, meaning that its run is not contiguous...
+
+    static const int NbOfVariables = 2;
+    static const quint64 NbOfPoints = 1000;
+    static const quint64 FinalCapacity = 1024;
+
+    for (int i = 0; i < 3; ++i) {
+        OpenCOR::DataStore::DataStore dataStore(nullptr);
+        double values[NbOfVariables];
+        OpenCOR::DataStore::DataStoreVariables variables = dataStore.addVariables(values, NbOfVariables);
+
+        variables[1]->setRecording(OpenCOR::DataStore::DataStoreVariableRun::Recording::Changes);
+
+        dataStore.setContiguous(i == 1);
+
+        QVERIFY(dataStore.addRun(1));
+
+        dataStore.setContiguous(i != 0);
+
+        for (quint64 j = 0; j < NbOfPoints; ++j) {
+            if (dataStore.size() == dataStore.capacity()) {
+                QVERIFY(dataStore.growRun(2*dataStore.capacity()));
+            }
+
+            values[0] = double(j*j);
+            values[1] = double(j/100);
+
+            dataStore.addValues(double(j));
+        }
+
+        QCOMPARE(dataStore.size(), NbOfPoints);
+        QCOMPARE(dataStore.capacity(), FinalCapacity);
+        QVERIFY(!dataStore.growRun(FinalCapacity));
+
+        for (quint64 j = 0; j < NbOfPoints; ++j) {
+            QCOMPARE(dataStore.voi()->value(j), double(j));
+            QCOMPARE(variables[0]->value(j), double(j*j));
+            QCOMPARE(variables[1]->values()[j], double(j/100));
+        }
+
+        // Make sure that, if our run is contiguous, our VOI and the variable
+        // that records all of its values are in our new contiguous array
+
+        if (i != 1) {
+            QVERIFY(dataStore.contiguousArray() == nullptr);
+        } else {
+            OpenCOR::DataStore::DataStoreArray *contiguousArray = dataStore.contiguousArray();
+
+            QCOMPARE(contiguousArray->size(), 2*FinalCapacity);
+            QCOMPARE(contiguousArray->data(NbOfPoints-1), double(NbOfPoints-1));
+            QCOMPARE(contiguousArray->data(FinalCapacity+NbOfPoints-1),
+                     double((NbOfPoints-1)*(NbOfPoints-1)));
+        }
+    }
+}
+
+//==============================================================================
+
+QTEST_GUILESS_MAIN(Tests)
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -26,10 +26,16 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QDir>
+#include <QTemporaryFile>
 #include <QThread>
 
 //==============================================================================
 
+#include <algorithm>
+
+//==============================================================================
+
 namespace OpenCOR {
 
 //==============================================================================
@@ -38,7 +44,7 @@ extern "C" Q_DECL_EXPORT int dataStoreInterfaceVersion()
 {
     // Version of the data store interface
 
-    return 5;
+    return 9;
 }
 
 //==============================================================================
@@ -47,12 +53,51 @@ namespace DataStore {
 
 //==============================================================================
 
-DataStoreArray::DataStoreArray(quint64 pSize) :
-    mSize(pSize)
+DataStoreArray::DataStoreArray(quint64 pSize, Storage pStorage) :
+    mSize(pSize),
+    mStorage(pStorage)
+{
+    // Allocate our data, either in memory or in a temporary file that we map
+    // into memory
+    // Note: in the latter case, the file is resized (rather than written to),
+    //       so that it is sparse and filled with zeros. Also, since our data is
+    //       backed by a file rather than by the swap, the OS can page out the
+    //       parts of it that are not used anymore (e.g. the beginning of a long
+    //       run) and page them back in when needed (e.g. when plotting or
+    //       exporting our data), meaning that only the "hot" parts of our data
+    //       remain in physical memory...
+
+    if (pStorage == Storage::Memory) {
+        mData = new double[pSize] {};
+    } else {
+        static const QString FileNameTemplate = QDir::tempPath()+"/OpenCOR.XXXXXX.dat";
+
+        mFile = new QTemporaryFile(FileNameTemplate);
+
+        qint64 fileSize = qint64(qMax(pSize, quint64(1))*Solver::SizeOfDouble);
+
+        if (   !mFile->open() || !mFile->resize(fileSize)
+            || ((mData = reinterpret_cast<double *>(mFile->map(0, fileSize))) == nullptr)) {
+            delete mFile;
+
+            throw std::bad_alloc();
+        }
+    }
+}
+
+//==============================================================================
+
+DataStoreArray::DataStoreArray(DataStoreArray *pArray, quint64 pOffset,
+                               quint64 pSize) :
+    mSize(pSize),
+    mStorage(pArray->storage()),
+    mData(pArray->data()+pOffset),
+    mArray(pArray)
 {
-    // Allocate our data
+    // Use part of the given array as our data, making sure that the given array
+    // lives as long as we do
 
-    mData = new double[pSize] {};
+    mArray->hold();
 }
 
 //==============================================================================
@@ -66,6 +111,15 @@ quint64 DataStoreArray::size() const
 
 //==============================================================================
 
+DataStoreArray::Storage DataStoreArray::storage() const
+{
+    // Return our storage
+
+    return mStorage;
+}
+
+//==============================================================================
+
 double * DataStoreArray::data() const
 {
     // Return our data
@@ -112,7 +166,15 @@ void DataStoreArray::release()
     // needed
 
     if (--mReferenceCounter == 0) {
-        delete[] mData;
+        if (mArray != nullptr) {
+            mArray->release();
+        } else if (mFile != nullptr) {
+            mFile->unmap(reinterpret_cast<uchar *>(mData));
+
+            delete mFile;
+        } else {
+            delete[] mData;
+        }
 
         delete this;
     }
@@ -197,13 +259,36 @@ DataStoreValues::~DataStoreValues()
 
 //==============================================================================
 
-DataStoreVariableRun::DataStoreVariableRun(quint64 pCapacity, double *pValue) :
+DataStoreVariableRun::DataStoreVariableRun(quint64 pCapacity, double *pValue,
+                                           DataStoreArray::Storage pStorage,
+                                           Recording pRecording) :
     mCapacity(pCapacity),
+    mStorage(pStorage),
+    mRecording(pRecording),
     mValue(pValue)
 {
-    // Create our array of values
+    // Create our array of values, if we are to record all of them
+    // Note: if we are only to record the changes in our values, then our array
+    //       only gets created when someone asks for it (see array())...
+
+    if (pRecording == Recording::Values) {
+        mArray = new DataStoreArray(mCapacity, pStorage);
+    }
+}
 
-    mArray = new DataStoreArray(mCapacity);
+//==============================================================================
+
+DataStoreVariableRun::DataStoreVariableRun(DataStoreArray *pArray,
+                                           double *pValue,
+                                           Recording pRecording) :
+    mCapacity(pArray->size()),
+    mStorage(pArray->storage()),
+    mRecording(pRecording),
+    mArray(pArray),
+    mValue(pValue)
+{
+    // Use the given array, which we now own, to record all of our values or
+    // to bring the changes in our values up to date (see array())
 }
 
 //==============================================================================
@@ -212,7 +297,60 @@ DataStoreVariableRun::~DataStoreVariableRun()
 {
     // Delete some internal objects
 
-    mArray->release();
+    if (mArray != nullptr) {
+        mArray->release();
+    }
+
+    for (auto oldArray : qAsConst(mOldArrays)) {
+        oldArray->release();
+    }
+}
+
+//==============================================================================
+
+DataStoreVariableRun::Recording DataStoreVariableRun::recording() const
+{
+    // Return our recording
+
+    return mRecording;
+}
+
+//==============================================================================
+
+quint64 DataStoreVariableRun::capacity() const
+{
+    // Return our capacity
+
+    return mCapacity;
+}
+
+//==============================================================================
+
+void DataStoreVariableRun::grow(quint64 pCapacity, DataStoreArray *pArray)
+{
+    // Grow to the given capacity, using the given array, which we now own, to
+    // record all of our values or to bring the changes in our values up to date
+    // (see array())
+    // Note #1: if we only record the changes in our values, then we may not be
+    //          given an array, in which case it only gets created when someone
+    //          asks for it...
+    // Note #2: we keep our old array until we get deleted since someone may
+    //          still be using its data (e.g. a graph that is being plotted
+    //          while our simulation is running)...
+
+    QMutexLocker locker(&mChangesMutex);
+
+    if (mRecording == Recording::Values) {
+        memcpy(pArray->data(), mArray->data(), mSize*Solver::SizeOfDouble);
+    }
+
+    if (mArray != nullptr) {
+        mOldArrays << mArray;
+    }
+
+    mCapacity = pCapacity;
+    mArray = pArray;
+    mArraySize = 0;
 }
 
 //==============================================================================
@@ -226,14 +364,46 @@ quint64 DataStoreVariableRun::size() const
 
 //==============================================================================
 
-void DataStoreVariableRun::addValue()
+void DataStoreVariableRun::setSize(quint64 pSize)
+{
+    // Set our size, i.e. the number of values that were directly set in our
+    // array (see values())
+    // Note: this only makes sense if we record all of our values...
+
+    if (mRecording == Recording::Values) {
+        mSize = qMin(pSize, mCapacity);
+    }
+}
+
+//==============================================================================
+
+void DataStoreVariableRun::addChange(double pValue)
 {
-    // Set the value of the variable at the given position
+    // Keep track of the given value, but only if it is different from the last
+    // one we have
+    // Note: we compare the bits of the two values rather than the two values
+    //       themselves, so that a NaN value doesn't get recorded over and
+    //       over again...
 
-    if ((mSize < mCapacity) && (mValue != nullptr)) {
-        mArray->data()[mSize] = *mValue;
+    if (   mChangesValues.isEmpty()
+        || (memcmp(&mChangesValues.constLast(), &pValue, Solver::SizeOfDouble) != 0)) {
+        QMutexLocker locker(&mChangesMutex);
 
-        ++mSize;
+        mChangesPositions << mSize;
+        mChangesValues << pValue;
+    }
+
+    ++mSize;
+}
+
+//==============================================================================
+
+void DataStoreVariableRun::addValue()
+{
+    // Add the value of our variable
+
+    if (mValue != nullptr) {
+        addValue(*mValue);
     }
 }
 
@@ -241,12 +411,16 @@ void DataStoreVariableRun::addValue()
 
 void DataStoreVariableRun::addValue(double pValue)
 {
-    // Set the value of the variable at the given position using the given value
+    // Add the given value, using our recording
 
     if (mSize < mCapacity) {
-        mArray->data()[mSize] = pValue;
+        if (mRecording == Recording::Values) {
+            mArray->data()[mSize] = pValue;
 
-        ++mSize;
+            ++mSize;
+        } else if (mRecording == Recording::Changes) {
+            addChange(pValue);
+        }
     }
 }
 
@@ -255,6 +429,34 @@ void DataStoreVariableRun::addValue(double pValue)
 DataStoreArray * DataStoreVariableRun::array() const
 {
     // Return our array
+    // Note: if we only record the changes in our values, then we (create and)
+    //       bring our array up to date before returning it...
+
+    if (mRecording == Recording::Changes) {
+        QMutexLocker locker(&mChangesMutex);
+
+        if (mArray == nullptr) {
+            try {
+                mArray = new DataStoreArray(mCapacity, mStorage);
+            } catch (...) {
+                return nullptr;
+            }
+        }
+
+        double *data = mArray->data();
+        quint64 size = mSize;
+
+        for (int i = 0, iMax = mChangesPositions.count(); i < iMax; ++i) {
+            quint64 from = qMax(mChangesPositions[i], mArraySize);
+            quint64 to = (i == iMax-1)?size:qMin(mChangesPositions[i+1], size);
+
+            if (from < to) {
+                std::fill(data+from, data+to, mChangesValues[i]);
+            }
+        }
+
+        mArraySize = size;
+    }
 
     return mArray;
 }
@@ -265,18 +467,53 @@ double DataStoreVariableRun::value(quint64 pPosition) const
 {
     // Return the value at the given position
 
-    return (pPosition < mSize)?
-               mArray->data()[pPosition]:
-               qQNaN();
+    if (pPosition >= mSize) {
+        return qQNaN();
+    }
+
+    if (mRecording == Recording::Values) {
+        return mArray->data()[pPosition];
+    }
+
+    // We only record the changes in our values, so retrieve the last change
+    // that happened at or before the given position
+
+    QMutexLocker locker(&mChangesMutex);
+
+    auto change = std::upper_bound(mChangesPositions.constBegin(),
+                                   mChangesPositions.constEnd(), pPosition);
+
+    return mChangesValues[int(change-mChangesPositions.constBegin())-1];
 }
 
 //==============================================================================
 
 double * DataStoreVariableRun::values() const
 {
-    // Return our values
+    // Return our values, if any
+
+    DataStoreArray *dataStoreArray = array();
+
+    return (dataStoreArray != nullptr)?
+                dataStoreArray->data():
+                nullptr;
+}
+
+//==============================================================================
+
+bool DataStoreVariableRun::isConstant() const
+{
+    // Return whether we only record the changes in our values and our value
+    // has never changed, in which case value(0) is all that is needed to know
+    // all of our values, without having to call values()
+
+    if (mRecording != Recording::Changes) {
+        return false;
+    }
+
+    QMutexLocker locker(&mChangesMutex);
 
-    return mArray->data();
+    return mChangesValues.count() <= 1;
 }
 
 //==============================================================================
@@ -335,12 +572,14 @@ int DataStoreVariable::runsCount() const
 
 //==============================================================================
 
-bool DataStoreVariable::addRun(quint64 pCapacity)
+bool DataStoreVariable::addRun(quint64 pCapacity,
+                               DataStoreArray::Storage pStorage)
 {
-    // Try to add a run of the given capacity
+    // Try to add a run of the given capacity and storage, and using our
+    // recording
 
     try {
-        mRuns << new DataStoreVariableRun(pCapacity, mValue);
+        mRuns << new DataStoreVariableRun(pCapacity, mValue, pStorage, mRecording);
     } catch (...) {
         return false;
     }
@@ -350,6 +589,15 @@ bool DataStoreVariable::addRun(quint64 pCapacity)
 
 //==============================================================================
 
+void DataStoreVariable::addRun(DataStoreArray *pArray)
+{
+    // Add a run that uses the given array and our recording
+
+    mRuns << new DataStoreVariableRun(pArray, mValue, mRecording);
+}
+
+//==============================================================================
+
 void DataStoreVariable::keepRuns(int pRunsCount)
 {
     // Keep the given number of runs
@@ -363,6 +611,38 @@ void DataStoreVariable::keepRuns(int pRunsCount)
 
 //==============================================================================
 
+void DataStoreVariable::growRun(quint64 pCapacity, DataStoreArray *pArray)
+{
+    // Grow our current (i.e. last) run to the given capacity, using the given
+    // array, if any
+
+    if (!mRuns.isEmpty()) {
+        mRuns.last()->grow(pCapacity, pArray);
+    } else if (pArray != nullptr) {
+        pArray->release();
+    }
+}
+
+//==============================================================================
+
+DataStoreVariableRun::Recording DataStoreVariable::recording() const
+{
+    // Return our recording
+
+    return mRecording;
+}
+
+//==============================================================================
+
+void DataStoreVariable::setRecording(DataStoreVariableRun::Recording pRecording)
+{
+    // Set our recording, which will be used by our future runs
+
+    mRecording = pRecording;
+}
+
+//==============================================================================
+
 int DataStoreVariable::type() const
 {
     // Return our type
@@ -454,6 +734,25 @@ quint64 DataStoreVariable::size(int pRun) const
 
 //==============================================================================
 
+quint64 DataStoreVariable::capacity(int pRun) const
+{
+    // Return our capacity for the given run
+
+    if (mRuns.isEmpty()) {
+        return 0;
+    }
+
+    if (pRun == -1) {
+        return mRuns.last()->capacity();
+    }
+
+    return ((pRun >= 0) && (pRun < mRuns.count()))?
+               mRuns[pRun]->capacity():
+               0;
+}
+
+//==============================================================================
+
 DataStoreArray * DataStoreVariable::array(int pRun) const
 {
     // Return the array for the given run, if any
@@ -499,6 +798,17 @@ void DataStoreVariable::addValue(double pValue, int pRun)
 
 //==============================================================================
 
+void DataStoreVariable::setSize(quint64 pSize)
+{
+    // Set the size of our current (i.e. last) run
+
+    if (!mRuns.isEmpty()) {
+        mRuns.last()->setSize(pSize);
+    }
+}
+
+//==============================================================================
+
 double DataStoreVariable::value(quint64 pPosition, int pRun) const
 {
     // Return the value at the given position and this for the given run
@@ -537,6 +847,28 @@ double * DataStoreVariable::values(int pRun) const
 
 //==============================================================================
 
+bool DataStoreVariable::isConstant(int pRun) const
+{
+    // Return whether our value is constant for the given run
+    // Note: this allows someone who is after our values to use value() rather
+    //       than values(), which would otherwise create an array for them (if
+    //       we only record the changes in our values)...
+
+    if (mRuns.isEmpty()) {
+        return false;
+    }
+
+    if (pRun == -1) {
+        return mRuns.last()->isConstant();
+    }
+
+    return ((pRun >= 0) && (pRun < mRuns.count()))?
+               mRuns[pRun]->isConstant():
+               false;
+}
+
+//==============================================================================
+
 double DataStoreVariable::value() const
 {
     // Return the value to be added next
@@ -768,6 +1100,18 @@ double DataStoreImportData::progress()
 
 //==============================================================================
 
+double DataStoreImportData::progress(quint64 pNbOfDataPoints)
+{
+    // Increase, by the given number of data points, and return our normalised
+    // progress
+
+    mProgress += pNbOfDataPoints;
+
+    return double(mProgress)*mOneOverTotalProgress;
+}
+
+//==============================================================================
+
 DataStoreExportData::DataStoreExportData(const QString &pFileName, DataStore *pDataStore,
                                          const DataStoreVariables &pVariables) :
     DataStoreData(pFileName),
@@ -815,6 +1159,12 @@ DataStore::~DataStore()
     for (auto variable : qAsConst(mVariables)) {
         delete variable;
     }
+
+    for (auto contiguousArray : qAsConst(mContiguousArrays)) {
+        if (contiguousArray != nullptr) {
+            contiguousArray->release();
+        }
+    }
 }
 
 //==============================================================================
@@ -838,19 +1188,80 @@ int DataStore::runsCount() const
 
 //==============================================================================
 
-bool DataStore::addRun(quint64 pCapacity)
+quint64 DataStore::runMemory(quint64 pCapacity) const
 {
-    // Try to add a run to our VOI and all our variables
+    // Return the amount of memory, in bytes, that a run of the given capacity
+    // requires for our VOI and all our variables
+
+    return pCapacity*quint64(mVariables.count()+1)*Solver::SizeOfDouble;
+}
+
+//==============================================================================
+
+void DataStore::sharedRunVariables(DataStoreArray::Storage pStorage,
+                                   bool pContiguous,
+                                   DataStoreVariables &pContiguousVariables,
+                                   DataStoreVariables &pSharedVariables) const
+{
+    // Determine the variables that share one array, if any, for a run of the
+    // given storage and contiguity (see addRun())
+
+    if (pContiguous || (pStorage == DataStoreArray::Storage::File)) {
+        DataStoreVariables variables = DataStoreVariables() << mVoi << mVariables;
+
+        for (auto variable : qAsConst(variables)) {
+            if (variable->recording() == DataStoreVariableRun::Recording::Values) {
+                pContiguousVariables << variable;
+            }
+        }
+
+        pSharedVariables = pContiguousVariables;
+
+        if (pStorage == DataStoreArray::Storage::File) {
+            for (auto variable : qAsConst(variables)) {
+                if (variable->recording() == DataStoreVariableRun::Recording::Changes) {
+                    pSharedVariables << variable;
+                }
+            }
+        }
+    }
+}
+
+//==============================================================================
+
+bool DataStore::addRun(quint64 pCapacity, DataStoreArray::Storage pStorage)
+{
+    // Try to add a run of the given storage to our VOI and all our variables
+    // Note #1: if we are contiguous, then our VOI and the variables that record
+    //          all of their values share one array, in which each of them has
+    //          a row of the given capacity...
+    // Note #2: if our run is to be stored in a file, then our VOI and the
+    //          variables that record something share one array (and therefore
+    //          one file), so that we don't run out of file descriptors. The
+    //          variables that only record the changes in their values come
+    //          last and their rows only get used if their values are asked
+    //          for, meaning that they otherwise don't use any disk space (see
+    //          DataStoreArray::DataStoreArray())...
 
     int oldRunsCount = mVoi->runsCount();
+    DataStoreVariables variables = DataStoreVariables() << mVoi << mVariables;
+    DataStoreArray *sharedArray = nullptr;
+    DataStoreVariables contiguousVariables;
+    DataStoreVariables sharedVariables;
+
+    sharedRunVariables(pStorage, mContiguous, contiguousVariables, sharedVariables);
 
     try {
-        if (!mVoi->addRun(pCapacity)) {
-            throw std::exception();
+        if (!sharedVariables.isEmpty()) {
+            sharedArray = new DataStoreArray(pCapacity*quint64(sharedVariables.count()), pStorage);
         }
 
-        for (auto variable : qAsConst(mVariables)) {
-            if (!variable->addRun(pCapacity)) {
+        for (auto variable : qAsConst(variables)) {
+            int row = sharedVariables.indexOf(variable);
+
+            if (row != -1) {
+                variable->addRun(new DataStoreArray(sharedArray, quint64(row)*pCapacity, pCapacity));
+            } else if (!variable->addRun(pCapacity, pStorage)) {
                 throw std::exception();
             }
         }
@@ -864,14 +1275,200 @@ bool DataStore::addRun(quint64 pCapacity)
             variable->keepRuns(oldRunsCount);
         }
 
+        if (sharedArray != nullptr) {
+            sharedArray->release();
+        }
+
         return false;
     }
 
+    // Keep track of our shared array, if we are contiguous, or let our
+    // variables be its sole owners
+
+    if (mContiguous) {
+        mContiguousArrays << sharedArray;
+        mContiguousVariables << contiguousVariables;
+    } else {
+        if (sharedArray != nullptr) {
+            sharedArray->release();
+        }
+
+        mContiguousArrays << nullptr;
+        mContiguousVariables << DataStoreVariables();
+    }
+
     return true;
 }
 
 //==============================================================================
 
+bool DataStore::addRun(quint64 pCapacity, quint64 pMemoryBudget)
+{
+    // Try to add a run to our VOI and all our variables
+    // Note: if the run would exceed the given memory budget (zero meaning that
+    //       there is no budget) or if we cannot allocate it in memory, then we
+    //       spill it to disk...
+
+    if (   ((pMemoryBudget == 0) || (runMemory(pCapacity) <= pMemoryBudget))
+        && addRun(pCapacity, DataStoreArray::Storage::Memory)) {
+        return true;
+    }
+
+    return addRun(pCapacity, DataStoreArray::Storage::File);
+}
+
+//==============================================================================
+
+bool DataStore::growRun(quint64 pCapacity)
+{
+    // Try to grow our current (i.e. last) run to the given capacity, keeping
+    // its storage
+    // Note #1: our VOI and some of our variables may share one array (see
+    //          addRun()), in which case we need a new shared array...
+    // Note #2: our run is contiguous if it was added while we were contiguous,
+    //          whether or not we are still contiguous...
+
+    if ((mVoi->runsCount() == 0) || (pCapacity <= capacity())) {
+        return false;
+    }
+
+    DataStoreArray::Storage storage = mVoi->array()->storage();
+    bool contiguous = mContiguousArrays.last() != nullptr;
+    DataStoreVariables variables = DataStoreVariables() << mVoi << mVariables;
+    DataStoreArray *sharedArray = nullptr;
+    DataStoreVariables contiguousVariables;
+    DataStoreVariables sharedVariables;
+    QList<DataStoreArray *> arrays;
+
+    sharedRunVariables(storage, contiguous, contiguousVariables, sharedVariables);
+
+    try {
+        if (!sharedVariables.isEmpty()) {
+            sharedArray = new DataStoreArray(pCapacity*quint64(sharedVariables.count()), storage);
+        }
+
+        for (auto variable : qAsConst(variables)) {
+            int row = sharedVariables.indexOf(variable);
+
+            if (row != -1) {
+                arrays << new DataStoreArray(sharedArray, quint64(row)*pCapacity, pCapacity);
+            } else if (variable->recording() == DataStoreVariableRun::Recording::Values) {
+                arrays << new DataStoreArray(pCapacity, storage);
+            } else {
+                arrays << nullptr;
+            }
+        }
+    } catch (...) {
+        // We couldn't allocate all the arrays we need, so leave our run as it
+        // is
+
+        for (auto array : qAsConst(arrays)) {
+            if (array != nullptr) {
+                array->release();
+            }
+        }
+
+        if (sharedArray != nullptr) {
+            sharedArray->release();
+        }
+
+        return false;
+    }
+
+    // Grow the run of our VOI and all our variables, and keep track of our new
+    // shared array, if our run is contiguous, or let our variables be its sole
+    // owners
+
+    for (int i = 0, iMax = variables.count(); i < iMax; ++i) {
+        variables[i]->growRun(pCapacity, arrays[i]);
+    }
+
+    if (contiguous) {
+        mContiguousArrays.last()->release();
+
+        mContiguousArrays.last() = sharedArray;
+    } else if (sharedArray != nullptr) {
+        sharedArray->release();
+    }
+
+    return true;
+}
+
+//==============================================================================
+
+quint64 DataStore::capacity(int pRun) const
+{
+    // Return our capacity, i.e. the capacity of our VOI, for example
+
+    return mVoi->capacity(pRun);
+}
+
+//==============================================================================
+
+bool DataStore::isContiguous() const
+{
+    // Return whether we are contiguous
+
+    return mContiguous;
+}
+
+//==============================================================================
+
+void DataStore::setContiguous(bool pContiguous)
+{
+    // Set whether we are contiguous, i.e. whether our future runs should keep
+    // the values of our VOI and of our variables next to one another, so that
+    // they can be accessed as a matrix (e.g. from Python)
+
+    mContiguous = pContiguous;
+}
+
+//==============================================================================
+
+DataStoreArray * DataStore::contiguousArray(int pRun) const
+{
+    // Return the contiguous array for the given run, if any
+    // Note: each row of the array has the capacity of the run and the first
+    //       rows are those of our contiguous variables (see
+    //       contiguousVariables()). If the run is stored in a file, then they
+    //       are followed by the rows of the variables that only record the
+    //       changes in their values (see addRun())...
+
+    if (mContiguousArrays.isEmpty()) {
+        return nullptr;
+    }
+
+    if (pRun == -1) {
+        return mContiguousArrays.last();
+    }
+
+    return ((pRun >= 0) && (pRun < mContiguousArrays.count()))?
+                mContiguousArrays[pRun]:
+                nullptr;
+}
+
+//==============================================================================
+
+DataStoreVariables DataStore::contiguousVariables(int pRun) const
+{
+    // Return the variables, in the order of their rows, that are in the
+    // contiguous array for the given run
+
+    if (mContiguousVariables.isEmpty()) {
+        return {};
+    }
+
+    if (pRun == -1) {
+        return mContiguousVariables.last();
+    }
+
+    return ((pRun >= 0) && (pRun < mContiguousVariables.count()))?
+                mContiguousVariables[pRun]:
+                DataStoreVariables();
+}
+
+//==============================================================================
+
 quint64 DataStore::size(int pRun) const
 {
     // Return our size, i.e. the size of our VOI, for example
@@ -989,6 +1586,21 @@ void DataStore::addValues(double pVoiValue)
 
 //==============================================================================
 
+void DataStore::setSize(quint64 pSize)
+{
+    // Set the size of the current run of all our variables including our VOI,
+    // i.e. the number of values that were directly set in their array
+    // Note: like in addValues(), our VOI must be updated last...
+
+    for (auto variable : qAsConst(mVariables)) {
+        variable->setSize(pSize);
+    }
+
+    mVoi->setSize(pSize);
+}
+
+//==============================================================================
+
 DataStoreImporterWorker::DataStoreImporterWorker(DataStoreImportData *pImportData) :
     mImportData(pImportData)
 {
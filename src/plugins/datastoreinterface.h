@@ -25,7 +25,13 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QMutex>
 #include <QObject>
+#include <QVector>
+
+//==============================================================================
+
+class QTemporaryFile;
 
 //==============================================================================
 
@@ -46,10 +52,19 @@ namespace DataStore {
 class DataStoreArray
 {
 public:
-    explicit DataStoreArray(quint64 pSize);
+    enum class Storage {
+        Memory,
+        File
+    };
+
+    explicit DataStoreArray(quint64 pSize, Storage pStorage = Storage::Memory);
+    explicit DataStoreArray(DataStoreArray *pArray, quint64 pOffset,
+                            quint64 pSize);
 
     quint64 size() const;
 
+    Storage storage() const;
+
     double * data() const;
     double data(quint64 pPosition) const;
 
@@ -62,7 +77,13 @@ private:
     int mReferenceCounter = 1;
 
     quint64 mSize;
+    Storage mStorage;
+
     double *mData = nullptr;
+
+    QTemporaryFile *mFile = nullptr;
+
+    DataStoreArray *mArray = nullptr;
 };
 
 //==============================================================================
@@ -104,10 +125,26 @@ class DataStoreVariableRun : public QObject
     Q_OBJECT
 
 public:
-    explicit DataStoreVariableRun(quint64 pCapacity, double *pValue);
+    enum class Recording {
+        Values,
+        Changes,
+        None
+    };
+
+    explicit DataStoreVariableRun(quint64 pCapacity, double *pValue,
+                                  DataStoreArray::Storage pStorage,
+                                  Recording pRecording = Recording::Values);
+    explicit DataStoreVariableRun(DataStoreArray *pArray, double *pValue,
+                                  Recording pRecording = Recording::Values);
     ~DataStoreVariableRun() override;
 
+    Recording recording() const;
+
+    quint64 capacity() const;
+    void grow(quint64 pCapacity, DataStoreArray *pArray);
+
     quint64 size() const;
+    void setSize(quint64 pSize);
 
     DataStoreArray * array() const;
 
@@ -117,12 +154,25 @@ public:
     double value(quint64 pPosition) const;
     double * values() const;
 
+    bool isConstant() const;
+
 private:
     quint64 mCapacity;
     quint64 mSize = 0;
 
-    DataStoreArray *mArray = nullptr;
+    DataStoreArray::Storage mStorage;
+    Recording mRecording;
+
+    mutable DataStoreArray *mArray = nullptr;
+    QList<DataStoreArray *> mOldArrays;
     double *mValue;
+
+    mutable QMutex mChangesMutex;
+    QVector<quint64> mChangesPositions;
+    QVector<double> mChangesValues;
+    mutable quint64 mArraySize = 0;
+
+    void addChange(double pValue);
 };
 
 //==============================================================================
@@ -144,8 +194,14 @@ public:
     static bool compare(DataStoreVariable *pVariable1,
                         DataStoreVariable *pVariable2);
 
-    bool addRun(quint64 pCapacity);
+    bool addRun(quint64 pCapacity,
+                DataStoreArray::Storage pStorage = DataStoreArray::Storage::Memory);
+    void addRun(DataStoreArray *pArray);
     void keepRuns(int pRunsCount);
+    void growRun(quint64 pCapacity, DataStoreArray *pArray);
+
+    DataStoreVariableRun::Recording recording() const;
+    void setRecording(DataStoreVariableRun::Recording pRecording);
 
     void setType(int pType);
 
@@ -158,8 +214,14 @@ public:
     void addValue();
     void addValue(double pValue, int pRun = -1);
 
+    quint64 capacity(int pRun = -1) const;
+
+    void setSize(quint64 pSize);
+
     double * values(int pRun = -1) const;
 
+    bool isConstant(int pRun = -1) const;
+
 public slots:
     bool isVisible() const;
 
@@ -182,6 +244,7 @@ private:
     SimulationSupport::Simulation *mSimulation;
 
     int mType = -1;
+    DataStoreVariableRun::Recording mRecording = DataStoreVariableRun::Recording::Values;
     QString mUri;
     QString mName;
     QString mUnit;
@@ -248,6 +311,7 @@ public:
     QList<quint64> runSizes() const;
 
     double progress();
+    double progress(quint64 pNbOfDataPoints);
 
 private:
     bool mValid = true;
@@ -299,12 +363,25 @@ class DataStore : public QObject
 {
     Q_OBJECT
 
+    friend class DataStorePythonWrapper;
+
 public:
     explicit DataStore(SimulationSupport::Simulation *pSimulation,
                        const QString &pUri = {});
     ~DataStore() override;
 
-    bool addRun(quint64 pCapacity);
+    quint64 runMemory(quint64 pCapacity) const;
+
+    bool addRun(quint64 pCapacity, quint64 pMemoryBudget = 0);
+    bool growRun(quint64 pCapacity);
+
+    quint64 capacity(int pRun = -1) const;
+
+    bool isContiguous() const;
+    void setContiguous(bool pContiguous);
+
+    DataStoreArray * contiguousArray(int pRun = -1) const;
+    DataStoreVariables contiguousVariables(int pRun = -1) const;
 
     DataStoreVariables variables();
     DataStoreVariables voiAndVariables();
@@ -317,6 +394,8 @@ public:
 
     void addValues(double pVoiValue);
 
+    void setSize(quint64 pSize);
+
 public slots:
     QString uri() const;
 
@@ -333,6 +412,16 @@ private:
 
     DataStoreVariable *mVoi = nullptr;
     DataStoreVariables mVariables;
+
+    bool mContiguous = false;
+    QList<DataStoreArray *> mContiguousArrays;
+    QList<DataStoreVariables> mContiguousVariables;
+
+    void sharedRunVariables(DataStoreArray::Storage pStorage, bool pContiguous,
+                            DataStoreVariables &pContiguousVariables,
+                            DataStoreVariables &pSharedVariables) const;
+
+    bool addRun(quint64 pCapacity, DataStoreArray::Storage pStorage);
 };
 
 //==============================================================================
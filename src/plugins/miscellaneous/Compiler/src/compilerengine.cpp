@@ -29,6 +29,15 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 #include "compilerengine.h"
 #include "compilermath.h"
+#include "corecliutils.h"
+
+//==============================================================================
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QMutex>
+#include <QStandardPaths>
 
 //==============================================================================
 
@@ -41,6 +50,11 @@ along with this program. If not, see <https://gnu.org/licenses>.
     #include "clang/Frontend/TextDiagnosticPrinter.h"
     #include "clang/Lex/PreprocessorOptions.h"
 
+    #include "llvm/Config/llvm-config.h"
+
+    #include "llvm/ExecutionEngine/ObjectCache.h"
+    #include "llvm/ExecutionEngine/Orc/CompileUtils.h"
+
     #include "llvm/Support/Host.h"
     #include "llvm/Support/TargetSelect.h"
 
@@ -54,6 +68,113 @@ namespace Compiler {
 
 //==============================================================================
 
+class CompilerObjectCache : public llvm::ObjectCache
+{
+public:
+    void notifyObjectCompiled(const llvm::Module *pModule,
+                              llvm::MemoryBufferRef pObject) override;
+
+    std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *pModule) override;
+
+private:
+    void trimCache(const QString &pCacheDirName);
+};
+
+//==============================================================================
+
+void CompilerObjectCache::notifyObjectCompiled(const llvm::Module *pModule,
+                                               llvm::MemoryBufferRef pObject)
+{
+    // Save the object code that has just been compiled for the given module,
+    // but only if the module is to be cached, i.e. if its identifier is the
+    // name of a cached object file (see CompilerEngine::addModule())
+
+    static const QString ObjectFileExtension = ".o";
+
+    QString objectFileName = QString::fromStdString(pModule->getModuleIdentifier());
+
+    if (objectFileName.endsWith(ObjectFileExtension)) {
+        Core::writeFile(objectFileName,
+                        QByteArray(pObject.getBufferStart(), int(pObject.getBufferSize())));
+
+        trimCache(QFileInfo(objectFileName).absolutePath());
+    }
+}
+
+//==============================================================================
+
+void CompilerObjectCache::trimCache(const QString &pCacheDirName)
+{
+    // Make sure that our cache doesn't get bigger than it should by removing
+    // its least recently used object files, if needed
+    // Note: the modification time of an object file is updated whenever it
+    //       gets used (see CompilerEngine::addModule()), so that it reflects
+    //       when it was last used...
+
+    static const qint64 MaximumCacheSize = 256*1024*1024;
+
+    static QMutex mutex;
+
+    QMutexLocker mutexLocker(&mutex);
+
+    const QFileInfoList objectFileInfos = QDir(pCacheDirName).entryInfoList({ "*.o" },
+                                                                             QDir::Files,
+                                                                             QDir::Time);
+    qint64 cacheSize = 0;
+
+    for (const auto &objectFileInfo : objectFileInfos) {
+        cacheSize += objectFileInfo.size();
+
+        if (cacheSize > MaximumCacheSize) {
+            QFile::remove(objectFileInfo.absoluteFilePath());
+        }
+    }
+}
+
+//==============================================================================
+
+std::unique_ptr<llvm::MemoryBuffer> CompilerObjectCache::getObject(const llvm::Module *pModule)
+{
+    Q_UNUSED(pModule)
+
+    // We never have any object code for a module since cached object code is
+    // loaded before the corresponding module even gets created (see
+    // CompilerEngine::addModule())
+
+    return nullptr;
+}
+
+//==============================================================================
+
+static QString cachedObjectFileName(const QString &pCode,
+                                    const std::vector<const char *> &pCompilationArguments)
+{
+    // Determine the name of the file that contains (or will contain) the object
+    // code for the given code, if we can cache object code
+    // Note: the name of the file is based on the SHA-1 of the given code, as
+    //       well as of anything that may affect the generated object code,
+    //       i.e. the version of LLVM, the target triple, the host CPU and the
+    //       compilation arguments...
+
+    static const QString CacheDirName = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+
+    if (CacheDirName.isEmpty()) {
+        return {};
+    }
+
+    QString key = QString("%1|%2|%3").arg(LLVM_VERSION_STRING,
+                                          QString::fromStdString(llvm::sys::getProcessTriple()),
+                                          QString::fromStdString(llvm::sys::getHostCPUName().str()));
+
+    for (const auto &compilationArgument : pCompilationArguments) {
+        key += QString("|%1").arg(compilationArgument);
+    }
+
+    return CacheDirName+"/Compiler/"+Core::sha1(key+"|"+pCode)+".o";
+}
+
+//==============================================================================
+
 bool CompilerEngine::hasError() const
 {
     // Return whether an error occurred
@@ -91,10 +212,41 @@ bool CompilerEngine::addFunction(const QString &pName, void *pFunction)
 
 bool CompilerEngine::compileCode(const QString &pCode)
 {
-    // Reset ourselves
+    // Compile the given code as a single module
+
+    return compileCodes({ pCode });
+}
+
+//==============================================================================
+
+bool CompilerEngine::compileCodes(const QStringList &pCodes)
+{
+    // Reset ourselves and create our ORC-based JIT
 
     mError = QString();
 
+    if (!createLljit()) {
+        return false;
+    }
+
+    // Compile each of the given codes as a separate module
+    // Note: each module is cached separately (see addModule()), so only the
+    //       modules which code has changed since they were last compiled need
+    //       to be compiled again...
+
+    for (const auto &code : pCodes) {
+        if (!addModule(code)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+
+bool CompilerEngine::addModule(const QString &pCode)
+{
     // Prepend all the external functions that may, or not, be needed by the
     // given code
 
@@ -166,6 +318,13 @@ extern double lcm_multi(int, ...);
     driver.setCheckInputsExist(false);
 
     // Get a compilation object to which we pass some arguments
+    // Note: on x86, we target the host CPU, so that loops (e.g. the one in an
+    //       ensemble version of a model's rates) can be vectorised using
+    //       AVX2/AVX-512, if available. Our ORC-based JIT targets the host CPU
+    //       too and so does our cached object code (see
+    //       cachedObjectFileName()). However, we don't want floating-point
+    //       contractions (i.e. FMA instructions), so that our results remain
+    //       the same as those obtained without targeting the host CPU...
 
     constexpr char const *DummyFileName = "dummy.c";
 
@@ -175,10 +334,38 @@ extern double lcm_multi(int, ...);
                                                       "-O0",
 #else
                                                       "-O3",
+    #if defined(Q_PROCESSOR_X86)
+                                                      "-march=native",
+                                                      "-ffp-contract=off",
+    #endif
 #endif
                                                       "-fno-math-errno",
                                                       DummyFileName};
 
+    // Check whether we have some cached object code for our code and, if so,
+    // use it rather than compile our code
+
+    QString objectFileName = cachedObjectFileName(code, compilationArguments);
+    QByteArray objectFileContents;
+
+    if (   !objectFileName.isEmpty()
+        && Core::readFile(objectFileName, objectFileContents)) {
+        if (!mLljit->addObjectFile(llvm::MemoryBuffer::getMemBufferCopy(llvm::StringRef(objectFileContents.constData(), size_t(objectFileContents.size()))))) {
+            // Let our object cache know that our cached object code has just
+            // been used
+
+            QFile(objectFileName).setFileTime(QDateTime::currentDateTime(),
+                                              QFileDevice::FileModificationTime);
+
+            return true;
+        }
+
+        // Our cached object code couldn't be used, so remove it and compile our
+        // code after all
+
+        QFile::remove(objectFileName);
+    }
+
     std::unique_ptr<clang::driver::Compilation> compilation(driver.BuildCompilation(compilationArguments));
 
     if (!compilation) {
@@ -266,6 +453,31 @@ extern double lcm_multi(int, ...);
         return false;
     }
 
+    // Add our LLVM bitcode module to our ORC-based JIT
+    // Note: we use the name of our cached object file, if any, as the
+    //       identifier of our module, so that our object cache can save the
+    //       object code for our module once it has been compiled...
+
+    if (!objectFileName.isEmpty()) {
+        module->setModuleIdentifier(objectFileName.toStdString());
+    }
+
+    auto llvmContext = std::make_unique<llvm::LLVMContext>();
+    auto threadSafeModule = llvm::orc::ThreadSafeModule(std::move(module), std::move(llvmContext));
+
+    if (mLljit->addIRModule(std::move(threadSafeModule))) {
+        mError = tr("the IR module could not be added to the ORC-based JIT");
+
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+
+bool CompilerEngine::createLljit()
+{
     // Initialise the native target (and its ASM printer), so not only can we
     // then create an execution engine, but more importantly its data layout
     // will match that of our target platform
@@ -275,8 +487,14 @@ extern double lcm_multi(int, ...);
 
     // Create an ORC-based JIT and keep track of it (so that we can use it in
     // function())
+    // Note: we use our own IR compiler, so that we can cache the object code
+    //       that it generates...
 
-    auto lljit = llvm::orc::LLJITBuilder().create();
+    static CompilerObjectCache objectCache;
+
+    auto lljit = llvm::orc::LLJITBuilder().setCompileFunctionCreator([](llvm::orc::JITTargetMachineBuilder pJitTargetMachineBuilder) -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+                                              return std::make_unique<llvm::orc::ConcurrentIRCompiler>(std::move(pJitTargetMachineBuilder), &objectCache);
+                                          }).create();
 
     if (!lljit) {
         mError = tr("the ORC-based JIT could not be created");
@@ -329,17 +547,6 @@ extern double lcm_multi(int, ...);
         return false;
     }
 
-    // Add our LLVM bitcode module to our ORC-based JIT
-
-    auto llvmContext = std::make_unique<llvm::LLVMContext>();
-    auto threadSafeModule = llvm::orc::ThreadSafeModule(std::move(module), std::move(llvmContext));
-
-    if (mLljit->addIRModule(std::move(threadSafeModule))) {
-        mError = tr("the IR module could not be added to the ORC-based JIT");
-
-        return false;
-    }
-
     return true;
 }
 
@@ -37,6 +37,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 #include <QObject>
 #include <QString>
+#include <QStringList>
 
 //==============================================================================
 
@@ -56,6 +57,7 @@ public:
     bool addFunction(const QString &pName, void *pFunction);
 
     bool compileCode(const QString &pCode);
+    bool compileCodes(const QStringList &pCodes);
 
     void * function(const QString &pName);
 
@@ -63,6 +65,9 @@ private:
     std::unique_ptr<llvm::orc::LLJIT> mLljit;
 
     QString mError;
+
+    bool createLljit();
+    bool addModule(const QString &pCode);
 };
 
 //==============================================================================
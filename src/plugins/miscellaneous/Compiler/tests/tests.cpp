@@ -37,6 +37,10 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 void Tests::initTestCase()
 {
+    // Make sure that our object code gets cached in a test location
+
+    QStandardPaths::setTestModeEnabled(true);
+
     // Create our compiler engine
 
     mCompilerEngine = new OpenCOR::Compiler::CompilerEngine();
@@ -126,6 +130,71 @@ void Tests::basicTests()
 
 //==============================================================================
 
+void Tests::cacheTests()
+{
+    // Compile some code that is unlikely to have been compiled before and make
+    // sure that we can retrieve and call our function, something that will
+    // result in its object code being cached
+
+    QDir cacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)+"/Compiler");
+    const QStringList objectFileFilters = { "*.o" };
+    int objectFilesCount = cacheDir.entryList(objectFileFilters, QDir::Files).count();
+    qint64 value = QDateTime::currentMSecsSinceEpoch();
+    QString code = QString("double function() { return %1.0; }").arg(value);
+
+    QVERIFY(mCompilerEngine->compileCode(code));
+    QVERIFY(mCompilerEngine->function("function") != nullptr);
+    QCOMPARE(reinterpret_cast<double (*)()>(mCompilerEngine->function("function"))(), double(value));
+
+    // Make sure that our object code has been cached and make it look like it
+    // hasn't been used for a while
+
+    const QFileInfoList objectFileInfos = cacheDir.entryInfoList(objectFileFilters, QDir::Files, QDir::Time);
+
+    QCOMPARE(objectFileInfos.count(), objectFilesCount+1);
+
+    QString objectFileName = objectFileInfos.first().absoluteFilePath();
+    QDateTime oldDateTime = QDateTime::currentDateTime().addDays(-1);
+
+    QVERIFY(QFile(objectFileName).setFileTime(oldDateTime, QFileDevice::FileModificationTime));
+
+    // Compile the same code using another compiler engine, which should now
+    // use our cached object code (rather than cache some new object code), and
+    // make sure that we get the same result
+
+    OpenCOR::Compiler::CompilerEngine compilerEngine;
+
+    QVERIFY(compilerEngine.compileCode(code));
+    QVERIFY(compilerEngine.function("function") != nullptr);
+    QCOMPARE(reinterpret_cast<double (*)()>(compilerEngine.function("function"))(), double(value));
+
+    QCOMPARE(cacheDir.entryList(objectFileFilters, QDir::Files).count(), objectFilesCount+1);
+    QVERIFY(QFileInfo(objectFileName).lastModified() > oldDateTime);
+}
+
+//==============================================================================
+
+void Tests::modulesTests()
+{
+    // Compile some code as several modules, one of which calls a function
+    // defined in another module
+
+    QVERIFY(mCompilerEngine->compileCodes({ "double function1() { return 3.0; }",
+                                            "extern double function1();\n"
+                                            "\n"
+                                            "double function2() { return 2.0*function1(); }" }));
+    QCOMPARE(reinterpret_cast<double (*)()>(mCompilerEngine->function("function1"))(), 3.0);
+    QCOMPARE(reinterpret_cast<double (*)()>(mCompilerEngine->function("function2"))(), 6.0);
+
+    // Check that an invalid module results in an error
+
+    QVERIFY(!mCompilerEngine->compileCodes({ "double function1() { return 3.0; }",
+                                             "double function2() { return 3.0*/a; }" }));
+    QVERIFY(mCompilerEngine->hasError());
+}
+
+//==============================================================================
+
 void Tests::voidFunctionTests()
 {
     std::array<double, 3> arrayA = {};
@@ -59,6 +59,8 @@ private slots:
     void cleanupTestCase();
 
     void basicTests();
+    void cacheTests();
+    void modulesTests();
 
     void voidFunctionTests();
 
@@ -123,11 +123,11 @@ File::Status File::check()
     // Retrieve our 'new' SHA-1 value and that of our dependencies (if any), and
     // check whether they are different from the one(s) we currently have
 
-    QString newSha1 = sha1();
+    QString newSha1 = checkedSha1(mFileName);
     QStringList newDependenciesSha1;
 
     for (const auto &dependency : qAsConst(mDependencies)) {
-        newDependenciesSha1 << sha1(dependency);
+        newDependenciesSha1 << checkedSha1(dependency);
     }
 
     if (newSha1.isEmpty()) {
@@ -149,6 +149,38 @@ File::Status File::check()
 
 //==============================================================================
 
+QString File::checkedSha1(const QString &pFileName)
+{
+    // Return the SHA-1 value of the given file, but only compute it if the
+    // file's last modification time, size or permissions have changed since we
+    // last checked it, i.e. most of the time, we only need to stat the file
+    // rather than read and hash it
+
+    QFileInfo fileInfo(pFileName);
+
+    if (!fileInfo.exists()) {
+        mStamps.remove(pFileName);
+
+        return {};
+    }
+
+    QDateTime lastModified = fileInfo.lastModified();
+    qint64 size = fileInfo.size();
+    QFileDevice::Permissions permissions = fileInfo.permissions();
+    auto stamp = mStamps.find(pFileName);
+
+    if (   (stamp == mStamps.end())
+        || (stamp->lastModified != lastModified) || (stamp->size != size)
+        || (stamp->permissions != permissions)) {
+        stamp = mStamps.insert(pFileName, { lastModified, size, permissions,
+                                            sha1(pFileName) });
+    }
+
+    return stamp->sha1;
+}
+
+//==============================================================================
+
 QString File::sha1(const QString &pFileName)
 {
     // Return the SHA-1 value of the given file
@@ -181,6 +213,8 @@ void File::reset(bool pResetDependencies)
         mDependencies.clear();
         mDependenciesSha1.clear();
 
+        mStamps.clear();
+
         mDependenciesModified = false;
     }
 }
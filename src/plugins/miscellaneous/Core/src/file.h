@@ -29,6 +29,9 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QDateTime>
+#include <QFileDevice>
+#include <QMap>
 #include <QStringList>
 
 //==============================================================================
@@ -109,10 +112,20 @@ public:
     bool setDependenciesModified(bool pDependenciesModified);
 
 private:
+    struct Stamp
+    {
+        QDateTime lastModified;
+        qint64 size;
+        QFileDevice::Permissions permissions;
+        QString sha1;
+    };
+
     QString mFileName;
     QString mUrl;
     QString mSha1;
 
+    QMap<QString, Stamp> mStamps;
+
     int mNewIndex;
 
     bool mModified = false;
@@ -121,6 +134,8 @@ private:
     QStringList mDependenciesSha1;
 
     bool mDependenciesModified = false;
+
+    QString checkedSha1(const QString &pFileName);
 };
 
 //==============================================================================
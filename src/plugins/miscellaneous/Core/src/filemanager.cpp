@@ -28,7 +28,11 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include <QApplication>
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSet>
 #include <QTimer>
 #include <QWindow>
 
@@ -39,17 +43,35 @@ namespace Core {
 
 //==============================================================================
 
+static const int CheckFilesDelay = 100;
+static const int PollFilesInterval = 1000;
+
+//==============================================================================
+
 FileManager::FileManager()
 {
-    // Create our timer
+    // Create our timer and file system watcher
+    // Note: our timer is single shot since we only check our files when our
+    //       file system watcher tells us that something has changed, and we do
+    //       so with a small delay since a file being saved may result in
+    //       several notifications...
 
     mTimer = new QTimer(this);
+    mWatcher = new QFileSystemWatcher(this);
 
-    // A connection to handle the timing out of our timer
+    mTimer->setSingleShot(true);
+
+    // Some connections to handle the timing out of our timer and the changes
+    // reported by our file system watcher
 
     connect(mTimer, &QTimer::timeout,
             this, &FileManager::checkFiles);
 
+    connect(mWatcher, &QFileSystemWatcher::fileChanged,
+            this, &FileManager::fileSystemChanged);
+    connect(mWatcher, &QFileSystemWatcher::directoryChanged,
+            this, &FileManager::fileSystemChanged);
+
     // Keep track of when OpenCOR gets/loses the focus
 
     if (qobject_cast<QGuiApplication *>(QCoreApplication::instance()) != nullptr) {
@@ -71,20 +93,24 @@ FileManager::~FileManager()
 
 //==============================================================================
 
-void FileManager::startStopTimer()
+void FileManager::startStopChecking()
 {
-    // Start our timer if OpenCOR is active and we have files, or stop it if
-    // either OpenCOR is not active or we don't have files anymore
-    // Note #1: if we are to start our timer, then we check files first since
-    //          waiting one second may seem long to a user (when some files have
-    //          changed and after having reactivated OpenCOR)...
+    // Start checking our files if OpenCOR is active and we have files, or stop
+    // checking them if either OpenCOR is not active or we don't have files
+    // anymore
+    // Note #1: if we are to start checking our files, then we check all of them
+    //          straightaway since they may have changed while OpenCOR was not
+    //          active, and our file system watcher would have told us about it
+    //          while we were not checking our files...
     // Note #2: checking files may result in a message box being shown and,
     //          therefore, in a focusWindowChanged() signal being emitted. To
     //          handle that signal would result in reentry, so we temporarily
     //          disable our handling of it...
 
-    if (   !mTimer->isActive()
+    if (   !mCheckingFiles
         &&  opencorActive() && !mFiles.isEmpty()) {
+        mCheckingFiles = true;
+
         disconnect(qApp, &QApplication::focusWindowChanged,
                    this, &FileManager::focusWindowChanged);
 
@@ -92,16 +118,65 @@ void FileManager::startStopTimer()
 
         connect(qApp, &QApplication::focusWindowChanged,
                 this, &FileManager::focusWindowChanged);
-
-        mTimer->start(1000);
-    } else if (   mTimer->isActive()
+    } else if (   mCheckingFiles
                && (!opencorActive() || mFiles.isEmpty())) {
+        mCheckingFiles = false;
+
         mTimer->stop();
     }
 }
 
 //==============================================================================
 
+void FileManager::updateWatchedPaths()
+{
+    // Watch our local files and their dependencies, as well as the directories
+    // in which they are
+    // Note: we watch those directories since some editors save a file by
+    //       writing a new file and then renaming it, in which case our file
+    //       system watcher stops watching the original file. This also means
+    //       that we get to know when a deleted file gets recreated. Then, if
+    //       some paths cannot be watched (e.g. because we have reached the
+    //       system's limit), then we fall back to polling our files, which is
+    //       cheap since a file only gets rehashed if it looks like it has
+    //       changed (see File::check())...
+
+    QSet<QString> paths;
+
+    for (auto file : qAsConst(mFiles)) {
+        if (!file->isLocal()) {
+            continue;
+        }
+
+        const QStringList fileNames = QStringList() << file->fileName() << file->dependencies();
+
+        for (const auto &fileName : fileNames) {
+            QFileInfo fileInfo(fileName);
+            QDir dir = fileInfo.absoluteDir();
+
+            if (fileInfo.exists()) {
+                paths << fileInfo.absoluteFilePath();
+            }
+
+            if (dir.exists()) {
+                paths << dir.absolutePath();
+            }
+        }
+    }
+
+    QSet<QString> watchedPaths = QSet<QString>::fromList(mWatcher->files()+mWatcher->directories());
+    QStringList oldPaths = (watchedPaths-paths).values();
+    QStringList newPaths = (paths-watchedPaths).values();
+
+    if (!oldPaths.isEmpty()) {
+        mWatcher->removePaths(oldPaths);
+    }
+
+    mPollingFiles = !newPaths.isEmpty() && !mWatcher->addPaths(newPaths).isEmpty();
+}
+
+//==============================================================================
+
 FileManager * FileManager::instance()
 {
     // Return the 'global' instance of our file manager class
@@ -136,7 +211,8 @@ FileManager::Status FileManager::manage(const QString &pFileName,
 
         mFileNameFiles.insert(fileName, file);
 
-        startStopTimer();
+        updateWatchedPaths();
+        startStopChecking();
 
         emit fileManaged(fileName);
 
@@ -163,7 +239,8 @@ FileManager::Status FileManager::unmanage(const QString &pFileName)
 
         delete file;
 
-        startStopTimer();
+        updateWatchedPaths();
+        startStopChecking();
 
         emit fileUnmanaged(fileName);
 
@@ -365,6 +442,8 @@ void FileManager::makeNew(const QString &pFileName)
 
         if (newFile(fileName)) {
             file->makeNew(fileName);
+
+            updateWatchedPaths();
         }
     }
 }
@@ -509,8 +588,8 @@ void FileManager::setDependencies(const QString &pFileName,
 
     File *file = FileManager::file(canonicalFileName(pFileName));
 
-    if (file != nullptr) {
-        file->setDependencies(pDependencies);
+    if ((file != nullptr) && file->setDependencies(pDependencies)) {
+        updateWatchedPaths();
     }
 }
 
@@ -626,6 +705,8 @@ FileManager::Status FileManager::rename(const QString &pOldFileName,
             mFileNameFiles.insert(newFileName, file);
             mFileNameFiles.remove(oldFileName);
 
+            updateWatchedPaths();
+
             emit fileRenamed(oldFileName, newFileName);
 
             return Status::Renamed;
@@ -727,9 +808,21 @@ void FileManager::setCheckFilesEnabled(bool pCheckFilesEnabled)
 
 void FileManager::focusWindowChanged()
 {
-    // Start/stop our timer
+    // Start/stop checking our files
 
-    startStopTimer();
+    startStopChecking();
+}
+
+//==============================================================================
+
+void FileManager::fileSystemChanged()
+{
+    // Something has changed in the file system, so check our files, if we are
+    // checking them, once things have settled down
+
+    if (mCheckingFiles) {
+        mTimer->start(CheckFilesDelay);
+    }
 }
 
 //==============================================================================
@@ -737,13 +830,20 @@ void FileManager::focusWindowChanged()
 void FileManager::checkFiles()
 {
     // Make sure that OpenCOR is active
-    // Note: indeed, although we try our best to enable/disable our timer as
-    //       needed, there are cases (e.g. a QFileDialog is opened) that don't
-    //       result in the focusWindowChanged() signal being emitted, which
-    //       means that we can't enable/disable our timer in those cases, hence
-    //       our checking that OpenCOR is really active indeed...
+    // Note: indeed, although we try our best to start/stop checking our files
+    //       as needed, there are cases (e.g. a QFileDialog is opened) that
+    //       don't result in the focusWindowChanged() signal being emitted,
+    //       which means that we can't start/stop checking our files in those
+    //       cases, hence our checking that OpenCOR is really active indeed...
 
     if (!opencorActive() || !mCheckFilesEnabled) {
+        // We cannot check our files right now, so try again later, if we are
+        // still checking them
+
+        if (mCheckingFiles) {
+            mTimer->start(PollFilesInterval);
+        }
+
         return;
     }
 
@@ -786,6 +886,16 @@ void FileManager::checkFiles()
             emit fileDeleted(fileName);
         }
     }
+
+    // Make sure that we are (still) watching all the paths we should be
+    // watching (e.g. a file that was deleted may have been recreated since)
+    // and poll our files, if we cannot watch all of them
+
+    updateWatchedPaths();
+
+    if (mCheckingFiles && mPollingFiles) {
+        mTimer->start(PollFilesInterval);
+    }
 }
 
 //==============================================================================
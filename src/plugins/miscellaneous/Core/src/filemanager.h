@@ -35,6 +35,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+class QFileSystemWatcher;
 class QTimer;
 
 //==============================================================================
@@ -150,6 +151,7 @@ public:
 
 private:
     QTimer *mTimer;
+    QFileSystemWatcher *mWatcher;
 
     QList<File *> mFiles;
     QMap<QString, File *> mFileNameFiles;
@@ -159,7 +161,12 @@ private:
 
     bool mCheckFilesEnabled = true;
 
-    void startStopTimer();
+    bool mCheckingFiles = false;
+    bool mPollingFiles = false;
+
+    void startStopChecking();
+
+    void updateWatchedPaths();
 
     bool newFile(QString &pFileName,
                  const QByteArray &pContents = {});
@@ -188,6 +195,8 @@ signals:
 private slots:
     void focusWindowChanged();
 
+    void fileSystemChanged();
+
     void checkFiles();
 };
 
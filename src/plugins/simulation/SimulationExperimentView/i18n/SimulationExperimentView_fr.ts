@@ -596,6 +596,10 @@
         <source>the model needs an ODE solver, but none is available</source>
         <translation>le modèle a besoin d&apos;un solveur EDO, mais aucun n&apos;est disponible</translation>
     </message>
+    <message>
+        <source>only SED-ML files that execute one or two simulations once can be run from the Simulation Experiment view</source>
+        <translation>seulement les fichiers SED-ML qui exécutent une ou deux simulations une fois peuvent être exécutés depuis la vue Expérience de Simulation</translation>
+    </message>
     <message>
         <source>Save File</source>
         <translation>Sauvegarder Fichier</translation>
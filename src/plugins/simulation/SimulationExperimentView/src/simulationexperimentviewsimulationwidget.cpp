@@ -1139,11 +1139,26 @@ void SimulationExperimentViewSimulationWidget::initialize(bool pReloading)
         // not dealing with a CellML file
 
         if (mValidSimulationEnvironment && (isSedmlFile || isCombineArchive)) {
+            // Make sure that our SED-ML file simply runs our simulation(s) once
+            // since we would otherwise run it once and ignore its ranges, task
+            // changes and repeated sub-tasks
+            // Note: such a SED-ML file can still be run from Python (see
+            //       SimulationSupport::SimulationRepeatedTask)...
+
+            if (!mSimulation->sedmlFile()->runsOnce()) {
+                simulationError(tr("only SED-ML files that execute one or two simulations once can be run from the Simulation Experiment view"),
+                                Error::InvalidSimulationEnvironment);
+
+                mValidSimulationEnvironment = false;
+            }
+
             // Further initialise ourselves, update our GUI (by reinitialising
             // it) and initialise our simulation, if we still have a valid
             // simulation environment
 
-            mValidSimulationEnvironment = furtherInitialize();
+            if (mValidSimulationEnvironment) {
+                mValidSimulationEnvironment = furtherInitialize();
+            }
 
             initializeGui(mValidSimulationEnvironment);
 
@@ -3866,33 +3881,21 @@ void SimulationExperimentViewSimulationWidget::updateSimulationResults(Simulatio
                     // current viewport, but only if the user hasn't changed the
                     // plot's viewport since we last came here (e.g. by panning
                     // the plot's contents)
+                    // Note: our graph keeps track of the rectangle that
+                    //       contains the valid data of its run (that rectangle
+                    //       has a negative width if there is no valid data),
+                    //       so we check that rectangle rather than our graph
+                    //       segment. This is equivalent since our plot's
+                    //       current viewport contains the rest of our run...
 
-                    if (!hasDirtyAxes) {
-                        double minX = plotMinX;
-                        double maxX = plotMaxX;
-                        double minY = plotMinY;
-                        double maxY = plotMaxY;
-                        auto graphData = graph->data(pSimulationRun);
-
-                        for (quint64 i = (oldDataSize != 0)?oldDataSize-1:0; i < pSimulationResultsSize; ++i) {
-                            auto val = graphData->sample(i);
-                            auto valX = val.x();
-                            auto valY = val.y();
-
-                            if (   !qIsInf(valX) && !qIsNaN(valX)
-                                && !qIsInf(valY) && !qIsNaN(valY)) {
-                                minX = qMin(minX, valX);
-                                maxX = qMax(maxX, valX);
-                                minY = qMin(minY, valY);
-                                maxY = qMax(maxY, valY);
-                            }
-                        }
+                    QRectF dataRect = graph->dataRect(pSimulationRun);
 
+                    if (!hasDirtyAxes && (dataRect.width() >= 0.0)) {
                         // Update our plot, if our graph segment cannot fit
                         // within our plot's current viewport
 
-                        needFullUpdatePlot =    (minX < plotMinX) || (maxX > plotMaxX)
-                                             || (minY < plotMinY) || (maxY > plotMaxY);
+                        needFullUpdatePlot =    (dataRect.left() < plotMinX) || (dataRect.right() > plotMaxX)
+                                             || (dataRect.top() < plotMinY) || (dataRect.bottom() > plotMaxY);
                     }
 
                     if (!needFullUpdatePlot) {
@@ -22,6 +22,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include "cvodesolver.h"
+#include "sparselinearsolver.h"
 
 //==============================================================================
 
@@ -30,6 +31,9 @@ along with this program. If not, see <https://gnu.org/licenses>.
     #include "cvodes/cvodes_bandpre.h"
     #include "cvodes/cvodes_diag.h"
     #include "nvector/nvector_serial.h"
+    #include "sunmatrix/sunmatrix_band.h"
+    #include "sunmatrix/sunmatrix_dense.h"
+    #include "sunmatrix/sunmatrix_sparse.h"
     #include "sunlinsol/sunlinsol_band.h"
     #include "sunlinsol/sunlinsol_dense.h"
     #include "sunlinsol/sunlinsol_spbcgs.h"
@@ -61,6 +65,76 @@ int rhsFunction(double pVoi, N_Vector pStates, N_Vector pRates, void *pUserData)
 
 //==============================================================================
 
+static int jacobianFunction(double pVoi, N_Vector pStates, N_Vector pRates,
+                            SUNMatrix pJacobian, void *pUserData, N_Vector pTemp1,
+                            N_Vector pTemp2, N_Vector pTemp3)
+{
+    Q_UNUSED(pRates)
+    Q_UNUSED(pTemp2)
+    Q_UNUSED(pTemp3)
+
+    // Compute the non-zero entries of our Jacobian
+    // Note: our first temporary vector is used to hold the rates that get
+    //       computed as part of our Jacobian function...
+
+    auto userData = static_cast<CvodeSolverUserData *>(pUserData);
+    double *jacobian = userData->jacobian();
+
+    userData->computeJacobian()(pVoi, userData->constants(),
+                                N_VGetArrayPointer_Serial(pTemp1),
+                                N_VGetArrayPointer_Serial(pStates),
+                                userData->algebraic(), jacobian);
+
+    // Copy the non-zero entries of our Jacobian, which uses the compressed
+    // sparse column (CSC) format, to the given sparse matrix (after having
+    // reallocated it, if needed) or dense/banded matrix
+    // Note: in the case of a banded matrix, we skip any entry that lies outside
+    //       of its band, just like CVODES does when approximating the
+    //       Jacobian...
+
+    const QVector<int> &columnPointers = userData->jacobianColumnPointers();
+    const QVector<int> &rowIndices = userData->jacobianRowIndices();
+
+    if (SUNMatGetID(pJacobian) == SUNMATRIX_SPARSE) {
+        int nonZeroCount = rowIndices.count();
+
+        if (SUNSparseMatrix_NNZ(pJacobian) < nonZeroCount) {
+            SUNSparseMatrix_Reallocate(pJacobian, nonZeroCount);
+        }
+
+        std::copy(columnPointers.constBegin(), columnPointers.constEnd(),
+                  SUNSparseMatrix_IndexPointers(pJacobian));
+        std::copy(rowIndices.constBegin(), rowIndices.constEnd(),
+                  SUNSparseMatrix_IndexValues(pJacobian));
+        std::copy(jacobian, jacobian+nonZeroCount,
+                  SUNSparseMatrix_Data(pJacobian));
+
+        return 0;
+    }
+
+    SUNMatZero(pJacobian);
+
+    bool denseMatrix = SUNMatGetID(pJacobian) == SUNMATRIX_DENSE;
+    int columnsCount = columnPointers.count()-1;
+
+    for (int column = 0; column < columnsCount; ++column) {
+        for (int i = columnPointers[column], iMax = columnPointers[column+1]; i < iMax; ++i) {
+            int row = rowIndices[i];
+
+            if (denseMatrix) {
+                SM_ELEMENT_D(pJacobian, row, column) = jacobian[i];
+            } else if (   (row-column <= SM_LBAND_B(pJacobian))
+                       && (column-row <= SM_UBAND_B(pJacobian))) {
+                SM_ELEMENT_B(pJacobian, row, column) = jacobian[i];
+            }
+        }
+    }
+
+    return 0;
+}
+
+//==============================================================================
+
 void errorHandler(int pErrorCode, const char *pModule, const char *pFunction,
                   char *pErrorMessage, void *pUserData)
 {
@@ -77,10 +151,17 @@ void errorHandler(int pErrorCode, const char *pModule, const char *pFunction,
 //==============================================================================
 
 CvodeSolverUserData::CvodeSolverUserData(double *pConstants, double *pAlgebraic,
-                                         Solver::OdeSolver::ComputeRatesFunction pComputeRates) :
+                                         Solver::OdeSolver::ComputeRatesFunction pComputeRates,
+                                         Solver::OdeSolver::ComputeJacobianFunction pComputeJacobian,
+                                         const QVector<int> &pJacobianColumnPointers,
+                                         const QVector<int> &pJacobianRowIndices) :
     mConstants(pConstants),
     mAlgebraic(pAlgebraic),
-    mComputeRates(pComputeRates)
+    mComputeRates(pComputeRates),
+    mComputeJacobian(pComputeJacobian),
+    mJacobianColumnPointers(pJacobianColumnPointers),
+    mJacobianRowIndices(pJacobianRowIndices),
+    mJacobian(pJacobianRowIndices.count())
 {
 }
 
@@ -113,6 +194,42 @@ Solver::OdeSolver::ComputeRatesFunction CvodeSolverUserData::computeRates() cons
 
 //==============================================================================
 
+Solver::OdeSolver::ComputeJacobianFunction CvodeSolverUserData::computeJacobian() const
+{
+    // Return our compute Jacobian function
+
+    return mComputeJacobian;
+}
+
+//==============================================================================
+
+const QVector<int> & CvodeSolverUserData::jacobianColumnPointers() const
+{
+    // Return the column pointers of our Jacobian
+
+    return mJacobianColumnPointers;
+}
+
+//==============================================================================
+
+const QVector<int> & CvodeSolverUserData::jacobianRowIndices() const
+{
+    // Return the row indices of our Jacobian
+
+    return mJacobianRowIndices;
+}
+
+//==============================================================================
+
+double * CvodeSolverUserData::jacobian()
+{
+    // Return our Jacobian values
+
+    return mJacobian.data();
+}
+
+//==============================================================================
+
 CvodeSolver::~CvodeSolver()
 {
     // Make sure that the solver has been initialised
@@ -314,7 +431,10 @@ void CvodeSolver::initialize(double pVoi, int pRatesStatesCount,
 
     // Set our user data
 
-    mUserData = new CvodeSolverUserData(pConstants, pAlgebraic, pComputeRates);
+    mUserData = new CvodeSolverUserData(pConstants, pAlgebraic, pComputeRates,
+                                        mComputeJacobian,
+                                        mJacobianColumnPointers,
+                                        mJacobianRowIndices);
 
     CVodeSetUserData(mSolver, mUserData);
 
@@ -327,21 +447,48 @@ void CvodeSolver::initialize(double pVoi, int pRatesStatesCount,
     CVodeSetMaxNumSteps(mSolver, maximumNumberOfSteps);
 
     // Set our linear solver, if needed
+    // Note: CVODES cannot approximate a sparse Jacobian, so we fall back to a
+    //       dense linear solver if the model doesn't provide its Jacobian...
 
     if (newtonIteration) {
+        if (   (linearSolver == SparseLinearSolver)
+            && (mComputeJacobian == nullptr)) {
+            linearSolver = DenseLinearSolver;
+        }
+
         if (linearSolver == DenseLinearSolver) {
             mMatrix = SUNDenseMatrix(pRatesStatesCount, pRatesStatesCount, context);
             mLinearSolver = SUNLinSol_Dense(mStatesVector, mMatrix, context);
 
             CVodeSetLinearSolver(mSolver, mLinearSolver, mMatrix);
+
+            if (mComputeJacobian != nullptr) {
+                CVodeSetJacFn(mSolver, jacobianFunction);
+            }
         } else if (linearSolver == BandedLinearSolver) {
             mMatrix = SUNBandMatrix(pRatesStatesCount, upperHalfBandwidth,
                                                        lowerHalfBandwidth, context);
             mLinearSolver = SUNLinSol_Band(mStatesVector, mMatrix, context);
 
             CVodeSetLinearSolver(mSolver, mLinearSolver, mMatrix);
+
+            if (mComputeJacobian != nullptr) {
+                CVodeSetJacFn(mSolver, jacobianFunction);
+            }
         } else if (linearSolver == DiagonalLinearSolver) {
             CVDiag(mSolver);
+        } else if (linearSolver == SparseLinearSolver) {
+            // Note: we leave room for the diagonal entries that CVODES adds to
+            //       our Jacobian when computing I-gamma*J, in case they are
+            //       not already in it...
+
+            mMatrix = SUNSparseMatrix(pRatesStatesCount, pRatesStatesCount,
+                                      mJacobianRowIndices.count()+pRatesStatesCount,
+                                      CSC_MAT, context);
+            mLinearSolver = SUNDIALS::sparseLinearSolver(mStatesVector, mMatrix, context);
+
+            CVodeSetLinearSolver(mSolver, mLinearSolver, mMatrix);
+            CVodeSetJacFn(mSolver, jacobianFunction);
         } else {
             // We are dealing with a GMRES/Bi-CGStab/TFQMR linear solver
 
@@ -420,6 +567,43 @@ void CvodeSolver::solve(double &pVoi, double pVoiEnd) const
 
 //==============================================================================
 
+bool CvodeSolver::supportsOneStep() const
+{
+    // We can take one internal step at a time
+
+    return true;
+}
+
+//==============================================================================
+
+void CvodeSolver::solveOneStep(double &pVoi, double pVoiEnd) const
+{
+    // Take one internal step, without going past the given end point
+    // Note #1: unlike in solve(), we always need a stop time since CVODE would
+    //          otherwise happily step past our end point...
+    // Note #2: as in solve(), we compute our rate values ourselves, but over
+    //          the step that was actually taken...
+
+    auto oldStates = mRates;
+    double oldVoi = pVoi;
+
+    std::copy(mStates, mStates + mRatesStatesCount, oldStates);
+
+    CVodeSetStopTime(mSolver, pVoiEnd);
+
+    CVode(mSolver, pVoiEnd, mStatesVector, &pVoi, CV_ONE_STEP);
+
+    if (pVoi > oldVoi) {
+        auto oneOverdVoi = 1.0 / (pVoi - oldVoi);
+
+        for (int i = 0; i < mRatesStatesCount; ++i) {
+            mRates[i] = oneOverdVoi * (mStates[i] - oldStates[i]);
+        }
+    }
+}
+
+//==============================================================================
+
 } // namespace CVODESolver
 } // namespace OpenCOR
 
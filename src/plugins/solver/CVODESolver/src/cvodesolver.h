@@ -69,6 +69,7 @@ static const auto NewtonIteration     = QStringLiteral("Newton");
 static const auto DenseLinearSolver    = QStringLiteral("Dense");
 static const auto BandedLinearSolver   = QStringLiteral("Banded");
 static const auto DiagonalLinearSolver = QStringLiteral("Diagonal");
+static const auto SparseLinearSolver   = QStringLiteral("Sparse");
 static const auto GmresLinearSolver    = QStringLiteral("GMRES");
 static const auto BiCgStabLinearSolver = QStringLiteral("BiCGStab");
 static const auto TfqmrLinearSolver    = QStringLiteral("TFQMR");
@@ -113,18 +114,33 @@ class CvodeSolverUserData
 {
 public:
     explicit CvodeSolverUserData(double *pConstants, double *pAlgebraic,
-                                 Solver::OdeSolver::ComputeRatesFunction pComputeRates);
+                                 Solver::OdeSolver::ComputeRatesFunction pComputeRates,
+                                 Solver::OdeSolver::ComputeJacobianFunction pComputeJacobian,
+                                 const QVector<int> &pJacobianColumnPointers,
+                                 const QVector<int> &pJacobianRowIndices);
 
     double * constants() const;
     double * algebraic() const;
 
     Solver::OdeSolver::ComputeRatesFunction computeRates() const;
+    Solver::OdeSolver::ComputeJacobianFunction computeJacobian() const;
+
+    const QVector<int> & jacobianColumnPointers() const;
+    const QVector<int> & jacobianRowIndices() const;
+
+    double * jacobian();
 
 private:
     double *mConstants;
     double *mAlgebraic;
 
     Solver::OdeSolver::ComputeRatesFunction mComputeRates;
+    Solver::OdeSolver::ComputeJacobianFunction mComputeJacobian;
+
+    QVector<int> mJacobianColumnPointers;
+    QVector<int> mJacobianRowIndices;
+
+    QVector<double> mJacobian;
 };
 
 //==============================================================================
@@ -143,6 +159,9 @@ public:
 
     void solve(double &pVoi, double pVoiEnd) const override;
 
+    bool supportsOneStep() const override;
+    void solveOneStep(double &pVoi, double pVoiEnd) const override;
+
 private:
     void *mSolver = nullptr;
 
@@ -273,6 +273,7 @@ Solver::Properties CVODESolverPlugin::solverProperties() const
                                                           DenseLinearSolver,
                                                           BandedLinearSolver,
                                                           DiagonalLinearSolver,
+                                                          SparseLinearSolver,
                                                           GmresLinearSolver,
                                                           BiCgStabLinearSolver,
                                                           TfqmrLinearSolver
@@ -312,8 +313,9 @@ QMap<QString, bool> CVODESolverPlugin::solverPropertiesVisibility(const QMap<QSt
         QString linearSolver = pSolverPropertiesValues.value(LinearSolverId);
 
         if (   (linearSolver == DenseLinearSolver)
-            || (linearSolver == DiagonalLinearSolver)) {
-            // Dense/diagonal linear solver
+            || (linearSolver == DiagonalLinearSolver)
+            || (linearSolver == SparseLinearSolver)) {
+            // Dense/diagonal/sparse linear solver
 
             res.insert(PreconditionerId, false);
             res.insert(UpperHalfBandwidthId, false);
@@ -71,11 +71,11 @@ void ForwardEulerSolver::solve(double &pVoi, double pVoiEnd) const
 
         // Compute f(t_n, Y_n)
 
-        mComputeRates(pVoi, mConstants, mRates, mStates, mAlgebraic);
+        computeRates(pVoi, mStates);
 
         // Compute Y_n+1
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
+        for (int i = 0; i < mValuesCount; ++i) {
             mStates[i] += realStep*mRates[i];
         }
 
@@ -91,6 +91,15 @@ void ForwardEulerSolver::solve(double &pVoi, double pVoiEnd) const
 
 //==============================================================================
 
+bool ForwardEulerSolver::supportsEnsemble() const
+{
+    // Our Y_n+1 is computed element-wise, so we can support ensembles
+
+    return true;
+}
+
+//==============================================================================
+
 } // namespace ForwardEulerSolver
 } // namespace OpenCOR
 
@@ -68,9 +68,9 @@ void FourthOrderRungeKuttaSolver::initialize(double pVoi, int pRatesStatesCount,
     delete[] mK23;
     delete[] mYk123;
 
-    mK1 = new double[pRatesStatesCount] {};
-    mK23 = new double[pRatesStatesCount] {};
-    mYk123 = new double[pRatesStatesCount] {};
+    mK1 = new double[mValuesCount] {};
+    mK23 = new double[mValuesCount] {};
+    mYk123 = new double[mValuesCount] {};
 }
 
 //==============================================================================
@@ -105,44 +105,44 @@ void FourthOrderRungeKuttaSolver::solve(double &pVoi, double pVoiEnd) const
 
         // Compute f(t_n, Y_n)
 
-        mComputeRates(pVoi, mConstants, mRates, mStates, mAlgebraic);
+        computeRates(pVoi, mStates);
 
         // Compute k1 and Yk1
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
+        for (int i = 0; i < mValuesCount; ++i) {
             mK1[i] = mRates[i];
             mYk123[i] = mStates[i]+realHalfStep*mK1[i];
         }
 
         // Compute f(t_n + h / 2, Y_n + k1 / 2)
 
-        mComputeRates(pVoi+realHalfStep, mConstants, mRates, mYk123, mAlgebraic);
+        computeRates(pVoi+realHalfStep, mYk123);
 
         // Compute k2 and Yk2
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
+        for (int i = 0; i < mValuesCount; ++i) {
             mK23[i] = mRates[i];
             mYk123[i] = mStates[i]+realHalfStep*mK23[i];
         }
 
         // Compute f(t_n + h / 2, Y_n + k2 / 2)
 
-        mComputeRates(pVoi+realHalfStep, mConstants, mRates, mYk123, mAlgebraic);
+        computeRates(pVoi+realHalfStep, mYk123);
 
         // Compute k3 and Yk3
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
+        for (int i = 0; i < mValuesCount; ++i) {
             mK23[i] += mRates[i];
             mYk123[i] = mStates[i]+realStep*mK23[i];
         }
 
         // Compute f(t_n + h, Y_n + k3)
 
-        mComputeRates(pVoi+realStep, mConstants, mRates, mYk123, mAlgebraic);
+        computeRates(pVoi+realStep, mYk123);
 
         // Compute k4 and therefore Y_n+1
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
+        for (int i = 0; i < mValuesCount; ++i) {
             mStates[i] += realStep*(OneOverSix*(mK1[i]+mRates[i])+OneOverThree*mK23[i]);
         }
 
@@ -158,6 +158,16 @@ void FourthOrderRungeKuttaSolver::solve(double &pVoi, double pVoiEnd) const
 
 //==============================================================================
 
+bool FourthOrderRungeKuttaSolver::supportsEnsemble() const
+{
+    // We support ensembles (our various k's and Y's are computed
+    // element-wise)
+
+    return true;
+}
+
+//==============================================================================
+
 } // namespace FourthOrderRungeKuttaSolver
 } // namespace OpenCOR
 
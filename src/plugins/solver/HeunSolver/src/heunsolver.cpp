@@ -65,8 +65,8 @@ void HeunSolver::initialize(double pVoi, int pRatesStatesCount,
     delete[] mK;
     delete[] mYk;
 
-    mK = new double[pRatesStatesCount] {};
-    mYk = new double[pRatesStatesCount] {};
+    mK = new double[mValuesCount] {};
+    mYk = new double[mValuesCount] {};
 }
 
 //==============================================================================
@@ -92,22 +92,22 @@ void HeunSolver::solve(double &pVoi, double pVoiEnd) const
 
         // Compute f(t_n, Y_n)
 
-        mComputeRates(pVoi, mConstants, mRates, mStates, mAlgebraic);
+        computeRates(pVoi, mStates);
 
         // Compute k and Yk
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
+        for (int i = 0; i < mValuesCount; ++i) {
             mK[i] = mRates[i];
             mYk[i] = mStates[i]+realStep*mRates[i];
         }
 
         // Compute f(t_n + h, Y_n + k)
 
-        mComputeRates(pVoi+realStep, mConstants, mRates, mYk, mAlgebraic);
+        computeRates(pVoi+realStep, mYk);
 
         // Compute Y_n+1
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
+        for (int i = 0; i < mValuesCount; ++i) {
             mStates[i] += realHalfStep*(mK[i]+mRates[i]);
         }
 
@@ -123,6 +123,16 @@ void HeunSolver::solve(double &pVoi, double pVoiEnd) const
 
 //==============================================================================
 
+bool HeunSolver::supportsEnsemble() const
+{
+    // k, Yk and Y_n+1 are all computed element-wise, so we can support
+    // ensembles
+
+    return true;
+}
+
+//==============================================================================
+
 } // namespace HeunSolver
 } // namespace OpenCOR
 
@@ -53,6 +53,8 @@ public:
                     double *pRates, double *pStates, double *pAlgebraic,
                     ComputeRatesFunction pComputeRates) override;
 
+    bool supportsEnsemble() const override;
+
     void solve(double &pVoi, double pVoiEnd) const override;
 
 private:
@@ -22,12 +22,23 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include "kinsolsolver.h"
+#include "sparselinearsolver.h"
+
+//==============================================================================
+
+#include <algorithm>
+#include <cfloat>
+
+//==============================================================================
+
+#include <QtMath>
 
 //==============================================================================
 
 #include "sundialsbegin.h"
     #include "kinsol/kinsol.h"
     #include "nvector/nvector_serial.h"
+    #include "sunmatrix/sunmatrix_sparse.h"
     #include "sunlinsol/sunlinsol_band.h"
     #include "sunlinsol/sunlinsol_dense.h"
     #include "sunlinsol/sunlinsol_spbcgs.h"
@@ -67,6 +78,220 @@ int systemFunction(N_Vector pY, N_Vector pF, void *pUserData)
 
 //==============================================================================
 
+static sunindextype updateJacobianPattern(KinsolSolverUserData *pUserData,
+                                          double *pY, double *pF, double *pPerturbedF,
+                                          sunindextype pSize)
+{
+    // Determine the sparsity pattern of our Jacobian, one column at a time,
+    // and then colour its columns so that columns that don't share a row can be
+    // approximated together
+    // Note: the pattern we determine is merged with our current one since an
+    //       entry that is currently zero may not be structurally so, meaning
+    //       that the pattern of our Jacobian may only grow. This ensures that
+    //       the sparse linear solver always sees the same structure (unless
+    //       we find a new entry, which should only happen early on)...
+
+    static const double SqrtEpsilon = qSqrt(DBL_EPSILON);
+
+    QVector<QVector<sunindextype>> &pattern = pUserData->jacobianPattern();
+    sunindextype nonZeroCount = 0;
+
+    pattern.resize(int(pSize));
+
+    for (sunindextype j = 0; j < pSize; ++j) {
+        double yj = pY[j];
+        double increment = SqrtEpsilon*qMax(qAbs(yj), 1.0);
+
+        pY[j] += increment;
+
+        pUserData->computeSystem()(pY, pPerturbedF, pUserData->userData());
+
+        pY[j] = yj;
+
+        QVector<sunindextype> &column = pattern[int(j)];
+
+        for (sunindextype i = 0; i < pSize; ++i) {
+            if (   (pPerturbedF[i] != pF[i])
+                && !std::binary_search(column.constBegin(), column.constEnd(), i)) {
+                column.insert(std::lower_bound(column.begin(), column.end(), i), i);
+            }
+        }
+
+        nonZeroCount += column.count();
+    }
+
+    // Colour the columns of our Jacobian using a greedy (Curtis-Powell-Reid)
+    // approach, i.e. give a column the first colour that is not used by a
+    // column that shares a row with it
+
+    QVector<int> &colors = pUserData->jacobianColors();
+    QVector<QVector<bool>> colorRows;
+
+    colors.resize(int(pSize));
+
+    for (sunindextype j = 0; j < pSize; ++j) {
+        const QVector<sunindextype> &column = pattern[int(j)];
+        int color = 0;
+
+        for (int colorsCount = colorRows.count(); color < colorsCount; ++color) {
+            const QVector<bool> &rows = colorRows[color];
+            bool available = true;
+
+            for (auto i : column) {
+                if (rows[int(i)]) {
+                    available = false;
+
+                    break;
+                }
+            }
+
+            if (available) {
+                break;
+            }
+        }
+
+        if (color == colorRows.count()) {
+            colorRows << QVector<bool>(int(pSize), false);
+        }
+
+        for (auto i : column) {
+            colorRows[color][int(i)] = true;
+        }
+
+        colors[int(j)] = color;
+    }
+
+    pUserData->setJacobianColorsCount(colorRows.count());
+
+    // Return the number of non-zero entries in our pattern
+
+    return nonZeroCount;
+}
+
+//==============================================================================
+
+static int jacobianFunction(N_Vector pY, N_Vector pF, SUNMatrix pJacobian,
+                            void *pUserData, N_Vector pTemp1, N_Vector pTemp2)
+{
+    // Approximate our Jacobian using forward differences and store it in the
+    // given sparse matrix (after having reallocated it, if needed)
+    // Note #1: KINSOL can only approximate dense/banded Jacobians, hence we
+    //          need to do it ourselves for sparse ones...
+    // Note #2: the sparsity pattern of our Jacobian is fixed (see
+    //          updateJacobianPattern()), so we can perturb all the columns of
+    //          a given colour at once, meaning that we need as many evaluations
+    //          of our system as there are colours rather than columns...
+
+    static const double SqrtEpsilon = qSqrt(DBL_EPSILON);
+
+    auto userData = static_cast<KinsolSolverUserData *>(pUserData);
+    double *y = N_VGetArrayPointer_Serial(pY);
+    double *f = N_VGetArrayPointer_Serial(pF);
+    double *perturbedF = N_VGetArrayPointer_Serial(pTemp1);
+    double *originalY = N_VGetArrayPointer_Serial(pTemp2);
+    sunindextype size = N_VGetLength_Serial(pY);
+
+    if (userData->jacobianPattern().isEmpty()) {
+        updateJacobianPattern(userData, y, f, perturbedF, size);
+    }
+
+    const QVector<QVector<sunindextype>> &pattern = userData->jacobianPattern();
+    const QVector<int> &colors = userData->jacobianColors();
+    QVector<int> rowColors(int(size));
+    bool checkPattern = true;
+
+    forever {
+        // Store the structure of our Jacobian
+
+        sunindextype *columnPointers = SUNSparseMatrix_IndexPointers(pJacobian);
+        sunindextype nonZeroCount = 0;
+
+        columnPointers[0] = 0;
+
+        for (sunindextype j = 0; j < size; ++j) {
+            nonZeroCount += pattern[int(j)].count();
+
+            columnPointers[j+1] = nonZeroCount;
+        }
+
+        if (nonZeroCount > SUNSparseMatrix_NNZ(pJacobian)) {
+            SUNSparseMatrix_Reallocate(pJacobian, nonZeroCount);
+        }
+
+        sunindextype *rowIndices = SUNSparseMatrix_IndexValues(pJacobian);
+        double *values = SUNSparseMatrix_Data(pJacobian);
+
+        for (sunindextype j = 0; j < size; ++j) {
+            std::copy(pattern[int(j)].constBegin(), pattern[int(j)].constEnd(),
+                      rowIndices+columnPointers[j]);
+        }
+
+        // Approximate our Jacobian, one colour at a time, and check that the
+        // perturbations don't affect a row that is not in our pattern, in
+        // which case our pattern is incomplete and needs updating
+
+        bool validPattern = true;
+
+        rowColors.fill(-1);
+
+        for (int color = 0, colorsCount = userData->jacobianColorsCount(); color < colorsCount; ++color) {
+            for (sunindextype j = 0; j < size; ++j) {
+                if (colors[int(j)] == color) {
+                    originalY[j] = y[j];
+
+                    y[j] += SqrtEpsilon*qMax(qAbs(y[j]), 1.0);
+
+                    for (auto i : pattern[int(j)]) {
+                        rowColors[int(i)] = color;
+                    }
+                }
+            }
+
+            userData->computeSystem()(y, perturbedF, userData->userData());
+
+            for (sunindextype j = 0; j < size; ++j) {
+                if (colors[int(j)] == color) {
+                    double increment = y[j]-originalY[j];
+
+                    y[j] = originalY[j];
+
+                    for (sunindextype k = columnPointers[j], kMax = columnPointers[j+1]; k < kMax; ++k) {
+                        values[k] = (perturbedF[rowIndices[k]]-f[rowIndices[k]])/increment;
+                    }
+                }
+            }
+
+            if (checkPattern) {
+                for (sunindextype i = 0; i < size; ++i) {
+                    if ((perturbedF[i] != f[i]) && (rowColors[int(i)] != color)) {
+                        validPattern = false;
+
+                        break;
+                    }
+                }
+
+                if (!validPattern) {
+                    break;
+                }
+            }
+        }
+
+        if (validPattern) {
+            return 0;
+        }
+
+        // Update our pattern and try again, without checking it if it didn't
+        // grow
+        // Note: this may happen if an entry only shows up when several columns
+        //       are perturbed at once (e.g. f[i] = y[j]*y[k] with y[j] and y[k]
+        //       both null), in which case we just use our current pattern...
+
+        checkPattern = updateJacobianPattern(userData, y, f, perturbedF, size) != nonZeroCount;
+    }
+}
+
+//==============================================================================
+
 void errorHandler(int pErrorCode, const char *pModule, const char *pFunction,
                   char *pErrorMessage, void *pUserData)
 {
@@ -109,6 +334,51 @@ void * KinsolSolverUserData::userData() const
 
 //==============================================================================
 
+void KinsolSolverUserData::setUserData(void *pUserData)
+{
+    // Set our user data
+
+    mUserData = pUserData;
+}
+
+//==============================================================================
+
+QVector<QVector<sunindextype>> & KinsolSolverUserData::jacobianPattern()
+{
+    // Return the sparsity pattern of our Jacobian
+
+    return mJacobianPattern;
+}
+
+//==============================================================================
+
+QVector<int> & KinsolSolverUserData::jacobianColors()
+{
+    // Return the colours of the columns of our Jacobian
+
+    return mJacobianColors;
+}
+
+//==============================================================================
+
+int KinsolSolverUserData::jacobianColorsCount() const
+{
+    // Return the number of colours used by the columns of our Jacobian
+
+    return mJacobianColorsCount;
+}
+
+//==============================================================================
+
+void KinsolSolverUserData::setJacobianColorsCount(int pJacobianColorsCount)
+{
+    // Set the number of colours used by the columns of our Jacobian
+
+    mJacobianColorsCount = pJacobianColorsCount;
+}
+
+//==============================================================================
+
 KinsolSolverData::KinsolSolverData(void *pSolver, N_Vector pParametersVector,
                                    N_Vector pOnesVector, SUNMatrix pMatrix,
                                    SUNLinearSolver pLinearSolver,
@@ -176,13 +446,15 @@ KinsolSolverUserData * KinsolSolverData::userData() const
 
 //==============================================================================
 
-void KinsolSolverData::setUserData(KinsolSolverUserData *pUserData)
+void KinsolSolverData::setSolved(bool pSolved)
 {
-    // Set our user data, after having delete our 'old' ones
-
-    delete mUserData;
+    // Let KINSOL know whether it can start from its current Jacobian
+    // information the next time round, i.e. whether it has just solved our
+    // system
+    // Note: if KINSOL finds that information to be out of date, it will update
+    //       it by itself...
 
-    mUserData = pUserData;
+    KINSetNoInitSetup(mSolver, pSolved?SUNTRUE:SUNFALSE);
 }
 
 //==============================================================================
@@ -310,6 +582,12 @@ void KinsolSolver::solve(ComputeSystemFunction pComputeSystem,
             linearSolver = SUNLinSol_Band(parametersVector, matrix, context);
 
             KINSetLinearSolver(solver, linearSolver, matrix);
+        } else if (linearSolverValue == SparseLinearSolver) {
+            matrix = SUNSparseMatrix(pSize, pSize, pSize, CSC_MAT, context);
+            linearSolver = SUNDIALS::sparseLinearSolver(parametersVector, matrix, context);
+
+            KINSetLinearSolver(solver, linearSolver, matrix);
+            KINSetJacFn(solver, jacobianFunction);
         } else if (linearSolverValue == GmresLinearSolver) {
             linearSolver = SUNLinSol_SPGMR(parametersVector, PREC_NONE, 0, context);
 
@@ -331,17 +609,24 @@ void KinsolSolver::solve(ComputeSystemFunction pComputeSystem,
 
         mData.insert(reinterpret_cast<void *>(pComputeSystem), data);
     } else {
-        // We are already initialised, so simply update our user data
+        // We are already initialised, so simply update our user data and the
+        // array that our parameters vector wraps
+        // Note: the given parameters are our initial guess, which is normally
+        //       our previous solution since the caller's array is where we
+        //       left it...
 
-        data->setUserData(new KinsolSolverUserData(pComputeSystem, pUserData));
+        data->userData()->setUserData(pUserData);
 
-        KINSetUserData(data->solver(), data->userData());
+        if (N_VGetArrayPointer_Serial(data->parametersVector()) != pParameters) {
+            N_VSetArrayPointer_Serial(pParameters, data->parametersVector());
+        }
     }
 
-    // Solve our linear system
+    // Solve our linear system and keep track of whether it got solved
 
-    KINSol(data->solver(), data->parametersVector(), KIN_LINESEARCH,
-           data->onesVector(), data->onesVector());
+    data->setSolved(KINSol(data->solver(), data->parametersVector(),
+                           KIN_LINESEARCH, data->onesVector(),
+                           data->onesVector()) >= 0);
 }
 
 //==============================================================================
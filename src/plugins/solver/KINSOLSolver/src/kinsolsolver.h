@@ -50,6 +50,7 @@ static const auto LowerHalfBandwidthId        = QStringLiteral("LowerHalfBandwid
 
 static const auto DenseLinearSolver    = QStringLiteral("Dense");
 static const auto BandedLinearSolver   = QStringLiteral("Banded");
+static const auto SparseLinearSolver   = QStringLiteral("Sparse");
 static const auto GmresLinearSolver    = QStringLiteral("GMRES");
 static const auto BiCgStabLinearSolver = QStringLiteral("BiCGStab");
 static const auto TfqmrLinearSolver    = QStringLiteral("TFQMR");
@@ -82,11 +83,23 @@ public:
     Solver::NlaSolver::ComputeSystemFunction computeSystem() const;
 
     void * userData() const;
+    void setUserData(void *pUserData);
+
+    QVector<QVector<sunindextype>> & jacobianPattern();
+
+    QVector<int> & jacobianColors();
+    int jacobianColorsCount() const;
+    void setJacobianColorsCount(int pJacobianColorsCount);
 
 private:
     Solver::NlaSolver::ComputeSystemFunction mComputeSystem;
 
     void *mUserData;
+
+    QVector<QVector<sunindextype>> mJacobianPattern;
+
+    QVector<int> mJacobianColors;
+    int mJacobianColorsCount = 0;
 };
 
 //==============================================================================
@@ -106,7 +119,8 @@ public:
     N_Vector onesVector() const;
 
     KinsolSolverUserData * userData() const;
-    void setUserData(KinsolSolverUserData *pUserData);
+
+    void setSolved(bool pSolved);
 
 private:
     void *mSolver;
@@ -173,6 +173,7 @@ Solver::Properties KINSOLSolverPlugin::solverProperties() const
     static const QStringList LinearSolverListValues = {
                                                           DenseLinearSolver,
                                                           BandedLinearSolver,
+                                                          SparseLinearSolver,
                                                           GmresLinearSolver,
                                                           BiCgStabLinearSolver,
                                                           TfqmrLinearSolver
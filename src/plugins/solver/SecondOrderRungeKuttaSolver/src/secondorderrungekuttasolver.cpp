@@ -64,7 +64,7 @@ void SecondOrderRungeKuttaSolver::initialize(double pVoi, int pRatesStatesCount,
 
     delete[] mYk1;
 
-    mYk1 = new double[pRatesStatesCount] {};
+    mYk1 = new double[mValuesCount] {};
 }
 
 //==============================================================================
@@ -94,21 +94,21 @@ void SecondOrderRungeKuttaSolver::solve(double &pVoi, double pVoiEnd) const
 
         // Compute f(t_n, Y_n)
 
-        mComputeRates(pVoi, mConstants, mRates, mStates, mAlgebraic);
+        computeRates(pVoi, mStates);
 
         // Compute k1 and therefore Yk1
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
+        for (int i = 0; i < mValuesCount; ++i) {
             mYk1[i] = mStates[i]+realHalfStep*mRates[i];
         }
 
         // Compute f(t_n + h / 2, Y_n + k1 / 2)
 
-        mComputeRates(pVoi+realHalfStep, mConstants, mRates, mYk1, mAlgebraic);
+        computeRates(pVoi+realHalfStep, mYk1);
 
         // Compute Y_n+1
 
-        for (int i = 0; i < mRatesStatesCount; ++i) {
+        for (int i = 0; i < mValuesCount; ++i) {
             mStates[i] += realStep*mRates[i];
         }
 
@@ -124,6 +124,15 @@ void SecondOrderRungeKuttaSolver::solve(double &pVoi, double pVoiEnd) const
 
 //==============================================================================
 
+bool SecondOrderRungeKuttaSolver::supportsEnsemble() const
+{
+    // We support ensembles, since Yk1 and Y_n+1 are computed element-wise
+
+    return true;
+}
+
+//==============================================================================
+
 } // namespace SecondOrderRungeKuttaSolver
 } // namespace OpenCOR
 
@@ -52,7 +52,7 @@ extern "C" Q_DECL_EXPORT int solverInterfaceVersion()
 {
     // Version of the solver interface
 
-    return 2;
+    return 5;
 }
 
 //==============================================================================
@@ -97,6 +97,70 @@ void Solver::emitError(const QString &pErrorMessage)
 
 //==============================================================================
 
+void OdeSolver::setJacobian(ComputeJacobianFunction pComputeJacobian,
+                            const QVector<int> &pColumnPointers,
+                            const QVector<int> &pRowIndices)
+{
+    // Keep track of the function that computes our Jacobian, as well as of the
+    // sparsity pattern of our Jacobian, which uses the compressed sparse column
+    // (CSC) format
+    // Note: this must be done before initialising the ODE solver and a null
+    //       function means that the ODE solver should approximate the
+    //       Jacobian itself, if it needs it...
+
+    mComputeJacobian = pComputeJacobian;
+
+    mJacobianColumnPointers = pColumnPointers;
+    mJacobianRowIndices = pRowIndices;
+}
+
+//==============================================================================
+
+bool OdeSolver::supportsEnsemble() const
+{
+    // By default, an ODE solver doesn't support ensembles
+
+    return false;
+}
+
+//==============================================================================
+
+bool OdeSolver::supportsOneStep() const
+{
+    // By default, an ODE solver can only be asked to compute its model up to a
+    // given point
+
+    return false;
+}
+
+//==============================================================================
+
+void OdeSolver::solveOneStep(double &pVoi, double pVoiEnd) const
+{
+    // By default, our one step goes all the way to the given end point
+
+    solve(pVoi, pVoiEnd);
+}
+
+//==============================================================================
+
+void OdeSolver::setEnsemble(ComputeEnsembleRatesFunction pComputeEnsembleRates,
+                            int pEnsembleSize)
+{
+    // Keep track of the function that computes the rates of an ensemble of
+    // models, as well as of the size of that ensemble
+    // Note: this must be done before initialising the ODE solver. The model
+    //       arrays given to initialize() are then expected to use a
+    //       structure-of-arrays layout, i.e. the value of the i-th variable of
+    //       the j-th model of the ensemble is at index i*pEnsembleSize+j. A
+    //       null function means that we are not dealing with an ensemble...
+
+    mComputeEnsembleRates = pComputeEnsembleRates;
+    mEnsembleSize = (pComputeEnsembleRates != nullptr)?pEnsembleSize:1;
+}
+
+//==============================================================================
+
 void OdeSolver::initialize(double pVoi, int pRatesStatesCount,
                            double *pConstants, double *pRates, double *pStates,
                            double *pAlgebraic,
@@ -107,6 +171,7 @@ void OdeSolver::initialize(double pVoi, int pRatesStatesCount,
     // Initialise the ODE solver
 
     mRatesStatesCount = pRatesStatesCount;
+    mValuesCount = pRatesStatesCount*mEnsembleSize;
 
     mConstants = pConstants;
     mRates = pRates;
@@ -127,6 +192,21 @@ void OdeSolver::reinitialize(double pVoi)
 
 //==============================================================================
 
+void OdeSolver::computeRates(double pVoi, double *pStates) const
+{
+    // Compute our rates using the given states, be it for a single model or for
+    // an ensemble of models
+
+    if (mComputeEnsembleRates != nullptr) {
+        mComputeEnsembleRates(pVoi, mConstants, mRates, pStates, mAlgebraic,
+                              mEnsembleSize);
+    } else {
+        mComputeRates(pVoi, mConstants, mRates, pStates, mAlgebraic);
+    }
+}
+
+//==============================================================================
+
 NlaSolver::~NlaSolver() = default;
 
 //==============================================================================
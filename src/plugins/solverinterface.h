@@ -30,6 +30,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include <QVariant>
+#include <QVector>
 
 //==============================================================================
 
@@ -75,6 +76,17 @@ class OdeSolver : public Solver
 {
 public:
     using ComputeRatesFunction = void (*)(double pVoi, double *pConstants, double *pRates, double *pStates, double *pAlgebraic);
+    using ComputeJacobianFunction = void (*)(double pVoi, double *pConstants, double *pRates, double *pStates, double *pAlgebraic, double *pJacobian);
+    using ComputeEnsembleRatesFunction = void (*)(double pVoi, double *pConstants, double *pRates, double *pStates, double *pAlgebraic, int pEnsembleSize);
+
+    void setJacobian(ComputeJacobianFunction pComputeJacobian,
+                     const QVector<int> &pColumnPointers,
+                     const QVector<int> &pRowIndices);
+
+    virtual bool supportsEnsemble() const;
+
+    void setEnsemble(ComputeEnsembleRatesFunction pComputeEnsembleRates,
+                     int pEnsembleSize);
 
     virtual void initialize(double pVoi, int pRatesStatesCount,
                             double *pConstants, double *pRates, double *pStates,
@@ -84,8 +96,13 @@ public:
 
     virtual void solve(double &pVoi, double pVoiEnd) const = 0;
 
+    virtual bool supportsOneStep() const;
+    virtual void solveOneStep(double &pVoi, double pVoiEnd) const;
+
 protected:
     int mRatesStatesCount = 0;
+    int mEnsembleSize = 1;
+    int mValuesCount = 0;
 
     double *mConstants = nullptr;
     double *mStates = nullptr;
@@ -93,6 +110,13 @@ protected:
     double *mAlgebraic = nullptr;
 
     ComputeRatesFunction mComputeRates = nullptr;
+    ComputeJacobianFunction mComputeJacobian = nullptr;
+    ComputeEnsembleRatesFunction mComputeEnsembleRates = nullptr;
+
+    QVector<int> mJacobianColumnPointers;
+    QVector<int> mJacobianRowIndices;
+
+    void computeRates(double pVoi, double *pStates) const;
 };
 
 //==============================================================================
@@ -38,6 +38,10 @@
         <source>&apos;%1&apos; could not be found</source>
         <translation>&apos;%1&apos; n&apos;a pas pu être trouvé</translation>
     </message>
+    <message>
+        <source>&apos;%1&apos; could not be extracted</source>
+        <translation>&apos;%1&apos; n&apos;a pas pu être extrait</translation>
+    </message>
     <message>
         <source>no reference to the COMBINE archive itself could be found</source>
         <translation>aucune référence à l&apos;archive COMBINE elle-même n&apos;a pu être trouvée</translation>
@@ -27,7 +27,9 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QDir>
 #include <QFile>
+#include <QFileInfo>
 #include <QRegularExpression>
 #include <QTemporaryDir>
 
@@ -174,6 +176,8 @@ void CombineArchive::reset()
 
     mLoadingNeeded = true;
 
+    resetEntries();
+
     mFiles.clear();
     mIssues.clear();
 
@@ -188,6 +192,100 @@ static const char *ManifestFileName = "manifest.xml";
 
 //==============================================================================
 
+static QString normalizedLocation(const QString &pLocation)
+{
+    // Return the given location in a form that can be compared with the name of
+    // a ZIP entry, i.e. without any leading "./" or "/"
+
+    QString res = QDir::cleanPath(pLocation);
+
+    while (res.startsWith('/')) {
+        res.remove(0, 1);
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+void CombineArchive::resetEntries()
+{
+    // Forget about our entries
+    // Note: files that were extracted before are left in our temporary
+    //       directory, but they will get overwritten if they are extracted
+    //       again...
+
+    mEntriesInArchive = false;
+
+    mEntries.clear();
+    mExtractedEntries.clear();
+}
+
+//==============================================================================
+
+bool CombineArchive::hasEntry(const QString &pLocation) const
+{
+    // Return whether our archive has an entry for the given location
+
+    return mEntries.contains(normalizedLocation(pLocation));
+}
+
+//==============================================================================
+
+bool CombineArchive::extractEntry(const QString &pLocation) const
+{
+    // Extract the entry for the given location to our temporary directory, if
+    // it exists and hasn't already been extracted
+    // Note #1: only that entry gets inflated, which is what makes it worth not
+    //          extracting everything upfront. It also gets streamed straight to
+    //          its file, so that large entries don't need to fit in memory...
+    // Note #2: we don't keep our archive open between extractions since it
+    //          would otherwise be locked on Windows. Instead, we make sure that
+    //          our archive hasn't changed since we indexed it, since our
+    //          entries would otherwise be stale...
+
+    QString location = normalizedLocation(pLocation);
+
+    if (!mEntriesInArchive || mExtractedEntries.contains(location)) {
+        return true;
+    }
+
+    auto entry = mEntries.constFind(location);
+
+    if (entry == mEntries.constEnd()) {
+        return false;
+    }
+
+    QFileInfo archiveFileInfo(mFileName);
+
+    if (   (archiveFileInfo.lastModified() != mArchiveLastModified)
+        || (archiveFileInfo.size() != mArchiveSize)) {
+        return false;
+    }
+
+    QString fileName = mDirName+"/"+location;
+
+    if (!QDir().mkpath(QFileInfo(fileName).path())) {
+        return false;
+    }
+
+    ZIPSupport::QZipReader zipReader(mFileName);
+    QFile file(fileName);
+
+    if (   !file.open(QIODevice::WriteOnly)
+        || !zipReader.extractFile(entry.value(), &file)) {
+        file.remove();
+
+        return false;
+    }
+
+    mExtractedEntries << location;
+
+    return true;
+}
+
+//==============================================================================
+
 bool CombineArchive::load()
 {
     // Check whether we are already loaded and without an issue
@@ -220,12 +318,15 @@ bool CombineArchive::load()
     };
 
     ZIPSupport::QZipReader zipReader(mFileName);
+
     std::array<uchar, SignatureSize> signatureData = {};
 
     if (zipReader.device()->read(reinterpret_cast<char *>(signatureData.data()), SignatureSize) != SignatureSize) {
         mIssues << CombineArchiveIssue(CombineArchiveIssue::Type::Error,
                                        tr("the archive is not signed"));
 
+        resetEntries();
+
         return false;
     }
 
@@ -233,17 +334,41 @@ bool CombineArchive::load()
         mIssues << CombineArchiveIssue(CombineArchiveIssue::Type::Error,
                                        tr("the archive does not have the correct signature"));
 
+        resetEntries();
+
         return false;
     }
 
-    // Our file is effectively a ZIP file, so extract all of its contents
+    // Our file is effectively a ZIP file, so index its entries and extract
+    // its manifest, if any
+    // Note: we used to extract all of the contents of our file, but an archive
+    //       may come with large datasets, so we now only extract an entry when
+    //       it is needed. For that purpose, we keep track of when our file was
+    //       last modified and of its size, so that we can tell whether our
+    //       entries are still valid when we need to extract one of them...
 
     zipReader.device()->reset();
 
-    if (!zipReader.extractAll(mDirName)) {
+    QFileInfo archiveFileInfo(mFileName);
+
+    mEntriesInArchive = true;
+    mArchiveLastModified = archiveFileInfo.lastModified();
+    mArchiveSize = archiveFileInfo.size();
+
+    const QVector<ZIPSupport::QZipReader::FileInfo> fileInfoList = zipReader.fileInfoList();
+
+    for (const auto &fileInfo : fileInfoList) {
+        if (fileInfo.isFile) {
+            mEntries.insert(normalizedLocation(fileInfo.filePath), fileInfo.filePath);
+        }
+    }
+
+    if (hasEntry(ManifestFileName) && !extractEntry(ManifestFileName)) {
         mIssues << CombineArchiveIssue(CombineArchiveIssue::Type::Error,
                                        tr("the contents of the archive could not be extracted"));
 
+        resetEntries();
+
         return false;
     }
 
@@ -305,6 +430,19 @@ bool CombineArchive::save(const QString &pFileName)
 
     static const QString Dot = ".";
 
+    // Make sure that all of our files have been extracted since we may be
+    // about to overwrite our archive
+    // Note: we keep track of our entries since they are all either in our
+    //       temporary directory or not needed anymore...
+
+    for (const auto &file : mFiles) {
+        if ((file.location() != Dot) && !extractEntry(file.location())) {
+            return false;
+        }
+    }
+
+    mEntriesInArchive = false;
+
     ZIPSupport::QZipWriter zipWriter(pFileName.isEmpty()?mFileName:pFileName);
 
     zipWriter.addFile(ManifestFileName,
@@ -317,13 +455,19 @@ bool CombineArchive::save(const QString &pFileName)
 
     for (const auto &file : mFiles) {
         if (file.location() != Dot) {
-            QByteArray fileContents;
+            // Stream our file into our archive
+
+            QFile fileContents(mDirName+"/"+file.location());
 
-            if (!Core::readFile(mDirName+"/"+file.location(), fileContents)) {
+            if (!fileContents.open(QIODevice::ReadOnly)) {
                 return false;
             }
 
-            zipWriter.addFile(file.location(), fileContents);
+            zipWriter.addFile(file.location(), &fileContents);
+
+            if (zipWriter.status() != ZIPSupport::QZipWriter::NoError) {
+                return false;
+            }
         }
     }
 
@@ -355,6 +499,8 @@ void CombineArchive::forceNew()
 
     mLoadingNeeded = true;
 
+    resetEntries();
+
     mFiles.clear();
 }
 
@@ -380,7 +526,7 @@ bool CombineArchive::isValid()
 
     QString manifestFileName = mDirName+"/"+ManifestFileName;
 
-    if (!QFile::exists(manifestFileName)) {
+    if (!hasEntry(ManifestFileName)) {
         mIssues << CombineArchiveIssue(CombineArchiveIssue::Type::Error,
                                        tr("the archive does not have a manifest"));
 
@@ -403,12 +549,20 @@ bool CombineArchive::isValid()
     }
 
     // Retrieve the COMBINE archive files from the manifest, making sure that
-    // they have been physically extracted
+    // they are in our archive, and extract those that we know how to handle
+    // (e.g. a CellML or a SED-ML file), as well as those that are not listed
+    // in the manifest (e.g. a CellML file imported by a listed one), since
+    // they are read straight from our temporary directory
+    // Note: other files (e.g. experimental data) only get extracted when their
+    //       location is requested or when we get saved...
 
     static const QString True = "true";
     static const QString One  = "1";
 
+    static const QString Dot = ".";
+
     QDomDocument domDocument;
+    QSet<QString> listedLocations;
 
     domDocument.setContent(manifestContents, true);
 
@@ -418,8 +572,12 @@ bool CombineArchive::isValid()
          !childElement.isNull(); childElement = childElement.nextSiblingElement()) {
         QString location = childElement.attribute("location");
         QString fileName = mDirName+"/"+location;
+        CombineArchiveFile::Format format = CombineArchiveFile::format(childElement.attribute("format"));
 
-        if (!QFile::exists(fileName)) {
+        if (   (normalizedLocation(location) != Dot)
+            && (   !hasEntry(location)
+                || (   (format != CombineArchiveFile::Format::Unknown)
+                    && !extractEntry(location)))) {
             mIssues << CombineArchiveIssue(CombineArchiveIssue::Type::Error,
                                            tr("'%1' could not be found").arg(location));
 
@@ -428,17 +586,29 @@ bool CombineArchive::isValid()
             return false;
         }
 
-        mFiles << CombineArchiveFile(fileName, location,
-                                     CombineArchiveFile::format(childElement.attribute("format")),
+        listedLocations << normalizedLocation(location);
+
+        mFiles << CombineArchiveFile(fileName, location, format,
                                         (childElement.attribute("master") == True)
                                      || (childElement.attribute("master") == One));
     }
 
+    const QStringList entries = mEntries.keys();
+
+    for (const auto &entry : entries) {
+        if (!listedLocations.contains(entry) && !extractEntry(entry)) {
+            mIssues << CombineArchiveIssue(CombineArchiveIssue::Type::Error,
+                                           tr("'%1' could not be extracted").arg(entry));
+
+            mFiles.clear();
+
+            return false;
+        }
+    }
+
     // Make sure that one of our COMBINE archive files represents our COMBINE
     // archive itself
 
-    static const QString Dot = ".";
-
     bool combineArchiveReferenceFound = false;
 
     for (int i = 0, iMax = mFiles.count(); i < iMax; ++i) {
@@ -494,7 +664,10 @@ bool CombineArchive::isSupported()
 
 QString CombineArchive::location(const CombineArchiveFile &pFile) const
 {
-    // Return the (full) location of the given file
+    // Return the (full) location of the given file, after having extracted it,
+    // if needed
+
+    extractEntry(pFile.location());
 
     return mDirName+"/"+pFile.location();
 }
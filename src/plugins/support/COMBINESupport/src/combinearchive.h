@@ -31,7 +31,10 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QDateTime>
+#include <QMap>
 #include <QObject>
+#include <QSet>
 
 //==============================================================================
 
@@ -121,6 +124,12 @@ private:
 
     bool mLoadingNeeded = true;
 
+    bool mEntriesInArchive = false;
+    QDateTime mArchiveLastModified;
+    qint64 mArchiveSize = 0;
+    QMap<QString, QString> mEntries;
+    mutable QSet<QString> mExtractedEntries;
+
     SEDMLSupport::SedmlFile *mSedmlFile = nullptr;
 
     CombineArchiveFiles mFiles;
@@ -129,6 +138,11 @@ private:
     bool mUpdated = false;
 
     void reset() override;
+
+    void resetEntries();
+
+    bool hasEntry(const QString &pLocation) const;
+    bool extractEntry(const QString &pLocation) const;
 };
 
 //==============================================================================
@@ -29,14 +29,24 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QDateTime>
 #include <QDir>
 #include <QDomDocument>
+#include <QEventLoop>
 #include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QMutex>
 #include <QStringList>
 #include <QUrl>
 
 //==============================================================================
 
+#include <QtConcurrent/QtConcurrent>
+
+//==============================================================================
+
 #include "cellmlapibegin.h"
     #include "IfaceCeLEDSExporter.hxx"
     #include "IfaceVACSS.hxx"
@@ -53,6 +63,105 @@ namespace CellMLSupport {
 
 //==============================================================================
 
+namespace {
+
+struct ImportCacheEntry
+{
+    QString contents;
+    QDateTime lastModified;
+    qint64 size;
+};
+
+} // namespace
+
+//==============================================================================
+
+static QMutex importCacheMutex;
+static QHash<QString, ImportCacheEntry> importCache;
+
+//==============================================================================
+
+CellmlFileImportRetriever::CellmlFileImportRetriever(const QString &pFileNameOrUrl,
+                                                     bool pIsLocalFile) :
+    mFileNameOrUrl(pFileNameOrUrl),
+    mIsLocalFile(pIsLocalFile)
+{
+}
+
+//==============================================================================
+
+void CellmlFileImportRetriever::retrieve()
+{
+    // Retrieve the contents of our import from our process-wide cache, if
+    // possible
+    // Note: a local file is only taken from our cache if it hasn't changed
+    //       since we cached it while a remote file is cached for the rest of
+    //       the session...
+
+    QFileInfo fileInfo;
+
+    if (mIsLocalFile) {
+        fileInfo.setFile(mFileNameOrUrl);
+    }
+
+    importCacheMutex.lock();
+        auto entry = importCache.constFind(mFileNameOrUrl);
+
+        if (   (entry != importCache.constEnd())
+            && (   !mIsLocalFile
+                || (   (entry->lastModified == fileInfo.lastModified())
+                    && (entry->size == fileInfo.size())))) {
+            mContents = entry->contents;
+            mRetrieved = true;
+        }
+    importCacheMutex.unlock();
+
+    if (mRetrieved) {
+        return;
+    }
+
+    // Retrieve the contents of our import and cache them
+
+    mRetrieved = Core::readFile(mFileNameOrUrl, mContents);
+
+    if (mRetrieved) {
+        importCacheMutex.lock();
+            importCache.insert(mFileNameOrUrl, { mContents,
+                                                 fileInfo.lastModified(),
+                                                 fileInfo.size() });
+        importCacheMutex.unlock();
+    }
+}
+
+//==============================================================================
+
+QString CellmlFileImportRetriever::fileNameOrUrl() const
+{
+    // Return our file name or URL
+
+    return mFileNameOrUrl;
+}
+
+//==============================================================================
+
+bool CellmlFileImportRetriever::retrieved() const
+{
+    // Return whether our contents could be retrieved
+
+    return mRetrieved;
+}
+
+//==============================================================================
+
+QString CellmlFileImportRetriever::contents() const
+{
+    // Return our contents
+
+    return mContents;
+}
+
+//==============================================================================
+
 CellmlFile::CellmlFile(const QString &pFileName) :
     StandardSupport::StandardFile(pFileName),
     mRdfTriples(CellmlFileRdfTriples(this))
@@ -197,61 +306,133 @@ bool CellmlFile::fullyInstantiateImports(iface::cellml_api::Model *pModel,
 
             retrieveImports(crtUrl, pModel, imports, crtUrls, importedUrls);
 
-            // Instantiate all the imports in our list
+            // Instantiate all the imports in our list, one level of our import
+            // hierarchy at a time
+            // Note: the imports of a given level are independent of one
+            //       another, so we retrieve the contents of those we haven't
+            //       already loaded in parallel (our CellML API isn't thread
+            //       safe, so the instantiation itself is done sequentially)...
 
             while (!imports.isEmpty()) {
-                // Retrieve the first import and instantiate it, if needed
-                // Note: CDA_CellMLImport::instantiate() would normally be
-                //       called, but it doesn't work with https, so we retrieve
-                //       the contents of the import ourselves and instantiate it
-                //       from text instead...
-
-                ObjRef<iface::cellml_api::CellMLImport> import = imports.first();
-                bool dummy;
-                QString crtFileNameOrUrl;
-                QString importedUrl = importedUrls.first();
-                bool isLocalImportedFile;
-                QString importedFileNameOrUrl;
-
-                Core::checkFileNameOrUrl(crtUrls.first(), dummy, crtFileNameOrUrl);
-                Core::checkFileNameOrUrl(importedUrl, isLocalImportedFile, importedFileNameOrUrl);
-
-                imports.removeFirst();
-                crtUrls.removeFirst();
-                importedUrls.removeFirst();
-
-                if (importedFileNameOrUrl == mFileName) {
-                    // We want to import ourselves, something we can't do
-
-                    throw std::runtime_error(tr("%1 cannot import itself").arg(QDir::toNativeSeparators(importedFileNameOrUrl)).toStdString());
+                // Retrieve the contents of the imports of the current level,
+                // with a busy widget if some of them are remote
+
+                QList<CellmlFileImportRetriever *> importRetrievers;
+                QStringList importedFileNamesOrUrls;
+                bool hasRemoteImports = false;
+
+                for (const auto &importedUrl : qAsConst(importedUrls)) {
+                    bool isLocalImportedFile;
+                    QString importedFileNameOrUrl;
+
+                    Core::checkFileNameOrUrl(importedUrl, isLocalImportedFile, importedFileNameOrUrl);
+
+                    if (   (importedFileNameOrUrl != mFileName)
+                        && !mImportContents.contains(importedFileNameOrUrl)
+                        && !importedFileNamesOrUrls.contains(importedFileNameOrUrl)) {
+                        importRetrievers << new CellmlFileImportRetriever(importedFileNameOrUrl, isLocalImportedFile);
+                        importedFileNamesOrUrls << importedFileNameOrUrl;
+
+                        hasRemoteImports = hasRemoteImports || !isLocalImportedFile;
+                    }
                 }
 
-                if (mImportContents.contains(importedFileNameOrUrl)) {
-                    // We have already loaded the import contents, so directly
-                    // instantiate the import with it
+                if (hasRemoteImports) {
+                    Core::showCentralBusyWidget();
+                }
 
-                    import->instantiateFromText(mImportContents.value(importedFileNameOrUrl).toStdWString());
-                } else {
-                    // We haven't already loaded the import contents, so do so
-                    // now, with a busy widget if requested and if we are not
-                    // dealing with a local file
+                // Note: we wait for our retrievers through a local event loop
+                //       rather than by blocking, so that the GUI remains
+                //       responsive while remote imports are being
+                //       downloaded...
 
-                    QString fileContents;
+                if (!importRetrievers.isEmpty()) {
+                    QEventLoop waitLoop;
+                    QList<QFutureWatcher<void> *> futureWatchers;
+                    int nbOfRunningImportRetrievers = importRetrievers.count();
 
-                    if (!isLocalImportedFile) {
-                        Core::showCentralBusyWidget();
+                    for (auto importRetriever : qAsConst(importRetrievers)) {
+                        auto futureWatcher = new QFutureWatcher<void>();
+
+                        connect(futureWatcher, &QFutureWatcher<void>::finished, &waitLoop, [&]() {
+                            if (--nbOfRunningImportRetrievers == 0) {
+                                waitLoop.quit();
+                            }
+                        });
+
+                        futureWatcher->setFuture(QtConcurrent::run(importRetriever, &CellmlFileImportRetriever::retrieve));
+
+                        futureWatchers << futureWatcher;
                     }
 
-                    bool res = Core::readFile(importedFileNameOrUrl, fileContents);
+                    waitLoop.exec();
+
+                    qDeleteAll(futureWatchers);
+                }
 
-                    if (!isLocalImportedFile) {
-                        Core::hideCentralBusyWidget();
+                if (hasRemoteImports) {
+                    Core::hideCentralBusyWidget();
+                }
+
+                QMap<QString, QString> retrievedContents;
+
+                for (auto importRetriever : qAsConst(importRetrievers)) {
+                    if (importRetriever->retrieved()) {
+                        retrievedContents.insert(importRetriever->fileNameOrUrl(),
+                                                 importRetriever->contents());
                     }
 
-                    if (res) {
+                    delete importRetriever;
+                }
+
+                // Instantiate the imports of the current level and gather those
+                // of the next level
+
+                QList<iface::cellml_api::CellMLImport *> levelImports = imports;
+                QStringList levelCrtUrls = crtUrls;
+                QStringList levelImportedUrls = importedUrls;
+
+                imports.clear();
+                crtUrls.clear();
+                importedUrls.clear();
+
+                while (!levelImports.isEmpty()) {
+                    // Retrieve the first import and instantiate it, if needed
+                    // Note: CDA_CellMLImport::instantiate() would normally be
+                    //       called, but it doesn't work with https, so we
+                    //       instantiate the import from its contents instead...
+
+                    ObjRef<iface::cellml_api::CellMLImport> import = levelImports.first();
+                    bool dummy;
+                    QString crtFileNameOrUrl;
+                    QString importedUrl = levelImportedUrls.first();
+                    bool isLocalImportedFile;
+                    QString importedFileNameOrUrl;
+
+                    Core::checkFileNameOrUrl(levelCrtUrls.first(), dummy, crtFileNameOrUrl);
+                    Core::checkFileNameOrUrl(importedUrl, isLocalImportedFile, importedFileNameOrUrl);
+
+                    levelImports.removeFirst();
+                    levelCrtUrls.removeFirst();
+                    levelImportedUrls.removeFirst();
+
+                    if (importedFileNameOrUrl == mFileName) {
+                        // We want to import ourselves, something we can't do
+
+                        throw std::runtime_error(tr("%1 cannot import itself").arg(QDir::toNativeSeparators(importedFileNameOrUrl)).toStdString());
+                    }
+
+                    if (mImportContents.contains(importedFileNameOrUrl)) {
+                        // We have already loaded the import contents, so
+                        // directly instantiate the import with it
+
+                        import->instantiateFromText(mImportContents.value(importedFileNameOrUrl).toStdWString());
+                    } else if (retrievedContents.contains(importedFileNameOrUrl)) {
                         // We were able to retrieve the import contents, so
                         // instantiate the import with it
 
+                        QString fileContents = retrievedContents.value(importedFileNameOrUrl);
+
                         try {
                             import->instantiateFromText(fileContents.toStdWString());
                         } catch (iface::cellml_api::CellMLException &exception) {
@@ -278,19 +459,19 @@ bool CellmlFile::fullyInstantiateImports(iface::cellml_api::Model *pModel,
                         throw std::runtime_error(tr("<strong>%1</strong> imports <strong>%2</strong>, which contents could not be retrieved").arg(QDir::toNativeSeparators(crtFileNameOrUrl),
                                                                                                                                                   QDir::toNativeSeparators(importedFileNameOrUrl)).toStdString());
                     }
-                }
 
-                // Now that the import is instantiated, add its own imports to
-                // our list
+                    // Now that the import is instantiated, add its own imports
+                    // to the next level
 
-                ObjRef<iface::cellml_api::Model> importedModel = import->importedModel();
+                    ObjRef<iface::cellml_api::Model> importedModel = import->importedModel();
 
-                if (importedModel == nullptr) {
-                    throw std::runtime_error(tr("<strong>%1</strong> imports <strong>%2</strong>, which CellML object could not be retrieved").arg(QDir::toNativeSeparators(crtFileNameOrUrl),
-                                                                                                                                                   QDir::toNativeSeparators(importedFileNameOrUrl)).toStdString());
-                }
+                    if (importedModel == nullptr) {
+                        throw std::runtime_error(tr("<strong>%1</strong> imports <strong>%2</strong>, which CellML object could not be retrieved").arg(QDir::toNativeSeparators(crtFileNameOrUrl),
+                                                                                                                                                       QDir::toNativeSeparators(importedFileNameOrUrl)).toStdString());
+                    }
 
-                retrieveImports(importedUrl, importedModel, imports, crtUrls, importedUrls);
+                    retrieveImports(importedUrl, importedModel, imports, crtUrls, importedUrls);
+                }
             }
         } catch (std::runtime_error &runtimeError) {
             // Something went wrong with the full instantiation of the imports
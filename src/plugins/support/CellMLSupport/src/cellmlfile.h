@@ -60,6 +60,29 @@ static const auto XlinkNamespace            = QStringLiteral("http://www.w3.org/
 
 //==============================================================================
 
+class CellmlFileImportRetriever
+{
+public:
+    explicit CellmlFileImportRetriever(const QString &pFileNameOrUrl,
+                                       bool pIsLocalFile);
+
+    void retrieve();
+
+    QString fileNameOrUrl() const;
+
+    bool retrieved() const;
+    QString contents() const;
+
+private:
+    QString mFileNameOrUrl;
+    bool mIsLocalFile;
+
+    bool mRetrieved = false;
+    QString mContents;
+};
+
+//==============================================================================
+
 class CELLMLSUPPORT_EXPORT CellmlFile : public StandardSupport::StandardFile
 {
     Q_OBJECT
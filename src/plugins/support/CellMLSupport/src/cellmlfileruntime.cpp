@@ -29,6 +29,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 #include "cellmlfile.h"
 #include "cellmlfileruntime.h"
+#include "cellmlfileruntimejacobian.h"
 #include "compilerengine.h"
 #include "corecliutils.h"
 #include "solverinterface.h"
@@ -478,7 +479,7 @@ void CellmlFileRuntime::update(CellmlFile *pCellmlFile, bool pAll)
 
     // Generate the model code
 
-    QString modelCode;
+    QString nlaSystemsCode;
     QString functionsString = cleanCode(mCodeInformation->functionsString());
 
     if (!functionsString.isEmpty()) {
@@ -486,20 +487,22 @@ void CellmlFileRuntime::update(CellmlFile *pCellmlFile, bool pAll)
 
         mAtLeastOneNlaSystem = true;
 
-        modelCode +=  "struct rootfind_info\n"
-                      "{\n"
-                      "    double aVOI;\n"
-                      "\n"
-                      "    double *aCONSTANTS;\n"
-                      "    double *aRATES;\n"
-                      "    double *aSTATES;\n"
-                      "    double *aALGEBRAIC;\n"
-                      "};\n"
-                      "\n"
-                      "extern void doNonLinearSolve(char *, void (*)(double *, double *, void*), double *, int, void *);\n"
-                      "\n"
-                     +functionsString
-                     +"\n";
+        nlaSystemsCode =  "struct rootfind_info\n"
+                          "{\n"
+                          "    double aVOI;\n"
+                          "\n"
+                          "    double *aCONSTANTS;\n"
+                          "    double *aRATES;\n"
+                          "    double *aSTATES;\n"
+                          "    double *aALGEBRAIC;\n"
+                          "};\n"
+                          "\n"
+                          "extern char runtimeAddress[];\n"
+                          "\n"
+                          "extern void doNonLinearSolve(char *, void (*)(double *, double *, void*), double *, int, void *);\n"
+                          "\n"
+                         +functionsString
+                         +"\n";
     }
 
     // Retrieve the body of the function that initialises constants and extract
@@ -526,24 +529,94 @@ void CellmlFileRuntime::update(CellmlFile *pCellmlFile, bool pAll)
         }
     }
 
-    modelCode +=  methodCode("initializeConstants(double *CONSTANTS, double *RATES, double *STATES)",
-                             initConsts)
-                 +methodCode("computeComputedConstants(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC)",
-                             compCompConsts)
-                 +methodCode("computeVariables(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, double *CONDVAR)",
-                             mCodeInformation->variablesString())
-                 +methodCode("computeRates(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC)",
-                             mCodeInformation->ratesString());
+    QString initializeConstantsCode = methodCode("initializeConstants(double *CONSTANTS, double *RATES, double *STATES)",
+                                                 initConsts);
+    QString computeComputedConstantsCode = methodCode("computeComputedConstants(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC)",
+                                                      compCompConsts);
+    QString computeVariablesCode = methodCode("computeVariables(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, double *CONDVAR)",
+                                              mCodeInformation->variablesString());
+    QString computeRatesCode = methodCode("computeRates(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC)",
+                                          mCodeInformation->ratesString());
+
+    // Split our model code into modules that can be compiled (and therefore
+    // cached) separately, so that modifying a model (e.g. the value of a
+    // constant) only requires the affected modules to be recompiled
+    // Note: the functions used to solve NLA systems may be needed by
+    //       computeComputedConstants(), computeVariables() and computeRates(),
+    //       hence those must all be in the same module...
+
+    QStringList modelCodes;
+
+    if (mAtLeastOneNlaSystem) {
+        modelCodes << initializeConstantsCode
+                   << nlaSystemsCode+computeComputedConstantsCode+computeVariablesCode+computeRatesCode;
+    } else {
+        modelCodes << initializeConstantsCode
+                   << computeComputedConstantsCode
+                   << computeVariablesCode
+                   << computeRatesCode;
+    }
+
+    // Generate the code for our Jacobian, if possible
+    // Note: our Jacobian is computed analytically from the code for our rates,
+    //       which is not always possible (e.g. when an NLA system needs to be
+    //       solved), in which case an ODE solver will have to fall back to a
+    //       finite difference approximation of the Jacobian...
+
+    CellmlFileRuntimeJacobian jacobian(cleanCode(mCodeInformation->ratesString()),
+                                       mStatesRatesCount);
+    QString jacobianCode;
+
+    if ((mStatesRatesCount != 0) && jacobian.isValid()) {
+        jacobianCode = methodCode("computeJacobian(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, double *JACOBIAN)",
+                                  jacobian.code());
+    }
+
+    // Generate the code for an ensemble version of our rates, i.e. a version
+    // that computes the rates of several instances of our model at once
+    // Note: this is only possible if we don't need to solve any NLA system
+    //       since the code for an NLA system works on a single instance of our
+    //       model...
+
+    QString ensembleCode;
+
+    if ((mStatesRatesCount != 0) && !mAtLeastOneNlaSystem) {
+        ensembleCode = ensembleMethodCode("computeEnsembleRates(double VOI, double * restrict CONSTANTS, double * restrict RATES, double * restrict STATES, double * restrict ALGEBRAIC, int COUNT)",
+                                          model);
+    }
 
     // Check whether the model code contains a definite integral, otherwise
-    // compile it and check that everything went fine
+    // compile it (with the code for our Jacobian and ensemble rates, if any, or
+    // without them should the compilation fail) and check that everything went
+    // fine
 
-    if (modelCode.contains("defint(func")) {
+    if (modelCodes.join(QString()).contains("defint(func")) {
         mIssues << CellmlFileIssue(CellmlFileIssue::Type::Error,
                                    tr("definite integrals are not supported"));
-    } else if (!mCompilerEngine->compileCode(modelCode)) {
-        mIssues << CellmlFileIssue(CellmlFileIssue::Type::Error,
-                                   mCompilerEngine->error());
+    } else {
+        QStringList extraCodes;
+
+        if (!jacobianCode.isEmpty()) {
+            extraCodes << jacobianCode;
+        }
+
+        if (!ensembleCode.isEmpty()) {
+            extraCodes << ensembleCode;
+        }
+
+        bool codeCompiled = mCompilerEngine->compileCodes(modelCodes+extraCodes);
+
+        if (!codeCompiled && !extraCodes.isEmpty()) {
+            jacobianCode = QString();
+            ensembleCode = QString();
+
+            codeCompiled = mCompilerEngine->compileCodes(modelCodes);
+        }
+
+        if (!codeCompiled) {
+            mIssues << CellmlFileIssue(CellmlFileIssue::Type::Error,
+                                       mCompilerEngine->error());
+        }
     }
 
     // Keep track of the ODE functions, but only if no issues were reported
@@ -553,8 +626,17 @@ void CellmlFileRuntime::update(CellmlFile *pCellmlFile, bool pAll)
     } else {
         // Add the symbol of any required external function, if any
 
+        // Note: runtimeAddress is not a function, but the address of our
+        //       runtime as a string (see cleanCode()). We add it as an
+        //       external symbol rather than embed it in our code, so that our
+        //       code, and therefore its cached object code, doesn't depend on
+        //       where our runtime is in memory...
+
         if (mAtLeastOneNlaSystem) {
+            mAddress = Solver::objectAddress(this).toUtf8();
+
             mCompilerEngine->addFunction("doNonLinearSolve", reinterpret_cast<void *>(doNonLinearSolve));
+            mCompilerEngine->addFunction("runtimeAddress", mAddress.data());
         }
 
         // Retrieve the ODE functions
@@ -572,6 +654,21 @@ void CellmlFileRuntime::update(CellmlFile *pCellmlFile, bool pAll)
                                        tr("an unexpected problem occurred while trying to retrieve the model functions"));
 
             reset(true, false, true);
+        } else if (!jacobianCode.isEmpty()) {
+            // Retrieve our Jacobian function and its sparsity pattern
+
+            mComputeJacobian = reinterpret_cast<ComputeJacobianFunction>(mCompilerEngine->function("computeJacobian"));
+
+            if (mComputeJacobian != nullptr) {
+                mJacobianColumnPointers = jacobian.columnPointers();
+                mJacobianRowIndices = jacobian.rowIndices();
+            }
+        }
+
+        // Retrieve our ensemble rates function, if any
+
+        if (mIssues.isEmpty() && !ensembleCode.isEmpty()) {
+            mComputeEnsembleRates = reinterpret_cast<ComputeEnsembleRatesFunction>(mCompilerEngine->function("computeEnsembleRates"));
         }
     }
 }
@@ -680,6 +777,44 @@ CellmlFileRuntime::ComputeRatesFunction CellmlFileRuntime::computeRates() const
 
 //==============================================================================
 
+CellmlFileRuntime::ComputeJacobianFunction CellmlFileRuntime::computeJacobian() const
+{
+    // Return the computeJacobian function, if any
+
+    return mComputeJacobian;
+}
+
+//==============================================================================
+
+CellmlFileRuntime::ComputeEnsembleRatesFunction CellmlFileRuntime::computeEnsembleRates() const
+{
+    // Return the computeEnsembleRates function, if any
+
+    return mComputeEnsembleRates;
+}
+
+//==============================================================================
+
+QVector<int> CellmlFileRuntime::jacobianColumnPointers() const
+{
+    // Return the column pointers of our Jacobian, which uses the compressed
+    // sparse column (CSC) format
+
+    return mJacobianColumnPointers;
+}
+
+//==============================================================================
+
+QVector<int> CellmlFileRuntime::jacobianRowIndices() const
+{
+    // Return the row indices of our Jacobian, which uses the compressed sparse
+    // column (CSC) format
+
+    return mJacobianRowIndices;
+}
+
+//==============================================================================
+
 CellmlFileIssues CellmlFileRuntime::issues() const
 {
     // Return the issue(s)
@@ -735,6 +870,11 @@ void CellmlFileRuntime::resetFunctions()
     mComputeComputedConstants = nullptr;
     mComputeVariables = nullptr;
     mComputeRates = nullptr;
+    mComputeJacobian = nullptr;
+    mComputeEnsembleRates = nullptr;
+
+    mJacobianColumnPointers.clear();
+    mJacobianRowIndices.clear();
 }
 
 //==============================================================================
@@ -885,6 +1025,54 @@ QString CellmlFileRuntime::methodCode(const QString &pCodeSignature,
 
 //==============================================================================
 
+QString CellmlFileRuntime::ensembleMethodCode(const QString &pCodeSignature,
+                                              iface::cellml_api::Model *pModel)
+{
+    // Generate and return the code for the ensemble version of our rates, i.e.
+    // a method that loops over the COUNT instances of our model, which values
+    // are stored using a structure-of-arrays layout (i.e. the value of the
+    // i-th variable of the j-th instance is at index i*COUNT+j)
+    // Note: we get the code generator to use that layout directly, rather than
+    //       rewrite the code that it generated for our rates...
+
+    QString ratesCode;
+
+    try {
+        ObjRef<iface::cellml_services::CodeGenerator> codeGenerator = CreateCodeGeneratorBootstrap()->createCodeGenerator();
+
+        codeGenerator->constantPattern(L"CONSTANTS[%*COUNT+LANE]");
+        codeGenerator->stateVariableNamePattern(L"STATES[%*COUNT+LANE]");
+        codeGenerator->algebraicVariableNamePattern(L"ALGEBRAIC[%*COUNT+LANE]");
+        codeGenerator->rateNamePattern(L"RATES[%*COUNT+LANE]");
+
+        ObjRef<iface::cellml_services::CodeInformation> codeInformation = codeGenerator->generateCode(pModel);
+
+        if (!codeInformation->errorMessage().empty()) {
+            return {};
+        }
+
+        ratesCode = cleanCode(codeInformation->ratesString());
+    } catch (...) {
+        return {};
+    }
+
+    QString res;
+    const QStringList codes = ratesCode.split('\n');
+
+    for (const auto &code : codes) {
+        if (!code.isEmpty()) {
+            res += "    "+code+"\n";
+        }
+    }
+
+    return methodCode(pCodeSignature,
+                      "for (int LANE = 0; LANE < COUNT; ++LANE) {\n"
+                      +res
+                      +"}");
+}
+
+//==============================================================================
+
 QStringList CellmlFileRuntime::componentHierarchy(iface::cellml_api::CellMLElement *pElement)
 {
     // Make sure that we have a given element
@@ -950,8 +1138,10 @@ QString CellmlFileRuntime::cleanCode(const std::wstring &pCode)
     // own non-linear solve routine defined in our Solver interface, and add a
     // new parameter to all our calls to doNonLinearSolve() so that
     // doNonLinearSolve() can retrieve the correct instance of our NLA solver
+    // Note: that parameter is the address of our runtime, which is provided as
+    //       an external symbol (see update())...
 
-    res.replace("do_nonlinearsolve(", QString(R"(doNonLinearSolve("%1", )").arg(Solver::objectAddress(this)));
+    res.replace("do_nonlinearsolve(", "doNonLinearSolve(runtimeAddress, ");
 
     return res;
 }
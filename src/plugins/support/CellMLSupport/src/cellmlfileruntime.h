@@ -33,6 +33,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 #include <QIcon>
 #include <QList>
 #include <QMap>
+#include <QVector>
 #ifdef Q_OS_WIN
     #include <QSet>
     #include <QVector>
@@ -134,6 +135,8 @@ public:
     using ComputeComputedConstantsFunction = void (*)(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC);
     using ComputeVariablesFunction = void (*)(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC);
     using ComputeRatesFunction = void (*)(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC);
+    using ComputeJacobianFunction = void (*)(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, double *JACOBIAN);
+    using ComputeEnsembleRatesFunction = void (*)(double VOI, double *CONSTANTS, double *RATES, double *STATES, double *ALGEBRAIC, int COUNT);
 
     explicit CellmlFileRuntime(CellmlFile *pCellmlFile);
     ~CellmlFileRuntime() override;
@@ -157,6 +160,11 @@ public:
     ComputeComputedConstantsFunction computeComputedConstants() const;
     ComputeVariablesFunction computeVariables() const;
     ComputeRatesFunction computeRates() const;
+    ComputeJacobianFunction computeJacobian() const;
+    ComputeEnsembleRatesFunction computeEnsembleRates() const;
+
+    QVector<int> jacobianColumnPointers() const;
+    QVector<int> jacobianRowIndices() const;
 
     CellmlFileIssues issues() const;
 
@@ -168,6 +176,8 @@ public:
 private:
     bool mAtLeastOneNlaSystem = false;
 
+    QByteArray mAddress;
+
     ObjRef<iface::cellml_services::CodeInformation> mCodeInformation;
 
     int mConstantsCount = 0;
@@ -185,6 +195,11 @@ private:
     ComputeComputedConstantsFunction mComputeComputedConstants = nullptr;
     ComputeVariablesFunction mComputeVariables = nullptr;
     ComputeRatesFunction mComputeRates = nullptr;
+    ComputeJacobianFunction mComputeJacobian = nullptr;
+    ComputeEnsembleRatesFunction mComputeEnsembleRates = nullptr;
+
+    QVector<int> mJacobianColumnPointers;
+    QVector<int> mJacobianRowIndices;
 
     void resetCodeInformation();
 
@@ -203,6 +218,8 @@ private:
     QString methodCode(const QString &pCodeSignature, const QString &pCodeBody);
     QString methodCode(const QString &pCodeSignature,
                        const std::wstring &pCodeBody);
+    QString ensembleMethodCode(const QString &pCodeSignature,
+                               iface::cellml_api::Model *pModel);
 
     QStringList componentHierarchy(iface::cellml_api::CellMLElement *pElement);
 };
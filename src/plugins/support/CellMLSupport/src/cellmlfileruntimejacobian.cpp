@@ -0,0 +1,852 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// CellML file runtime Jacobian
+//==============================================================================
+
+#include "cellmlfileruntimejacobian.h"
+
+//==============================================================================
+
+#include <QRegularExpression>
+#include <QSet>
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace CellMLSupport {
+
+//==============================================================================
+
+enum {
+    MaximumDerivativesCount = 100000
+};
+
+//==============================================================================
+
+CellmlFileRuntimeJacobian::CellmlFileRuntimeJacobian(const QString &pRatesCode,
+                                                     int pStatesCount) :
+    mStatesCount(pStatesCount)
+{
+    // Generate the code for our Jacobian
+
+    generate(pRatesCode);
+}
+
+//==============================================================================
+
+bool CellmlFileRuntimeJacobian::isValid() const
+{
+    // Return whether we could generate the code for our Jacobian
+
+    return mValid;
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::code() const
+{
+    // Return the code for our Jacobian
+    // Note: the code is that of the body of a function that has the same
+    //       parameters as computeRates(), as well as a JACOBIAN parameter,
+    //       which values are stored using the compressed sparse column (CSC)
+    //       format described by columnPointers() and rowIndices()...
+
+    return mCode;
+}
+
+//==============================================================================
+
+int CellmlFileRuntimeJacobian::nonZeroCount() const
+{
+    // Return the number of non-zero entries in our Jacobian
+
+    return mRowIndices.count();
+}
+
+//==============================================================================
+
+QVector<int> CellmlFileRuntimeJacobian::columnPointers() const
+{
+    // Return our column pointers
+
+    return mColumnPointers;
+}
+
+//==============================================================================
+
+QVector<int> CellmlFileRuntimeJacobian::rowIndices() const
+{
+    // Return our row indices
+
+    return mRowIndices;
+}
+
+//==============================================================================
+
+void CellmlFileRuntimeJacobian::generate(const QString &pRatesCode)
+{
+    // Tokenise the given code
+    // Note: the code generated by the CellML API only uses numbers,
+    //       identifiers and C operators, so this is all we need to support...
+
+    static const QRegularExpression TokenRegEx = QRegularExpression(R"((\d+\.?\d*|\.\d+)([eE][+-]?\d+)?|[A-Za-z_]\w*|<=|>=|==|!=|&&|\|\||\S)");
+
+    QRegularExpressionMatchIterator tokenIter = TokenRegEx.globalMatch(pRatesCode);
+
+    while (tokenIter.hasNext()) {
+        mTokens << tokenIter.next().captured();
+    }
+
+    // Go through the statements of the given code, keeping them as is (since
+    // our derivatives may need their values) and differentiating them with
+    // respect to the state variables on which they (indirectly) depend
+    // Note: we only support statements of the form ALGEBRAIC[i] = ...; and
+    //       RATES[i] = ...;, which means that we don't support models that
+    //       need to solve an NLA system...
+
+    QMap<int, Derivatives> ratesDerivatives;
+    int derivativesCount = 0;
+
+    while (mValid && (mTokenIndex < mTokens.count())) {
+        QString array = nextToken();
+
+        expectToken("[");
+
+        QString index = nextToken();
+        bool validIndex;
+        int indexValue = index.toInt(&validIndex);
+
+        expectToken("]");
+        expectToken("=");
+
+        QString variable = array+"["+index+"]";
+
+        if (   !mValid || !validIndex
+            || ((array != "ALGEBRAIC") && (array != "RATES"))
+            || ((array == "RATES") && ((indexValue < 0) || (indexValue >= mStatesCount)))
+            || mVariablesDerivatives.contains(variable)) {
+            invalidate();
+
+            break;
+        }
+
+        Derivatives derivatives;
+        QString expression = parseTernary(derivatives);
+
+        expectToken(";");
+
+        if (!mValid) {
+            break;
+        }
+
+        // Keep track of our statement and of its derivatives, using local
+        // variables for the latter
+
+        mCode += variable+" = "+expression+";\n";
+
+        Derivatives variableDerivatives;
+
+        for (auto derivative = derivatives.constBegin(), derivativeEnd = derivatives.constEnd();
+             derivative != derivativeEnd; ++derivative) {
+            QString derivativeVariable = "d"+array+"_"+index+"_"+QString::number(derivative.key());
+
+            mCode += "double "+derivativeVariable+" = "+derivative.value()+";\n";
+
+            variableDerivatives.insert(derivative.key(), derivativeVariable);
+        }
+
+        mVariablesDerivatives.insert(variable, variableDerivatives);
+
+        if (array == "RATES") {
+            ratesDerivatives.insert(indexValue, variableDerivatives);
+        }
+
+        // Make sure that we are not generating an unreasonable amount of code
+        // (i.e. something that would take longer to compile than what we could
+        // ever gain from it)
+
+        derivativesCount += variableDerivatives.count();
+
+        if (derivativesCount > MaximumDerivativesCount) {
+            invalidate();
+        }
+    }
+
+    if (!mValid) {
+        return;
+    }
+
+    // Determine the sparsity pattern of our Jacobian, using the compressed
+    // sparse column (CSC) format, and assign the values of its non-zero entries
+
+    mColumnPointers << 0;
+
+    for (int column = 0; column < mStatesCount; ++column) {
+        for (auto rateDerivatives = ratesDerivatives.constBegin(), rateDerivativesEnd = ratesDerivatives.constEnd();
+             rateDerivatives != rateDerivativesEnd; ++rateDerivatives) {
+            if (rateDerivatives.value().contains(column)) {
+                mCode += "JACOBIAN["+QString::number(mRowIndices.count())+"] = "+rateDerivatives.value().value(column)+";\n";
+
+                mRowIndices << rateDerivatives.key();
+            }
+        }
+
+        mColumnPointers << mRowIndices.count();
+    }
+}
+
+//==============================================================================
+
+void CellmlFileRuntimeJacobian::invalidate()
+{
+    // Invalidate ourselves
+
+    mValid = false;
+
+    mCode = QString();
+
+    mColumnPointers.clear();
+    mRowIndices.clear();
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::token() const
+{
+    // Return our current token, if any
+
+    return mTokens.value(mTokenIndex);
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::nextToken()
+{
+    // Return our current token, if any, and move to the next one
+
+    return mTokens.value(mTokenIndex++);
+}
+
+//==============================================================================
+
+bool CellmlFileRuntimeJacobian::acceptToken(const QString &pToken)
+{
+    // Move to the next token if our current one is the given one
+
+    if (token() == pToken) {
+        ++mTokenIndex;
+
+        return true;
+    }
+
+    return false;
+}
+
+//==============================================================================
+
+void CellmlFileRuntimeJacobian::expectToken(const QString &pToken)
+{
+    // Move to the next token if our current one is the given one, otherwise
+    // invalidate ourselves
+
+    if (!acceptToken(pToken)) {
+        invalidate();
+    }
+}
+
+//==============================================================================
+
+bool CellmlFileRuntimeJacobian::isNumber(const QString &pToken)
+{
+    // Return whether the given token is a number
+
+    return !pToken.isEmpty() && (pToken[0].isDigit() || (pToken[0] == '.'));
+}
+
+//==============================================================================
+
+bool CellmlFileRuntimeJacobian::isIdentifier(const QString &pToken)
+{
+    // Return whether the given token is an identifier
+
+    return !pToken.isEmpty() && (pToken[0].isLetter() || (pToken[0] == '_'));
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::sum(const QString &pTerm1,
+                                       const QString &pTerm2)
+{
+    // Return the sum of the given terms
+    // Note: an empty term stands for zero, which is also the case for all the
+    //       methods below...
+
+    if (pTerm1.isEmpty()) {
+        return pTerm2;
+    }
+
+    if (pTerm2.isEmpty()) {
+        return pTerm1;
+    }
+
+    return "("+pTerm1+"+"+pTerm2+")";
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::difference(const QString &pTerm1,
+                                              const QString &pTerm2)
+{
+    // Return the difference between the given terms
+
+    if (pTerm2.isEmpty()) {
+        return pTerm1;
+    }
+
+    if (pTerm1.isEmpty()) {
+        return negation(pTerm2);
+    }
+
+    return "("+pTerm1+"-"+pTerm2+")";
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::product(const QString &pFactor1,
+                                           const QString &pFactor2)
+{
+    // Return the product of the given factors
+
+    if (pFactor1.isEmpty() || pFactor2.isEmpty()) {
+        return {};
+    }
+
+    static const QString One = "1.0";
+
+    if (pFactor1 == One) {
+        return pFactor2;
+    }
+
+    if (pFactor2 == One) {
+        return pFactor1;
+    }
+
+    return "("+pFactor1+"*"+pFactor2+")";
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::negation(const QString &pTerm)
+{
+    // Return the negation of the given term
+
+    if (pTerm.isEmpty()) {
+        return {};
+    }
+
+    return "(-"+pTerm+")";
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::parseTernary(Derivatives &pDerivatives)
+{
+    // Parse a (possibly) ternary expression
+    // Note: the derivatives of a condition are irrelevant since a condition is
+    //       piecewise constant...
+
+    Derivatives conditionDerivatives;
+    QString condition = parseCondition(0, conditionDerivatives);
+
+    if (!acceptToken("?")) {
+        pDerivatives = conditionDerivatives;
+
+        return condition;
+    }
+
+    Derivatives trueDerivatives;
+    QString trueValue = parseTernary(trueDerivatives);
+
+    expectToken(":");
+
+    Derivatives falseDerivatives;
+    QString falseValue = parseTernary(falseDerivatives);
+
+    static const QString Zero = "0.0";
+
+    QSet<int> states = QSet<int>::fromList(trueDerivatives.keys())+QSet<int>::fromList(falseDerivatives.keys());
+
+    for (auto state : states) {
+        pDerivatives.insert(state, "("+condition+"?"+trueDerivatives.value(state, Zero)+":"+falseDerivatives.value(state, Zero)+")");
+    }
+
+    return "("+condition+"?"+trueValue+":"+falseValue+")";
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::parseCondition(int pLevel,
+                                                  Derivatives &pDerivatives)
+{
+    // Parse a logical, equality or relational expression, which result is
+    // piecewise constant and therefore has no derivatives
+
+    static const QList<QStringList> Operators = { { "||" },
+                                                  { "&&" },
+                                                  { "==", "!=" },
+                                                  { "<", ">", "<=", ">=" } };
+
+    if (pLevel == Operators.count()) {
+        return parseAdditive(pDerivatives);
+    }
+
+    QString res = parseCondition(pLevel+1, pDerivatives);
+
+    while (mValid && Operators[pLevel].contains(token())) {
+        QString operation = nextToken();
+        Derivatives derivatives;
+
+        res = "("+res+operation+parseCondition(pLevel+1, derivatives)+")";
+
+        pDerivatives.clear();
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::parseAdditive(Derivatives &pDerivatives)
+{
+    // Parse an additive expression
+
+    QString res = parseMultiplicative(pDerivatives);
+
+    while (mValid && ((token() == "+") || (token() == "-"))) {
+        bool addition = nextToken() == "+";
+        Derivatives derivatives;
+        QString term = parseMultiplicative(derivatives);
+
+        for (auto derivative = derivatives.constBegin(), derivativeEnd = derivatives.constEnd();
+             derivative != derivativeEnd; ++derivative) {
+            QString currentDerivative = pDerivatives.value(derivative.key());
+            QString newDerivative = addition?
+                                        sum(currentDerivative, derivative.value()):
+                                        difference(currentDerivative, derivative.value());
+
+            pDerivatives.insert(derivative.key(), newDerivative);
+        }
+
+        res = "("+res+(addition?"+":"-")+term+")";
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::parseMultiplicative(Derivatives &pDerivatives)
+{
+    // Parse a multiplicative expression
+
+    QString res = parseUnary(pDerivatives);
+
+    while (mValid && ((token() == "*") || (token() == "/") || (token() == "%"))) {
+        QString operation = nextToken();
+        Derivatives derivatives;
+        QString factor = parseUnary(derivatives);
+        QString newRes = "("+res+operation+factor+")";
+        QSet<int> states = QSet<int>::fromList(pDerivatives.keys())+QSet<int>::fromList(derivatives.keys());
+        Derivatives newDerivatives;
+
+        if (operation == "*") {
+            // (u*v)' = u'*v+u*v'
+
+            for (auto state : states) {
+                newDerivatives.insert(state, sum(product(pDerivatives.value(state), factor),
+                                                 product(res, derivatives.value(state))));
+            }
+        } else if (operation == "/") {
+            // (u/v)' = (u'-(u/v)*v')/v
+
+            for (auto state : states) {
+                QString numerator = difference(pDerivatives.value(state),
+                                               product(newRes, derivatives.value(state)));
+
+                if (!numerator.isEmpty()) {
+                    newDerivatives.insert(state, "("+numerator+"/"+factor+")");
+                }
+            }
+        }
+
+        // Note: the CellML API only ever uses the modulo operator with integer
+        //       operands, so its derivatives are always zero...
+
+        pDerivatives = newDerivatives;
+
+        res = newRes;
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::parseUnary(Derivatives &pDerivatives)
+{
+    // Parse a unary expression
+
+    if (acceptToken("-")) {
+        QString res = parseUnary(pDerivatives);
+
+        for (auto &derivative : pDerivatives) {
+            derivative = negation(derivative);
+        }
+
+        return "(-"+res+")";
+    }
+
+    if (acceptToken("+")) {
+        return parseUnary(pDerivatives);
+    }
+
+    if (acceptToken("!")) {
+        QString res = parseUnary(pDerivatives);
+
+        pDerivatives.clear();
+
+        return "(!"+res+")";
+    }
+
+    return parsePrimary(pDerivatives);
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::parsePrimary(Derivatives &pDerivatives)
+{
+    // Parse a primary expression
+
+    QString currentToken = nextToken();
+
+    if (currentToken == "(") {
+        // Check whether we are dealing with a cast or with a parenthesised
+        // expression
+
+        static const QString Int = "int";
+        static const QString Double = "double";
+
+        if (   ((token() == Int) || (token() == Double))
+            && (mTokens.value(mTokenIndex+1) == ")")) {
+            QString type = nextToken();
+
+            nextToken();
+
+            QString res = parseUnary(pDerivatives);
+
+            if (type == Int) {
+                pDerivatives.clear();
+            }
+
+            return "(("+type+")"+res+")";
+        }
+
+        // Note: our expressions are either atomic or fully parenthesised, so
+        //       no need to add parentheses...
+
+        QString res = parseTernary(pDerivatives);
+
+        expectToken(")");
+
+        return res;
+    }
+
+    if (isNumber(currentToken)) {
+        return currentToken;
+    }
+
+    if (isIdentifier(currentToken)) {
+        if (currentToken == "VOI") {
+            return currentToken;
+        }
+
+        if (acceptToken("(")) {
+            return parseFunction(currentToken, pDerivatives);
+        }
+
+        if (acceptToken("[")) {
+            QString index = nextToken();
+            bool validIndex;
+            int indexValue = index.toInt(&validIndex);
+
+            expectToken("]");
+
+            QString variable = currentToken+"["+index+"]";
+
+            if (!validIndex) {
+                invalidate();
+            } else if (currentToken == "STATES") {
+                if ((indexValue >= 0) && (indexValue < mStatesCount)) {
+                    pDerivatives.insert(indexValue, "1.0");
+                } else {
+                    invalidate();
+                }
+            } else if (   (currentToken == "ALGEBRAIC")
+                       || (currentToken == "RATES")) {
+                // Note: an algebraic variable or a rate that hasn't been
+                //       computed as part of our code doesn't depend on any
+                //       state variable...
+
+                pDerivatives = mVariablesDerivatives.value(variable);
+            } else if (currentToken != "CONSTANTS") {
+                invalidate();
+            }
+
+            return variable;
+        }
+    }
+
+    invalidate();
+
+    return {};
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::parseFunction(const QString &pName,
+                                                 Derivatives &pDerivatives)
+{
+    // Parse the arguments of the given function
+
+    QStringList arguments;
+    QList<Derivatives> argumentsDerivatives;
+
+    if (!acceptToken(")")) {
+        do {
+            Derivatives derivatives;
+
+            arguments << parseTernary(derivatives);
+            argumentsDerivatives << derivatives;
+        } while (mValid && acceptToken(","));
+
+        expectToken(")");
+    }
+
+    QString res = pName+"("+arguments.join(",")+")";
+
+    // Determine the derivatives of the function, if any
+
+    bool hasDerivatives = false;
+
+    for (const auto &derivatives : argumentsDerivatives) {
+        if (!derivatives.isEmpty()) {
+            hasDerivatives = true;
+
+            break;
+        }
+    }
+
+    if (   !mValid || !hasDerivatives
+        || (pName == "floor") || (pName == "ceil") || (pName == "factorial")) {
+        // Either something went wrong, the arguments of the function don't
+        // depend on any state variable or the function is piecewise constant
+
+        return res;
+    }
+
+    if ((pName == "pow") && (arguments.count() == 2)) {
+        // (u^v)' = v*u^(v-1)*u'+u^v*ln(u)*v'
+
+        QString baseFactor = "("+arguments[1]+"*pow("+arguments[0]+",("+arguments[1]+"-1.0)))";
+        QString exponentFactor = "("+res+"*log("+arguments[0]+"))";
+        QSet<int> states = QSet<int>::fromList(argumentsDerivatives[0].keys())+QSet<int>::fromList(argumentsDerivatives[1].keys());
+
+        for (auto state : states) {
+            pDerivatives.insert(state, sum(product(baseFactor, argumentsDerivatives[0].value(state)),
+                                           product(exponentFactor, argumentsDerivatives[1].value(state))));
+        }
+
+        return res;
+    }
+
+    if (   (pName == "arbitrary_log") && (arguments.count() == 2)
+        && argumentsDerivatives[1].isEmpty()) {
+        // (log_b(u))' = u'/(u*ln(b)), with b a constant
+
+        QString factor = "(1.0/("+arguments[0]+"*log("+arguments[1]+")))";
+
+        for (auto derivative = argumentsDerivatives[0].constBegin(), derivativeEnd = argumentsDerivatives[0].constEnd();
+             derivative != derivativeEnd; ++derivative) {
+            pDerivatives.insert(derivative.key(), product(factor, derivative.value()));
+        }
+
+        return res;
+    }
+
+    // We are dealing with a function that we can only differentiate if it has
+    // one argument (i.e. not min(), max(), gcd() or lcm())
+
+    QString factor = (arguments.count() == 1)?
+                         functionDerivative(pName, arguments):
+                         QString();
+
+    if (factor.isEmpty()) {
+        invalidate();
+
+        return {};
+    }
+
+    for (auto derivative = argumentsDerivatives[0].constBegin(), derivativeEnd = argumentsDerivatives[0].constEnd();
+         derivative != derivativeEnd; ++derivative) {
+        pDerivatives.insert(derivative.key(), product(factor, derivative.value()));
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+QString CellmlFileRuntimeJacobian::functionDerivative(const QString &pName,
+                                                      const QStringList &pArguments)
+{
+    // Return the derivative of the given one-argument function, or an empty
+    // string if we don't know how to differentiate it
+    // Note: our arguments are either atomic or fully parenthesised, so we can
+    //       safely use them as operands...
+
+    QString u = pArguments.first();
+    QString uSquared = u+"*"+u;
+
+    if (pName == "fabs") {
+        return "(("+u+"<0.0)?-1.0:1.0)";
+    }
+
+    if (pName == "exp") {
+        return "exp("+u+")";
+    }
+
+    if (pName == "log") {
+        return "(1.0/"+u+")";
+    }
+
+    if (pName == "sin") {
+        return "cos("+u+")";
+    }
+
+    if (pName == "cos") {
+        return "(-sin("+u+"))";
+    }
+
+    if (pName == "tan") {
+        return "(1.0/(cos("+u+")*cos("+u+")))";
+    }
+
+    if (pName == "sinh") {
+        return "cosh("+u+")";
+    }
+
+    if (pName == "cosh") {
+        return "sinh("+u+")";
+    }
+
+    if (pName == "tanh") {
+        return "(1.0-tanh("+u+")*tanh("+u+"))";
+    }
+
+    if (pName == "asin") {
+        return "(1.0/pow(1.0-"+uSquared+",0.5))";
+    }
+
+    if (pName == "acos") {
+        return "(-1.0/pow(1.0-"+uSquared+",0.5))";
+    }
+
+    if (pName == "atan") {
+        return "(1.0/(1.0+"+uSquared+"))";
+    }
+
+    if (pName == "asinh") {
+        return "(1.0/pow("+uSquared+"+1.0,0.5))";
+    }
+
+    if (pName == "acosh") {
+        return "(1.0/pow("+uSquared+"-1.0,0.5))";
+    }
+
+    if ((pName == "atanh") || (pName == "acoth")) {
+        return "(1.0/(1.0-"+uSquared+"))";
+    }
+
+    if (pName == "sec") {
+        return "(sec("+u+")*tan("+u+"))";
+    }
+
+    if (pName == "csc") {
+        return "(-csc("+u+")*cot("+u+"))";
+    }
+
+    if (pName == "cot") {
+        return "(-csc("+u+")*csc("+u+"))";
+    }
+
+    if (pName == "sech") {
+        return "(-sech("+u+")*tanh("+u+"))";
+    }
+
+    if (pName == "csch") {
+        return "(-csch("+u+")*coth("+u+"))";
+    }
+
+    if (pName == "coth") {
+        return "(-csch("+u+")*csch("+u+"))";
+    }
+
+    if (pName == "asec") {
+        return "(1.0/(fabs("+u+")*pow("+uSquared+"-1.0,0.5)))";
+    }
+
+    if (pName == "acsc") {
+        return "(-1.0/(fabs("+u+")*pow("+uSquared+"-1.0,0.5)))";
+    }
+
+    if (pName == "acot") {
+        return "(-1.0/(1.0+"+uSquared+"))";
+    }
+
+    if (pName == "asech") {
+        return "(-1.0/("+u+"*pow(1.0-"+uSquared+",0.5)))";
+    }
+
+    if (pName == "acsch") {
+        return "(-1.0/(fabs("+u+")*pow(1.0+"+uSquared+",0.5)))";
+    }
+
+    return {};
+}
+
+//==============================================================================
+
+} // namespace CellMLSupport
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -0,0 +1,108 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// CellML file runtime Jacobian
+//==============================================================================
+
+#pragma once
+
+//==============================================================================
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace CellMLSupport {
+
+//==============================================================================
+
+class CellmlFileRuntimeJacobian
+{
+public:
+    explicit CellmlFileRuntimeJacobian(const QString &pRatesCode,
+                                       int pStatesCount);
+
+    bool isValid() const;
+
+    QString code() const;
+
+    int nonZeroCount() const;
+
+    QVector<int> columnPointers() const;
+    QVector<int> rowIndices() const;
+
+private:
+    using Derivatives = QMap<int, QString>;
+
+    int mStatesCount;
+
+    bool mValid = true;
+
+    QString mCode;
+
+    QVector<int> mColumnPointers;
+    QVector<int> mRowIndices;
+
+    QStringList mTokens;
+    int mTokenIndex = 0;
+
+    QMap<QString, Derivatives> mVariablesDerivatives;
+
+    void generate(const QString &pRatesCode);
+
+    void invalidate();
+
+    QString token() const;
+    QString nextToken();
+    bool acceptToken(const QString &pToken);
+    void expectToken(const QString &pToken);
+
+    static bool isNumber(const QString &pToken);
+    static bool isIdentifier(const QString &pToken);
+
+    static QString sum(const QString &pTerm1, const QString &pTerm2);
+    static QString difference(const QString &pTerm1, const QString &pTerm2);
+    static QString product(const QString &pFactor1, const QString &pFactor2);
+    static QString negation(const QString &pTerm);
+
+    QString parseTernary(Derivatives &pDerivatives);
+    QString parseCondition(int pLevel, Derivatives &pDerivatives);
+    QString parseAdditive(Derivatives &pDerivatives);
+    QString parseMultiplicative(Derivatives &pDerivatives);
+    QString parseUnary(Derivatives &pDerivatives);
+    QString parsePrimary(Derivatives &pDerivatives);
+    QString parseFunction(const QString &pName, Derivatives &pDerivatives);
+
+    QString functionDerivative(const QString &pName,
+                               const QStringList &pArguments);
+};
+
+//==============================================================================
+
+} // namespace CellMLSupport
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
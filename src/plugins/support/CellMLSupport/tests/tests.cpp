@@ -134,6 +134,154 @@ void Tests::runtimeTests()
 
 //==============================================================================
 
+void Tests::jacobianTest(const QString &pFileName)
+{
+    // Retrieve a runtime for the given CellML file and make sure that it has an
+    // analytical Jacobian
+
+    OpenCOR::CellMLSupport::CellmlFile cellmlFile(pFileName);
+    OpenCOR::CellMLSupport::CellmlFileRuntime *runtime = cellmlFile.runtime();
+
+    QVERIFY(runtime);
+    QVERIFY(runtime->isValid());
+    QVERIFY(runtime->computeJacobian() != nullptr);
+
+    // Initialise our model
+
+    static const double Voi = 0.0;
+
+    int statesCount = runtime->statesCount();
+    QVector<double> constants(runtime->constantsCount());
+    QVector<double> rates(runtime->ratesCount());
+    QVector<double> otherRates(runtime->ratesCount());
+    QVector<double> states(statesCount);
+    QVector<double> algebraic(runtime->algebraicCount());
+
+    runtime->initializeConstants()(constants.data(), rates.data(), states.data());
+    runtime->computeComputedConstants()(Voi, constants.data(), rates.data(), states.data(), algebraic.data());
+
+    // Compute our analytical Jacobian and check that each of its non-zero
+    // entries matches a central finite difference approximation
+
+    QVector<int> columnPointers = runtime->jacobianColumnPointers();
+    QVector<int> rowIndices = runtime->jacobianRowIndices();
+    QVector<double> jacobian(rowIndices.count());
+
+    QCOMPARE(columnPointers.count(), statesCount+1);
+
+    runtime->computeJacobian()(Voi, constants.data(), rates.data(), states.data(), algebraic.data(), jacobian.data());
+
+    for (int column = 0; column < statesCount; ++column) {
+        double state = states[column];
+        double delta = 1.0e-6*qMax(1.0, qAbs(state));
+
+        states[column] = state+delta;
+
+        runtime->computeRates()(Voi, constants.data(), rates.data(), states.data(), algebraic.data());
+
+        states[column] = state-delta;
+
+        runtime->computeRates()(Voi, constants.data(), otherRates.data(), states.data(), algebraic.data());
+
+        states[column] = state;
+
+        for (int i = columnPointers[column]; i < columnPointers[column+1]; ++i) {
+            int row = rowIndices[i];
+            double approximation = (rates[row]-otherRates[row])/(2.0*delta);
+
+            QVERIFY(qAbs(jacobian[i]-approximation) <= 1.0e-5*qMax(1.0, qAbs(approximation)));
+        }
+    }
+}
+
+//==============================================================================
+
+void Tests::jacobianTests()
+{
+    // Check the analytical Jacobian of some models
+
+    jacobianTest(OpenCOR::fileName("models/noble_model_1962.cellml"));
+    jacobianTest(OpenCOR::fileName("models/hodgkin_huxley_squid_axon_model_1952.cellml"));
+    jacobianTest(OpenCOR::fileName("models/van_der_pol_model_1928.cellml"));
+}
+
+//==============================================================================
+
+void Tests::ensembleTest(const QString &pFileName)
+{
+    // Retrieve a runtime for the given CellML file and make sure that it has an
+    // ensemble version of its rates
+
+    OpenCOR::CellMLSupport::CellmlFile cellmlFile(pFileName);
+    OpenCOR::CellMLSupport::CellmlFileRuntime *runtime = cellmlFile.runtime();
+
+    QVERIFY(runtime);
+    QVERIFY(runtime->isValid());
+    QVERIFY(runtime->computeEnsembleRates() != nullptr);
+
+    // Initialise an ensemble of slightly different instances of our model,
+    // using a structure-of-arrays layout
+
+    static const double Voi = 0.0;
+    static const int EnsembleSize = 5;
+
+    int constantsCount = runtime->constantsCount();
+    int ratesCount = runtime->ratesCount();
+    int statesCount = runtime->statesCount();
+    int algebraicCount = runtime->algebraicCount();
+    QVector<double> constants(constantsCount);
+    QVector<double> rates(ratesCount);
+    QVector<double> states(statesCount);
+    QVector<double> algebraic(algebraicCount);
+    QVector<double> ensembleConstants(constantsCount*EnsembleSize);
+    QVector<double> ensembleRates(ratesCount*EnsembleSize);
+    QVector<double> ensembleStates(statesCount*EnsembleSize);
+    QVector<double> ensembleAlgebraic(algebraicCount*EnsembleSize);
+
+    runtime->initializeConstants()(constants.data(), rates.data(), states.data());
+    runtime->computeComputedConstants()(Voi, constants.data(), rates.data(), states.data(), algebraic.data());
+
+    for (int j = 0; j < EnsembleSize; ++j) {
+        for (int i = 0; i < constantsCount; ++i) {
+            ensembleConstants[i*EnsembleSize+j] = constants[i];
+        }
+
+        for (int i = 0; i < statesCount; ++i) {
+            ensembleStates[i*EnsembleSize+j] = (1.0+0.01*j)*states[i];
+        }
+    }
+
+    // Compute the rates of our ensemble and check that they match those of each
+    // of its instances
+
+    runtime->computeEnsembleRates()(Voi, ensembleConstants.data(), ensembleRates.data(), ensembleStates.data(), ensembleAlgebraic.data(), EnsembleSize);
+
+    for (int j = 0; j < EnsembleSize; ++j) {
+        for (int i = 0; i < statesCount; ++i) {
+            states[i] = ensembleStates[i*EnsembleSize+j];
+        }
+
+        runtime->computeRates()(Voi, constants.data(), rates.data(), states.data(), algebraic.data());
+
+        for (int i = 0; i < ratesCount; ++i) {
+            QCOMPARE(ensembleRates[i*EnsembleSize+j], rates[i]);
+        }
+    }
+}
+
+//==============================================================================
+
+void Tests::ensembleTests()
+{
+    // Check the ensemble rates of some models
+
+    ensembleTest(OpenCOR::fileName("models/noble_model_1962.cellml"));
+    ensembleTest(OpenCOR::fileName("models/hodgkin_huxley_squid_axon_model_1952.cellml"));
+    ensembleTest(OpenCOR::fileName("models/van_der_pol_model_1928.cellml"));
+}
+
+//==============================================================================
+
 QTEST_GUILESS_MAIN(Tests)
 
 //==============================================================================
@@ -36,9 +36,13 @@ class Tests : public QObject
 private:
     void runtimeTest(const QString &pFileName, const QString &pCellmlVersion,
                      const QStringList &pModelParameters, bool pIsValid = true);
+    void jacobianTest(const QString &pFileName);
+    void ensembleTest(const QString &pFileName);
 
 private slots:
     void runtimeTests();
+    void jacobianTests();
+    void ensembleTests();
 };
 
 //==============================================================================
@@ -1,3 +1,4 @@
+import numpy as np
 import opencor as oc
 import sys
 
@@ -176,4 +177,15 @@ if __name__ == '__main__':
     test_data_store_variables(data_store.variables(), 'DataStore.variables()', '   ')
     test_data_store_variables(data_store.voi_and_variables(), 'DataStore.voi_and_variables()', '   ')
 
+    # Make sure that the rows of our data store's matrix are the values of our
+    # VOI and variables
+    # Note: we only print something if this is not the case...
+
+    matrix = data_store.matrix()
+    voi_and_variables = data_store.voi_and_variables()
+
+    for uri, row in data_store.matrix_rows().items():
+        if not np.array_equal(matrix[row], voi_and_variables[uri].values(), equal_nan=True):
+            print('       - DataStore.matrix() row %d is not the same as the values of %s' % (row, uri))
+
     oc.close_simulation(simulation)
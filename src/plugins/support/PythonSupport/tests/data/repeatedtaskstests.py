@@ -0,0 +1,47 @@
+import opencor as oc
+import sys
+
+sys.dont_write_bytecode = True
+
+import utils
+
+
+def test_repeated_task(title, file_name, first=True):
+    # Header
+
+    utils.header(title, first)
+
+    # Open the simulation and run its repeated task
+
+    simulation = utils.open_simulation(file_name)
+    repeated_task = simulation.repeatedTask()
+
+    repeated_task.run()
+
+    # Output the initial and final value of y for each iteration
+
+    for i in range(repeated_task.iterationsCount()):
+        y = repeated_task.dataStore(i).voi_and_variables()['main/y']
+        values_count = y.values_count()
+
+        print(' - Iteration #%d: y(0) = %s, y(1) = %s'
+              % (i + 1, utils.str_value(y.value(0)),
+                 utils.str_value(y.value(values_count - 1))))
+
+    # Close the simulation
+
+    oc.close_simulation(simulation)
+
+
+if __name__ == '__main__':
+    # Test repeated tasks that reset or don't reset the model, as well as
+    # nested repeated tasks
+
+    test_repeated_task('Repeated task that resets the model',
+                       'tests/sedml/parabola_repeated_task_reset.sedml')
+    test_repeated_task('Repeated task that does not reset the model',
+                       'tests/sedml/parabola_repeated_task_no_reset.sedml',
+                       False)
+    test_repeated_task('Nested repeated tasks',
+                       'tests/sedml/parabola_repeated_task_nested.sedml',
+                       False)
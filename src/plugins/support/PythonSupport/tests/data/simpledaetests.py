@@ -0,0 +1,46 @@
+import opencor as oc
+import sys
+
+sys.dont_write_bytecode = True
+
+import utils
+
+
+def run_simulation(simulation, run):
+    # Run the simulation and output the values of a (a state) and b (which is
+    # computed using the NLA solver) every 2.5 time units
+
+    simulation.run()
+
+    results = simulation.results()
+    a = results.states()['main/a'].values()
+    b = results.algebraic()['main/b'].values()
+
+    print(' - Run #%d:' % run)
+    print('    - Number of points: %d' % len(a))
+
+    for i in range(25, len(a), 25):
+        print('    - t = %.1f: a = %.3f, b = %.3f' % (0.1 * i, a[i], b[i]))
+
+
+if __name__ == '__main__':
+    # Test a DAE model, i.e. a model that needs an NLA solver for each of its
+    # rates evaluations, and make sure that we get the same results when
+    # running it again (i.e. when the NLA solver reuses its data)
+
+    utils.header('Simple DAE model')
+
+    simulation = utils.open_simulation('tests/cellml/simple_dae_model.cellml')
+    data = simulation.data()
+
+    data.set_ending_point(7.5)
+    data.set_point_interval(0.1)
+
+    run_simulation(simulation, 1)
+
+    simulation.reset()
+    simulation.clear_results()
+
+    run_simulation(simulation, 2)
+
+    oc.close_simulation(simulation)
@@ -0,0 +1,53 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Python support simple DAE model tests
+//==============================================================================
+
+#include "../../../../tests/src/testsutils.h"
+
+//==============================================================================
+
+#include "simpledaetests.h"
+
+//==============================================================================
+
+#include <QtTest/QtTest>
+
+//==============================================================================
+
+void SimpleDaeTests::tests()
+{
+    // Some tests to make sure that a DAE model (i.e. a model that needs an NLA
+    // solver) works fine
+
+    QStringList output;
+
+    QVERIFY(!OpenCOR::runCli({ "-c", "PythonShell", OpenCOR::fileName("src/plugins/support/PythonSupport/tests/data/simpledaetests.py") }, output));
+    QCOMPARE(output, OpenCOR::fileContents(OpenCOR::fileName("src/plugins/support/PythonSupport/tests/data/simpledaetests.out")));
+}
+
+//==============================================================================
+
+QTEST_GUILESS_MAIN(SimpleDaeTests)
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -95,8 +95,60 @@
         <translation>seulement les fichiers SED-ML avec deux simulations avec le même algorithme sont supportés</translation>
     </message>
     <message>
-        <source>only SED-ML files that execute one or two simulations once are supported</source>
-        <translation>seulement les fichiers SED-ML qui exécutent une ou deux simulations sont supportés</translation>
+        <source>only SED-ML files with tasks that reference the model and one of the simulations are supported</source>
+        <translation>seulement les fichiers SED-ML avec des tâches qui référencent le modèle et une des simulations sont supportés</translation>
+    </message>
+    <message>
+        <source>only SED-ML files with tasks and repeated tasks are supported</source>
+        <translation>seulement les fichiers SED-ML avec des tâches et des tâches répétitives sont supportés</translation>
+    </message>
+    <message>
+        <source>only SED-ML files with one main repeated task are supported</source>
+        <translation>seulement les fichiers SED-ML avec une tâche répétitive principale sont supportés</translation>
+    </message>
+    <message>
+        <source>only SED-ML files with ranges and changes that use variables with a reference to a CellML variable are supported</source>
+        <translation>seulement les fichiers SED-ML avec des intervalles et des changements qui utilisent des variables avec une référence à une variable CellML sont supportés</translation>
+    </message>
+    <message>
+        <source>the repeated task &apos;%1&apos; cannot be one of its own sub-tasks</source>
+        <translation>la tâche répétitive &apos;%1&apos; ne peut pas être une de ses propres sous-tâches</translation>
+    </message>
+    <message>
+        <source>the repeated task &apos;%1&apos; must reference one of its ranges</source>
+        <translation>la tâche répétitive &apos;%1&apos; doit référencer un de ses intervalles</translation>
+    </message>
+    <message>
+        <source>a vector range must have at least one value</source>
+        <translation>un intervalle vectoriel doit avoir au moins une valeur</translation>
+    </message>
+    <message>
+        <source>only SED-ML files with linear and logarithmic uniform ranges are supported</source>
+        <translation>seulement les fichiers SED-ML avec des intervalles uniformes linéaires et logarithmiques sont supportés</translation>
+    </message>
+    <message>
+        <source>a uniform range must have a number of points greater than zero and, if logarithmic, start and end values greater than zero</source>
+        <translation>un intervalle uniforme doit avoir un nombre de points plus grand que zéro et, s&apos;il est logarithmique, des valeurs de départ et d&apos;arrivée plus grandes que zéro</translation>
+    </message>
+    <message>
+        <source>a functional range must have some maths</source>
+        <translation>un intervalle fonctionnel doit avoir des mathématiques</translation>
+    </message>
+    <message>
+        <source>only SED-ML files with vector, uniform and functional ranges are supported</source>
+        <translation>seulement les fichiers SED-ML avec des intervalles vectoriels, uniformes et fonctionnels sont supportés</translation>
+    </message>
+    <message>
+        <source>only SED-ML files with task changes that set the value of a CellML variable are supported</source>
+        <translation>seulement les fichiers SED-ML avec des changements de tâche qui spécifient la valeur d&apos;une variable CellML sont supportés</translation>
+    </message>
+    <message>
+        <source>the repeated task &apos;%1&apos; must have at least one sub-task</source>
+        <translation>la tâche répétitive &apos;%1&apos; doit avoir au moins une sous-tâche</translation>
+    </message>
+    <message>
+        <source>the sub-task &apos;%1&apos; does not exist</source>
+        <translation>la sous-tâche &apos;%1&apos; n&apos;existe pas</translation>
     </message>
     <message>
         <source>only SED-ML files with data generators for one variable are supported</source>
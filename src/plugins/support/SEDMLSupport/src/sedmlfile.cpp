@@ -35,6 +35,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 #include <QDir>
 #include <QRegularExpression>
+#include <QSet>
 #include <QTemporaryFile>
 
 //==============================================================================
@@ -42,12 +43,15 @@ along with this program. If not, see <https://gnu.org/licenses>.
 #include "libsedmlbegin.h"
     #include "sedml/SedCurve.h"
     #include "sedml/SedDocument.h"
+    #include "sedml/SedFunctionalRange.h"
     #include "sedml/SedOneStep.h"
     #include "sedml/SedPlot2D.h"
     #include "sedml/SedReader.h"
     #include "sedml/SedRepeatedTask.h"
+    #include "sedml/SedSetValue.h"
     #include "sedml/SedTask.h"
     #include "sedml/SedWriter.h"
+    #include "sedml/SedUniformRange.h"
     #include "sedml/SedUniformTimeCourse.h"
     #include "sedml/SedVectorRange.h"
 #include "libsedmlend.h"
@@ -107,6 +111,7 @@ void SedmlFile::reset()
     delete mSedmlDocument;
 
     mSedmlDocument = nullptr;
+    mRepeatedTask = nullptr;
     mCellmlFile = nullptr;
 
     mLoadingNeeded = true;
@@ -576,6 +581,195 @@ bool SedmlFile::validColorPropertyValue(const libsbml::XMLNode &pPropertyNode,
 
 //==============================================================================
 
+bool SedmlFile::validComputeVariables(const libsedml::SedListOfVariables *pVariables)
+{
+    // Make sure that the given variables, which are used to compute a range or
+    // a change, reference a CellML variable
+
+    for (uint i = 0, iMax = pVariables->getNumVariables(); i < iMax; ++i) {
+        const libsedml::SedVariable *variable = pVariables->get(i);
+
+        if (   !variable->getSymbol().empty()
+            || cellmlVariableUri(QString::fromStdString(variable->getTarget())).isEmpty()) {
+            mIssues << SedmlFileIssue(SedmlFileIssue::Type::Unsupported,
+                                      int(variable->getLine()),
+                                      int(variable->getColumn()),
+                                      tr("only SED-ML files with ranges and changes that use variables with a reference to a CellML variable are supported"));
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+
+bool SedmlFile::validRepeatedTask(libsedml::SedRepeatedTask *pRepeatedTask,
+                                  QStringList &pRepeatedTaskIds)
+{
+    // Make sure that the given repeated task is not one of its own (direct or
+    // indirect) sub-tasks
+
+    QString repeatedTaskId = QString::fromStdString(pRepeatedTask->getId());
+
+    if (pRepeatedTaskIds.contains(repeatedTaskId)) {
+        mIssues << SedmlFileIssue(SedmlFileIssue::Type::Error,
+                                  int(pRepeatedTask->getLine()),
+                                  int(pRepeatedTask->getColumn()),
+                                  tr("the repeated task '%1' cannot be one of its own sub-tasks").arg(repeatedTaskId));
+
+        return false;
+    }
+
+    // Make sure that the repeated task references one of its ranges, since it
+    // determines its number of iterations
+
+    if (pRepeatedTask->getRange(pRepeatedTask->getRangeId()) == nullptr) {
+        mIssues << SedmlFileIssue(SedmlFileIssue::Type::Error,
+                                  int(pRepeatedTask->getLine()),
+                                  int(pRepeatedTask->getColumn()),
+                                  tr("the repeated task '%1' must reference one of its ranges").arg(repeatedTaskId));
+
+        return false;
+    }
+
+    // Make sure that the ranges are either vector, uniform or functional
+    // ranges, and that they are sound
+
+    static const std::string Linear = "linear";
+    static const std::string Log = "log";
+
+    for (uint i = 0, iMax = pRepeatedTask->getNumRanges(); i < iMax; ++i) {
+        libsedml::SedRange *range = pRepeatedTask->getRange(i);
+        int line = int(range->getLine());
+        int column = int(range->getColumn());
+
+        switch (range->getTypeCode()) {
+        case libsedml::SEDML_RANGE_VECTORRANGE:
+            if (static_cast<libsedml::SedVectorRange *>(range)->getNumValues() == 0) {
+                mIssues << SedmlFileIssue(SedmlFileIssue::Type::Error,
+                                          line, column,
+                                          tr("a vector range must have at least one value"));
+
+                return false;
+            }
+
+            break;
+        case libsedml::SEDML_RANGE_UNIFORMRANGE: {
+            auto uniformRange = static_cast<libsedml::SedUniformRange *>(range);
+
+            if ((uniformRange->getType() != Linear) && (uniformRange->getType() != Log)) {
+                mIssues << SedmlFileIssue(SedmlFileIssue::Type::Unsupported,
+                                          line, column,
+                                          tr("only SED-ML files with linear and logarithmic uniform ranges are supported"));
+
+                return false;
+            }
+
+            if (uniformRangeValues(uniformRange->getStart(),
+                                   uniformRange->getEnd(),
+                                   uniformRange->getNumberOfPoints(),
+                                   uniformRange->getType() == Log).isEmpty()) {
+                mIssues << SedmlFileIssue(SedmlFileIssue::Type::Error,
+                                          line, column,
+                                          tr("a uniform range must have a number of points greater than zero and, if logarithmic, start and end values greater than zero"));
+
+                return false;
+            }
+
+            break;
+        }
+        case libsedml::SEDML_RANGE_FUNCTIONALRANGE: {
+            auto functionalRange = static_cast<libsedml::SedFunctionalRange *>(range);
+
+            if (functionalRange->getMath() == nullptr) {
+                mIssues << SedmlFileIssue(SedmlFileIssue::Type::Error,
+                                          line, column,
+                                          tr("a functional range must have some maths"));
+
+                return false;
+            }
+
+            if (!validComputeVariables(functionalRange->getListOfVariables())) {
+                return false;
+            }
+
+            break;
+        }
+        default:
+            mIssues << SedmlFileIssue(SedmlFileIssue::Type::Unsupported,
+                                      line, column,
+                                      tr("only SED-ML files with vector, uniform and functional ranges are supported"));
+
+            return false;
+        }
+    }
+
+    // Make sure that the task changes set the value of a CellML variable using
+    // some maths
+
+    for (uint i = 0, iMax = pRepeatedTask->getNumTaskChanges(); i < iMax; ++i) {
+        libsedml::SedSetValue *setValue = pRepeatedTask->getTaskChange(i);
+
+        if (   cellmlVariableUri(QString::fromStdString(setValue->getTarget())).isEmpty()
+            || (setValue->getMath() == nullptr)
+            || (   !setValue->getRange().empty()
+                && (pRepeatedTask->getRange(setValue->getRange()) == nullptr))) {
+            mIssues << SedmlFileIssue(SedmlFileIssue::Type::Unsupported,
+                                      int(setValue->getLine()),
+                                      int(setValue->getColumn()),
+                                      tr("only SED-ML files with task changes that set the value of a CellML variable are supported"));
+
+            return false;
+        }
+
+        if (!validComputeVariables(setValue->getListOfVariables())) {
+            return false;
+        }
+    }
+
+    // Make sure that the repeated task has at least one sub-task and that its
+    // sub-tasks, if they are themselves repeated tasks, are also valid
+
+    if (pRepeatedTask->getNumSubTasks() == 0) {
+        mIssues << SedmlFileIssue(SedmlFileIssue::Type::Error,
+                                  int(pRepeatedTask->getLine()),
+                                  int(pRepeatedTask->getColumn()),
+                                  tr("the repeated task '%1' must have at least one sub-task").arg(repeatedTaskId));
+
+        return false;
+    }
+
+    pRepeatedTaskIds << repeatedTaskId;
+
+    for (uint i = 0, iMax = pRepeatedTask->getNumSubTasks(); i < iMax; ++i) {
+        libsedml::SedSubTask *subTask = pRepeatedTask->getSubTask(i);
+        libsedml::SedAbstractTask *task = mSedmlDocument->getTask(subTask->getTask());
+
+        if (task == nullptr) {
+            mIssues << SedmlFileIssue(SedmlFileIssue::Type::Error,
+                                      int(subTask->getLine()),
+                                      int(subTask->getColumn()),
+                                      tr("the sub-task '%1' does not exist").arg(QString::fromStdString(subTask->getTask())));
+
+            return false;
+        }
+
+        if (   (task->getTypeCode() == libsedml::SEDML_TASK_REPEATEDTASK)
+            && !validRepeatedTask(static_cast<libsedml::SedRepeatedTask *>(task),
+                                  pRepeatedTaskIds)) {
+            return false;
+        }
+    }
+
+    pRepeatedTaskIds.removeLast();
+
+    return true;
+}
+
+//==============================================================================
+
 bool SedmlFile::isSupported()
 {
     // Make sure that we are valid
@@ -830,101 +1024,82 @@ bool SedmlFile::isSupported()
         }
     }
 
-    // Make sure that we have only one repeated task, which aim is to execute
-    // each simulation (using a sub-task) once
+    // Make sure that all our (non-repeated) tasks reference our model and one
+    // of our simulations, and keep track of the tasks that are used as
+    // sub-tasks
 
-    uint totalNbOfTasks = (secondSimulation != nullptr)?3:2;
+    QList<libsedml::SedRepeatedTask *> repeatedTasks;
+    QSet<QString> subTaskIds;
 
-    if (mSedmlDocument->getNumTasks() != totalNbOfTasks) {
-        mIssues << SedmlFileIssue(SedmlFileIssue::Type::Unsupported,
-                                  tr("only SED-ML files that execute one or two simulations once are supported"));
-
-        return false;
-    }
-
-    libsedml::SedRepeatedTask *repeatedTask = nullptr;
-
-    bool repeatedTaskOk = false;
-    std::string repeatedTaskFirstSubTaskId;
-    std::string repeatedTaskSecondSubTaskId;
-
-    bool firstSubTaskOk = false;
-    std::string firstSubTaskId;
-
-    bool secondSubTaskOk = false;
-    std::string secondSubTaskId;
-
-    for (uint i = 0; i < totalNbOfTasks; ++i) {
-        auto task = static_cast<libsedml::SedTask *>(mSedmlDocument->getTask(i));
+    for (uint i = 0, iMax = mSedmlDocument->getNumTasks(); i < iMax; ++i) {
+        libsedml::SedAbstractTask *task = mSedmlDocument->getTask(i);
 
         if (task->getTypeCode() == libsedml::SEDML_TASK_REPEATEDTASK) {
-            // Make sure that the repeated task asks for the model to be reset,
-            // that it has one range, no task change and one/two sub-task/s
+            auto repeatedTask = static_cast<libsedml::SedRepeatedTask *>(task);
 
-            repeatedTask = reinterpret_cast<libsedml::SedRepeatedTask *>(task);
+            repeatedTasks << repeatedTask;
 
-            if (   repeatedTask->getResetModel()
-                && (repeatedTask->getNumRanges() == 1)
-                && (repeatedTask->getNumTaskChanges() == 0)
-                && (repeatedTask->getNumSubTasks() == totalNbOfTasks-1)) {
-                // Make sure that the range is a vector range and that it's the
-                // one referenced in the repeated task
+            for (uint j = 0, jMax = repeatedTask->getNumSubTasks(); j < jMax; ++j) {
+                subTaskIds << QString::fromStdString(repeatedTask->getSubTask(j)->getTask());
+            }
+        } else if (task->getTypeCode() == libsedml::SEDML_TASK) {
+            auto sedmlTask = static_cast<libsedml::SedTask *>(task);
 
-                libsedml::SedRange *range = repeatedTask->getRange(0);
+            if (   (sedmlTask->getModelReference() != model->getId())
+                || (   (sedmlTask->getSimulationReference() != firstSimulation->getId())
+                    && (   (secondSimulation == nullptr)
+                        || (sedmlTask->getSimulationReference() != secondSimulation->getId())))) {
+                mIssues << SedmlFileIssue(SedmlFileIssue::Type::Unsupported,
+                                          tr("only SED-ML files with tasks that reference the model and one of the simulations are supported"));
 
-                if (    (range->getTypeCode() == libsedml::SEDML_RANGE_VECTORRANGE)
-                    && (repeatedTask->getRangeId() == range->getId())) {
-                    // Make sure that the vector range has one value that is
-                    // equal to 1
+                return false;
+            }
+        } else {
+            mIssues << SedmlFileIssue(SedmlFileIssue::Type::Unsupported,
+                                      tr("only SED-ML files with tasks and repeated tasks are supported"));
 
-                    auto vectorRange = static_cast<libsedml::SedVectorRange *>(range);
+            return false;
+        }
+    }
 
-                    if (   (vectorRange->getNumValues() == 1)
-                        && (qFuzzyCompare(vectorRange->getValues().front(), 1.0))) {
-                        // Make sure that the one/two sub-tasks have the correct
-                        // order and retrieve their id
+    // Make sure that we have one main repeated task, i.e. a repeated task that
+    // is not the sub-task of another repeated task, and that it only relies on
+    // features that we support
 
-                        for (uint j = 0, jMax = totalNbOfTasks-1; j < jMax; ++j) {
-                            libsedml::SedSubTask *subTask = repeatedTask->getSubTask(j);
+    libsedml::SedRepeatedTask *repeatedTask = nullptr;
 
-                            if (subTask->getOrder() == 1) {
-                                repeatedTaskFirstSubTaskId = subTask->getTask();
-                            } else if (subTask->getOrder() == 2) {
-                                repeatedTaskSecondSubTaskId = subTask->getTask();
-                            }
-                        }
+    for (auto someRepeatedTask : repeatedTasks) {
+        if (!subTaskIds.contains(QString::fromStdString(someRepeatedTask->getId()))) {
+            if (repeatedTask != nullptr) {
+                repeatedTask = nullptr;
 
-                        repeatedTaskOk = true;
-                    }
-                }
-            }
-        } else if (task->getTypeCode() == libsedml::SEDML_TASK) {
-            // Make sure the sub-task references the correct model and
-            // simulation
-
-            if (   (task->getModelReference() == model->getId())
-                && (task->getSimulationReference() == firstSimulation->getId())) {
-                firstSubTaskOk = true;
-                firstSubTaskId = task->getId();
-            } else if (   (secondSimulation != nullptr)
-                       && (task->getModelReference() == model->getId())
-                       && (task->getSimulationReference() == secondSimulation->getId())) {
-                secondSubTaskOk = true;
-                secondSubTaskId = task->getId();
+                break;
             }
+
+            repeatedTask = someRepeatedTask;
         }
     }
 
-    if (   !repeatedTaskOk
-        || !firstSubTaskOk || (repeatedTaskFirstSubTaskId != firstSubTaskId)
-        || (   (secondSimulation != nullptr)
-            && (!secondSubTaskOk || (repeatedTaskSecondSubTaskId != secondSubTaskId)))) {
+    if (repeatedTask == nullptr) {
         mIssues << SedmlFileIssue(SedmlFileIssue::Type::Unsupported,
-                                  tr("only SED-ML files that execute one or two simulations once are supported"));
+                                  tr("only SED-ML files with one main repeated task are supported"));
+
+        return false;
+    }
+
+    QStringList repeatedTaskIds;
 
+    if (!validRepeatedTask(repeatedTask, repeatedTaskIds)) {
         return false;
     }
 
+    // Keep track of our main repeated task
+    // Note: the simulation(s) executed by a repeated task always use the
+    //       settings of our first simulation, extended by the step of our
+    //       second simulation, if any...
+
+    mRepeatedTask = repeatedTask;
+
     // Make sure that all the data generators have one variable that references
     // the repeated task, that follows the correct CellML format for their
     // target (and OpenCOR format for their degree, if any), and that is not
@@ -956,34 +1131,7 @@ bool SedmlFile::isSupported()
             return false;
         }
 
-        static const QRegularExpression TargetStartRegEx  = QRegularExpression(R"(^\/cellml:model\/cellml:component\[@name=')");
-        static const QRegularExpression TargetMiddleRegEx = QRegularExpression(R"(']\/cellml:variable\[@name=')");
-        static const QRegularExpression TargetEndRegEx    = QRegularExpression(R"('\]$)");
-
-        bool referencingCellmlVariable = false;
-        QString target = QString::fromStdString(variable->getTarget());
-
-        if (target.contains(TargetStartRegEx) && target.contains(TargetEndRegEx)) {
-            static const QString Separator = "|";
-
-            target.remove(TargetStartRegEx);
-            target.replace(TargetMiddleRegEx, Separator);
-            target.remove(TargetEndRegEx);
-
-            QStringList identifiers = target.split(Separator);
-
-            if (identifiers.count() == 2) {
-                static const QRegularExpression IdentifierRegEx = QRegularExpression("^[[:alpha:]_][[:alnum:]_]*$");
-
-                QString componentName = identifiers.first();
-                QString variableName = identifiers.last();
-
-                referencingCellmlVariable =    IdentifierRegEx.match(componentName).hasMatch()
-                                            && IdentifierRegEx.match(variableName).hasMatch();
-            }
-        }
-
-        if (!referencingCellmlVariable) {
+        if (cellmlVariableUri(QString::fromStdString(variable->getTarget())).isEmpty()) {
             mIssues << SedmlFileIssue(SedmlFileIssue::Type::Unsupported,
                                       tr("only SED-ML files with data generators for one variable with a reference to a CellML variable are supported"));
 
@@ -1493,6 +1641,52 @@ bool SedmlFile::isSupported()
 
 //==============================================================================
 
+libsedml::SedRepeatedTask * SedmlFile::repeatedTask()
+{
+    // Return our main repeated task
+    // Note: it only gets set once we have been found to be supported, which
+    //       happens when retrieving our CellML file...
+
+    return mRepeatedTask;
+}
+
+//==============================================================================
+
+bool SedmlFile::runsOnce() const
+{
+    // Return whether our main repeated task simply runs our simulation(s)
+    // once, i.e. whether it has only one iteration, no task changes and no
+    // repeated sub-tasks
+    // Note: this is what the Simulation Experiment view supports, while other
+    //       repeated tasks can only be run from Python (see
+    //       SimulationSupport::SimulationRepeatedTask)...
+
+    if (mRepeatedTask == nullptr) {
+        return false;
+    }
+
+    libsedml::SedRange *mainRange = mRepeatedTask->getRange(mRepeatedTask->getRangeId());
+
+    if (   (mainRange == nullptr)
+        || (mainRange->getTypeCode() != libsedml::SEDML_RANGE_VECTORRANGE)
+        || (static_cast<libsedml::SedVectorRange *>(mainRange)->getNumValues() != 1)
+        || (mRepeatedTask->getNumTaskChanges() != 0)) {
+        return false;
+    }
+
+    for (uint i = 0, iMax = mRepeatedTask->getNumSubTasks(); i < iMax; ++i) {
+        libsedml::SedAbstractTask *task = mSedmlDocument->getTask(mRepeatedTask->getSubTask(i)->getTask());
+
+        if ((task == nullptr) || (task->getTypeCode() == libsedml::SEDML_TASK_REPEATEDTASK)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+
 CellMLSupport::CellmlFile * SedmlFile::cellmlFile()
 {
     // Return our CellML file, after having created it, if necessary
@@ -32,6 +32,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include <QString>
+#include <QStringList>
 
 //==============================================================================
 
@@ -44,6 +45,8 @@ along with this program. If not, see <https://gnu.org/licenses>.
 namespace libsedml {
     class SedDocument;
     class SedListOfAlgorithmParameters;
+    class SedListOfVariables;
+    class SedRepeatedTask;
 } // namespace libsedml
 
 //==============================================================================
@@ -135,6 +138,9 @@ public:
     bool isValid();
     bool isSupported();
 
+    libsedml::SedRepeatedTask * repeatedTask();
+    bool runsOnce() const;
+
     CellMLSupport::CellmlFile * cellmlFile();
 
     SedmlFileIssues issues() const;
@@ -143,6 +149,7 @@ private:
     QString mOwnerFileName;
 
     libsedml::SedDocument *mSedmlDocument = nullptr;
+    libsedml::SedRepeatedTask *mRepeatedTask = nullptr;
 
     bool mLoadingNeeded = true;
 
@@ -163,6 +170,10 @@ private:
     bool validAlgorithmParameters(const libsedml::SedListOfAlgorithmParameters *pSedmlAlgorithmParameters,
                                   SolverInterface *pSolverInterface);
 
+    bool validComputeVariables(const libsedml::SedListOfVariables *pVariables);
+    bool validRepeatedTask(libsedml::SedRepeatedTask *pRepeatedTask,
+                           QStringList &pRepeatedTaskIds);
+
     bool validListPropertyValue(const libsbml::XMLNode &pPropertyNode,
                                 const QString &pPropertyNodeValue,
                                 const QString &pPropertyName,
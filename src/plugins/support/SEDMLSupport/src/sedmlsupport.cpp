@@ -26,10 +26,21 @@ along with this program. If not, see <https://gnu.org/licenses>.
 //==============================================================================
 
 #include <QObject>
+#include <QRegularExpression>
 #include <QStringList>
 
 //==============================================================================
 
+#include <cmath>
+
+//==============================================================================
+
+#include "libsbmlbegin.h"
+    #include "sbml/math/ASTNode.h"
+#include "libsbmlend.h"
+
+//==============================================================================
+
 namespace OpenCOR {
 namespace SEDMLSupport {
 
@@ -164,6 +175,393 @@ QString stringSymbolStyleFromIndex(int pIndexSymbolStyle, bool pFormatted)
 
 //==============================================================================
 
+QString cellmlVariableUri(const QString &pTarget)
+{
+    // Return the URI, i.e. <component>/<variable>, of the CellML variable
+    // referenced by the given target, or an empty string if the target doesn't
+    // follow the format that we support
+    // Note: the URI is the one used by our simulations to identify their
+    //       constants, states, etc....
+
+    static const QRegularExpression TargetRegEx = QRegularExpression(R"(^\/cellml:model\/cellml:component\[@name='([[:alpha:]_][[:alnum:]_]*)'\]\/cellml:variable\[@name='([[:alpha:]_][[:alnum:]_]*)'\]$)");
+
+    QRegularExpressionMatch match = TargetRegEx.match(pTarget);
+
+    return match.hasMatch()?
+               match.captured(1)+"/"+match.captured(2):
+               QString();
+}
+
+//==============================================================================
+
+QVector<double> uniformRangeValues(double pStart, double pEnd,
+                                   int pNumberOfPoints, bool pLogarithmic)
+{
+    // Return the values of a uniform range
+    // Note: like the SED-ML reference implementations, we consider that
+    //       'numberOfPoints' is the number of intervals, meaning that the range
+    //       has numberOfPoints+1 values that include both its start and end
+    //       values. A logarithmic range is only valid for strictly positive
+    //       start and end values...
+
+    QVector<double> res;
+
+    if (   (pNumberOfPoints <= 0)
+        || (pLogarithmic && ((pStart <= 0.0) || (pEnd <= 0.0)))) {
+        return res;
+    }
+
+    res.reserve(pNumberOfPoints+1);
+
+    if (pLogarithmic) {
+        double logStart = std::log(pStart);
+        double logStep = (std::log(pEnd)-logStart)/pNumberOfPoints;
+
+        for (int i = 0; i < pNumberOfPoints; ++i) {
+            res << std::exp(logStart+i*logStep);
+        }
+    } else {
+        double step = (pEnd-pStart)/pNumberOfPoints;
+
+        for (int i = 0; i < pNumberOfPoints; ++i) {
+            res << pStart+i*step;
+        }
+    }
+
+    res << pEnd;
+
+    return res;
+}
+
+//==============================================================================
+
+double evaluateMath(const libsbml::ASTNode *pMath,
+                    const QMap<QString, double> &pSymbols, bool &pOk)
+{
+    // Evaluate the given (SED-ML) mathematical expression using the given
+    // symbols
+    // Note: we only support the MathML elements that SED-ML allows in a range
+    //       or a change, i.e. no user-defined function or SED-ML aggregate
+    //       function (e.g. max(), sum()), which only make sense for data
+    //       generators...
+
+    pOk = false;
+
+    if (pMath == nullptr) {
+        return 0.0;
+    }
+
+    static const double E = std::exp(1.0);
+    static const double Pi = std::acos(-1.0);
+
+    uint childrenCount = pMath->getNumChildren();
+    QVector<double> children;
+
+    children.reserve(int(childrenCount));
+
+    if (pMath->getType() != libsbml::AST_FUNCTION_PIECEWISE) {
+        for (uint i = 0; i < childrenCount; ++i) {
+            children << evaluateMath(pMath->getChild(i), pSymbols, pOk);
+
+            if (!pOk) {
+                return 0.0;
+            }
+        }
+
+        pOk = false;
+    }
+
+    double res = 0.0;
+
+    switch (pMath->getType()) {
+    case libsbml::AST_INTEGER:
+        res = double(pMath->getInteger());
+
+        break;
+    case libsbml::AST_REAL:
+    case libsbml::AST_REAL_E:
+    case libsbml::AST_RATIONAL:
+        res = pMath->getReal();
+
+        break;
+    case libsbml::AST_NAME: {
+        auto symbol = pSymbols.constFind(QString::fromStdString(pMath->getName()));
+
+        if (symbol == pSymbols.constEnd()) {
+            return 0.0;
+        }
+
+        res = symbol.value();
+
+        break;
+    }
+    case libsbml::AST_CONSTANT_E:
+        res = E;
+
+        break;
+    case libsbml::AST_CONSTANT_PI:
+        res = Pi;
+
+        break;
+    case libsbml::AST_CONSTANT_TRUE:
+        res = 1.0;
+
+        break;
+    case libsbml::AST_CONSTANT_FALSE:
+        res = 0.0;
+
+        break;
+    case libsbml::AST_PLUS:
+        for (auto child : children) {
+            res += child;
+        }
+
+        break;
+    case libsbml::AST_MINUS:
+        if (childrenCount == 1) {
+            res = -children[0];
+        } else if (childrenCount == 2) {
+            res = children[0]-children[1];
+        } else {
+            return 0.0;
+        }
+
+        break;
+    case libsbml::AST_TIMES:
+        res = 1.0;
+
+        for (auto child : children) {
+            res *= child;
+        }
+
+        break;
+    case libsbml::AST_DIVIDE:
+        if (childrenCount != 2) {
+            return 0.0;
+        }
+
+        res = children[0]/children[1];
+
+        break;
+    case libsbml::AST_POWER:
+    case libsbml::AST_FUNCTION_POWER:
+        if (childrenCount != 2) {
+            return 0.0;
+        }
+
+        res = std::pow(children[0], children[1]);
+
+        break;
+    case libsbml::AST_FUNCTION_ROOT:
+        if (childrenCount == 1) {
+            res = std::sqrt(children[0]);
+        } else if (childrenCount == 2) {
+            res = std::pow(children[1], 1.0/children[0]);
+        } else {
+            return 0.0;
+        }
+
+        break;
+    case libsbml::AST_FUNCTION_LOG:
+        // Note: a logarithm with two children has its base as its first
+        //       child...
+
+        if (childrenCount == 1) {
+            res = std::log10(children[0]);
+        } else if (childrenCount == 2) {
+            res = std::log(children[1])/std::log(children[0]);
+        } else {
+            return 0.0;
+        }
+
+        break;
+    case libsbml::AST_FUNCTION_ABS:
+    case libsbml::AST_FUNCTION_CEILING:
+    case libsbml::AST_FUNCTION_EXP:
+    case libsbml::AST_FUNCTION_FLOOR:
+    case libsbml::AST_FUNCTION_LN:
+    case libsbml::AST_FUNCTION_SIN:
+    case libsbml::AST_FUNCTION_COS:
+    case libsbml::AST_FUNCTION_TAN:
+    case libsbml::AST_FUNCTION_ARCSIN:
+    case libsbml::AST_FUNCTION_ARCCOS:
+    case libsbml::AST_FUNCTION_ARCTAN:
+    case libsbml::AST_FUNCTION_SINH:
+    case libsbml::AST_FUNCTION_COSH:
+    case libsbml::AST_FUNCTION_TANH:
+    case libsbml::AST_LOGICAL_NOT:
+        if (childrenCount != 1) {
+            return 0.0;
+        }
+
+        switch (pMath->getType()) {
+        case libsbml::AST_FUNCTION_ABS:
+            res = std::fabs(children[0]);
+
+            break;
+        case libsbml::AST_FUNCTION_CEILING:
+            res = std::ceil(children[0]);
+
+            break;
+        case libsbml::AST_FUNCTION_EXP:
+            res = std::exp(children[0]);
+
+            break;
+        case libsbml::AST_FUNCTION_FLOOR:
+            res = std::floor(children[0]);
+
+            break;
+        case libsbml::AST_FUNCTION_LN:
+            res = std::log(children[0]);
+
+            break;
+        case libsbml::AST_FUNCTION_SIN:
+            res = std::sin(children[0]);
+
+            break;
+        case libsbml::AST_FUNCTION_COS:
+            res = std::cos(children[0]);
+
+            break;
+        case libsbml::AST_FUNCTION_TAN:
+            res = std::tan(children[0]);
+
+            break;
+        case libsbml::AST_FUNCTION_ARCSIN:
+            res = std::asin(children[0]);
+
+            break;
+        case libsbml::AST_FUNCTION_ARCCOS:
+            res = std::acos(children[0]);
+
+            break;
+        case libsbml::AST_FUNCTION_ARCTAN:
+            res = std::atan(children[0]);
+
+            break;
+        case libsbml::AST_FUNCTION_SINH:
+            res = std::sinh(children[0]);
+
+            break;
+        case libsbml::AST_FUNCTION_COSH:
+            res = std::cosh(children[0]);
+
+            break;
+        case libsbml::AST_FUNCTION_TANH:
+            res = std::tanh(children[0]);
+
+            break;
+        default: // libsbml::AST_LOGICAL_NOT
+            res = (children[0] != 0.0)?0.0:1.0;
+        }
+
+        break;
+    case libsbml::AST_RELATIONAL_EQ:
+    case libsbml::AST_RELATIONAL_NEQ:
+    case libsbml::AST_RELATIONAL_LT:
+    case libsbml::AST_RELATIONAL_LEQ:
+    case libsbml::AST_RELATIONAL_GT:
+    case libsbml::AST_RELATIONAL_GEQ:
+        if (childrenCount != 2) {
+            return 0.0;
+        }
+
+        switch (pMath->getType()) {
+        case libsbml::AST_RELATIONAL_EQ:
+            res = (children[0] == children[1])?1.0:0.0;
+
+            break;
+        case libsbml::AST_RELATIONAL_NEQ:
+            res = (children[0] != children[1])?1.0:0.0;
+
+            break;
+        case libsbml::AST_RELATIONAL_LT:
+            res = (children[0] < children[1])?1.0:0.0;
+
+            break;
+        case libsbml::AST_RELATIONAL_LEQ:
+            res = (children[0] <= children[1])?1.0:0.0;
+
+            break;
+        case libsbml::AST_RELATIONAL_GT:
+            res = (children[0] > children[1])?1.0:0.0;
+
+            break;
+        default: // libsbml::AST_RELATIONAL_GEQ
+            res = (children[0] >= children[1])?1.0:0.0;
+        }
+
+        break;
+    case libsbml::AST_LOGICAL_AND:
+        res = 1.0;
+
+        for (auto child : children) {
+            if (child == 0.0) {
+                res = 0.0;
+
+                break;
+            }
+        }
+
+        break;
+    case libsbml::AST_LOGICAL_OR:
+        for (auto child : children) {
+            if (child != 0.0) {
+                res = 1.0;
+
+                break;
+            }
+        }
+
+        break;
+    case libsbml::AST_LOGICAL_XOR:
+        for (auto child : children) {
+            if (child != 0.0) {
+                res = 1.0-res;
+            }
+        }
+
+        break;
+    case libsbml::AST_FUNCTION_PIECEWISE: {
+        // Evaluate the conditions of our pieces, one after the other, and
+        // return the value of the first piece which condition is true or, if
+        // there is none, the value of our otherwise, if any
+        // Note: a piecewise's children are <value>, <condition> pairs followed
+        //       by an optional otherwise value...
+
+        for (uint i = 0; i+1 < childrenCount; i += 2) {
+            double condition = evaluateMath(pMath->getChild(i+1), pSymbols, pOk);
+
+            if (!pOk) {
+                return 0.0;
+            }
+
+            if (condition != 0.0) {
+                return evaluateMath(pMath->getChild(i), pSymbols, pOk);
+            }
+        }
+
+        if ((childrenCount%2) == 1) {
+            return evaluateMath(pMath->getChild(childrenCount-1), pSymbols, pOk);
+        }
+
+        pOk = false;
+
+        return 0.0;
+    }
+    default:
+        // Not a MathML element that we support
+
+        return 0.0;
+    }
+
+    pOk = true;
+
+    return res;
+}
+
+//==============================================================================
+
 } // namespace SEDMLSupport
 } // namespace OpenCOR
 
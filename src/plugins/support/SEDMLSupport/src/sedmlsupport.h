@@ -29,7 +29,15 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <QMap>
 #include <QString>
+#include <QVector>
+
+//==============================================================================
+
+namespace libsbml {
+    class ASTNode;
+} // namespace libsbml
 
 //==============================================================================
 
@@ -52,6 +60,17 @@ int SEDMLSUPPORT_EXPORT indexSymbolStyleFromString(const QString &pStringSymbolS
 QString SEDMLSUPPORT_EXPORT stringSymbolStyleFromIndex(int pIndexSymbolStyle,
                                                        bool pFormatted = false);
 
+QString SEDMLSUPPORT_EXPORT cellmlVariableUri(const QString &pTarget);
+
+QVector<double> SEDMLSUPPORT_EXPORT uniformRangeValues(double pStart,
+                                                       double pEnd,
+                                                       int pNumberOfPoints,
+                                                       bool pLogarithmic = false);
+
+double SEDMLSUPPORT_EXPORT evaluateMath(const libsbml::ASTNode *pMath,
+                                        const QMap<QString, double> &pSymbols,
+                                        bool &pOk);
+
 //==============================================================================
 
 } // namespace SEDMLSupport
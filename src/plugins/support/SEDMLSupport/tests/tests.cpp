@@ -30,6 +30,13 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include "libsbmlbegin.h"
+    #include "sbml/math/ASTNode.h"
+    #include "sbml/math/FormulaParser.h"
+#include "libsbmlend.h"
+
+//==============================================================================
+
 void Tests::lineStyleTests()
 {
     // Convert a string line style to an index line style
@@ -125,6 +132,102 @@ void Tests::symbolStyleTests()
 
 //==============================================================================
 
+void Tests::cellmlVariableUriTests()
+{
+    // Convert some valid targets to a URI
+
+    QCOMPARE(OpenCOR::SEDMLSupport::cellmlVariableUri("/cellml:model/cellml:component[@name='membrane']/cellml:variable[@name='V']"), "membrane/V");
+    QCOMPARE(OpenCOR::SEDMLSupport::cellmlVariableUri("/cellml:model/cellml:component[@name='_c1']/cellml:variable[@name='v_2']"), "_c1/v_2");
+
+    // Try to convert some invalid targets
+
+    QVERIFY(OpenCOR::SEDMLSupport::cellmlVariableUri({}).isEmpty());
+    QVERIFY(OpenCOR::SEDMLSupport::cellmlVariableUri("/cellml:model/cellml:component[@name='membrane']").isEmpty());
+    QVERIFY(OpenCOR::SEDMLSupport::cellmlVariableUri("/cellml:model/cellml:component[@name='1membrane']/cellml:variable[@name='V']").isEmpty());
+    QVERIFY(OpenCOR::SEDMLSupport::cellmlVariableUri("/cellml:model/cellml:component[@name='membrane']/cellml:variable[@name='V']/extra").isEmpty());
+}
+
+//==============================================================================
+
+void Tests::uniformRangeValuesTests()
+{
+    // Linear uniform ranges
+
+    QCOMPARE(OpenCOR::SEDMLSupport::uniformRangeValues(0.0, 1.0, 4),
+             QVector<double>({ 0.0, 0.25, 0.5, 0.75, 1.0 }));
+    QCOMPARE(OpenCOR::SEDMLSupport::uniformRangeValues(3.0, 1.0, 2),
+             QVector<double>({ 3.0, 2.0, 1.0 }));
+
+    // Logarithmic uniform range
+
+    QVector<double> values = OpenCOR::SEDMLSupport::uniformRangeValues(1.0, 1000.0, 3, true);
+
+    QCOMPARE(values.count(), 4);
+    QCOMPARE(values[0], 1.0);
+    QCOMPARE(values[1], 10.0);
+    QCOMPARE(values[2], 100.0);
+    QCOMPARE(values[3], 1000.0);
+
+    // Invalid uniform ranges
+
+    QVERIFY(OpenCOR::SEDMLSupport::uniformRangeValues(0.0, 1.0, 0).isEmpty());
+    QVERIFY(OpenCOR::SEDMLSupport::uniformRangeValues(0.0, 1.0, 3, true).isEmpty());
+}
+
+//==============================================================================
+
+static double evaluateFormula(const char *pFormula,
+                              const QMap<QString, double> &pSymbols, bool &pOk)
+{
+    // Evaluate the given formula using the given symbols
+
+    libsbml::ASTNode *math = SBML_parseFormula(pFormula);
+    double res = OpenCOR::SEDMLSupport::evaluateMath(math, pSymbols, pOk);
+
+    delete math;
+
+    return res;
+}
+
+//==============================================================================
+
+void Tests::evaluateMathTests()
+{
+    // Evaluate some expressions
+
+    QMap<QString, double> symbols = { { "a", 2.0 }, { "b", 3.0 } };
+    bool ok;
+
+    QCOMPARE(evaluateFormula("1+2*3", symbols, ok), 7.0);
+    QVERIFY(ok);
+    QCOMPARE(evaluateFormula("a*b-1", symbols, ok), 5.0);
+    QVERIFY(ok);
+    QCOMPARE(evaluateFormula("-a/4", symbols, ok), -0.5);
+    QVERIFY(ok);
+    QCOMPARE(evaluateFormula("pow(a, b)", symbols, ok), 8.0);
+    QVERIFY(ok);
+    QCOMPARE(evaluateFormula("sqrt(16)", symbols, ok), 4.0);
+    QVERIFY(ok);
+    QCOMPARE(evaluateFormula("abs(a-b)", symbols, ok), 1.0);
+    QVERIFY(ok);
+    QCOMPARE(evaluateFormula("exp(0)+floor(2.7)+ceil(0.2)", symbols, ok), 4.0);
+    QVERIFY(ok);
+
+    // Try to evaluate an expression with an unknown symbol
+
+    evaluateFormula("a+c", symbols, ok);
+
+    QVERIFY(!ok);
+
+    // Try to evaluate a null expression
+
+    OpenCOR::SEDMLSupport::evaluateMath(nullptr, symbols, ok);
+
+    QVERIFY(!ok);
+}
+
+//==============================================================================
+
 QTEST_GUILESS_MAIN(Tests)
 
 //==============================================================================
@@ -36,6 +36,9 @@ class Tests : public QObject
 private slots:
     void lineStyleTests();
     void symbolStyleTests();
+    void cellmlVariableUriTests();
+    void uniformRangeValuesTests();
+    void evaluateMathTests();
 };
 
 //==============================================================================
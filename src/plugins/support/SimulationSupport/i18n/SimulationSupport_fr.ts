@@ -20,6 +20,40 @@
         <translation>&apos;%1&apos; doit être un fichier CellML, un fichier SED-ML ou une archive COMBINE.</translation>
     </message>
 </context>
+<context>
+    <name>OpenCOR::SimulationSupport::SimulationData</name>
+    <message>
+        <source>%1 is not an NLA solver</source>
+        <translation>%1 n&apos;est pas un solveur ALN</translation>
+    </message>
+    <message>
+        <source>the steady state could not be found</source>
+        <translation>l&apos;état stationnaire n&apos;a pas pu être trouvé</translation>
+    </message>
+</context>
+<context>
+    <name>OpenCOR::SimulationSupport::SimulationRepeatedTask</name>
+    <message>
+        <source>the number of iterations of repeated task &apos;%1&apos; cannot be determined</source>
+        <translation>le nombre d&apos;itérations de la tâche répétée &apos;%1&apos; ne peut pas être déterminé</translation>
+    </message>
+    <message>
+        <source>range &apos;%1&apos; of repeated task &apos;%2&apos; does not have enough values</source>
+        <translation>l&apos;intervalle &apos;%1&apos; de la tâche répétée &apos;%2&apos; n&apos;a pas assez de valeurs</translation>
+    </message>
+    <message>
+        <source>the simulation does not have a repeated task</source>
+        <translation>la simulation n&apos;a pas de tâche répétée</translation>
+    </message>
+    <message>
+        <source>iteration #%1: %2</source>
+        <translation>itération #%1 : %2</translation>
+    </message>
+    <message>
+        <source>the repeated task could not be run</source>
+        <translation>la tâche répétée n&apos;a pas pu être exécutée</translation>
+    </message>
+</context>
 <context>
     <name>OpenCOR::SimulationSupport::SimulationSupportPythonWrapper</name>
     <message>
@@ -34,6 +68,87 @@
         <source>The memory required for the simulation could not be allocated.</source>
         <translation>La mémoire requise pour la simulation n&apos;a pas pu être allouée.</translation>
     </message>
+    <message>
+        <source>The parameters values must be given as a dictionary.</source>
+        <translation>Les valeurs des paramètres doivent être données sous forme de dictionnaire.</translation>
+    </message>
+    <message>
+        <source>The parameters must be given as strings.</source>
+        <translation>Les paramètres doivent être donnés sous forme de chaînes de caractères.</translation>
+    </message>
+    <message>
+        <source>The value of %1 must be a number.</source>
+        <translation>La valeur de %1 doit être un nombre.</translation>
+    </message>
+    <message>
+        <source>Task #%1: %2</source>
+        <translation>Tâche #%1 : %2</translation>
+    </message>
+    <message>
+        <source>The requested simulation type (%1) is not valid.</source>
+        <translation>Le type de simulation demandé (%1) n&apos;est pas valide.</translation>
+    </message>
+    <message>
+        <source>The steady-state tolerance must be strictly positive.</source>
+        <translation>La tolérance de l&apos;état stationnaire doit être strictement positive.</translation>
+    </message>
+    <message>
+        <source>The requested solver (%1) could not be found.</source>
+        <translation>Le solveur demandé (%1) n&apos;a pas pu être trouvé.</translation>
+    </message>
+</context>
+<context>
+    <name>OpenCOR::SimulationSupport::SimulationSweep</name>
+    <message>
+        <source>the simulation has an invalid runtime</source>
+        <translation>la simulation a un environnement d&apos;exécution invalide</translation>
+    </message>
+    <message>
+        <source>task #%1 does not exist</source>
+        <translation>la tâche #%1 n&apos;existe pas</translation>
+    </message>
+    <message>
+        <source>another task already continues from task #%1</source>
+        <translation>une autre tâche continue déjà à partir de la tâche #%1</translation>
+    </message>
+    <message>
+        <source>%1 is neither a constant nor a state</source>
+        <translation>%1 n&apos;est ni une constante ni un état</translation>
+    </message>
+</context>
+<context>
+    <name>OpenCOR::SimulationSupport::SimulationSweepTask</name>
+    <message>
+        <source>the memory required for the simulation could not be allocated</source>
+        <translation>la mémoire requise pour la simulation n&apos;a pas pu être allouée</translation>
+    </message>
+    <message>
+        <source>the simulation was stopped</source>
+        <translation>la simulation a été arrêtée</translation>
+    </message>
+    <message>
+        <source>the task continues from a task that failed</source>
+        <translation>la tâche continue à partir d&apos;une tâche qui a échoué</translation>
+    </message>
+    <message>
+        <source>the value of %1 could not be computed</source>
+        <translation>la valeur de %1 n&apos;a pas pu être calculée</translation>
+    </message>
+    <message>
+        <source>the steady state could not be reached before the ending point</source>
+        <translation>l&apos;état stationnaire n&apos;a pas pu être atteint avant le point d&apos;arrivée</translation>
+    </message>
+</context>
+<context>
+    <name>OpenCOR::SimulationSupport::SimulationWorker</name>
+    <message>
+        <source>the memory required for the simulation could not be allocated</source>
+        <translation>la mémoire requise pour la simulation n&apos;a pas pu être allouée</translation>
+    </message>
+    <message>
+        <source>the steady state could not be reached before the ending point</source>
+        <translation>l&apos;état stationnaire n&apos;a pas pu être atteint avant le point d&apos;arrivée</translation>
+    </message>
 </context>
 <context>
     <name>QObject</name>
@@ -24,12 +24,15 @@ along with this program. If not, see <https://gnu.org/licenses>.
 #include "cellmlfilemanager.h"
 #include "cellmlfileruntime.h"
 #include "combinefilemanager.h"
+#include "corecliutils.h"
 #include "datastorepythonwrapper.h"
 #include "filemanager.h"
 #include "interfaces.h"
 #include "sedmlfile.h"
 #include "sedmlfilemanager.h"
 #include "simulation.h"
+#include "simulationrepeatedtask.h"
+#include "simulationsweep.h"
 #include "simulationworker.h"
 
 //==============================================================================
@@ -348,6 +351,204 @@ void SimulationData::setPointInterval(double pPointInterval)
 
 //==============================================================================
 
+SimulationData::Type SimulationData::type() const
+{
+    // Return our type
+
+    return mType;
+}
+
+//==============================================================================
+
+void SimulationData::setType(Type pType)
+{
+    // Set our type
+
+    mType = pType;
+
+    // Let people know that our point data has been updated
+    // Note: our type affects the number of points that get generated...
+
+    emit pointUpdated();
+}
+
+//==============================================================================
+
+bool SimulationData::adaptiveOutput() const
+{
+    // Return whether our points are to be recorded at our ODE solver's own
+    // steps
+
+    return mAdaptiveOutput;
+}
+
+//==============================================================================
+
+void SimulationData::setAdaptiveOutput(bool pAdaptiveOutput)
+{
+    // Set whether our points are to be recorded at our ODE solver's own steps
+    // Note: our point interval is then only used to estimate our size, our
+    //       results growing if our ODE solver takes more steps than that...
+
+    mAdaptiveOutput = pAdaptiveOutput;
+}
+
+//==============================================================================
+
+double SimulationData::steadyStateTolerance() const
+{
+    // Return our steady-state tolerance
+
+    return mSteadyStateTolerance;
+}
+
+//==============================================================================
+
+void SimulationData::setSteadyStateTolerance(double pSteadyStateTolerance)
+{
+    // Set our steady-state tolerance
+
+    mSteadyStateTolerance = pSteadyStateTolerance;
+}
+
+//==============================================================================
+
+QString SimulationData::steadyStateSolverName() const
+{
+    // Return the name of our steady-state solver
+
+    return mSteadyStateSolverName;
+}
+
+//==============================================================================
+
+void SimulationData::setSteadyStateSolverName(const QString &pSteadyStateSolverName)
+{
+    // Set the name of our steady-state solver
+    // Note: an empty name means that a steady state is to be reached by
+    //       integrating our model until its states settle...
+
+    mSteadyStateSolverName = pSteadyStateSolverName;
+}
+
+//==============================================================================
+
+bool SimulationData::steadyStateReached(const double *pPreviousStates,
+                                        const double *pStates) const
+{
+    // Check whether our states have settled, i.e. whether none of them has
+    // changed by more than our tolerance, relative to its magnitude (or in
+    // absolute terms, for a state close to zero), over one point interval
+    // Note: for a paced model, our point interval should be the pacing period,
+    //       in which case this is a beat-to-beat check...
+
+    for (int i = 0, iMax = mSimulation->runtime()->statesCount(); i < iMax; ++i) {
+        if (std::fabs(pStates[i]-pPreviousStates[i]) > mSteadyStateTolerance*qMax(1.0, std::fabs(pStates[i]))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+
+namespace {
+
+struct SteadyStateSystemData
+{
+    CellMLSupport::CellmlFileRuntime::ComputeRatesFunction computeRates;
+    double voi;
+    double *constants;
+    double *rates;
+    double *algebraic;
+    int statesCount;
+};
+
+} // namespace
+
+//==============================================================================
+
+static void computeSteadyStateSystem(double *pStates, double *pResiduals,
+                                     void *pUserData)
+{
+    // Our residuals are simply our rates
+
+    auto data = static_cast<SteadyStateSystemData *>(pUserData);
+
+    data->computeRates(data->voi, data->constants, data->rates, pStates,
+                       data->algebraic);
+
+    memcpy(pResiduals, data->rates, size_t(data->statesCount)*Solver::SizeOfDouble);
+}
+
+//==============================================================================
+
+QString SimulationData::solveSteadyState(double pVoi, double *pConstants,
+                                         double *pRates, double *pStates,
+                                         double *pAlgebraic) const
+{
+    // Make sure that our steady-state solver is an NLA solver
+
+    SolverInterface *steadyStateSolverInterface = solverInterface(mSteadyStateSolverName);
+
+    if (   (steadyStateSolverInterface == nullptr)
+        || (steadyStateSolverInterface->solverType() != Solver::Type::Nla)) {
+        return tr("%1 is not an NLA solver").arg(mSteadyStateSolverName);
+    }
+
+    // Solve rates(states) = 0 using our steady-state solver with its default
+    // properties, starting from the given states
+    // Note: the given states are updated in place. We use a direct connection
+    //       to retrieve the first error, if any, since the solver is used in
+    //       our thread...
+
+    auto steadyStateSolver = static_cast<Solver::NlaSolver *>(steadyStateSolverInterface->solverInstance());
+    Solver::Solver::Properties steadyStateSolverProperties;
+    QString res;
+
+    const Solver::Properties solverProperties = steadyStateSolverInterface->solverProperties();
+
+    for (const auto &solverProperty : solverProperties) {
+        steadyStateSolverProperties.insert(solverProperty.id(), solverProperty.defaultValue());
+    }
+
+    steadyStateSolver->setProperties(steadyStateSolverProperties);
+
+    connect(steadyStateSolver, &Solver::Solver::error,
+            [&res](const QString &pErrorMessage) {
+                if (res.isEmpty()) {
+                    res = pErrorMessage;
+                }
+            });
+
+    CellMLSupport::CellmlFileRuntime *runtime = mSimulation->runtime();
+    SteadyStateSystemData data = { runtime->computeRates(), pVoi, pConstants,
+                                   pRates, pAlgebraic, runtime->statesCount() };
+
+    steadyStateSolver->solve(computeSteadyStateSystem, pStates,
+                             data.statesCount, &data);
+
+    delete steadyStateSolver;
+
+    // Make sure that we have really reached a steady state, i.e. that our rates
+    // are (almost) all zero
+
+    if (res.isEmpty()) {
+        computeSteadyStateSystem(pStates, pRates, &data);
+
+        for (int i = 0; i < data.statesCount; ++i) {
+            if (std::fabs(pRates[i]) > mSteadyStateTolerance) {
+                return tr("the steady state could not be found");
+            }
+        }
+    }
+
+    return res;
+}
+
+//==============================================================================
+
 SolverInterface * SimulationData::solverInterface(const QString &pSolverName) const
 {
     // Return the named solver interface, if any
@@ -873,12 +1074,15 @@ void SimulationResults::createDataStore()
         return;
     }
 
-    // Create our data store
+    // Create our data store and make it contiguous, so that our runs can be
+    // accessed as matrices from Python
 
     SimulationData *simulationData = mSimulation->data();
 
     mDataStore = new DataStore::DataStore(mSimulation, mSimulation->cellmlFile()->xmlBase());
 
+    mDataStore->setContiguous(true);
+
     mPointsVariable = mDataStore->voi();
 
     mConstantsVariables = mDataStore->addVariables(simulationData->constants(), runtime->constantsCount());
@@ -932,6 +1136,10 @@ void SimulationResults::createDataStore()
         }
     }
 
+    // Determine what our model variables should record
+
+    updateRecording();
+
     // Reimport our data, if any, and update their array so that it contains the
     // computed values for our start point
 
@@ -960,6 +1168,61 @@ void SimulationResults::createDataStore()
 
 //==============================================================================
 
+void SimulationResults::updateRecording()
+{
+    // Determine what our model variables should record, i.e. everything or only
+    // the variables that have been asked for
+    // Note: a constant can only change if the user modifies it (or, for a
+    //       computed constant, one of the constants it depends on) during a
+    //       pause, so we only record the changes in its value rather than its
+    //       value at every point...
+
+    using Recording = DataStore::DataStoreVariableRun::Recording;
+
+    for (auto variable : qAsConst(mConstantsVariables)) {
+        variable->setRecording((   mRecordedVariables.isEmpty()
+                                || mRecordedVariables.contains(variable->uri()))?
+                                   Recording::Changes:
+                                   Recording::None);
+    }
+
+    DataStore::DataStoreVariables variables = DataStore::DataStoreVariables() << mRatesVariables
+                                                                              << mStatesVariables
+                                                                              << mAlgebraicVariables;
+
+    for (auto variable : qAsConst(variables)) {
+        variable->setRecording((   mRecordedVariables.isEmpty()
+                                || mRecordedVariables.contains(variable->uri()))?
+                                   Recording::Values:
+                                   Recording::None);
+    }
+}
+
+//==============================================================================
+
+QStringList SimulationResults::recordedVariables() const
+{
+    // Return the URI of the model variables that we record, an empty list
+    // meaning that we record all of them
+
+    return mRecordedVariables;
+}
+
+//==============================================================================
+
+void SimulationResults::setRecordedVariables(const QStringList &pRecordedVariables)
+{
+    // Keep track of the URI of the model variables that we should record and
+    // update our model variables accordingly
+    // Note: this only affects the runs that get added from now on...
+
+    mRecordedVariables = pRecordedVariables;
+
+    updateRecording();
+}
+
+//==============================================================================
+
 void SimulationResults::deleteDataStore()
 {
     // Delete our data store
@@ -1102,12 +1365,14 @@ bool SimulationResults::addRun()
     // Ask our data store to add a run to itself and let people know about it,
     // if we were able to add one
     // Note: we consider things to be fine if our data store has had no problems
-    //       adding a run to itself or if the simulation size is zero...
+    //       adding a run to itself or if the simulation size is zero. Also, we
+    //       only allow a run to use up to half of the available physical
+    //       memory, beyond which our data store spills it to disk...
 
     quint64 simulationSize = mSimulation->size();
 
     if (simulationSize != 0) {
-        bool res = mDataStore->addRun(simulationSize);
+        bool res = mDataStore->addRun(simulationSize, Core::freeMemory()/2);
 
         if (res) {
             emit runAdded();
@@ -1191,8 +1456,21 @@ double SimulationResults::realValue(double pPoint,
 
 //==============================================================================
 
-void SimulationResults::addPoint(double pPoint)
+bool SimulationResults::addPoint(double pPoint)
 {
+    // Make sure that our data store has room for the given point, growing our
+    // current run if needed
+    // Note: this can only happen with an adaptive output, in which case we
+    //       cannot know in advance how many points we will need (see
+    //       SimulationWorker::run())...
+
+    quint64 capacity = mDataStore->capacity();
+
+    if (   (mDataStore->size() == capacity)
+        && !mDataStore->growRun(2*capacity)) {
+        return false;
+    }
+
     // Make sure that all our variables are up to date
 
     mSimulation->data()->recomputeVariables(pPoint);
@@ -1216,6 +1494,8 @@ void SimulationResults::addPoint(double pPoint)
     // Now that we are all set, we can add the data to our data store
 
     mDataStore->addValues(pPoint);
+
+    return true;
 }
 
 //==============================================================================
@@ -1398,6 +1678,8 @@ Simulation::Simulation(const QString &pFileName) :
     mData = new SimulationData(this);
     mResults = new SimulationResults(this);
     mImportData = new SimulationImportData(this);
+    mSweep = new SimulationSweep(this);
+    mRepeatedTask = new SimulationRepeatedTask(this);
 
     // Keep track of any error occurring in our data
 
@@ -1422,6 +1704,8 @@ Simulation::~Simulation()
 
     delete mRuntime;
 
+    delete mRepeatedTask;
+    delete mSweep;
     delete mImportData;
     delete mResults;
     delete mData;
@@ -1444,6 +1728,84 @@ Simulation::~Simulation()
 
 //==============================================================================
 
+QString Simulation::initialize()
+{
+    // Retrieve a default ODE and NLA solver, i.e. the first ones in
+    // alphabetical order
+    // Note: this is useful in case our simulation is solely based on a CellML
+    //       file...
+
+    const SolverInterfaces solverInterfaces = Core::solverInterfaces();
+    SolverInterface *odeSolverInterface = nullptr;
+    SolverInterface *nlaSolverInterface = nullptr;
+
+    for (auto solverInterface : solverInterfaces) {
+        QString solverName = solverInterface->solverName();
+
+        if (solverInterface->solverType() == Solver::Type::Ode) {
+            if (   (odeSolverInterface == nullptr)
+                || (odeSolverInterface->solverName().compare(solverName, Qt::CaseInsensitive) > 0)) {
+                odeSolverInterface = solverInterface;
+            }
+        } else if (solverInterface->solverType() == Solver::Type::Nla) {
+            if (   (nlaSolverInterface == nullptr)
+                || (nlaSolverInterface->solverName().compare(solverName, Qt::CaseInsensitive) > 0)) {
+                nlaSolverInterface = solverInterface;
+            }
+        }
+    }
+
+    // Set our default ODE and NLA, if needed, solvers, as well as their default
+    // properties
+
+    if (odeSolverInterface != nullptr) {
+        mData->setOdeSolverName(odeSolverInterface->solverName());
+
+        const Solver::Properties solverProperties = odeSolverInterface->solverProperties();
+
+        for (const auto &solverProperty : solverProperties) {
+            mData->setOdeSolverProperty(solverProperty.id(), solverProperty.defaultValue());
+        }
+    }
+
+    if (   (nlaSolverInterface != nullptr)
+        && (mRuntime != nullptr) && mRuntime->needNlaSolver()) {
+        mData->setNlaSolverName(nlaSolverInterface->solverName());
+
+        const Solver::Properties solverProperties = nlaSolverInterface->solverProperties();
+
+        for (const auto &solverProperty : solverProperties) {
+            mData->setNlaSolverProperty(solverProperty.id(), solverProperty.defaultValue());
+        }
+    }
+
+    // Further initialise ourselves, should we be dealing with either a SED-ML
+    // file or a COMBINE archive
+    // Note: this will overwrite the default ODE and NLA solvers that we set
+    //       above...
+
+    if (   (mFileType == FileType::SedmlFile)
+        || (mFileType == FileType::CombineArchive)) {
+        QString error = furtherInitialize();
+
+        if (!error.isEmpty()) {
+            return error;
+        }
+    }
+
+    // Reset both our data and results (well, initialise in the case of our
+    // data), should we have a valid runtime
+
+    if ((mRuntime != nullptr) && mRuntime->isValid()) {
+        mData->reset();
+        mResults->reset();
+    }
+
+    return {};
+}
+
+//==============================================================================
+
 void Simulation::retrieveFileDetails(bool pRecreateRuntime)
 {
     // Retrieve our CellML and SED-ML files, as well as COMBINE archive
@@ -1563,6 +1925,8 @@ void Simulation::reload()
 
     mData->reload();
     mResults->reload();
+    mSweep->reset();
+    mRepeatedTask->reset();
 }
 
 //==============================================================================
@@ -1833,6 +2197,24 @@ SimulationResults * Simulation::results() const
 
 //==============================================================================
 
+SimulationSweep * Simulation::sweep() const
+{
+    // Return our sweep
+
+    return mSweep;
+}
+
+//==============================================================================
+
+SimulationRepeatedTask * Simulation::repeatedTask() const
+{
+    // Return our repeated task
+
+    return mRepeatedTask;
+}
+
+//==============================================================================
+
 SimulationImportData * Simulation::importData() const
 {
     // Return our imported data
@@ -1981,7 +2363,14 @@ quint64 Simulation::size()
     // Return the size of our simulation (i.e. the number of data points that
     // should be generated), if possible
 
+    // Note: only the final state of a one-step or steady-state simulation gets
+    //       recorded...
+
     if (simulationSettingsOk(false)) {
+        if (mData->type() != SimulationData::Type::UniformTimeCourse) {
+            return 1;
+        }
+
         return quint64(ceil((mData->endingPoint()-mData->startingPoint())/mData->pointInterval())+1.0);
     }
 
@@ -2038,6 +2427,43 @@ void Simulation::run()
 
 //==============================================================================
 
+void Simulation::runSynchronously()
+{
+    // Make sure that we have a runtime
+
+    if (mRuntime == nullptr) {
+        return;
+    }
+
+    // Run our simulation in the calling thread, if we are not already running
+    // and if the simulation settings we were given are sound
+    // Note: unlike run(), this doesn't involve a thread or an event loop, so
+    //       our signals, including done(), are emitted before we return. This
+    //       is what we want when running a simulation from a Python script or
+    //       the command line...
+
+    if ((mWorker == nullptr) && simulationSettingsOk()) {
+        SimulationWorker worker(this, nullptr, mWorker);
+
+        mWorker = &worker;
+
+        connect(&worker, &SimulationWorker::running,
+                this, &Simulation::running);
+        connect(&worker, &SimulationWorker::paused,
+                this, &Simulation::paused);
+
+        connect(&worker, &SimulationWorker::done,
+                this, &Simulation::done);
+
+        connect(&worker, &SimulationWorker::error,
+                this, &Simulation::error);
+
+        worker.run();
+    }
+}
+
+//==============================================================================
+
 void Simulation::pause()
 {
     // Pause our worker
@@ -78,6 +78,8 @@ namespace SimulationSupport {
 
 class Simulation;
 class SimulationData;
+class SimulationRepeatedTask;
+class SimulationSweep;
 class SimulationWorker;
 
 //==============================================================================
@@ -148,6 +150,12 @@ class SIMULATIONSUPPORT_EXPORT SimulationData : public SimulationObject
     Q_OBJECT
 
 public:
+    enum class Type {
+        UniformTimeCourse,
+        OneStep,
+        SteadyState
+    };
+
     explicit SimulationData(Simulation *pSimulation);
     ~SimulationData() override;
 
@@ -168,6 +176,19 @@ public:
     void setEndingPoint(double pEndingPoint);
     void setPointInterval(double pPointInterval);
 
+    Type type() const;
+    void setType(Type pType);
+
+    void setAdaptiveOutput(bool pAdaptiveOutput);
+
+    void setSteadyStateTolerance(double pSteadyStateTolerance);
+    void setSteadyStateSolverName(const QString &pSteadyStateSolverName);
+
+    bool steadyStateReached(const double *pPreviousStates,
+                            const double *pStates) const;
+    QString solveSteadyState(double pVoi, double *pConstants, double *pRates,
+                             double *pStates, double *pAlgebraic) const;
+
     SolverInterface * odeSolverInterface() const;
     SolverInterface * nlaSolverInterface() const;
 
@@ -185,6 +206,13 @@ private:
     double mEndingPoint = 1000.0;
     double mPointInterval = 1.0;
 
+    Type mType = Type::UniformTimeCourse;
+
+    bool mAdaptiveOutput = false;
+
+    double mSteadyStateTolerance = 1.0e-6;
+    QString mSteadyStateSolverName;
+
     QString mOdeSolverName;
     Solver::Solver::Properties mOdeSolverProperties;
 
@@ -237,6 +265,11 @@ public slots:
     double endingPoint() const;
     double pointInterval() const;
 
+    bool adaptiveOutput() const;
+
+    double steadyStateTolerance() const;
+    QString steadyStateSolverName() const;
+
     QString odeSolverName() const;
     QString nlaSolverName() const;
 
@@ -278,7 +311,7 @@ public:
 
     bool addRun();
 
-    void addPoint(double pPoint);
+    bool addPoint(double pPoint);
 
     double * points(int pRun = -1) const;
 
@@ -309,9 +342,13 @@ private:
     QHash<double *, DataStore::DataStoreVariables> mData;
     QHash<double *, DataStore::DataStore *> mDataDataStores;
 
+    QStringList mRecordedVariables;
+
     void createDataStore();
     void deleteDataStore();
 
+    void updateRecording();
+
     QString uri(const CellMLSupport::CellmlFileRuntimeParameter *pParameter);
 
     double realPoint(double pPoint, int pRun = -1) const;
@@ -333,6 +370,9 @@ public slots:
     quint64 size(int pRun = -1) const;
 
     OpenCOR::DataStore::DataStore * dataStore() const;
+
+    QStringList recordedVariables() const;
+    void setRecordedVariables(const QStringList &pRecordedVariables);
 };
 
 //==============================================================================
@@ -374,6 +414,7 @@ public:
     SimulationIssues issues();
 
     QString furtherInitialize() const;
+    QString initialize();
 
     CellMLSupport::CellmlFileRuntime * runtime() const;
 
@@ -392,6 +433,7 @@ public:
     bool addRun();
 
     void run();
+    void runSynchronously();
     void pause();
     void resume();
     void stop();
@@ -417,6 +459,8 @@ private:
     SimulationData *mData = nullptr;
     SimulationResults *mResults = nullptr;
     SimulationImportData *mImportData = nullptr;
+    SimulationSweep *mSweep = nullptr;
+    SimulationRepeatedTask *mRepeatedTask = nullptr;
 
     QList<DataStore::NumPyPythonWrapper *> mNumPyArrays;
 
@@ -448,6 +492,8 @@ public slots:
 
     OpenCOR::SimulationSupport::SimulationData * data() const;
     OpenCOR::SimulationSupport::SimulationResults * results() const;
+    OpenCOR::SimulationSupport::SimulationSweep * sweep() const;
+    OpenCOR::SimulationSupport::SimulationRepeatedTask * repeatedTask() const;
 
     int runsCount() const;
     quint64 runSize(int pRun = -1) const;
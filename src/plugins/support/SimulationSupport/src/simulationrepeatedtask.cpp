@@ -0,0 +1,437 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Simulation repeated task
+//==============================================================================
+
+#include "sedmlfile.h"
+#include "sedmlsupport.h"
+#include "simulationrepeatedtask.h"
+
+//==============================================================================
+
+#include <algorithm>
+
+//==============================================================================
+
+#include "libsedmlbegin.h"
+    #include "sedml/SedDocument.h"
+    #include "sedml/SedFunctionalRange.h"
+    #include "sedml/SedRepeatedTask.h"
+    #include "sedml/SedSetValue.h"
+    #include "sedml/SedUniformRange.h"
+    #include "sedml/SedVectorRange.h"
+#include "libsedmlend.h"
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace SimulationSupport {
+
+//==============================================================================
+
+SimulationRepeatedTask::SimulationRepeatedTask(Simulation *pSimulation) :
+    SimulationObject(pSimulation),
+    mSweep(new SimulationSweep(pSimulation))
+{
+}
+
+//==============================================================================
+
+SimulationRepeatedTask::~SimulationRepeatedTask()
+{
+    // Delete some internal objects
+
+    delete mSweep;
+}
+
+//==============================================================================
+
+Simulation * SimulationRepeatedTask::simulation() const
+{
+    // Return our simulation
+
+    return mSimulation;
+}
+
+//==============================================================================
+
+template<typename T>
+static QMap<QString, double> parameters(const T *pObject)
+{
+    // Return the parameters of the given range or change
+
+    QMap<QString, double> res;
+
+    for (uint i = 0, iMax = pObject->getNumParameters(); i < iMax; ++i) {
+        const libsedml::SedParameter *parameter = pObject->getParameter(i);
+
+        res.insert(QString::fromStdString(parameter->getId()),
+                   parameter->getValue());
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+template<typename T>
+static QMap<QString, QString> variables(const T *pObject)
+{
+    // Return the variables of the given range or change, i.e. the URI of the
+    // model parameter that each of them references
+    // Note: the value of those model parameters is only known when the
+    //       iteration that uses them starts (see
+    //       SimulationSweepTask::initializeValues())...
+
+    QMap<QString, QString> res;
+
+    for (uint i = 0, iMax = pObject->getNumVariables(); i < iMax; ++i) {
+        const libsedml::SedVariable *variable = pObject->getVariable(i);
+
+        res.insert(QString::fromStdString(variable->getId()),
+                   SEDMLSupport::cellmlVariableUri(QString::fromStdString(variable->getTarget())));
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+bool SimulationRepeatedTask::addIterations(const libsedml::SedRepeatedTask *pRepeatedTask,
+                                           const QString &pParentIteration,
+                                           const SimulationSweepChanges &pChanges,
+                                           SimulationSweepChanges &pPendingChanges,
+                                           int &pPreviousIteration,
+                                           QString &pErrorMessage)
+{
+    // Retrieve the values of our vector and uniform ranges, and keep track of
+    // our functional ranges, which values depend on those of our other ranges
+    // and must therefore be computed for each iteration
+
+    static const std::string Log = "log";
+
+    QString repeatedTaskId = QString::fromStdString(pRepeatedTask->getId());
+    QMap<QString, QVector<double>> rangesValues;
+    QList<const libsedml::SedFunctionalRange *> functionalRanges;
+
+    for (uint i = 0, iMax = pRepeatedTask->getNumRanges(); i < iMax; ++i) {
+        const libsedml::SedRange *range = pRepeatedTask->getRange(i);
+        QString rangeId = QString::fromStdString(range->getId());
+
+        if (range->getTypeCode() == libsedml::SEDML_RANGE_VECTORRANGE) {
+            std::vector<double> values = static_cast<const libsedml::SedVectorRange *>(range)->getValues();
+
+            rangesValues.insert(rangeId, QVector<double>::fromStdVector(values));
+        } else if (range->getTypeCode() == libsedml::SEDML_RANGE_UNIFORMRANGE) {
+            auto uniformRange = static_cast<const libsedml::SedUniformRange *>(range);
+
+            rangesValues.insert(rangeId, SEDMLSupport::uniformRangeValues(uniformRange->getStart(),
+                                                                          uniformRange->getEnd(),
+                                                                          uniformRange->getNumberOfPoints(),
+                                                                          uniformRange->getType() == Log));
+        } else {
+            functionalRanges << static_cast<const libsedml::SedFunctionalRange *>(range);
+        }
+    }
+
+    // Determine our number of iterations, which is given by our main range or,
+    // if it is a functional range, by the range on which it depends
+
+    const libsedml::SedRange *mainRange = pRepeatedTask->getRange(pRepeatedTask->getRangeId());
+    QString mainRangeId = QString::fromStdString((mainRange->getTypeCode() == libsedml::SEDML_RANGE_FUNCTIONALRANGE)?
+                                                     static_cast<const libsedml::SedFunctionalRange *>(mainRange)->getRange():
+                                                     mainRange->getId());
+
+    if (!rangesValues.contains(mainRangeId)) {
+        pErrorMessage = tr("the number of iterations of repeated task '%1' cannot be determined").arg(repeatedTaskId);
+
+        return false;
+    }
+
+    int iterationsCount = rangesValues.value(mainRangeId).count();
+
+    for (auto rangeValues = rangesValues.constBegin(),
+              rangeValuesEnd = rangesValues.constEnd();
+         rangeValues != rangeValuesEnd; ++rangeValues) {
+        if (rangeValues.value().count() < iterationsCount) {
+            pErrorMessage = tr("range '%1' of repeated task '%2' does not have enough values").arg(rangeValues.key(),
+                                                                                                 repeatedTaskId);
+
+            return false;
+        }
+    }
+
+    // Retrieve our sub-tasks, sorted by order
+
+    QList<const libsedml::SedSubTask *> subTasks;
+
+    for (uint i = 0, iMax = pRepeatedTask->getNumSubTasks(); i < iMax; ++i) {
+        subTasks << pRepeatedTask->getSubTask(i);
+    }
+
+    std::stable_sort(subTasks.begin(), subTasks.end(), [](const libsedml::SedSubTask *pSubTask1,
+                                                          const libsedml::SedSubTask *pSubTask2) {
+        return pSubTask1->getOrder() < pSubTask2->getOrder();
+    });
+
+    // Go through our iterations
+
+    libsedml::SedDocument *sedmlDocument = mSimulation->sedmlFile()->sedmlDocument();
+
+    for (int i = 0; i < iterationsCount; ++i) {
+        // Determine the current value of our vector and uniform ranges
+
+        QMap<QString, double> symbols;
+
+        for (auto rangeValues = rangesValues.constBegin(),
+                  rangeValuesEnd = rangesValues.constEnd();
+             rangeValues != rangeValuesEnd; ++rangeValues) {
+            symbols.insert(rangeValues.key(), rangeValues.value()[i]);
+        }
+
+        // Determine our iteration's changes, i.e. the value of our functional
+        // ranges, which may use the value of the ranges that precede them, and
+        // then the new value of our task changes
+        // Note: those values may depend on the value of some model parameters
+        //       at the start of our iteration, so they can only be computed
+        //       then (see SimulationSweepTask::initializeValues())...
+
+        SimulationSweepChanges iterationChanges;
+
+        for (auto functionalRange : qAsConst(functionalRanges)) {
+            QMap<QString, double> functionalRangeSymbols = symbols;
+            const QMap<QString, double> functionalRangeParameters = parameters(functionalRange);
+
+            for (auto parameter = functionalRangeParameters.constBegin(),
+                      parameterEnd = functionalRangeParameters.constEnd();
+                 parameter != parameterEnd; ++parameter) {
+                functionalRangeSymbols.insert(parameter.key(), parameter.value());
+            }
+
+            iterationChanges << SimulationSweepChange(SimulationSweepChange::Type::Symbol,
+                                                      QString::fromStdString(functionalRange->getId()),
+                                                      functionalRange->getMath(),
+                                                      functionalRangeSymbols,
+                                                      variables(functionalRange));
+        }
+
+        for (uint j = 0, jMax = pRepeatedTask->getNumTaskChanges(); j < jMax; ++j) {
+            const libsedml::SedSetValue *setValue = pRepeatedTask->getTaskChange(j);
+            QMap<QString, double> setValueSymbols = symbols;
+            const QMap<QString, double> setValueParameters = parameters(setValue);
+
+            for (auto parameter = setValueParameters.constBegin(),
+                      parameterEnd = setValueParameters.constEnd();
+                 parameter != parameterEnd; ++parameter) {
+                setValueSymbols.insert(parameter.key(), parameter.value());
+            }
+
+            iterationChanges << SimulationSweepChange(SimulationSweepChange::Type::Parameter,
+                                                      SEDMLSupport::cellmlVariableUri(QString::fromStdString(setValue->getTarget())),
+                                                      setValue->getMath(),
+                                                      setValueSymbols,
+                                                      variables(setValue));
+        }
+
+        // Determine the changes for our iteration, i.e. those of our parent
+        // and our own changes, and whether we start from our model's initial
+        // state (in which case all those changes must be applied) or from the
+        // end of our previous iteration (in which case only the changes that
+        // have not yet been applied need to be applied)
+
+        SimulationSweepChanges changes = pChanges+iterationChanges;
+        QString iteration = (pParentIteration.isEmpty()?
+                                 QString():
+                                 pParentIteration+".")
+                            +QString::number(i+1);
+
+        pPendingChanges << iterationChanges;
+
+        if (pRepeatedTask->getResetModel()) {
+            pPreviousIteration = -1;
+        }
+
+        // Run our sub-tasks, one after the other
+        // Note: consecutive (non-repeated) sub-tasks are executed as one
+        //       iteration since our simulation's settings are those of all our
+        //       simulations together (see Simulation::furtherInitialize())...
+
+        bool newIteration = true;
+
+        for (auto subTask : qAsConst(subTasks)) {
+            libsedml::SedAbstractTask *task = sedmlDocument->getTask(subTask->getTask());
+
+            if (task->getTypeCode() == libsedml::SEDML_TASK_REPEATEDTASK) {
+                if (!addIterations(static_cast<libsedml::SedRepeatedTask *>(task),
+                                   iteration, changes, pPendingChanges,
+                                   pPreviousIteration, pErrorMessage)) {
+                    return false;
+                }
+
+                newIteration = true;
+            } else if (newIteration) {
+                int sweepTask = mSweep->addTask({},
+                                                (pPreviousIteration == -1)?
+                                                    changes:
+                                                    pPendingChanges,
+                                                pErrorMessage, pPreviousIteration);
+
+                if (sweepTask == -1) {
+                    return false;
+                }
+
+                mTasksIterations << iteration;
+
+                pPreviousIteration = sweepTask;
+
+                pPendingChanges.clear();
+
+                newIteration = false;
+            }
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+
+bool SimulationRepeatedTask::run(QString &pErrorMessage, int pThreadsCount)
+{
+    // Make sure that our simulation has a main repeated task
+
+    SEDMLSupport::SedmlFile *sedmlFile = mSimulation->sedmlFile();
+    libsedml::SedRepeatedTask *repeatedTask = (sedmlFile != nullptr)?
+                                                  sedmlFile->repeatedTask():
+                                                  nullptr;
+
+    if (repeatedTask == nullptr) {
+        pErrorMessage = tr("the simulation does not have a repeated task");
+
+        return false;
+    }
+
+    // Unroll our repeated task into a list of iterations, each of which being
+    // a simulation sweep task that either starts from our model's initial state
+    // or continues from a previous iteration
+
+    SimulationSweepChanges pendingChanges;
+    int previousIteration = -1;
+
+    reset();
+
+    if (!addIterations(repeatedTask, {}, {}, pendingChanges,
+                       previousIteration, pErrorMessage)) {
+        reset();
+
+        return false;
+    }
+
+    // Run our iterations
+    // Note: iterations that start from our model's initial state are
+    //       independent from one another, so our sweep runs them in parallel
+    //       while iterations that continue from a previous one are run after
+    //       it...
+
+    if (!mSweep->run(pThreadsCount)) {
+        for (int i = 0, iMax = mSweep->tasksCount(); i < iMax; ++i) {
+            QString errorMessage = mSweep->errorMessage(i);
+
+            if (!errorMessage.isEmpty()) {
+                pErrorMessage = tr("iteration #%1: %2").arg(mTasksIterations[i],
+                                                            errorMessage);
+
+                return false;
+            }
+        }
+
+        pErrorMessage = tr("the repeated task could not be run");
+
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+
+void SimulationRepeatedTask::stop()
+{
+    // Ask our iterations to stop
+
+    mSweep->stop();
+}
+
+//==============================================================================
+
+void SimulationRepeatedTask::reset()
+{
+    // Delete all our iterations
+
+    mSweep->reset();
+
+    mTasksIterations.clear();
+}
+
+//==============================================================================
+
+int SimulationRepeatedTask::iterationsCount() const
+{
+    // Return our number of iterations
+
+    return mSweep->tasksCount();
+}
+
+//==============================================================================
+
+DataStore::DataStore * SimulationRepeatedTask::dataStore(int pIteration) const
+{
+    // Return the data store of the given iteration
+
+    return mSweep->dataStore(pIteration);
+}
+
+//==============================================================================
+
+QString SimulationRepeatedTask::errorMessage(int pIteration) const
+{
+    // Return the error message of the given iteration
+
+    return mSweep->errorMessage(pIteration);
+}
+
+//==============================================================================
+
+qint64 SimulationRepeatedTask::elapsedTime(int pIteration) const
+{
+    // Return the elapsed time of the given iteration
+
+    return mSweep->elapsedTime(pIteration);
+}
+
+//==============================================================================
+
+} // namespace SimulationSupport
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
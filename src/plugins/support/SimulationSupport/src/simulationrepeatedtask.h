@@ -0,0 +1,91 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Simulation repeated task
+//==============================================================================
+
+#pragma once
+
+//==============================================================================
+
+#include "simulation.h"
+#include "simulationsweep.h"
+
+//==============================================================================
+
+#include <QMap>
+
+//==============================================================================
+
+namespace libsedml {
+    class SedRepeatedTask;
+} // namespace libsedml
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace SimulationSupport {
+
+//==============================================================================
+
+class SIMULATIONSUPPORT_EXPORT SimulationRepeatedTask : public SimulationObject
+{
+    Q_OBJECT
+
+public:
+    explicit SimulationRepeatedTask(Simulation *pSimulation);
+    ~SimulationRepeatedTask() override;
+
+    Simulation * simulation() const;
+
+    bool run(QString &pErrorMessage, int pThreadsCount = 0);
+
+private:
+    SimulationSweep *mSweep;
+
+    QStringList mTasksIterations;
+
+    bool addIterations(const libsedml::SedRepeatedTask *pRepeatedTask,
+                       const QString &pParentIteration,
+                       const SimulationSweepChanges &pChanges,
+                       SimulationSweepChanges &pPendingChanges,
+                       int &pPreviousIteration, QString &pErrorMessage);
+
+public slots:
+    void stop();
+
+    void reset();
+
+    int iterationsCount() const;
+
+    OpenCOR::DataStore::DataStore * dataStore(int pIteration) const;
+
+    QString errorMessage(int pIteration) const;
+    qint64 elapsedTime(int pIteration) const;
+};
+
+//==============================================================================
+
+} // namespace SimulationSupport
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -21,9 +21,17 @@ along with this program. If not, see <https://gnu.org/licenses>.
 // Simulation support plugin
 //==============================================================================
 
+#include "cellmlfileruntime.h"
+#include "corecliutils.h"
+#include "filemanager.h"
 #include "simulationmanager.h"
 #include "simulationsupportplugin.h"
 #include "simulationsupportpythonwrapper.h"
+#include "simulationsweep.h"
+
+//==============================================================================
+
+#include <iostream>
 
 //==============================================================================
 
@@ -39,11 +47,47 @@ PLUGININFO_FUNC SimulationSupportPluginInfo()
                                                  { "fr", QString::fromUtf8("une extension pour supporter des simulations.") }
                                              };
 
-    return new PluginInfo(PluginInfo::Category::Support, false, false,
+    return new PluginInfo(PluginInfo::Category::Support, false, true,
                           { "COMBINESupport", "DataStore", "PythonQtSupport" },
                           descriptions);
 }
 
+//==============================================================================
+// CLI interface
+//==============================================================================
+
+bool SimulationSupportPlugin::executeCommand(const QString &pCommand,
+                                             const QStringList &pArguments,
+                                             int &pRes)
+{
+    Q_UNUSED(pRes)
+
+    // Run the given CLI command
+
+    static const QString Help  = "help";
+    static const QString Sweep = "sweep";
+
+    if (pCommand == Help) {
+        // Display the commands that we support
+
+        runHelpCommand();
+
+        return true;
+    }
+
+    if (pCommand == Sweep) {
+        // Run a parameter sweep
+
+        return runSweepCommand(pArguments);
+    }
+
+    // Not a CLI command that we support
+
+    runHelpCommand();
+
+    return false;
+}
+
 //==============================================================================
 // File handling interface
 //==============================================================================
@@ -162,6 +206,211 @@ void SimulationSupportPlugin::registerPythonClasses(void *pModule)
     new SimulationSupportPythonWrapper(pModule, this);
 }
 
+//==============================================================================
+// Plugin specific
+//==============================================================================
+
+void SimulationSupportPlugin::runHelpCommand()
+{
+    // Output the commands we support
+
+    std::cout << "Commands supported by the SimulationSupport plugin:" << std::endl;
+    std::cout << " * Display the commands supported by the SimulationSupport plugin:" << std::endl;
+    std::cout << "      help" << std::endl;
+    std::cout << " * Run a parameter sweep of <file> and output, in CSV format, the final value of" << std::endl;
+    std::cout << "   its model variables for each combination of the given parameter values:" << std::endl;
+    std::cout << "      sweep <file> <parameter>=<value1>,<value2>,... [<parameter>=<value1>,<value2>,...] ... [record=<variable1>,<variable2>,...]" << std::endl;
+    std::cout << "   <parameter> is the URI of a constant or a state, i.e. <component>/<variable>." << std::endl;
+    std::cout << "   record=... limits the output to the given model variables (URIs)." << std::endl;
+}
+
+//==============================================================================
+
+bool SimulationSupportPlugin::runSweepCommand(const QStringList &pArguments)
+{
+    // Make sure that we have at least a file and a parameter
+
+    if (pArguments.count() < 2) {
+        runHelpCommand();
+
+        return false;
+    }
+
+    // Retrieve the parameters and their values, as well as the model variables
+    // to record, if any
+
+    static const QString Record = "record";
+
+    QStringList parameters;
+    QList<QList<double>> parametersValues;
+    QStringList recordedVariables;
+
+    for (int i = 1, iMax = pArguments.count(); i < iMax; ++i) {
+        QStringList parameterAndValues = pArguments[i].split('=');
+
+        if (parameterAndValues.count() != 2) {
+            runHelpCommand();
+
+            return false;
+        }
+
+        if (parameterAndValues[0] == Record) {
+            recordedVariables << parameterAndValues[1].split(',');
+
+            continue;
+        }
+
+        QList<double> values;
+
+        for (const auto &value : parameterAndValues[1].split(',')) {
+            bool ok;
+            double realValue = value.toDouble(&ok);
+
+            if (!ok) {
+                std::cout << QString("The value of %1 is not valid (%2).").arg(parameterAndValues[0],
+                                                                              value).toStdString() << std::endl;
+
+                return false;
+            }
+
+            values << realValue;
+        }
+
+        parameters << parameterAndValues[0];
+        parametersValues << values;
+    }
+
+    // Open our file and retrieve its simulation
+
+    bool isLocalFile;
+    QString fileNameOrUrl;
+
+    Core::checkFileNameOrUrl(pArguments[0], isLocalFile, fileNameOrUrl);
+
+    QString error = isLocalFile?
+                        Core::cliOpenFile(fileNameOrUrl):
+                        Core::cliOpenRemoteFile(fileNameOrUrl);
+
+    if (!error.isEmpty()) {
+        std::cout << error.toStdString() << std::endl;
+
+        return false;
+    }
+
+    QString fileName = isLocalFile?
+                           fileNameOrUrl:
+                           Core::FileManager::instance()->fileName(fileNameOrUrl);
+    SimulationManager *simulationManager = SimulationManager::instance();
+
+    simulationManager->manage(fileName);
+
+    Simulation *simulation = simulationManager->simulation(fileName);
+
+    if ((simulation == nullptr) || simulation->hasBlockingIssues()) {
+        std::cout << "The simulation has blocking issues and cannot therefore be run." << std::endl;
+
+        simulationManager->unmanage(fileName);
+
+        return false;
+    }
+
+    error = simulation->initialize();
+
+    if (error.isEmpty()) {
+        // Add a task for each combination of parameter values
+
+        SimulationSweep *sweep = simulation->sweep();
+        int parametersCount = parameters.count();
+        QVector<int> indexes(parametersCount, 0);
+        QList<QMap<QString, double>> tasksParametersValues;
+
+        simulation->results()->setRecordedVariables(recordedVariables);
+
+        sweep->reset();
+
+        forever {
+            QMap<QString, double> taskParametersValues;
+
+            for (int i = 0; i < parametersCount; ++i) {
+                taskParametersValues.insert(parameters[i], parametersValues[i][indexes[i]]);
+            }
+
+            if (sweep->addTask(taskParametersValues, error) == -1) {
+                break;
+            }
+
+            tasksParametersValues << taskParametersValues;
+
+            // Move on to the next combination of parameter values, if any
+
+            int i = parametersCount-1;
+
+            while ((i >= 0) && (++indexes[i] == parametersValues[i].count())) {
+                indexes[i--] = 0;
+            }
+
+            if (i < 0) {
+                break;
+            }
+        }
+
+        // Run our sweep and output the final value of our model variables for
+        // each of our tasks
+
+        if (error.isEmpty()) {
+            sweep->run();
+
+            for (int i = 0, iMax = sweep->tasksCount(); i < iMax; ++i) {
+                if (!sweep->errorMessage(i).isEmpty()) {
+                    error = QString("Task #%1: %2").arg(i).arg(sweep->errorMessage(i));
+
+                    break;
+                }
+
+                DataStore::DataStoreVariables variables;
+
+                for (auto variable : sweep->dataStore(i)->voiAndVariables()) {
+                    if (variable->recording() != DataStore::DataStoreVariableRun::Recording::None) {
+                        variables << variable;
+                    }
+                }
+
+                if (i == 0) {
+                    QStringList header = QStringList() << "task" << parameters;
+
+                    for (auto variable : variables) {
+                        header << variable->uri();
+                    }
+
+                    std::cout << header.join(',').toStdString() << std::endl;
+                }
+
+                QStringList row = QStringList() << QString::number(i);
+
+                for (const auto &parameter : qAsConst(parameters)) {
+                    row << QString::number(tasksParametersValues[i].value(parameter), 'g', 15);
+                }
+
+                for (auto variable : variables) {
+                    row << QString::number(variable->value(variable->size()-1), 'g', 15);
+                }
+
+                std::cout << row.join(',').toStdString() << std::endl;
+            }
+        }
+    }
+
+    simulationManager->unmanage(fileName);
+
+    if (!error.isEmpty()) {
+        std::cout << error.toStdString() << std::endl;
+
+        return false;
+    }
+
+    return true;
+}
+
 //==============================================================================
 
 } // namespace SimulationSupport
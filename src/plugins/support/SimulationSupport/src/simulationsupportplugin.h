@@ -25,6 +25,7 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include "cliinterface.h"
 #include "filehandlinginterface.h"
 #include "i18ninterface.h"
 #include "plugininfo.h"
@@ -41,21 +42,28 @@ PLUGININFO_FUNC SimulationSupportPluginInfo();
 
 //==============================================================================
 
-class SimulationSupportPlugin : public QObject, public FileHandlingInterface,
+class SimulationSupportPlugin : public QObject, public CliInterface,
+                                public FileHandlingInterface,
                                 public I18nInterface, public PythonInterface
 {
     Q_OBJECT
 
     Q_PLUGIN_METADATA(IID "OpenCOR.SimulationSupportPlugin" FILE "simulationsupportplugin.json")
 
+    Q_INTERFACES(OpenCOR::CliInterface)
     Q_INTERFACES(OpenCOR::FileHandlingInterface)
     Q_INTERFACES(OpenCOR::I18nInterface)
     Q_INTERFACES(OpenCOR::PythonInterface)
 
 public:
+#include "cliinterface.inl"
 #include "filehandlinginterface.inl"
 #include "i18ninterface.inl"
 #include "pythoninterface.inl"
+
+private:
+    void runHelpCommand();
+    bool runSweepCommand(const QStringList &pArguments);
 };
 
 //==============================================================================
@@ -30,13 +30,12 @@ along with this program. If not, see <https://gnu.org/licenses>.
 #include "simulation.h"
 #include "simulationmanager.h"
 #include "simulationsupportpythonwrapper.h"
+#include "simulationrepeatedtask.h"
+#include "simulationsweep.h"
 
 //==============================================================================
 
-#include <QApplication>
 #include <QFileInfo>
-#include <QTimer>
-#include <QWidget>
 
 //==============================================================================
 
@@ -138,67 +137,21 @@ static PyObject * initializeSimulation(const QString &pFileName)
             return PythonQt::priv()->wrapQObject(simulation);
         }
 
-        // Retrieve a default ODE and NLA solver
-        // Note: this is useful in case our simulation is solely based on a
-        //       CellML file...
+        // Initialise our simulation, i.e. set its default solvers, further
+        // initialise it (should we be dealing with either a SED-ML file or a
+        // COMBINE archive) and reset its data and results
 
-        const SolverInterfaces solverInterfaces = Core::solverInterfaces();
-        QString odeSolverName;
-        QString nlaSolverName;
-
-        for (auto solverInterface : solverInterfaces) {
-            QString solverName = solverInterface->solverName();
-
-            if (solverInterface->solverType() == Solver::Type::Ode) {
-                if (    odeSolverName.isEmpty()
-                    || (odeSolverName.compare(solverName, Qt::CaseInsensitive) > 0)) {
-                    odeSolverName = solverName;
-                }
-            } else if (solverInterface->solverType() == Solver::Type::Nla) {
-                if (    nlaSolverName.isEmpty()
-                    || (nlaSolverName.compare(solverName, Qt::CaseInsensitive) > 0)) {
-                    nlaSolverName = solverName;
-                }
-            }
-        }
+        QString error = simulation->initialize();
 
-        // Set our default ODE and NLA, if needed, solvers
+        if (!error.isEmpty()) {
+            // We couldn't complete initialisation, so no longer manage the
+            // simulation and raise a Python exception
 
-        CellMLSupport::CellmlFileRuntime *runtime = simulation->runtime();
+            simulationManager->unmanage(pFileName);
 
-        setOdeSolver(simulation->data(), odeSolverName);
+            PyErr_SetString(PyExc_ValueError, qPrintable(error));
 
-        if ((runtime != nullptr) && runtime->needNlaSolver()) {
-            setNlaSolver(simulation->data(), nlaSolverName);
-        }
-
-        // Further initialise our simulation, should we be dealing with either
-        // a SED-ML file or a COMBINE archive
-        // Note: this will overwrite the default ODE and NLA solvers that we set
-        //       above...
-
-        if (   (simulation->fileType() == SimulationSupport::Simulation::FileType::SedmlFile)
-            || (simulation->fileType() == SimulationSupport::Simulation::FileType::CombineArchive)) {
-            QString error = simulation->furtherInitialize();
-
-            if (!error.isEmpty()) {
-                // We couldn't complete initialisation, so no longer manage the
-                // simulation and raise a Python exception
-
-                simulationManager->unmanage(pFileName);
-
-                PyErr_SetString(PyExc_ValueError, qPrintable(error));
-
-                return nullptr;
-            }
-        }
-
-        // Reset both the simulation's data and results (well, initialise in the
-        // case of its data), should we have a valid runtime
-
-        if ((runtime != nullptr) && runtime->isValid()) {
-            simulation->data()->reset();
-            simulation->results()->reset();
+            return nullptr;
         }
 
         // Return our simulation object as a Python object
@@ -231,6 +184,8 @@ SimulationSupportPythonWrapper::SimulationSupportPythonWrapper(void *pModule,
     PythonQtSupport::registerClass(&Simulation::staticMetaObject);
     PythonQtSupport::registerClass(&SimulationData::staticMetaObject);
     PythonQtSupport::registerClass(&SimulationResults::staticMetaObject);
+    PythonQtSupport::registerClass(&SimulationSweep::staticMetaObject);
+    PythonQtSupport::registerClass(&SimulationRepeatedTask::staticMetaObject);
 
     PythonQtSupport::addInstanceDecorators(this);
 
@@ -292,11 +247,6 @@ bool SimulationSupportPythonWrapper::run(Simulation *pSimulation)
 
     // Try to allocate all the memory we need by adding a run to our simulation
     // and, if successful, run our simulation
-    // Note: we keep track of our focus widget (which might be our Python
-    //       console window), so that we can give the focus back to it once we
-    //       are done running our simulation...
-
-    QWidget *focusWidget = QApplication::focusWidget();
 
     if (pSimulation->addRun()) {
         // Keep track of any simulation error and of when the simulation is done
@@ -308,11 +258,12 @@ bool SimulationSupportPythonWrapper::run(Simulation *pSimulation)
                 this, &SimulationSupportPythonWrapper::simulationDone,
                 Qt::UniqueConnection);
 
-        // Run our simulation and wait for it to complete
+        // Run our simulation in our thread
+        // Note: this means that our simulation is done by the time
+        //       runSynchronously() returns, so there is no need for us to wait
+        //       for it using an event loop...
 
-        pSimulation->run();
-
-        mWaitLoop.exec();
+        pSimulation->runSynchronously();
 
         // Throw any error message that has been generated
 
@@ -323,12 +274,6 @@ bool SimulationSupportPythonWrapper::run(Simulation *pSimulation)
         throw std::runtime_error(tr("The memory required for the simulation could not be allocated.").toStdString());
     }
 
-    // Restore the focus to the previous widget
-
-    if (focusWidget != nullptr) {
-        focusWidget->setFocus();
-    }
-
     return mElapsedTime >= 0;
 }
 
@@ -474,6 +419,136 @@ void SimulationSupportPythonWrapper::set_point_interval(SimulationData *pSimulat
 
 //==============================================================================
 
+static const auto UniformTimeCourseType = QStringLiteral("uniform_time_course");
+static const auto OneStepType = QStringLiteral("one_step");
+static const auto SteadyStateType = QStringLiteral("steady_state");
+
+//==============================================================================
+
+QString SimulationSupportPythonWrapper::simulation_type(SimulationData *pSimulationData)
+{
+    // Return the type of the given simulation data
+
+    switch (pSimulationData->type()) {
+    case SimulationData::Type::UniformTimeCourse:
+        return UniformTimeCourseType;
+    case SimulationData::Type::OneStep:
+        return OneStepType;
+    case SimulationData::Type::SteadyState:
+        return SteadyStateType;
+    }
+
+    return {};
+}
+
+//==============================================================================
+
+void SimulationSupportPythonWrapper::set_simulation_type(SimulationData *pSimulationData,
+                                                         const QString &pType)
+{
+    // Set the type of the given simulation data
+    // Note: with a type other than a uniform time course, only the final state
+    //       of the simulation gets recorded...
+
+    if (pType == UniformTimeCourseType) {
+        pSimulationData->setType(SimulationData::Type::UniformTimeCourse);
+    } else if (pType == OneStepType) {
+        pSimulationData->setType(SimulationData::Type::OneStep);
+    } else if (pType == SteadyStateType) {
+        pSimulationData->setType(SimulationData::Type::SteadyState);
+    } else {
+        throw std::runtime_error(tr("The requested simulation type (%1) is not valid.").arg(pType).toStdString());
+    }
+}
+
+//==============================================================================
+
+bool SimulationSupportPythonWrapper::adaptive_output(SimulationData *pSimulationData)
+{
+    // Return whether the given simulation data records its points at its ODE
+    // solver's own steps
+
+    return pSimulationData->adaptiveOutput();
+}
+
+//==============================================================================
+
+void SimulationSupportPythonWrapper::set_adaptive_output(SimulationData *pSimulationData,
+                                                         bool pAdaptiveOutput)
+{
+    // Set whether the given simulation data is to record its points at its ODE
+    // solver's own steps, rather than at every point interval
+    // Note: this is only effective with an ODE solver that can take one step at
+    //       a time (e.g. CVODE)...
+
+    pSimulationData->setAdaptiveOutput(pAdaptiveOutput);
+}
+
+//==============================================================================
+
+double SimulationSupportPythonWrapper::steady_state_tolerance(SimulationData *pSimulationData)
+{
+    // Return the steady-state tolerance for the given simulation data
+
+    return pSimulationData->steadyStateTolerance();
+}
+
+//==============================================================================
+
+void SimulationSupportPythonWrapper::set_steady_state_tolerance(SimulationData *pSimulationData,
+                                                                double pTolerance)
+{
+    // Set the steady-state tolerance for the given simulation data
+
+    if (pTolerance <= 0.0) {
+        throw std::runtime_error(tr("The steady-state tolerance must be strictly positive.").toStdString());
+    }
+
+    pSimulationData->setSteadyStateTolerance(pTolerance);
+}
+
+//==============================================================================
+
+QString SimulationSupportPythonWrapper::steady_state_solver_name(SimulationData *pSimulationData)
+{
+    // Return the name of the steady-state solver for the given simulation data
+
+    return pSimulationData->steadyStateSolverName();
+}
+
+//==============================================================================
+
+void SimulationSupportPythonWrapper::set_steady_state_solver(SimulationData *pSimulationData,
+                                                             const QString &pName)
+{
+    // Set the steady-state solver for the given simulation data, making sure
+    // that it is an NLA solver
+    // Note: an empty name means that our model is to be integrated, one point
+    //       interval at a time, until its states settle...
+
+    if (!pName.isEmpty()) {
+        const SolverInterfaces solverInterfaces = Core::solverInterfaces();
+        bool found = false;
+
+        for (auto solverInterface : solverInterfaces) {
+            if (   (pName == solverInterface->solverName())
+                && (solverInterface->solverType() == Solver::Type::Nla)) {
+                found = true;
+
+                break;
+            }
+        }
+
+        if (!found) {
+            throw std::runtime_error(tr("The requested solver (%1) could not be found.").arg(pName).toStdString());
+        }
+    }
+
+    pSimulationData->setSteadyStateSolverName(pName);
+}
+
+//==============================================================================
+
 QString SimulationSupportPythonWrapper::ode_solver_name(SimulationData *pSimulationData)
 {
     // Return the name of the ODE solver for the given simulation data
@@ -680,33 +755,129 @@ quint64 SimulationSupportPythonWrapper::values_count(DataStore::DataStoreVariabl
 
 //==============================================================================
 
-void SimulationSupportPythonWrapper::simulationError(const QString &pErrorMessage)
+int SimulationSupportPythonWrapper::add_task(SimulationSweep *pSimulationSweep,
+                                             PyObject *pParametersValues)
 {
-    // Keep track for the given error message
+    // Add a task to the given simulation sweep using the given dictionary of
+    // parameters values, i.e. a dictionary which keys are the URI of some
+    // constants and/or states and which values are numbers
 
-    mErrorMessage = pErrorMessage;
+    if ((pParametersValues == nullptr) || (PyDict_Check(pParametersValues) == 0)) {
+        throw std::runtime_error(tr("The parameters values must be given as a dictionary.").toStdString());
+    }
+
+    QMap<QString, double> parametersValues;
+    PyObject *key = nullptr;
+    PyObject *value = nullptr;
+    Py_ssize_t position = 0;
+
+    while (PyDict_Next(pParametersValues, &position, &key, &value) != 0) {
+        if (PyUnicode_Check(key) == 0) {
+            throw std::runtime_error(tr("The parameters must be given as strings.").toStdString());
+        }
+
+        PyObject *floatValue = PyNumber_Float(value);
+
+        if (floatValue == nullptr) {
+            PyErr_Clear();
+
+            throw std::runtime_error(tr("The value of %1 must be a number.").arg(PyUnicode_AsUTF8(key)).toStdString());
+        }
+
+        parametersValues.insert(PyUnicode_AsUTF8(key), PyFloat_AsDouble(floatValue));
+
+        Py_DECREF(floatValue);
+    }
+
+    QString errorMessage;
+    int res = pSimulationSweep->addTask(parametersValues, errorMessage);
+
+    if (res == -1) {
+        throw std::runtime_error(errorMessage.toStdString());
+    }
+
+    return res;
 }
 
 //==============================================================================
 
-void SimulationSupportPythonWrapper::simulationDone(qint64 pElapsedTime)
+bool SimulationSupportPythonWrapper::run(SimulationSweep *pSimulationSweep,
+                                         int pThreadsCount)
 {
-    // The simulation is done, so keep track of the given elapsed time and ask
-    // our wait loop to quit with a delay (so that mWaitLoop.exec() has time to
-    // be called in case the simulation was very quick to run)
+    // Run the given simulation sweep, but only if its simulation doesn't have
+    // blocking issues and if it is valid
 
-    mElapsedTime = pElapsedTime;
+    Simulation *simulation = pSimulationSweep->simulation();
 
-    QTimer::singleShot(169, this, &SimulationSupportPythonWrapper::quitWaitLoop);
+    if (simulation->hasBlockingIssues()) {
+        throw std::runtime_error(tr("The simulation has blocking issues and cannot therefore be run.").toStdString());
+    }
+
+    if (!doValid(simulation)) {
+        throw std::runtime_error(tr("The simulation has an invalid runtime and cannot therefore be run.").toStdString());
+    }
+
+    // Run our simulation sweep and throw the first error message that has been
+    // generated, if any
+
+    bool res = pSimulationSweep->run(pThreadsCount);
+
+    for (int i = 0, iMax = pSimulationSweep->tasksCount(); i < iMax; ++i) {
+        QString errorMessage = pSimulationSweep->errorMessage(i);
+
+        if (!errorMessage.isEmpty()) {
+            throw std::runtime_error(tr("Task #%1: %2").arg(i).arg(errorMessage).toStdString());
+        }
+    }
+
+    return res;
 }
 
 //==============================================================================
 
-void SimulationSupportPythonWrapper::quitWaitLoop()
+bool SimulationSupportPythonWrapper::run(SimulationRepeatedTask *pSimulationRepeatedTask,
+                                         int pThreadsCount)
 {
-    // Quit our wait loop
+    // Run the given simulation repeated task, but only if its simulation
+    // doesn't have blocking issues and if it is valid
+
+    Simulation *simulation = pSimulationRepeatedTask->simulation();
 
-    mWaitLoop.quit();
+    if (simulation->hasBlockingIssues()) {
+        throw std::runtime_error(tr("The simulation has blocking issues and cannot therefore be run.").toStdString());
+    }
+
+    if (!doValid(simulation)) {
+        throw std::runtime_error(tr("The simulation has an invalid runtime and cannot therefore be run.").toStdString());
+    }
+
+    // Run our simulation repeated task and throw its error message, if any
+
+    QString errorMessage;
+
+    if (!pSimulationRepeatedTask->run(errorMessage, pThreadsCount)) {
+        throw std::runtime_error(errorMessage.toStdString());
+    }
+
+    return true;
+}
+
+//==============================================================================
+
+void SimulationSupportPythonWrapper::simulationError(const QString &pErrorMessage)
+{
+    // Keep track for the given error message
+
+    mErrorMessage = pErrorMessage;
+}
+
+//==============================================================================
+
+void SimulationSupportPythonWrapper::simulationDone(qint64 pElapsedTime)
+{
+    // The simulation is done, so keep track of the given elapsed time
+
+    mElapsedTime = pElapsedTime;
 }
 
 //==============================================================================
@@ -25,7 +25,6 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
-#include <QEventLoop>
 #include <QObject>
 
 //==============================================================================
@@ -54,7 +53,9 @@ namespace SimulationSupport {
 
 class Simulation;
 class SimulationData;
+class SimulationRepeatedTask;
 class SimulationResults;
+class SimulationSweep;
 
 //==============================================================================
 
@@ -69,8 +70,6 @@ private:
     qint64 mElapsedTime = -1;
     QString mErrorMessage;
 
-    QEventLoop mWaitLoop;
-
     bool doValid(Simulation *pSimulation);
 
 public slots:
@@ -99,6 +98,22 @@ public slots:
     void set_point_interval(OpenCOR::SimulationSupport::SimulationData *pSimulationData,
                             double pPointInterval);
 
+    QString simulation_type(OpenCOR::SimulationSupport::SimulationData *pSimulationData);
+    void set_simulation_type(OpenCOR::SimulationSupport::SimulationData *pSimulationData,
+                             const QString &pType);
+
+    bool adaptive_output(OpenCOR::SimulationSupport::SimulationData *pSimulationData);
+    void set_adaptive_output(OpenCOR::SimulationSupport::SimulationData *pSimulationData,
+                             bool pAdaptiveOutput);
+
+    double steady_state_tolerance(OpenCOR::SimulationSupport::SimulationData *pSimulationData);
+    void set_steady_state_tolerance(OpenCOR::SimulationSupport::SimulationData *pSimulationData,
+                                    double pTolerance);
+
+    QString steady_state_solver_name(OpenCOR::SimulationSupport::SimulationData *pSimulationData);
+    void set_steady_state_solver(OpenCOR::SimulationSupport::SimulationData *pSimulationData,
+                                 const QString &pName);
+
     QString ode_solver_name(OpenCOR::SimulationSupport::SimulationData *pSimulationData);
     void set_ode_solver(OpenCOR::SimulationSupport::SimulationData *pSimulationData,
                         const QString &pName);
@@ -138,11 +153,17 @@ public slots:
     quint64 values_count(OpenCOR::DataStore::DataStoreVariable *pDataStoreVariable,
                          int pRun = -1) const;
 
+    int add_task(OpenCOR::SimulationSupport::SimulationSweep *pSimulationSweep,
+                 PyObject *pParametersValues);
+
+    bool run(OpenCOR::SimulationSupport::SimulationSweep *pSimulationSweep,
+             int pThreadsCount = 0);
+    bool run(OpenCOR::SimulationSupport::SimulationRepeatedTask *pSimulationRepeatedTask,
+             int pThreadsCount = 0);
+
 private slots:
     void simulationError(const QString &pErrorMessage);
     void simulationDone(qint64 pElapsedTime);
-
-    void quitWaitLoop();
 };
 
 //==============================================================================
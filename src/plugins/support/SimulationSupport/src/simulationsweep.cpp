@@ -0,0 +1,1190 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Simulation sweep
+//==============================================================================
+
+#include "cellmlfileruntime.h"
+#include "sedmlsupport.h"
+#include "simulationsweep.h"
+
+//==============================================================================
+
+#include <QElapsedTimer>
+#include <QThread>
+#include <QThreadPool>
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace SimulationSupport {
+
+//==============================================================================
+
+SimulationSweepChange::SimulationSweepChange(Type pType, const QString &pTarget,
+                                             const libsbml::ASTNode *pMath,
+                                             const QMap<QString, double> &pSymbols,
+                                             const QMap<QString, QString> &pVariables) :
+    mType(pType),
+    mTarget(pTarget),
+    mMath(pMath),
+    mSymbols(pSymbols),
+    mVariables(pVariables)
+{
+}
+
+//==============================================================================
+
+SimulationSweepChange::Type SimulationSweepChange::type() const
+{
+    // Return the change's type
+
+    return mType;
+}
+
+//==============================================================================
+
+QString SimulationSweepChange::target() const
+{
+    // Return the change's target, i.e. either the id of a symbol or the URI of
+    // a parameter
+
+    return mTarget;
+}
+
+//==============================================================================
+
+const libsbml::ASTNode * SimulationSweepChange::math() const
+{
+    // Return the change's maths
+
+    return mMath;
+}
+
+//==============================================================================
+
+QMap<QString, double> SimulationSweepChange::symbols() const
+{
+    // Return the change's symbols, i.e. the symbols which value is known in
+    // advance
+
+    return mSymbols;
+}
+
+//==============================================================================
+
+QMap<QString, QString> SimulationSweepChange::variables() const
+{
+    // Return the change's variables, i.e. the symbols which value is that of a
+    // model parameter, referenced using its URI
+
+    return mVariables;
+}
+
+//==============================================================================
+
+SimulationSweepTask::SimulationSweepTask(Simulation *pSimulation,
+                                         const QMap<int, double> &pConstantsValues,
+                                         const QMap<int, double> &pStatesValues,
+                                         const SimulationSweepChanges &pChanges,
+                                         const QMap<QString, int> &pConstantsIndexes,
+                                         const QMap<QString, int> &pStatesIndexes,
+                                         const QAtomicInt *pStopped,
+                                         SimulationSweepTask *pPreviousTask) :
+    mSimulation(pSimulation),
+    mRuntime(pSimulation->runtime()),
+    mConstantsValues(pConstantsValues),
+    mStatesValues(pStatesValues),
+    mChanges(pChanges),
+    mConstantsIndexes(pConstantsIndexes),
+    mStatesIndexes(pStatesIndexes),
+    mStopped(pStopped),
+    mPreviousTask(pPreviousTask)
+{
+    // We are owned by our simulation sweep, so make sure that our thread pool
+    // doesn't delete us once we have been run
+
+    setAutoDelete(false);
+}
+
+//==============================================================================
+
+SimulationSweepTask::~SimulationSweepTask()
+{
+    // Delete some internal objects
+
+    deleteArrays();
+}
+
+//==============================================================================
+
+static void customizeVariable(DataStore::DataStoreVariable *pVariable,
+                              DataStore::DataStoreVariable *pSimulationVariable)
+{
+    // Customise the given variable using the given simulation variable
+
+    pVariable->setType(pSimulationVariable->type());
+    pVariable->setRecording(pSimulationVariable->recording());
+    pVariable->setUri(pSimulationVariable->uri());
+    pVariable->setName(pSimulationVariable->name());
+    pVariable->setUnit(pSimulationVariable->unit());
+}
+
+//==============================================================================
+
+bool SimulationSweepTask::initialize()
+{
+    // Delete our previous arrays and data store, if any, and reset our
+    // internals
+
+    deleteArrays();
+
+    mErrorMessage = QString();
+    mElapsedTime = -1;
+
+    // Create our own copy of our model's arrays and initialise them using our
+    // simulation's current values and our own constants and states values
+    // Note: if we continue from a previous task, then our arrays will be
+    //       reinitialised once that task is done (see run())...
+
+    int constantsCount = mRuntime->constantsCount();
+    int ratesCount = mRuntime->ratesCount();
+    int statesCount = mRuntime->statesCount();
+    int algebraicCount = mRuntime->algebraicCount();
+    SimulationData *simulationData = mSimulation->data();
+
+    mConstants = new double[constantsCount] {};
+    mRates = new double[ratesCount] {};
+    mStates = new double[statesCount] {};
+    mAlgebraic = new double[algebraicCount] {};
+
+    // Initialise our values, using a temporary NLA solver, if needed
+    // Note: initialising our values may require solving one or several NLA
+    //       systems...
+
+    Solver::NlaSolver *nlaSolver = createNlaSolver();
+    bool valuesInitialized = initializeValues(simulationData->constants(),
+                                              simulationData->states());
+
+    delete nlaSolver;
+
+    if (!valuesInitialized) {
+        return false;
+    }
+
+    // Create our data store and customise its VOI and variables using those of
+    // our simulation's results
+
+    SimulationResults *simulationResults = mSimulation->results();
+    DataStore::DataStoreVariables simulationConstantsVariables = simulationResults->constantsVariables();
+    DataStore::DataStoreVariables simulationRatesVariables = simulationResults->ratesVariables();
+    DataStore::DataStoreVariables simulationStatesVariables = simulationResults->statesVariables();
+    DataStore::DataStoreVariables simulationAlgebraicVariables = simulationResults->algebraicVariables();
+
+    mDataStore = new DataStore::DataStore(mSimulation, simulationResults->dataStore()->uri());
+
+    mDataStore->setContiguous(simulationResults->dataStore()->isContiguous());
+
+    DataStore::DataStoreVariables constantsVariables = mDataStore->addVariables(mConstants, constantsCount);
+    DataStore::DataStoreVariables ratesVariables = mDataStore->addVariables(mRates, ratesCount);
+    DataStore::DataStoreVariables statesVariables = mDataStore->addVariables(mStates, statesCount);
+    DataStore::DataStoreVariables algebraicVariables = mDataStore->addVariables(mAlgebraic, algebraicCount);
+
+    customizeVariable(mDataStore->voi(), simulationResults->pointsVariable());
+
+    for (int i = 0; i < constantsCount; ++i) {
+        customizeVariable(constantsVariables[i], simulationConstantsVariables[i]);
+    }
+
+    for (int i = 0; i < ratesCount; ++i) {
+        customizeVariable(ratesVariables[i], simulationRatesVariables[i]);
+    }
+
+    for (int i = 0; i < statesCount; ++i) {
+        customizeVariable(statesVariables[i], simulationStatesVariables[i]);
+    }
+
+    for (int i = 0; i < algebraicCount; ++i) {
+        customizeVariable(algebraicVariables[i], simulationAlgebraicVariables[i]);
+    }
+
+    // Try to allocate all the memory we need by adding a run to our data store
+
+    if (!mDataStore->addRun(mSimulation->size())) {
+        mErrorMessage = tr("the memory required for the simulation could not be allocated");
+
+        return false;
+    }
+
+    return true;
+}
+
+//==============================================================================
+
+void SimulationSweepTask::run()
+{
+    // Set up our NLA solver, if needed
+    // Note: we do this first since starting from where our previous task, if
+    //       any, ended may require solving one or several NLA systems...
+
+    Solver::NlaSolver *nlaSolver = createNlaSolver();
+
+    // Start from where our previous task, if any, ended
+
+    if (   (mPreviousTask != nullptr)
+        && !initializeValues(mPreviousTask->mConstants, mPreviousTask->mStates)) {
+        delete nlaSolver;
+
+        return;
+    }
+
+    // Set up our ODE solver
+    // Note: we use a direct connection to keep track of errors since we are
+    //       run from a thread pool...
+
+    SimulationData *simulationData = mSimulation->data();
+    auto odeSolver = static_cast<Solver::OdeSolver *>(simulationData->odeSolverInterface()->solverInstance());
+
+    connect(odeSolver, &Solver::OdeSolver::error,
+            this, &SimulationSweepTask::setErrorMessage,
+            Qt::DirectConnection);
+
+    // Retrieve our simulation properties
+
+    double startingPoint = simulationData->startingPoint();
+    double endingPoint = simulationData->endingPoint();
+    double pointInterval = simulationData->pointInterval();
+    quint64 pointCounter = 0;
+    double currentPoint = startingPoint;
+    SimulationData::Type type = simulationData->type();
+    bool steadyState = type == SimulationData::Type::SteadyState;
+    bool steadyStateReached = false;
+    bool adaptiveOutput =    simulationData->adaptiveOutput()
+                          && (type == SimulationData::Type::UniformTimeCourse)
+                          && odeSolver->supportsOneStep();
+
+    // Initialise our ODE solver using our own arrays, but the same compiled
+    // model as our simulation
+
+    odeSolver->setProperties(simulationData->odeSolverProperties());
+    odeSolver->setJacobian(mRuntime->computeJacobian(),
+                           mRuntime->jacobianColumnPointers(),
+                           mRuntime->jacobianRowIndices());
+
+    odeSolver->initialize(currentPoint, mRuntime->statesCount(),
+                          mConstants, mRates, mStates, mAlgebraic,
+                          mRuntime->computeRates());
+
+    // Compute our model, but only if no error has occurred so far
+
+    if (mErrorMessage.isEmpty()) {
+        QElapsedTimer timer;
+
+        timer.start();
+
+        if (type == SimulationData::Type::UniformTimeCourse) {
+            addPoint(currentPoint);
+        }
+
+        // Look for our steady state directly or keep track of our states at
+        // the end of each beat, if needed
+
+        int statesCount = mRuntime->statesCount();
+        double *previousStates = steadyState?
+                                     new double[size_t(statesCount)]:
+                                     nullptr;
+
+        if (previousStates != nullptr) {
+            memcpy(previousStates, mStates,
+                   size_t(statesCount)*Solver::SizeOfDouble);
+        }
+
+        if (steadyState && !simulationData->steadyStateSolverName().isEmpty()) {
+            steadyStateReached = simulationData->solveSteadyState(currentPoint,
+                                                                  mConstants,
+                                                                  mRates,
+                                                                  mStates,
+                                                                  mAlgebraic).isEmpty();
+
+            if (!steadyStateReached) {
+                memcpy(mStates, previousStates,
+                       size_t(statesCount)*Solver::SizeOfDouble);
+
+                odeSolver->reinitialize(currentPoint);
+            }
+        }
+
+        while (!steadyStateReached) {
+            // Make sure that we haven't been asked to stop
+
+            if (mStopped->loadAcquire() != 0) {
+                mErrorMessage = tr("the simulation was stopped");
+
+                break;
+            }
+
+            // Determine our next point and compute our model up to it
+
+            if (adaptiveOutput) {
+                odeSolver->solveOneStep(currentPoint, endingPoint);
+            } else {
+                odeSolver->solve(currentPoint,
+                                 qMin(endingPoint,
+                                      startingPoint+double(++pointCounter)*pointInterval));
+            }
+
+            if (!mErrorMessage.isEmpty()) {
+                break;
+            }
+
+            // Add our new point (for each of our ODE solver's steps, if we have
+            // an adaptive output) or check whether we have reached a steady
+            // state, and leave if we have reached our ending point
+
+            if (type == SimulationData::Type::UniformTimeCourse) {
+                if (!addPoint(currentPoint)) {
+                    break;
+                }
+            } else if (steadyState) {
+                steadyStateReached = simulationData->steadyStateReached(previousStates,
+                                                                        mStates);
+
+                memcpy(previousStates, mStates,
+                       size_t(statesCount)*Solver::SizeOfDouble);
+            }
+
+            if (qFuzzyCompare(currentPoint, endingPoint)) {
+                break;
+            }
+        }
+
+        delete[] previousStates;
+
+        // Add our final point, if it is the only one that we record
+
+        if (   mErrorMessage.isEmpty()
+            && (type != SimulationData::Type::UniformTimeCourse)) {
+            if (steadyState && !steadyStateReached) {
+                mErrorMessage = tr("the steady state could not be reached before the ending point");
+            } else {
+                addPoint(currentPoint);
+            }
+        }
+
+        if (mErrorMessage.isEmpty()) {
+            mElapsedTime = timer.elapsed();
+        }
+    }
+
+    // Delete our solver(s)
+
+    delete odeSolver;
+
+    if (nlaSolver != nullptr) {
+        delete nlaSolver;
+    }
+}
+
+//==============================================================================
+
+DataStore::DataStore * SimulationSweepTask::dataStore() const
+{
+    // Return our data store
+
+    return mDataStore;
+}
+
+//==============================================================================
+
+QString SimulationSweepTask::errorMessage() const
+{
+    // Return our error message
+
+    return mErrorMessage;
+}
+
+//==============================================================================
+
+qint64 SimulationSweepTask::elapsedTime() const
+{
+    // Return our elapsed time
+
+    return mElapsedTime;
+}
+
+//==============================================================================
+
+void SimulationSweepTask::deleteArrays()
+{
+    // Delete our data store and arrays
+
+    delete mDataStore;
+
+    delete[] mConstants;
+    delete[] mRates;
+    delete[] mStates;
+    delete[] mAlgebraic;
+
+    mDataStore = nullptr;
+
+    mConstants = mRates = mStates = mAlgebraic = nullptr;
+}
+
+//==============================================================================
+
+Solver::NlaSolver * SimulationSweepTask::createNlaSolver()
+{
+    // Create, register and set up an NLA solver for our runtime, if it needs
+    // one
+    // Note: we use a direct connection to keep track of errors since we may be
+    //       run from a thread pool...
+
+    if (!mRuntime->needNlaSolver()) {
+        return nullptr;
+    }
+
+    SimulationData *simulationData = mSimulation->data();
+    auto res = static_cast<Solver::NlaSolver *>(simulationData->nlaSolverInterface()->solverInstance());
+
+    Solver::setNlaSolver(mRuntime, res);
+
+    connect(res, &Solver::NlaSolver::error,
+            this, &SimulationSweepTask::setErrorMessage,
+            Qt::DirectConnection);
+
+    res->setProperties(simulationData->nlaSolverProperties());
+
+    return res;
+}
+
+//==============================================================================
+
+bool SimulationSweepTask::initializeValues(const double *pConstants,
+                                           const double *pStates)
+{
+    // Initialise our constants and states using the given ones, as well as our
+    // own constants and states values
+    // Note: our 'computed constants' are recomputed, in case they depend on
+    //       some of our constants...
+
+    memcpy(mConstants, pConstants, size_t(mRuntime->constantsCount())*Solver::SizeOfDouble);
+    memcpy(mStates, pStates, size_t(mRuntime->statesCount())*Solver::SizeOfDouble);
+
+    for (auto constantValue = mConstantsValues.constBegin(),
+              constantValueEnd = mConstantsValues.constEnd();
+         constantValue != constantValueEnd; ++constantValue) {
+        mConstants[constantValue.key()] = constantValue.value();
+    }
+
+    double startingPoint = mSimulation->data()->startingPoint();
+
+    mRuntime->computeComputedConstants()(startingPoint, mConstants, mRates,
+                                         mStates, mAlgebraic);
+
+    for (auto stateValue = mStatesValues.constBegin(),
+              stateValueEnd = mStatesValues.constEnd();
+         stateValue != stateValueEnd; ++stateValue) {
+        mStates[stateValue.key()] = stateValue.value();
+    }
+
+    // Apply our changes, one after the other, using the current value of the
+    // constants and states that they reference, i.e. their value at the start
+    // of our task rather than their initial value
+    // Note: a change may define a symbol (e.g. a functional range) that is
+    //       used by the changes that follow it...
+
+    QMap<QString, double> symbols;
+
+    for (const auto &change : qAsConst(mChanges)) {
+        QMap<QString, double> changeSymbols = change.symbols();
+        const QMap<QString, QString> changeVariables = change.variables();
+
+        for (auto symbol = symbols.constBegin(), symbolEnd = symbols.constEnd();
+             symbol != symbolEnd; ++symbol) {
+            changeSymbols.insert(symbol.key(), symbol.value());
+        }
+
+        for (auto variable = changeVariables.constBegin(),
+                  variableEnd = changeVariables.constEnd();
+             variable != variableEnd; ++variable) {
+            changeSymbols.insert(variable.key(),
+                                 mConstantsIndexes.contains(variable.value())?
+                                     mConstants[mConstantsIndexes.value(variable.value())]:
+                                     mStates[mStatesIndexes.value(variable.value())]);
+        }
+
+        bool ok;
+        double value = SEDMLSupport::evaluateMath(change.math(), changeSymbols, ok);
+
+        if (!ok) {
+            mErrorMessage = tr("the value of %1 could not be computed").arg(change.target());
+
+            return false;
+        }
+
+        if (change.type() == SimulationSweepChange::Type::Symbol) {
+            symbols.insert(change.target(), value);
+        } else if (mConstantsIndexes.contains(change.target())) {
+            mConstants[mConstantsIndexes.value(change.target())] = value;
+
+            mRuntime->computeComputedConstants()(startingPoint, mConstants,
+                                                 mRates, mStates, mAlgebraic);
+        } else {
+            mStates[mStatesIndexes.value(change.target())] = value;
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+
+bool SimulationSweepTask::addPoint(double pPoint)
+{
+    // Make sure that our data store has room for the given point, growing it
+    // if needed
+    // Note: this can only happen with an adaptive output, in which case we
+    //       cannot know in advance how many points we will need...
+
+    quint64 capacity = mDataStore->capacity();
+
+    if (   (mDataStore->size() == capacity)
+        && !mDataStore->growRun(2*capacity)) {
+        mErrorMessage = tr("the memory required for the simulation could not be allocated");
+
+        return false;
+    }
+
+    // Make sure that all our variables are up to date and add them to our data
+    // store
+
+    mRuntime->computeRates()(pPoint, mConstants, mRates, mStates, mAlgebraic);
+    mRuntime->computeVariables()(pPoint, mConstants, mRates, mStates, mAlgebraic);
+
+    mDataStore->addValues(pPoint);
+
+    return true;
+}
+
+//==============================================================================
+
+void SimulationSweepTask::setErrorMessage(const QString &pErrorMessage)
+{
+    // A solver error occurred, so keep track of it, but only if another error
+    // hasn't already been received
+
+    if (mErrorMessage.isEmpty()) {
+        mErrorMessage = pErrorMessage;
+    }
+}
+
+//==============================================================================
+
+SimulationSweepChain::SimulationSweepChain(const QList<SimulationSweepTask *> &pTasks,
+                                           const QAtomicInt *pStopped) :
+    mTasks(pTasks),
+    mStopped(pStopped)
+{
+    // We are owned by our simulation sweep, so make sure that our thread pool
+    // doesn't delete us once we have been run
+
+    setAutoDelete(false);
+}
+
+//==============================================================================
+
+void SimulationSweepChain::run()
+{
+    // Run our tasks one after the other, since each of them continues from
+    // where the previous one ended, and stop as soon as one of them fails
+
+    for (int i = 0, iMax = mTasks.count(); i < iMax; ++i) {
+        SimulationSweepTask *task = mTasks[i];
+
+        task->run();
+
+        if (!task->errorMessage().isEmpty()) {
+            for (int j = i+1; j < iMax; ++j) {
+                mTasks[j]->setErrorMessage((mStopped->loadAcquire() != 0)?
+                                               SimulationSweepTask::tr("the simulation was stopped"):
+                                               SimulationSweepTask::tr("the task continues from a task that failed"));
+            }
+
+            break;
+        }
+    }
+}
+
+//==============================================================================
+
+SimulationSweepEnsemble::SimulationSweepEnsemble(Simulation *pSimulation,
+                                                 const QList<SimulationSweepTask *> &pTasks,
+                                                 const QAtomicInt *pStopped) :
+    mSimulation(pSimulation),
+    mRuntime(pSimulation->runtime()),
+    mTasks(pTasks),
+    mStopped(pStopped)
+{
+    // We are owned by our simulation sweep, so make sure that our thread pool
+    // doesn't delete us once we have been run
+
+    setAutoDelete(false);
+}
+
+//==============================================================================
+
+void SimulationSweepEnsemble::run()
+{
+    // Create the arrays for our ensemble, using a structure-of-arrays layout,
+    // and initialise them using the arrays of our tasks
+
+    int ensembleSize = mTasks.count();
+    int constantsCount = mRuntime->constantsCount();
+    int ratesCount = mRuntime->ratesCount();
+    int statesCount = mRuntime->statesCount();
+    int algebraicCount = mRuntime->algebraicCount();
+    auto constants = new double[constantsCount*ensembleSize] {};
+    auto rates = new double[ratesCount*ensembleSize] {};
+    auto states = new double[statesCount*ensembleSize] {};
+    auto algebraic = new double[algebraicCount*ensembleSize] {};
+
+    for (int j = 0; j < ensembleSize; ++j) {
+        SimulationSweepTask *task = mTasks[j];
+
+        for (int i = 0; i < constantsCount; ++i) {
+            constants[i*ensembleSize+j] = task->mConstants[i];
+        }
+
+        for (int i = 0; i < statesCount; ++i) {
+            states[i*ensembleSize+j] = task->mStates[i];
+        }
+
+        for (int i = 0; i < algebraicCount; ++i) {
+            algebraic[i*ensembleSize+j] = task->mAlgebraic[i];
+        }
+    }
+
+    // Set up our ODE solver so that it integrates our whole ensemble at once
+
+    SimulationData *simulationData = mSimulation->data();
+    auto odeSolver = static_cast<Solver::OdeSolver *>(simulationData->odeSolverInterface()->solverInstance());
+
+    connect(odeSolver, &Solver::OdeSolver::error,
+            this, &SimulationSweepEnsemble::setErrorMessage,
+            Qt::DirectConnection);
+
+    double startingPoint = simulationData->startingPoint();
+    double endingPoint = simulationData->endingPoint();
+    double pointInterval = simulationData->pointInterval();
+    quint64 pointCounter = 0;
+    double currentPoint = startingPoint;
+
+    odeSolver->setProperties(simulationData->odeSolverProperties());
+    odeSolver->setEnsemble(mRuntime->computeEnsembleRates(), ensembleSize);
+
+    odeSolver->initialize(currentPoint, statesCount,
+                          constants, rates, states, algebraic,
+                          mRuntime->computeRates());
+
+    // Compute our ensemble, but only if no error has occurred so far, and let
+    // our tasks add the corresponding points to their data store
+
+    if (mErrorMessage.isEmpty()) {
+        QElapsedTimer timer;
+
+        timer.start();
+
+        for (auto task : qAsConst(mTasks)) {
+            task->addPoint(currentPoint);
+        }
+
+        forever {
+            if (mStopped->loadAcquire() != 0) {
+                mErrorMessage = SimulationSweepTask::tr("the simulation was stopped");
+
+                break;
+            }
+
+            odeSolver->solve(currentPoint,
+                             qMin(endingPoint,
+                                  startingPoint+double(++pointCounter)*pointInterval));
+
+            if (!mErrorMessage.isEmpty()) {
+                break;
+            }
+
+            for (int j = 0; j < ensembleSize; ++j) {
+                SimulationSweepTask *task = mTasks[j];
+
+                for (int i = 0; i < statesCount; ++i) {
+                    task->mStates[i] = states[i*ensembleSize+j];
+                }
+
+                task->addPoint(currentPoint);
+            }
+
+            if (qFuzzyCompare(currentPoint, endingPoint)) {
+                break;
+            }
+        }
+
+        if (mErrorMessage.isEmpty()) {
+            qint64 elapsedTime = timer.elapsed();
+
+            for (auto task : qAsConst(mTasks)) {
+                task->mElapsedTime = elapsedTime;
+            }
+        }
+    }
+
+    // Let our tasks know about any error that occurred
+
+    if (!mErrorMessage.isEmpty()) {
+        for (auto task : qAsConst(mTasks)) {
+            task->setErrorMessage(mErrorMessage);
+        }
+    }
+
+    // Delete our solver and arrays
+
+    delete odeSolver;
+
+    delete[] constants;
+    delete[] rates;
+    delete[] states;
+    delete[] algebraic;
+}
+
+//==============================================================================
+
+void SimulationSweepEnsemble::setErrorMessage(const QString &pErrorMessage)
+{
+    // A solver error occurred, so keep track of it, but only if another error
+    // hasn't already been received
+
+    if (mErrorMessage.isEmpty()) {
+        mErrorMessage = pErrorMessage;
+    }
+}
+
+//==============================================================================
+
+SimulationSweep::SimulationSweep(Simulation *pSimulation) :
+    SimulationObject(pSimulation)
+{
+}
+
+//==============================================================================
+
+SimulationSweep::~SimulationSweep()
+{
+    // Delete some internal objects
+
+    reset();
+}
+
+//==============================================================================
+
+Simulation * SimulationSweep::simulation() const
+{
+    // Return our simulation
+
+    return mSimulation;
+}
+
+//==============================================================================
+
+static int valueIndex(const DataStore::DataStoreValues *pValues,
+                      const QString &pUri)
+{
+    // Return the index of the value with the given URI, if any
+
+    for (int i = 0, iMax = pValues->count(); i < iMax; ++i) {
+        if (pValues->at(i)->uri() == pUri) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+//==============================================================================
+
+int SimulationSweep::addTask(const QMap<QString, double> &pParametersValues,
+                             QString &pErrorMessage, int pPreviousTask)
+{
+    // Add a task that only uses the given parameters values
+
+    return addTask(pParametersValues, {}, pErrorMessage, pPreviousTask);
+}
+
+//==============================================================================
+
+int SimulationSweep::addTask(const QMap<QString, double> &pParametersValues,
+                             const SimulationSweepChanges &pChanges,
+                             QString &pErrorMessage, int pPreviousTask)
+{
+    // Make sure that we have a valid runtime
+
+    CellMLSupport::CellmlFileRuntime *runtime = mSimulation->runtime();
+
+    if ((runtime == nullptr) || !runtime->isValid()) {
+        pErrorMessage = tr("the simulation has an invalid runtime");
+
+        return -1;
+    }
+
+    // Make sure that the previous task, if any, exists and that no other task
+    // already continues from it
+
+    SimulationSweepTask *previousTask = nullptr;
+
+    if (pPreviousTask != -1) {
+        if ((pPreviousTask < 0) || (pPreviousTask >= mTasks.count())) {
+            pErrorMessage = tr("task #%1 does not exist").arg(pPreviousTask);
+
+            return -1;
+        }
+
+        previousTask = mTasks[pPreviousTask];
+
+        for (auto task : qAsConst(mTasks)) {
+            if (task->mPreviousTask == previousTask) {
+                pErrorMessage = tr("another task already continues from task #%1").arg(pPreviousTask);
+
+                return -1;
+            }
+        }
+    }
+
+    // Determine which constants and states are to be given a specific value
+    // Note: parameters are referenced using the same URI as in our simulation's
+    //       data and results, i.e. <component>/<variable>...
+
+    const CellMLSupport::CellmlFileRuntimeParameters parameters = runtime->parameters();
+    DataStore::DataStoreValues *constantsValues = mSimulation->data()->constantsValues();
+    DataStore::DataStoreValues *statesValues = mSimulation->data()->statesValues();
+    QMap<int, double> taskConstantsValues;
+    QMap<int, double> taskStatesValues;
+
+    for (auto parameterValue = pParametersValues.constBegin(),
+              parameterValueEnd = pParametersValues.constEnd();
+         parameterValue != parameterValueEnd; ++parameterValue) {
+        bool parameterFound = false;
+
+        for (auto parameter : parameters) {
+            if (   (parameter->type() == CellMLSupport::CellmlFileRuntimeParameter::Type::Constant)
+                && (constantsValues->at(parameter->index())->uri() == parameterValue.key())) {
+                taskConstantsValues.insert(parameter->index(), parameterValue.value());
+
+                parameterFound = true;
+            } else if (   (parameter->type() == CellMLSupport::CellmlFileRuntimeParameter::Type::State)
+                       && (statesValues->at(parameter->index())->uri() == parameterValue.key())) {
+                taskStatesValues.insert(parameter->index(), parameterValue.value());
+
+                parameterFound = true;
+            }
+
+            if (parameterFound) {
+                break;
+            }
+        }
+
+        if (!parameterFound) {
+            pErrorMessage = tr("%1 is neither a constant nor a state").arg(parameterValue.key());
+
+            return -1;
+        }
+    }
+
+    // Determine which constants and states are referenced by our changes,
+    // either as a target, in which case it must be a constant or a state that
+    // can be given a specific value, or as a variable, in which case it can
+    // also be a computed constant
+
+    QMap<QString, int> constantsIndexes;
+    QMap<QString, int> statesIndexes;
+
+    for (const auto &change : pChanges) {
+        if (change.type() == SimulationSweepChange::Type::Parameter) {
+            bool parameterFound = false;
+
+            for (auto parameter : parameters) {
+                if (   (parameter->type() == CellMLSupport::CellmlFileRuntimeParameter::Type::Constant)
+                    && (constantsValues->at(parameter->index())->uri() == change.target())) {
+                    constantsIndexes.insert(change.target(), parameter->index());
+
+                    parameterFound = true;
+                } else if (   (parameter->type() == CellMLSupport::CellmlFileRuntimeParameter::Type::State)
+                           && (statesValues->at(parameter->index())->uri() == change.target())) {
+                    statesIndexes.insert(change.target(), parameter->index());
+
+                    parameterFound = true;
+                }
+
+                if (parameterFound) {
+                    break;
+                }
+            }
+
+            if (!parameterFound) {
+                pErrorMessage = tr("%1 is neither a constant nor a state").arg(change.target());
+
+                return -1;
+            }
+        }
+
+        const QStringList variablesUris = change.variables().values();
+
+        for (const auto &variableUri : variablesUris) {
+            int index = valueIndex(constantsValues, variableUri);
+
+            if (index != -1) {
+                constantsIndexes.insert(variableUri, index);
+            } else {
+                index = valueIndex(statesValues, variableUri);
+
+                if (index == -1) {
+                    pErrorMessage = tr("%1 is neither a constant nor a state").arg(variableUri);
+
+                    return -1;
+                }
+
+                statesIndexes.insert(variableUri, index);
+            }
+        }
+    }
+
+    // Create and keep track of our new task
+
+    mTasks << new SimulationSweepTask(mSimulation, taskConstantsValues,
+                                      taskStatesValues, pChanges,
+                                      constantsIndexes, statesIndexes,
+                                      &mStopped, previousTask);
+
+    return mTasks.count()-1;
+}
+
+//==============================================================================
+
+bool SimulationSweep::run(int pThreadsCount)
+{
+    // Make sure that we have a valid runtime with a VOI and that our simulation
+    // settings are sound
+
+    CellMLSupport::CellmlFileRuntime *runtime = mSimulation->runtime();
+
+    if (   (runtime == nullptr) || !runtime->isValid()
+        || (runtime->voi() == nullptr) || (mSimulation->size() == 0)) {
+        return false;
+    }
+
+    // Initialise our tasks, which includes allocating all the memory they need
+
+    for (auto task : qAsConst(mTasks)) {
+        if (!task->initialize()) {
+            return false;
+        }
+    }
+
+    // Determine which of our tasks continue from another task, in which case
+    // they must be run after that task, i.e. as part of a chain of tasks
+
+    QMap<SimulationSweepTask *, SimulationSweepTask *> nextTasks;
+
+    for (auto task : qAsConst(mTasks)) {
+        if (task->mPreviousTask != nullptr) {
+            nextTasks.insert(task->mPreviousTask, task);
+        }
+    }
+
+    // Determine whether our tasks can be run as ensembles, i.e. whether they
+    // record a uniform time course, whether none of them continues from another
+    // task, and whether our model has an ensemble version of its rates and our
+    // ODE solver supports ensembles
+
+    bool useEnsembles = false;
+
+    if (   (mSimulation->data()->type() == SimulationData::Type::UniformTimeCourse)
+        && nextTasks.isEmpty()
+        && (runtime->computeEnsembleRates() != nullptr) && (mTasks.count() > 1)) {
+        auto odeSolver = static_cast<Solver::OdeSolver *>(mSimulation->data()->odeSolverInterface()->solverInstance());
+
+        useEnsembles = odeSolver->supportsEnsemble();
+
+        delete odeSolver;
+    }
+
+    // Run our tasks using our own thread pool and wait for all of them to be
+    // done
+    // Note #1: an NLA solver is associated with a runtime rather than with an
+    //          ODE solver, so if our model needs an NLA solver then our tasks
+    //          must be run one after the other...
+    // Note #2: if we can use ensembles, then we split our tasks into as many
+    //          ensembles as we have threads...
+    // Note #3: if some tasks continue from other tasks, then each chain of
+    //          tasks is run in its own thread, but independent chains are
+    //          still run in parallel...
+
+    QThreadPool threadPool;
+
+    if (runtime->needNlaSolver()) {
+        threadPool.setMaxThreadCount(1);
+    } else if (pThreadsCount > 0) {
+        threadPool.setMaxThreadCount(pThreadsCount);
+    } else {
+        threadPool.setMaxThreadCount(QThread::idealThreadCount());
+    }
+
+    mStopped.storeRelease(0);
+
+    QList<SimulationSweepEnsemble *> ensembles;
+    QList<SimulationSweepChain *> chains;
+
+    if (useEnsembles) {
+        int tasksCount = mTasks.count();
+        int ensemblesCount = qMin(threadPool.maxThreadCount(), tasksCount);
+
+        for (int i = 0; i < ensemblesCount; ++i) {
+            int from = i*tasksCount/ensemblesCount;
+            int to = (i+1)*tasksCount/ensemblesCount;
+
+            ensembles << new SimulationSweepEnsemble(mSimulation,
+                                                     mTasks.mid(from, to-from),
+                                                     &mStopped);
+
+            threadPool.start(ensembles.last());
+        }
+    } else if (!nextTasks.isEmpty()) {
+        for (auto task : qAsConst(mTasks)) {
+            if (task->mPreviousTask == nullptr) {
+                QList<SimulationSweepTask *> chainTasks;
+
+                for (auto chainTask = task; chainTask != nullptr;
+                     chainTask = nextTasks.value(chainTask)) {
+                    chainTasks << chainTask;
+                }
+
+                chains << new SimulationSweepChain(chainTasks, &mStopped);
+
+                threadPool.start(chains.last());
+            }
+        }
+    } else {
+        for (auto task : qAsConst(mTasks)) {
+            threadPool.start(task);
+        }
+    }
+
+    threadPool.waitForDone();
+
+    for (auto ensemble : qAsConst(ensembles)) {
+        delete ensemble;
+    }
+
+    for (auto chain : qAsConst(chains)) {
+        delete chain;
+    }
+
+    // Check whether all our tasks completed successfully
+    // Note: if we were stopped, then the tasks that didn't complete have an
+    //       error message that says so...
+
+    for (auto task : qAsConst(mTasks)) {
+        if (!task->errorMessage().isEmpty()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//==============================================================================
+
+void SimulationSweep::stop()
+{
+    // Ask our tasks to stop
+
+    mStopped.storeRelease(1);
+}
+
+//==============================================================================
+
+void SimulationSweep::reset()
+{
+    // Delete all our tasks
+
+    for (auto task : qAsConst(mTasks)) {
+        delete task;
+    }
+
+    mTasks.clear();
+}
+
+//==============================================================================
+
+int SimulationSweep::tasksCount() const
+{
+    // Return our number of tasks
+
+    return mTasks.count();
+}
+
+//==============================================================================
+
+DataStore::DataStore * SimulationSweep::dataStore(int pTask) const
+{
+    // Return the data store of the given task
+
+    return ((pTask >= 0) && (pTask < mTasks.count()))?
+                mTasks[pTask]->dataStore():
+                nullptr;
+}
+
+//==============================================================================
+
+QString SimulationSweep::errorMessage(int pTask) const
+{
+    // Return the error message of the given task
+
+    return ((pTask >= 0) && (pTask < mTasks.count()))?
+                mTasks[pTask]->errorMessage():
+                QString();
+}
+
+//==============================================================================
+
+qint64 SimulationSweep::elapsedTime(int pTask) const
+{
+    // Return the elapsed time of the given task
+
+    return ((pTask >= 0) && (pTask < mTasks.count()))?
+                mTasks[pTask]->elapsedTime():
+                -1;
+}
+
+//==============================================================================
+
+} // namespace SimulationSupport
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -0,0 +1,243 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// Simulation sweep
+//==============================================================================
+
+#pragma once
+
+//==============================================================================
+
+#include "simulation.h"
+
+//==============================================================================
+
+#include <QAtomicInteger>
+#include <QMap>
+#include <QRunnable>
+
+//==============================================================================
+
+namespace libsbml {
+    class ASTNode;
+} // namespace libsbml
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace SimulationSupport {
+
+//==============================================================================
+
+class SIMULATIONSUPPORT_EXPORT SimulationSweepChange
+{
+public:
+    enum class Type {
+        Symbol,
+        Parameter
+    };
+
+    explicit SimulationSweepChange(Type pType, const QString &pTarget,
+                                   const libsbml::ASTNode *pMath,
+                                   const QMap<QString, double> &pSymbols,
+                                   const QMap<QString, QString> &pVariables);
+
+    Type type() const;
+    QString target() const;
+
+    const libsbml::ASTNode * math() const;
+
+    QMap<QString, double> symbols() const;
+    QMap<QString, QString> variables() const;
+
+private:
+    Type mType;
+    QString mTarget;
+
+    const libsbml::ASTNode *mMath;
+
+    QMap<QString, double> mSymbols;
+    QMap<QString, QString> mVariables;
+};
+
+//==============================================================================
+
+using SimulationSweepChanges = QList<SimulationSweepChange>;
+
+//==============================================================================
+
+class SimulationSweepTask : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+    friend class SimulationSweep;
+    friend class SimulationSweepChain;
+    friend class SimulationSweepEnsemble;
+
+public:
+    explicit SimulationSweepTask(Simulation *pSimulation,
+                                 const QMap<int, double> &pConstantsValues,
+                                 const QMap<int, double> &pStatesValues,
+                                 const SimulationSweepChanges &pChanges,
+                                 const QMap<QString, int> &pConstantsIndexes,
+                                 const QMap<QString, int> &pStatesIndexes,
+                                 const QAtomicInt *pStopped,
+                                 SimulationSweepTask *pPreviousTask = nullptr);
+    ~SimulationSweepTask() override;
+
+    bool initialize();
+
+    void run() override;
+
+    DataStore::DataStore * dataStore() const;
+
+    QString errorMessage() const;
+
+    qint64 elapsedTime() const;
+
+private:
+    Simulation *mSimulation;
+
+    CellMLSupport::CellmlFileRuntime *mRuntime;
+
+    QMap<int, double> mConstantsValues;
+    QMap<int, double> mStatesValues;
+
+    SimulationSweepChanges mChanges;
+    QMap<QString, int> mConstantsIndexes;
+    QMap<QString, int> mStatesIndexes;
+
+    const QAtomicInt *mStopped;
+
+    SimulationSweepTask *mPreviousTask;
+
+    double *mConstants = nullptr;
+    double *mRates = nullptr;
+    double *mStates = nullptr;
+    double *mAlgebraic = nullptr;
+
+    DataStore::DataStore *mDataStore = nullptr;
+
+    QString mErrorMessage;
+
+    qint64 mElapsedTime = -1;
+
+    void deleteArrays();
+
+    Solver::NlaSolver * createNlaSolver();
+
+    bool initializeValues(const double *pConstants, const double *pStates);
+
+    bool addPoint(double pPoint);
+
+public slots:
+    void setErrorMessage(const QString &pErrorMessage);
+};
+
+//==============================================================================
+
+class SimulationSweepChain : public QRunnable
+{
+public:
+    explicit SimulationSweepChain(const QList<SimulationSweepTask *> &pTasks,
+                                  const QAtomicInt *pStopped);
+
+    void run() override;
+
+private:
+    QList<SimulationSweepTask *> mTasks;
+
+    const QAtomicInt *mStopped;
+};
+
+//==============================================================================
+
+class SimulationSweepEnsemble : public QObject, public QRunnable
+{
+    Q_OBJECT
+
+public:
+    explicit SimulationSweepEnsemble(Simulation *pSimulation,
+                                     const QList<SimulationSweepTask *> &pTasks,
+                                     const QAtomicInt *pStopped);
+
+    void run() override;
+
+private:
+    Simulation *mSimulation;
+
+    CellMLSupport::CellmlFileRuntime *mRuntime;
+
+    QList<SimulationSweepTask *> mTasks;
+
+    const QAtomicInt *mStopped;
+
+    QString mErrorMessage;
+
+public slots:
+    void setErrorMessage(const QString &pErrorMessage);
+};
+
+//==============================================================================
+
+class SIMULATIONSUPPORT_EXPORT SimulationSweep : public SimulationObject
+{
+    Q_OBJECT
+
+public:
+    explicit SimulationSweep(Simulation *pSimulation);
+    ~SimulationSweep() override;
+
+    Simulation * simulation() const;
+
+    int addTask(const QMap<QString, double> &pParametersValues,
+                QString &pErrorMessage, int pPreviousTask = -1);
+    int addTask(const QMap<QString, double> &pParametersValues,
+                const SimulationSweepChanges &pChanges,
+                QString &pErrorMessage, int pPreviousTask = -1);
+
+    bool run(int pThreadsCount = 0);
+
+private:
+    QList<SimulationSweepTask *> mTasks;
+
+    QAtomicInt mStopped;
+
+public slots:
+    void stop();
+
+    void reset();
+
+    int tasksCount() const;
+
+    OpenCOR::DataStore::DataStore * dataStore(int pTask) const;
+
+    QString errorMessage(int pTask) const;
+    qint64 elapsedTime(int pTask) const;
+};
+
+//==============================================================================
+
+} // namespace SimulationSupport
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
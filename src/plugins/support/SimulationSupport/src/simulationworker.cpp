@@ -47,6 +47,20 @@ SimulationWorker::SimulationWorker(Simulation *pSimulation, QThread *pThread,
     mRuntime(pSimulation->runtime()),
     mSelf(pSelf)
 {
+    // Note: we normally live in the given thread, but if no thread is given,
+    //       then we are to be run synchronously, i.e. in the calling thread
+    //       (e.g. when running a simulation from a Python script or the
+    //       command line)...
+}
+
+//==============================================================================
+
+bool SimulationWorker::isActive() const
+{
+    // Return whether we are active, i.e. whether our thread is running or, if
+    // we don't have a thread, whether we are being run synchronously
+
+    return (mThread != nullptr)?mThread->isRunning():mActive;
 }
 
 //==============================================================================
@@ -55,7 +69,7 @@ bool SimulationWorker::isRunning() const
 {
     // Return whether our thread is running
 
-    return mThread->isRunning() && !mPaused;
+    return isActive() && !mPaused;
 }
 
 //==============================================================================
@@ -64,7 +78,7 @@ bool SimulationWorker::isPaused() const
 {
     // Return whether our thread is paused
 
-    return mThread->isRunning() && mPaused;
+    return isActive() && mPaused;
 }
 
 //==============================================================================
@@ -73,7 +87,7 @@ double SimulationWorker::currentPoint() const
 {
     // Return our current point
 
-    return mThread->isRunning()?
+    return isActive()?
                mCurrentPoint:
                mSimulation->data()->startingPoint();
 }
@@ -84,6 +98,8 @@ void SimulationWorker::run()
 {
     // Let people know that we are running
 
+    mActive = true;
+
     emit running(false);
 
     // Set up our ODE solver
@@ -119,12 +135,25 @@ void SimulationWorker::run()
     double endingPoint = mSimulation->data()->endingPoint();
     double pointInterval = mSimulation->data()->pointInterval();
     quint64 pointCounter = 0;
+    SimulationData::Type type = mSimulation->data()->type();
+    bool steadyState = type == SimulationData::Type::SteadyState;
+    bool steadyStateReached = false;
+
+    // Determine whether we can record our points at our ODE solver's own steps
+    // Note: this only makes sense for a uniform time course...
+
+    bool adaptiveOutput =    mSimulation->data()->adaptiveOutput()
+                          && (type == SimulationData::Type::UniformTimeCourse)
+                          && odeSolver->supportsOneStep();
 
     mCurrentPoint = startingPoint;
 
     // Initialise our ODE solver
 
     odeSolver->setProperties(mSimulation->data()->odeSolverProperties());
+    odeSolver->setJacobian(mRuntime->computeJacobian(),
+                           mRuntime->jacobianColumnPointers(),
+                           mRuntime->jacobianRowIndices());
 
     odeSolver->initialize(mCurrentPoint, mRuntime->statesCount(),
                           mSimulation->data()->constants(),
@@ -152,36 +181,84 @@ void SimulationWorker::run()
 
         timer.start();
 
-        // Add our first point
+        // Add our first point, but only if we are to record our transients
+
+        if (type == SimulationData::Type::UniformTimeCourse) {
+            mSimulation->results()->addPoint(mCurrentPoint);
+        }
+
+        // Try to solve for our steady state directly, if we have been given a
+        // solver to do so, falling back to integrating our model until it
+        // settles otherwise
+
+        // Note: we keep track of our states, so that we can both restore them
+        //       should our steady-state solver fail and, when integrating, know
+        //       what they were at the end of the previous beat...
+
+        SimulationData *data = mSimulation->data();
+        int statesCount = mRuntime->statesCount();
+        double *previousStates = steadyState?
+                                     new double[size_t(statesCount)]:
+                                     nullptr;
+
+        if (previousStates != nullptr) {
+            memcpy(previousStates, data->states(),
+                   size_t(statesCount)*Solver::SizeOfDouble);
+        }
+
+        if (steadyState && !data->steadyStateSolverName().isEmpty()) {
+            steadyStateReached = data->solveSteadyState(mCurrentPoint,
+                                                        data->constants(),
+                                                        data->rates(),
+                                                        data->states(),
+                                                        data->algebraic()).isEmpty();
 
-        mSimulation->results()->addPoint(mCurrentPoint);
+            if (!steadyStateReached) {
+                memcpy(data->states(), previousStates,
+                       size_t(statesCount)*Solver::SizeOfDouble);
+
+                mReset = true;
+            }
+        }
 
         // Our main work loop
-        // Note: for performance reasons, it is essential that the following
-        //       loop doesn't emit any signal, be it directly or indirectly,
-        //       unless it is to let people know that we are pausing or running.
-        //       Indeed, the signal/slot mechanism adds a certain level of
-        //       overhead and, here, we want things to be as fast as possible...
+        // Note #1: for performance reasons, it is essential that the following
+        //          loop doesn't emit any signal, be it directly or indirectly,
+        //          unless it is to let people know that we are pausing or
+        //          running. Indeed, the signal/slot mechanism adds a certain
+        //          level of overhead and, here, we want things to be as fast
+        //          as possible...
+        // Note #2: when looking for a steady state, our point interval is the
+        //          beat period over which our states must settle...
 
         QMutex pausedMutex;
 
-        forever {
-            // Reinitialise our solver, if we have an NLA solver or if the model
-            // got reset
-            // Note: indeed, with a solver such as CVODE, we need to update our
-            //       internals...
-
-            if ((nlaSolver != nullptr) || mReset) {
+        while (!steadyStateReached) {
+            // Reinitialise our solver, if the model got reset
+            // Note #1: indeed, with a solver such as CVODE, we need to update
+            //          our internals...
+            // Note #2: we used to also do this after each point when our model
+            //          needed an NLA solver, but its solution is a smooth
+            //          function of our states, so CVODE's history remains valid
+            //          and restarting it only forced it back to small first-
+            //          order steps...
+
+            if (mReset) {
                 odeSolver->reinitialize(mCurrentPoint);
 
                 mReset = false;
             }
 
-            // Determine our next point and compute our model up to it
+            // Determine our next point and compute our model up to it or, if
+            // we have an adaptive output, let our ODE solver take one step
 
-            odeSolver->solve(mCurrentPoint,
-                             qMin(endingPoint,
-                                  startingPoint+double(++pointCounter)*pointInterval));
+            if (adaptiveOutput) {
+                odeSolver->solveOneStep(mCurrentPoint, endingPoint);
+            } else {
+                odeSolver->solve(mCurrentPoint,
+                                 qMin(endingPoint,
+                                      startingPoint+double(++pointCounter)*pointInterval));
+            }
 
             // Make sure that no error occurred
 
@@ -189,13 +266,33 @@ void SimulationWorker::run()
                 break;
             }
 
-            // Add our new point
-
-            mSimulation->results()->addPoint(mCurrentPoint);
+            // Add our new point or check whether we have reached a steady
+            // state
+            // Note: with an adaptive output, we record each of our ODE
+            //       solver's steps, so we may end up with more points than
+            //       our point interval would suggest, in which case our
+            //       results grow to accommodate them...
+
+            if (adaptiveOutput) {
+                if (!mSimulation->results()->addPoint(mCurrentPoint)) {
+                    emitError(tr("the memory required for the simulation could not be allocated"));
+
+                    break;
+                }
+            } else if (type == SimulationData::Type::UniformTimeCourse) {
+                mSimulation->results()->addPoint(mCurrentPoint);
+            } else if (steadyState) {
+                steadyStateReached = data->steadyStateReached(previousStates,
+                                                              data->states());
+
+                memcpy(previousStates, data->states(),
+                       size_t(statesCount)*Solver::SizeOfDouble);
+            }
 
             // Some post-processing, if needed
 
-            if (qFuzzyCompare(mCurrentPoint, endingPoint) || mStopped) {
+            if (   steadyStateReached
+                || qFuzzyCompare(mCurrentPoint, endingPoint) || mStopped) {
                 // We have reached our ending point or we have been asked to
                 // stop, so leave our main work loop
 
@@ -239,6 +336,20 @@ void SimulationWorker::run()
             }
         }
 
+        delete[] previousStates;
+
+        // Add our final point, if we only record that one, unless we have been
+        // stopped or we failed to reach a steady state
+
+        if (   !mError && !mStopped
+            && (type != SimulationData::Type::UniformTimeCourse)) {
+            if (steadyState && !steadyStateReached) {
+                emitError(tr("the steady state could not be reached before the ending point"));
+            } else {
+                mSimulation->results()->addPoint(mCurrentPoint);
+            }
+        }
+
         // Retrieve the total elapsed time, should no error have occurred
 
         if (!mError) {
@@ -261,13 +372,19 @@ void SimulationWorker::run()
 
     mSelf = nullptr;
 
-    // Let people know that we are done and give them the elapsed time
-    // Note: we do this with a bit of a delay to give time to the GUI to update
-    //       itself. This is useful when running several simulations from a
-    //       Python script using the Python Console window...
+    mActive = false;
 
-    QTimer::singleShot(169, this, std::bind(&SimulationWorker::emitDone,
-                                            this, mError?-1:elapsedTime));
+    // Let people know that we are done and give them the elapsed time
+    // Note: when we have a thread, we do this with a bit of a delay to give
+    //       time to the GUI to update itself. When we are run synchronously,
+    //       there is no GUI to wait for, so we let people know straightaway...
+
+    if (mThread != nullptr) {
+        QTimer::singleShot(169, this, std::bind(&SimulationWorker::emitDone,
+                                                this, mError?-1:elapsedTime));
+    } else {
+        emitDone(mError?-1:elapsedTime);
+    }
 }
 
 //==============================================================================
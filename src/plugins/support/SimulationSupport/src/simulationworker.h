@@ -76,6 +76,7 @@ private:
 
     double mCurrentPoint = 0.0;
 
+    bool mActive = false;
     bool mPaused = false;
     bool mStopped = false;
 
@@ -87,6 +88,8 @@ private:
 
     SimulationWorker *&mSelf;
 
+    bool isActive() const;
+
 signals:
     void running(bool pIsResuming);
     void paused();
@@ -51,11 +51,21 @@
 #include <zlib.h>
 
 //---OPENCOR--- BEGIN
+#include <QBuffer>
 #include <QRegularExpression>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include <limits>
 //---OPENCOR--- END
 // Zip standard version for archives handled by this API
 // (actually, the only basic support of this version is implemented but it is enough for now)
 #define ZIP_VERSION 20
+//---OPENCOR--- BEGIN
+// Zip standard version needed for entries that rely on the ZIP64 extensions
+#define ZIP64_VERSION 45
+//---OPENCOR--- END
 
 #if 0
 #define ZDEBUG qDebug
@@ -145,6 +155,10 @@ static void writeMSDosDate(uchar *dest, const QDateTime& dt)
     }
 }
 
+//---OPENCOR--- BEGIN
+// Note: entries are now inflated and deflated in chunks, see below...
+#if 0
+//---OPENCOR--- END
 static int inflate(Bytef *dest, ulong *destLen, const Bytef *source, ulong sourceLen)
 {
     z_stream stream;
@@ -208,6 +222,100 @@ static int deflate (Bytef *dest, ulong *destLen, const Bytef *source, ulong sour
     err = deflateEnd(&stream);
     return err;
 }
+//---OPENCOR--- BEGIN
+#endif
+//---OPENCOR--- END
+
+//---OPENCOR--- BEGIN
+static inline quint64 readUInt64(const uchar *data)
+{
+    return quint64(readUInt(data)) | (quint64(readUInt(data + 4)) << 32);
+}
+
+static inline void writeUInt64(uchar *data, quint64 i)
+{
+    writeUInt(data, uint(i & 0xffffffff));
+    writeUInt(data + 4, uint(i >> 32));
+}
+
+// Size of the chunks in which the contents of an entry is streamed in and out
+// of an archive
+// Note: when compressing an entry, each of its chunks is deflated on its own
+//       (and in parallel with other chunks) and, except for the last one, ends
+//       with a sync flush, i.e. an empty stored block that leaves the output
+//       byte aligned. This means that the resulting raw deflate streams can
+//       simply be concatenated (as is done by pigz), at the cost of a slightly
+//       worse compression ratio since a chunk cannot refer back to data from
+//       the previous chunk...
+static const int ChunkSize = 1 << 20;
+
+// Value stored in a 32-bit field that has been moved to a ZIP64 extra field
+static const quint64 Zip64Limit = 0xffffffff;
+
+// Default size from which an entry is written using the ZIP64 extensions
+// Note: the compressed size of an entry is only known once it has been
+//       written and it could, in the worst case, end up being slightly bigger
+//       than its uncompressed size, hence we leave ourselves some room...
+static const qint64 DefaultZip64EntryThreshold = Q_INT64_C(0xf0000000);
+
+class QZipDeflateChunk : public QRunnable
+{
+public:
+    QZipDeflateChunk(const QByteArray &input, bool last)
+        : input(input), inputSize(input.size()), last(last), crc_32(0), result(Z_OK)
+    {
+        setAutoDelete(false);
+    }
+
+    void run() override
+    {
+        crc_32 = ::crc32(::crc32(0, 0, 0), (const uchar *)input.constData(), uInt(inputSize));
+
+        z_stream stream;
+        memset(&stream, 0, sizeof(z_stream));
+
+        result = deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+        if (result != Z_OK)
+            return;
+
+        // a sync flush needs a few more bytes than what deflateBound() allows
+        // for, hence we add some headroom and grow our output if needed
+        const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+        output.resize(int(deflateBound(&stream, uLong(inputSize))) + 16);
+        stream.next_in = (Bytef *)input.constData();
+        stream.avail_in = uInt(inputSize);
+        stream.next_out = (Bytef *)output.data();
+        stream.avail_out = uInt(output.size());
+        forever {
+            result = ::deflate(&stream, flush);
+            if (last ? (result == Z_STREAM_END) : ((result == Z_OK) && (stream.avail_out != 0))) {
+                result = Z_OK;
+                break;
+            }
+            if (result != Z_OK)
+                break;
+            if (stream.avail_out == 0) {
+                const int used = int(stream.total_out);
+                output.resize(2 * output.size());
+                stream.next_out = (Bytef *)output.data() + used;
+                stream.avail_out = uInt(output.size() - used);
+            }
+        }
+        output.resize(int(stream.total_out));
+        deflateEnd(&stream);
+
+        // we don't need our input anymore
+        input = QByteArray();
+    }
+
+    QByteArray input;
+    int inputSize;
+    bool last;
+    QByteArray output;
+    uLong crc_32;
+    int result;
+};
+//---OPENCOR--- END
 
 
 namespace WindowsFileAttributes {
@@ -479,6 +587,30 @@ struct EndOfDirectory
     uchar dir_start_offset[4];
     uchar comment_length[2];
 };
+//---OPENCOR--- BEGIN
+
+struct Zip64EndOfDirectory
+{
+    uchar signature[4]; // 0x06064b50
+    uchar record_size[8];
+    uchar version_made[2];
+    uchar version_needed[2];
+    uchar this_disk[4];
+    uchar start_of_directory_disk[4];
+    uchar num_dir_entries_this_disk[8];
+    uchar num_dir_entries[8];
+    uchar directory_size[8];
+    uchar dir_start_offset[8];
+};
+
+struct Zip64EndOfDirectoryLocator
+{
+    uchar signature[4]; // 0x07064b50
+    uchar start_of_directory_disk[4];
+    uchar eod_offset[8];
+    uchar num_disks[4];
+};
+//---OPENCOR--- END
 /*---OPENCOR---
 Q_DECLARE_TYPEINFO(EndOfDirectory, Q_PRIMITIVE_TYPE);
 */
@@ -506,6 +638,45 @@ Q_DECLARE_TYPEINFO(FileHeader, Q_MOVABLE_TYPE);
 Q_DECLARE_TYPEINFO(OpenCOR::ZIPSupport::FileHeader, Q_MOVABLE_TYPE);
 namespace OpenCOR {
 namespace ZIPSupport {
+
+static void readSizes(const FileHeader &header, quint64 &uncompressed_size,
+                      quint64 &compressed_size, quint64 &offset_local_header)
+{
+    // the sizes and offset of an entry are normally in its central header, but
+    // those that don't fit in 32 bits are saturated and then found, in that
+    // order, in a ZIP64 extra field
+    uncompressed_size = readUInt(header.h.uncompressed_size);
+    compressed_size = readUInt(header.h.compressed_size);
+    offset_local_header = readUInt(header.h.offset_local_header);
+
+    const uchar *data = (const uchar *)header.extra_field.constData();
+    int remaining = header.extra_field.size();
+    while (remaining >= 4) {
+        const ushort id = readUShort(data);
+        int size = readUShort(data + 2);
+        data += 4;
+        remaining -= 4;
+        if (size > remaining)
+            break;
+        if (id == 0x0001) {
+            if ((uncompressed_size == Zip64Limit) && (size >= 8)) {
+                uncompressed_size = readUInt64(data);
+                data += 8;
+                size -= 8;
+            }
+            if ((compressed_size == Zip64Limit) && (size >= 8)) {
+                compressed_size = readUInt64(data);
+                data += 8;
+                size -= 8;
+            }
+            if ((offset_local_header == Zip64Limit) && (size >= 8))
+                offset_local_header = readUInt64(data);
+            break;
+        }
+        data += size;
+        remaining -= size;
+    }
+}
 //---OPENCOR--- END
 
 class QZipPrivate
@@ -529,7 +700,12 @@ public:
     bool dirtyFileTree;
     QVector<FileHeader> fileHeaders;
     QByteArray comment;
+/*---OPENCOR---
     uint start_of_directory;
+*/
+//---OPENCOR--- BEGIN
+    quint64 start_of_directory;
+//---OPENCOR--- END
 };
 
 QZipReader::FileInfo QZipPrivate::fillFileInfo(int index) const
@@ -586,7 +762,14 @@ QZipReader::FileInfo QZipPrivate::fillFileInfo(int index) const
     const bool inUtf8 = (general_purpose_bits & Utf8Names) != 0;
     fileInfo.filePath = inUtf8 ? QString::fromUtf8(header.file_name) : QString::fromLocal8Bit(header.file_name);
     fileInfo.crc = readUInt(header.h.crc_32);
+/*---OPENCOR---
     fileInfo.size = readUInt(header.h.uncompressed_size);
+*/
+//---OPENCOR--- BEGIN
+    quint64 uncompressed_size, compressed_size, offset_local_header;
+    readSizes(header, uncompressed_size, compressed_size, offset_local_header);
+    fileInfo.size = qint64(uncompressed_size);
+//---OPENCOR--- END
     fileInfo.lastModified = readMSDosDate(header.h.last_mod_file);
 
     // fix the file path, if broken (convert separators, eat leading and trailing ones)
@@ -610,6 +793,10 @@ public:
     }
 
     void scanFiles();
+//---OPENCOR--- BEGIN
+    int indexOf(const QString &fileName) const;
+    bool extractEntry(int index, QIODevice *destination) const;
+//---OPENCOR--- END
 
     QZipReader::Status status;
 };
@@ -622,16 +809,27 @@ public:
         status(QZipWriter::NoError),
         permissions(QFile::ReadOwner | QFile::WriteOwner),
         compressionPolicy(QZipWriter::AlwaysCompress)
+//---OPENCOR--- BEGIN
+        , zip64EntryThreshold(DefaultZip64EntryThreshold)
+//---OPENCOR--- END
     {
     }
 
     QZipWriter::Status status;
     QFile::Permissions permissions;
     QZipWriter::CompressionPolicy compressionPolicy;
+//---OPENCOR--- BEGIN
+    qint64 zip64EntryThreshold;
+//---OPENCOR--- END
 
     enum EntryType { Directory, File, Symlink };
 
     void addEntry(EntryType type, const QString &fileName, const QByteArray &contents);
+//---OPENCOR--- BEGIN
+    void addEntry(EntryType type, const QString &fileName, QIODevice *source, qint64 size);
+    bool writeData(QIODevice *source, qint64 size, bool compress, uint &crc_32,
+                   quint64 &uncompressed_size, quint64 &compressed_size);
+//---OPENCOR--- END
 };
 
 static LocalFileHeader toLocalHeader(const CentralFileHeader &ch)
@@ -677,11 +875,22 @@ void QZipReaderPrivate::scanFiles()
 
     // find EndOfDirectory header
     int i = 0;
+/*---OPENCOR---
     int start_of_directory = -1;
     int num_dir_entries = 0;
+*/
+//---OPENCOR--- BEGIN
+    qint64 start_of_directory = -1;
+    qint64 num_dir_entries = 0;
+//---OPENCOR--- END
     EndOfDirectory eod;
     while (start_of_directory == -1) {
+/*---OPENCOR---
         const int pos = device->size() - int(sizeof(EndOfDirectory)) - i;
+*/
+//---OPENCOR--- BEGIN
+        const qint64 pos = device->size() - qint64(sizeof(EndOfDirectory)) - i;
+//---OPENCOR--- END
         if (pos < 0 || i > 65535) {
 /*---OPENCOR---
             qWarning("QZip: EndOfDirectory not found");
@@ -699,7 +908,36 @@ void QZipReaderPrivate::scanFiles()
     // have the eod
     start_of_directory = readUInt(eod.dir_start_offset);
     num_dir_entries = readUShort(eod.num_dir_entries);
+//---OPENCOR--- BEGIN
+    // a saturated field means that the archive uses the ZIP64 extensions, in
+    // which case the location of the central directory and its number of
+    // entries are to be found in the ZIP64 end of directory record, itself
+    // located through the record that precedes the end of directory
+    const qint64 eod_pos = device->size() - qint64(sizeof(EndOfDirectory)) - i;
+    if (   ((num_dir_entries == 0xffff) || (readUInt(eod.directory_size) == Zip64Limit)
+            || (quint64(start_of_directory) == Zip64Limit))
+        && (eod_pos >= qint64(sizeof(Zip64EndOfDirectoryLocator)))) {
+        Zip64EndOfDirectoryLocator locator;
+        device->seek(eod_pos - qint64(sizeof(Zip64EndOfDirectoryLocator)));
+        if (   (device->read((char *)&locator, sizeof(Zip64EndOfDirectoryLocator)) == qint64(sizeof(Zip64EndOfDirectoryLocator)))
+            && (readUInt(locator.signature) == 0x07064b50)) {
+            Zip64EndOfDirectory eod64;
+            device->seek(qint64(readUInt64(locator.eod_offset)));
+            if (   (device->read((char *)&eod64, sizeof(Zip64EndOfDirectory)) == qint64(sizeof(Zip64EndOfDirectory)))
+                && (readUInt(eod64.signature) == 0x06064b50)) {
+                start_of_directory = qint64(readUInt64(eod64.dir_start_offset));
+                num_dir_entries = qint64(readUInt64(eod64.num_dir_entries));
+            }
+        }
+    }
+    device->seek(eod_pos + qint64(sizeof(EndOfDirectory)));
+//---OPENCOR--- END
+/*---OPENCOR---
     ZDEBUG("start_of_directory at %d, num_dir_entries=%d", start_of_directory, num_dir_entries);
+*/
+//---OPENCOR--- BEGIN
+    ZDEBUG("start_of_directory at %lld, num_dir_entries=%lld", start_of_directory, num_dir_entries);
+//---OPENCOR--- END
     int comment_length = readUShort(eod.comment_length);
 /*---OPENCOR---
     if (comment_length != i)
@@ -754,6 +992,108 @@ void QZipReaderPrivate::scanFiles()
         fileHeaders.append(header);
     }
 }
+//---OPENCOR--- BEGIN
+
+int QZipReaderPrivate::indexOf(const QString &fileName) const
+{
+    // look for the entry by its raw name and, failing that, by the (cleaned
+    // up) path that fileInfoList() reports for it
+    for (int i = 0; i < fileHeaders.size(); ++i) {
+        if (QString::fromLocal8Bit(fileHeaders.at(i).file_name) == fileName)
+            return i;
+    }
+    for (int i = 0; i < fileHeaders.size(); ++i) {
+        if (fillFileInfo(i).filePath == fileName)
+            return i;
+    }
+    return -1;
+}
+
+bool QZipReaderPrivate::extractEntry(int index, QIODevice *destination) const
+{
+    const FileHeader &header = fileHeaders.at(index);
+
+    ushort version_needed = readUShort(header.h.version_needed);
+    if (version_needed > ZIP64_VERSION)
+        return false;
+
+    ushort general_purpose_bits = readUShort(header.h.general_purpose_bits);
+    if ((general_purpose_bits & Encrypted) != 0)
+        return false;
+
+    quint64 uncompressed_size, compressed_size, offset_local_header;
+    readSizes(header, uncompressed_size, compressed_size, offset_local_header);
+
+    device->seek(qint64(offset_local_header));
+    LocalFileHeader lh;
+    if (   (device->read((char *)&lh, sizeof(LocalFileHeader)) != qint64(sizeof(LocalFileHeader)))
+        || (readUInt(lh.signature) != 0x04034b50))
+        return false;
+    uint skip = readUShort(lh.file_name_length) + readUShort(lh.extra_field_length);
+    device->seek(device->pos() + skip);
+
+    // stream our data in and out, one chunk at a time, so that the amount of
+    // memory we use doesn't depend on the size of the entry
+    int compression_method = readUShort(lh.compression_method);
+    uint crc_32 = ::crc32(0, 0, 0);
+    quint64 remaining = compressed_size;
+    if (compression_method == CompressionMethodStored) {
+        remaining = qMin(compressed_size, uncompressed_size);
+        while (remaining != 0) {
+            const QByteArray chunk = device->read(qint64(qMin<quint64>(ChunkSize, remaining)));
+            if (chunk.isEmpty())
+                return false;
+            crc_32 = ::crc32(crc_32, (const uchar *)chunk.constData(), uInt(chunk.size()));
+            if (destination->write(chunk) != chunk.size())
+                return false;
+            remaining -= chunk.size();
+        }
+    } else if (compression_method == CompressionMethodDeflated) {
+        z_stream stream;
+        memset(&stream, 0, sizeof(z_stream));
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK)
+            return false;
+
+        QByteArray input;
+        QByteArray output(ChunkSize, Qt::Uninitialized);
+        int res = Z_OK;
+        while (res != Z_STREAM_END) {
+            if ((stream.avail_in == 0) && (remaining != 0)) {
+                input = device->read(qint64(qMin<quint64>(ChunkSize, remaining)));
+                if (input.isEmpty()) {
+                    res = Z_DATA_ERROR;
+                    break;
+                }
+                remaining -= input.size();
+                stream.next_in = (Bytef *)input.data();
+                stream.avail_in = uInt(input.size());
+            }
+            stream.next_out = (Bytef *)output.data();
+            stream.avail_out = uInt(output.size());
+
+            // note: Z_BUF_ERROR means that no progress could be made, i.e.
+            //       that our compressed data is truncated
+            res = ::inflate(&stream, Z_NO_FLUSH);
+            if ((res != Z_OK) && (res != Z_STREAM_END))
+                break;
+
+            const int produced = output.size() - int(stream.avail_out);
+            crc_32 = ::crc32(crc_32, (const uchar *)output.constData(), uInt(produced));
+            if (destination->write(output.constData(), produced) != produced) {
+                res = Z_ERRNO;
+                break;
+            }
+        }
+        inflateEnd(&stream);
+        if (res != Z_STREAM_END)
+            return false;
+    } else {
+        return false;
+    }
+
+    return crc_32 == readUInt(header.h.crc_32);
+}
+//---OPENCOR--- END
 
 void QZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const QByteArray &contents/*, QFile::Permissions permissions, QZip::Method m*/)
 {
@@ -764,6 +1104,17 @@ void QZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
         "symlink  " };
     ZDEBUG() << "adding" << entryTypes[type] <<":" << fileName.toUtf8().data() << (type == 2 ? QByteArray(" -> " + contents).constData() : "");
 #endif
+//---OPENCOR--- BEGIN
+
+    QBuffer buffer;
+    buffer.setData(contents);
+    buffer.open(QIODevice::ReadOnly);
+    addEntry(type, fileName, &buffer, contents.length());
+}
+
+void QZipWriterPrivate::addEntry(EntryType type, const QString &fileName, QIODevice *source, qint64 size)
+{
+//---OPENCOR--- END
 
     if (! (device->isOpen() || device->open(QIODevice::WriteOnly))) {
         status = QZipWriter::FileOpenError;
@@ -774,7 +1125,12 @@ void QZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
     // don't compress small files
     QZipWriter::CompressionPolicy compression = compressionPolicy;
     if (compressionPolicy == QZipWriter::AutoCompress) {
+/*---OPENCOR---
         if (contents.length() < 64)
+*/
+//---OPENCOR--- BEGIN
+        if (size < 64)
+//---OPENCOR--- END
             compression = QZipWriter::NeverCompress;
         else
             compression = QZipWriter::AlwaysCompress;
@@ -784,12 +1140,27 @@ void QZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
     memset(&header.h, 0, sizeof(CentralFileHeader));
     writeUInt(header.h.signature, 0x02014b50);
 
+/*---OPENCOR---
     writeUShort(header.h.version_needed, ZIP_VERSION);
     writeUInt(header.h.uncompressed_size, contents.length());
+*/
+//---OPENCOR--- BEGIN
+    // large entries and entries that start beyond 4 GB need the ZIP64
+    // extensions, the sizes and CRC-32 of an entry only being known once its
+    // contents has been streamed out
+    const bool zip64 = (size >= zip64EntryThreshold) || (start_of_directory >= Zip64Limit);
+    writeUShort(header.h.version_needed, zip64 ? ZIP64_VERSION : ZIP_VERSION);
+//---OPENCOR--- END
     writeMSDosDate(header.h.last_mod_file, QDateTime::currentDateTime());
+/*---OPENCOR---
     QByteArray data = contents;
+*/
     if (compression == QZipWriter::AlwaysCompress) {
         writeUShort(header.h.compression_method, CompressionMethodDeflated);
+//---OPENCOR--- BEGIN
+    }
+#if 0
+//---OPENCOR--- END
 
        ulong len = contents.length();
         // shamelessly copied form zlib
@@ -820,6 +1191,9 @@ void QZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
     uint crc_32 = ::crc32(0, 0, 0);
     crc_32 = ::crc32(crc_32, (const uchar *)contents.constData(), contents.length());
     writeUInt(header.h.crc_32, crc_32);
+//---OPENCOR--- BEGIN
+#endif
+//---OPENCOR--- END
 
     // if bit 11 is set, the filename and comment fields must be encoded using UTF-8
     ushort general_purpose_bits = Utf8Names; // always use utf-8
@@ -861,6 +1235,7 @@ void QZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
         break;
     }
     writeUInt(header.h.external_file_attributes, mode << 16);
+/*---OPENCOR---
     writeUInt(header.h.offset_local_header, start_of_directory);
 
 
@@ -872,7 +1247,150 @@ void QZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
     device->write(data);
     start_of_directory = device->pos();
     dirtyFileTree = true;
+*/
+//---OPENCOR--- BEGIN
+
+    // write the local header, with a ZIP64 extra field for the sizes if
+    // needed, then stream the data out and patch the local header
+    LocalFileHeader h = toLocalHeader(header.h);
+    QByteArray local_extra_field;
+    if (zip64) {
+        local_extra_field = QByteArray(20, 0);
+        writeUShort((uchar *)local_extra_field.data(), 0x0001);
+        writeUShort((uchar *)local_extra_field.data() + 2, 16);
+        writeUShort(h.extra_field_length, local_extra_field.size());
+        writeUInt(h.compressed_size, Zip64Limit);
+        writeUInt(h.uncompressed_size, Zip64Limit);
+    }
+    const quint64 offset_local_header = start_of_directory;
+    device->write((const char *)&h, sizeof(LocalFileHeader));
+    device->write(header.file_name);
+    device->write(local_extra_field);
+
+    uint crc_32;
+    quint64 uncompressed_size, compressed_size;
+    if (   !writeData(source, size, compression == QZipWriter::AlwaysCompress,
+                      crc_32, uncompressed_size, compressed_size)
+        || (!zip64 && ((uncompressed_size >= Zip64Limit) || (compressed_size >= Zip64Limit)))) {
+        // leave start_of_directory untouched and go back to it, so that
+        // whatever we have written gets overwritten by the next entry or the
+        // central directory
+        device->seek(qint64(start_of_directory));
+        status = QZipWriter::FileWriteError;
+        return;
+    }
+    const qint64 end_of_data = device->pos();
+
+    writeUInt(h.crc_32, crc_32);
+    if (zip64) {
+        writeUInt64((uchar *)local_extra_field.data() + 4, uncompressed_size);
+        writeUInt64((uchar *)local_extra_field.data() + 12, compressed_size);
+    } else {
+        writeUInt(h.compressed_size, uint(compressed_size));
+        writeUInt(h.uncompressed_size, uint(uncompressed_size));
+    }
+    device->seek(qint64(offset_local_header));
+    device->write((const char *)&h, sizeof(LocalFileHeader));
+    device->write(header.file_name);
+    device->write(local_extra_field);
+    device->seek(end_of_data);
+
+    writeUInt(header.h.crc_32, crc_32);
+    if (zip64) {
+        writeUInt(header.h.compressed_size, Zip64Limit);
+        writeUInt(header.h.uncompressed_size, Zip64Limit);
+        writeUInt(header.h.offset_local_header, Zip64Limit);
+        header.extra_field = QByteArray(28, 0);
+        uchar *extra_field = (uchar *)header.extra_field.data();
+        writeUShort(extra_field, 0x0001);
+        writeUShort(extra_field + 2, 24);
+        writeUInt64(extra_field + 4, uncompressed_size);
+        writeUInt64(extra_field + 12, compressed_size);
+        writeUInt64(extra_field + 20, offset_local_header);
+        writeUShort(header.h.extra_field_length, header.extra_field.size());
+    } else {
+        writeUInt(header.h.compressed_size, uint(compressed_size));
+        writeUInt(header.h.uncompressed_size, uint(uncompressed_size));
+        writeUInt(header.h.offset_local_header, uint(offset_local_header));
+    }
+
+    fileHeaders.append(header);
+
+    start_of_directory = quint64(end_of_data);
+    dirtyFileTree = true;
+}
+
+bool QZipWriterPrivate::writeData(QIODevice *source, qint64 size, bool compress, uint &crc_32,
+                                  quint64 &uncompressed_size, quint64 &compressed_size)
+{
+    crc_32 = ::crc32(0, 0, 0);
+    uncompressed_size = 0;
+    compressed_size = 0;
+
+    if (!compress) {
+        while (qint64(uncompressed_size) < size) {
+            const QByteArray chunk = source->read(qMin<qint64>(ChunkSize, size - qint64(uncompressed_size)));
+            if (chunk.isEmpty())
+                return false;
+            crc_32 = ::crc32(crc_32, (const uchar *)chunk.constData(), uInt(chunk.size()));
+            if (device->write(chunk) != chunk.size())
+                return false;
+            uncompressed_size += chunk.size();
+        }
+        compressed_size = uncompressed_size;
+        return true;
+    }
+
+    // deflate our chunks in batches that keep all of our cores busy while
+    // bounding the amount of memory we use, and write them out in order
+    const int batch_size = 2 * qMax(1, QThread::idealThreadCount());
+    QThreadPool threadPool;
+    QVector<QZipDeflateChunk *> chunks;
+    bool done = false;
+    bool ok = true;
+    while (!done) {
+        while (!done && (chunks.size() < batch_size)) {
+            const qint64 chunk_size = qMin<qint64>(ChunkSize, size - qint64(uncompressed_size));
+            const QByteArray input = source->read(chunk_size);
+            if (input.size() != chunk_size) {
+                ok = false;
+                done = true;
+                break;
+            }
+            uncompressed_size += input.size();
+            done = qint64(uncompressed_size) == size;
+            chunks << new QZipDeflateChunk(input, done);
+        }
+
+        // no need for another thread if we have only one chunk, which is
+        // typically the case for small entries
+        if (chunks.size() == 1) {
+            chunks.first()->run();
+        } else {
+            for (QZipDeflateChunk *chunk : qAsConst(chunks))
+                threadPool.start(chunk);
+            threadPool.waitForDone();
+        }
+
+        for (QZipDeflateChunk *chunk : qAsConst(chunks)) {
+            if (ok && (chunk->result == Z_OK)) {
+                crc_32 = uint(::crc32_combine(crc_32, chunk->crc_32, z_off_t(chunk->inputSize)));
+                ok = device->write(chunk->output) == chunk->output.size();
+                compressed_size += chunk->output.size();
+            } else {
+                ok = false;
+            }
+            delete chunk;
+        }
+        chunks.clear();
+
+        if (!ok)
+            return false;
+    }
+
+    return true;
 }
+//---OPENCOR--- END
 
 //////////////////////////////  Reader
 
@@ -1050,6 +1568,9 @@ QZipReader::FileInfo QZipReader::entryInfoAt(int index) const
 */
 QByteArray QZipReader::fileData(const QString &fileName) const
 {
+//---OPENCOR--- BEGIN
+#if 0
+//---OPENCOR--- END
     d->scanFiles();
     int i;
     for (i = 0; i < d->fileHeaders.size(); ++i) {
@@ -1136,8 +1657,44 @@ QByteArray QZipReader::fileData(const QString &fileName) const
     qWarning("QZip: Unsupported compression method %d is needed to extract the data.", compression_method);
 */
     return QByteArray();
+//---OPENCOR--- BEGIN
+#endif
+    d->scanFiles();
+    const int i = d->indexOf(fileName);
+    if (i == -1)
+        return QByteArray();
+
+    // inflate straight into our buffer, which we size upfront (if possible)
+    QByteArray data;
+    const qint64 size = d->fillFileInfo(i).size;
+    if (size < qint64(std::numeric_limits<int>::max()))
+        data.reserve(int(size));
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    if (!d->extractEntry(i, &buffer))
+        return QByteArray();
+    buffer.close();
+    return data;
+//---OPENCOR--- END
 }
 
+//---OPENCOR--- BEGIN
+/*!
+    Fetch the file contents from the zip archive and write the uncompressed
+    bytes to \a destination, one chunk at a time. This is to be preferred over
+    fileData() for large entries.
+    Returns true if the entry could be found, inflated and checked against its
+    CRC-32.
+*/
+bool QZipReader::extractFile(const QString &fileName, QIODevice *destination) const
+{
+    Q_ASSERT(destination);
+    d->scanFiles();
+    const int i = d->indexOf(fileName);
+    return (i != -1) && d->extractEntry(i, destination);
+}
+//---OPENCOR--- END
+
 /*!
     Extracts the full contents of the zip file into \a destinationDir on
     the local filesystem.
@@ -1211,7 +1768,13 @@ bool QZipReader::extractAll(const QString &destinationDir) const
             QFile f(absPath);
             if (!f.open(QIODevice::WriteOnly))
                 return false;
+/*---OPENCOR---
             f.write(fileData(fi.filePath));
+*/
+//---OPENCOR--- BEGIN
+            if (!extractFile(fi.filePath, &f))
+                return false;
+//---OPENCOR--- END
 /*---OPENCOR---
             f.setPermissions(fi.permissions);
 */
@@ -1423,6 +1986,35 @@ QFile::Permissions QZipWriter::creationPermissions() const
     return d->permissions;
 }
 
+//---OPENCOR--- BEGIN
+/*!
+    Sets the size from which newly added files will be stored using the ZIP64
+    extensions to \a threshold.
+
+    \note the default threshold is a bit less than 4 GB, so that this is only
+    really useful for testing purposes.
+
+    \sa zip64EntryThreshold()
+    \sa addFile()
+*/
+void QZipWriter::setZip64EntryThreshold(qint64 threshold)
+{
+    d->zip64EntryThreshold = threshold;
+}
+
+/*!
+    Returns the size from which newly added files will be stored using the
+    ZIP64 extensions.
+
+    \sa setZip64EntryThreshold()
+    \sa addFile()
+*/
+qint64 QZipWriter::zip64EntryThreshold() const
+{
+    return d->zip64EntryThreshold;
+}
+//---OPENCOR--- END
+
 /*!
     Add a file to the archive with \a data as the file contents.
     The file will be stored in the archive using the \a fileName which
@@ -1459,7 +2051,17 @@ void QZipWriter::addFile(const QString &fileName, QIODevice *device)
             return;
         }
     }
+/*---OPENCOR---
     d->addEntry(QZipWriterPrivate::File, QDir::fromNativeSeparators(fileName), device->readAll());
+*/
+//---OPENCOR--- BEGIN
+    // stream random-access devices straight into the archive rather than
+    // reading them in full first
+    if (device->isSequential())
+        d->addEntry(QZipWriterPrivate::File, QDir::fromNativeSeparators(fileName), device->readAll());
+    else
+        d->addEntry(QZipWriterPrivate::File, QDir::fromNativeSeparators(fileName), device, device->size() - device->pos());
+//---OPENCOR--- END
     if (opened)
         device->close();
 }
@@ -1507,17 +2109,57 @@ void QZipWriter::close()
         d->device->write(header.extra_field);
         d->device->write(header.file_comment);
     }
+/*---OPENCOR---
     int dir_size = d->device->pos() - d->start_of_directory;
+*/
+//---OPENCOR--- BEGIN
+    const quint64 dir_size = quint64(d->device->pos()) - d->start_of_directory;
+    const quint64 num_dir_entries = quint64(d->fileHeaders.size());
+
+    // fields that don't fit in the end of directory record get saturated,
+    // in which case the actual values go in a ZIP64 end of directory record,
+    // which is itself followed by a locator
+    if (   (num_dir_entries >= 0xffff) || (dir_size >= Zip64Limit)
+        || (d->start_of_directory >= Zip64Limit)) {
+        const quint64 eod64_offset = quint64(d->device->pos());
+        Zip64EndOfDirectory eod64;
+        memset(&eod64, 0, sizeof(Zip64EndOfDirectory));
+        writeUInt(eod64.signature, 0x06064b50);
+        writeUInt64(eod64.record_size, sizeof(Zip64EndOfDirectory) - 12);
+        writeUShort(eod64.version_made, (HostUnix << 8) | ZIP64_VERSION);
+        writeUShort(eod64.version_needed, ZIP64_VERSION);
+        writeUInt64(eod64.num_dir_entries_this_disk, num_dir_entries);
+        writeUInt64(eod64.num_dir_entries, num_dir_entries);
+        writeUInt64(eod64.directory_size, dir_size);
+        writeUInt64(eod64.dir_start_offset, d->start_of_directory);
+        d->device->write((const char *)&eod64, sizeof(Zip64EndOfDirectory));
+
+        Zip64EndOfDirectoryLocator locator;
+        memset(&locator, 0, sizeof(Zip64EndOfDirectoryLocator));
+        writeUInt(locator.signature, 0x07064b50);
+        writeUInt64(locator.eod_offset, eod64_offset);
+        writeUInt(locator.num_disks, 1);
+        d->device->write((const char *)&locator, sizeof(Zip64EndOfDirectoryLocator));
+    }
+//---OPENCOR--- END
     // write end of directory
     EndOfDirectory eod;
     memset(&eod, 0, sizeof(EndOfDirectory));
     writeUInt(eod.signature, 0x06054b50);
     //uchar this_disk[2];
     //uchar start_of_directory_disk[2];
+/*---OPENCOR---
     writeUShort(eod.num_dir_entries_this_disk, d->fileHeaders.size());
     writeUShort(eod.num_dir_entries, d->fileHeaders.size());
     writeUInt(eod.directory_size, dir_size);
     writeUInt(eod.dir_start_offset, d->start_of_directory);
+*/
+//---OPENCOR--- BEGIN
+    writeUShort(eod.num_dir_entries_this_disk, ushort(qMin<quint64>(num_dir_entries, 0xffff)));
+    writeUShort(eod.num_dir_entries, ushort(qMin<quint64>(num_dir_entries, 0xffff)));
+    writeUInt(eod.directory_size, uint(qMin(dir_size, Zip64Limit)));
+    writeUInt(eod.dir_start_offset, uint(qMin(d->start_of_directory, Zip64Limit)));
+//---OPENCOR--- END
     writeUShort(eod.comment_length, d->comment.length());
 
     d->device->write((const char *)&eod, sizeof(EndOfDirectory));
@@ -113,6 +113,9 @@ public:
 
     FileInfo entryInfoAt(int index) const;
     QByteArray fileData(const QString &fileName) const;
+//---OPENCOR--- BEGIN
+    bool extractFile(const QString &fileName, QIODevice *destination) const;
+//---OPENCOR--- END
     bool extractAll(const QString &destinationDir) const;
 
     enum Status {
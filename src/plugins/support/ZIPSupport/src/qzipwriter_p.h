@@ -110,6 +110,11 @@ public:
     void setCreationPermissions(QFile::Permissions permissions);
     QFile::Permissions creationPermissions() const;
 
+//---OPENCOR--- BEGIN
+    void setZip64EntryThreshold(qint64 threshold);
+    qint64 zip64EntryThreshold() const;
+//---OPENCOR--- END
+
     void addFile(const QString &fileName, const QByteArray &data);
 
     void addFile(const QString &fileName, QIODevice *device);
@@ -107,6 +107,99 @@ void Tests::uncompressTests()
 
 //==============================================================================
 
+void Tests::largeEntryTests()
+{
+    // Compress an entry that spans several chunks, streaming it from a buffer
+    // so that it gets deflated in parallel
+
+    QByteArray data;
+
+    for (int i = 0; i < 5*1024*1024/16; ++i) {
+        data += QByteArray::number(i%4099).rightJustified(16, ' ');
+    }
+
+    QString fileName = OpenCOR::Core::temporaryFileName();
+
+    {
+        OpenCOR::ZIPSupport::QZipWriter zipWriter(fileName);
+        QBuffer buffer(&data);
+
+        buffer.open(QIODevice::ReadOnly);
+
+        zipWriter.addFile(TxtFileName, &buffer);
+
+        QCOMPARE(zipWriter.status(), OpenCOR::ZIPSupport::QZipWriter::NoError);
+    }
+
+    // Uncompress our entry, both as a whole and by streaming it, and make sure
+    // that we get our data back
+
+    OpenCOR::ZIPSupport::QZipReader zipReader(fileName);
+    QByteArray streamedData;
+    QBuffer buffer(&streamedData);
+
+    buffer.open(QIODevice::WriteOnly);
+
+    QCOMPARE(zipReader.entryInfoAt(0).size, qint64(data.size()));
+    QVERIFY(zipReader.fileData(TxtFileName) == data);
+    QVERIFY(zipReader.extractFile(TxtFileName, &buffer));
+    QVERIFY(streamedData == data);
+
+    zipReader.close();
+
+    QFile::remove(fileName);
+}
+
+//==============================================================================
+
+void Tests::zip64EntryTests()
+{
+    // Compress ourselves and our header file using the ZIP64 extensions, this
+    // by lowering the size from which they are used since we don't want to
+    // have to compress 4 GB of data
+
+    QByteArray cppContents = OpenCOR::rawFileContents(CppFileName);
+    QByteArray hContents = OpenCOR::rawFileContents(HFileName);
+    QString fileName = OpenCOR::Core::temporaryFileName();
+
+    {
+        OpenCOR::ZIPSupport::QZipWriter zipWriter(fileName);
+
+        zipWriter.setZip64EntryThreshold(0);
+
+        zipWriter.addFile(CppFileName, cppContents);
+        zipWriter.addFile(HFileName, hContents);
+
+        QCOMPARE(zipWriter.status(), OpenCOR::ZIPSupport::QZipWriter::NoError);
+    }
+
+    // Make sure that our first entry was effectively written using the ZIP64
+    // extensions, i.e. that it needs version 4.5 of the ZIP specification,
+    // that its sizes are saturated and that it is followed by a ZIP64 extra
+    // field
+
+    QByteArray zipContents = OpenCOR::rawFileContents(fileName);
+
+    QCOMPARE(uchar(zipContents.at(4)), uchar(45));
+    QCOMPARE(zipContents.mid(18, 8), QByteArray(8, '\xff'));
+    QCOMPARE(zipContents.mid(30+int(strlen(CppFileName)), 2), QByteArray("\x01\x00", 2));
+
+    // Uncompress our entries and make sure that we get our data back
+
+    OpenCOR::ZIPSupport::QZipReader zipReader(fileName);
+
+    QCOMPARE(zipReader.entryInfoAt(0).size, qint64(cppContents.size()));
+    QCOMPARE(zipReader.entryInfoAt(1).size, qint64(hContents.size()));
+    QVERIFY(zipReader.fileData(CppFileName) == cppContents);
+    QVERIFY(zipReader.fileData(HFileName) == hContents);
+
+    zipReader.close();
+
+    QFile::remove(fileName);
+}
+
+//==============================================================================
+
 QTEST_GUILESS_MAIN(Tests)
 
 //==============================================================================
@@ -43,6 +43,8 @@ private slots:
 
     void compressTests();
     void uncompressTests();
+    void largeEntryTests();
+    void zip64EntryTests();
 };
 
 //==============================================================================
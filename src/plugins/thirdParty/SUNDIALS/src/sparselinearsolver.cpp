@@ -0,0 +1,500 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// SUNDIALS sparse linear solver
+//==============================================================================
+
+#include "sparselinearsolver.h"
+
+//==============================================================================
+
+#include <QtMath>
+
+//==============================================================================
+
+#include "sundialsbegin.h"
+    #include "sunmatrix/sunmatrix_sparse.h"
+#include "sundialsend.h"
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace SUNDIALS {
+
+//==============================================================================
+
+// Threshold used to favour diagonal pivots
+// Note: a diagonal entry is used as a pivot as long as its magnitude is at
+//       least that fraction of the largest candidate pivot in its column. This
+//       is what KLU does by default and it helps preserve the sparsity of the
+//       matrices we get from CVODES and KINSOL, which are often diagonally
+//       dominant...
+
+static const double DiagonalPivotTolerance = 0.001;
+
+//==============================================================================
+
+sunindextype SparseLuFactorisation::factorise(sunindextype pSize,
+                                              const sunindextype *pColumnPointers,
+                                              const sunindextype *pRowIndices,
+                                              const double *pValues)
+{
+    // Compute the LU factorisation, with partial pivoting, of the given matrix,
+    // which is in the compressed sparse column (CSC) format, using a
+    // left-looking algorithm (Gilbert-Peierls)
+    // Note #1: L is unit lower triangular, with its unit diagonal stored first
+    //          in each column, while U is upper triangular, with its diagonal
+    //          stored last in each column...
+    // Note #2: we return 0 if the factorisation succeeded or the (one-based)
+    //          index of the column for which we couldn't find a pivot...
+
+    if (pSize != mSize) {
+        mSize = pSize;
+
+        mLColumnPointers.resize(int(pSize+1));
+        mUColumnPointers.resize(int(pSize+1));
+
+        mPivots.resize(int(pSize));
+        mReach.resize(int(pSize));
+        mStack.resize(int(pSize));
+        mPositions.resize(int(pSize));
+        mMarks.resize(int(pSize));
+        mWork.resize(int(pSize));
+    }
+
+    sunindextype capacity = 4*pColumnPointers[pSize]+pSize;
+
+    if (mLValues.size() < capacity) {
+        reserve(mLRowIndices, mLValues, capacity);
+    }
+
+    if (mUValues.size() < capacity) {
+        reserve(mURowIndices, mUValues, capacity);
+    }
+
+    mPivots.fill(-1);
+    mMarks.fill(-1);
+    mWork.fill(0.0);
+
+    sunindextype lNonZeroCount = 0;
+    sunindextype uNonZeroCount = 0;
+    sunindextype *lColumnPointers = mLColumnPointers.data();
+    sunindextype *uColumnPointers = mUColumnPointers.data();
+    sunindextype *pivots = mPivots.data();
+    const sunindextype *reachedRows = mReach.constData();
+    double *work = mWork.data();
+
+    for (sunindextype k = 0; k < pSize; ++k) {
+        // Make sure that there is enough space for the k-th column of L and U
+
+        lColumnPointers[k] = lNonZeroCount;
+        uColumnPointers[k] = uNonZeroCount;
+
+        if (lNonZeroCount+pSize > mLValues.size()) {
+            reserve(mLRowIndices, mLValues, 2*mLValues.size()+pSize);
+        }
+
+        if (uNonZeroCount+pSize > mUValues.size()) {
+            reserve(mURowIndices, mUValues, 2*mUValues.size()+pSize);
+        }
+
+        sunindextype *lRowIndices = mLRowIndices.data();
+        double *lValues = mLValues.data();
+        sunindextype *uRowIndices = mURowIndices.data();
+        double *uValues = mUValues.data();
+
+        // Solve L*x = A(:, k), only visiting the entries of x that are
+        // reachable from the non-zero entries of A(:, k)
+
+        sunindextype top = reach(k, pColumnPointers, pRowIndices);
+
+        for (sunindextype i = top; i < pSize; ++i) {
+            work[reachedRows[i]] = 0.0;
+        }
+
+        for (sunindextype i = pColumnPointers[k], iMax = pColumnPointers[k+1]; i < iMax; ++i) {
+            work[pRowIndices[i]] = pValues[i];
+        }
+
+        for (sunindextype i = top; i < pSize; ++i) {
+            sunindextype row = reachedRows[i];
+            sunindextype column = pivots[row];
+
+            if (column < 0) {
+                continue;
+            }
+
+            double value = work[row];
+
+            for (sunindextype j = lColumnPointers[column]+1, jMax = lColumnPointers[column+1]; j < jMax; ++j) {
+                work[lRowIndices[j]] -= lValues[j]*value;
+            }
+        }
+
+        // Look for our pivot, keeping track of the entries of U as we go
+
+        sunindextype pivotRow = -1;
+        double pivotMagnitude = -1.0;
+
+        for (sunindextype i = top; i < pSize; ++i) {
+            sunindextype row = reachedRows[i];
+
+            if (pivots[row] < 0) {
+                double magnitude = qAbs(work[row]);
+
+                if (magnitude > pivotMagnitude) {
+                    pivotRow = row;
+                    pivotMagnitude = magnitude;
+                }
+            } else {
+                uRowIndices[uNonZeroCount] = pivots[row];
+                uValues[uNonZeroCount++] = work[row];
+            }
+        }
+
+        if ((pivotRow == -1) || (pivotMagnitude <= 0.0)) {
+            mLastFlag = k+1;
+
+            return mLastFlag;
+        }
+
+        if (   (pivots[k] < 0)
+            && (qAbs(work[k]) >= DiagonalPivotTolerance*pivotMagnitude)) {
+            pivotRow = k;
+        }
+
+        // Keep track of our pivot and compute the k-th column of L
+
+        double pivot = work[pivotRow];
+
+        uRowIndices[uNonZeroCount] = k;
+        uValues[uNonZeroCount++] = pivot;
+
+        pivots[pivotRow] = k;
+
+        lRowIndices[lNonZeroCount] = pivotRow;
+        lValues[lNonZeroCount++] = 1.0;
+
+        for (sunindextype i = top; i < pSize; ++i) {
+            sunindextype row = reachedRows[i];
+
+            if (pivots[row] < 0) {
+                lRowIndices[lNonZeroCount] = row;
+                lValues[lNonZeroCount++] = work[row]/pivot;
+            }
+
+            work[row] = 0.0;
+        }
+    }
+
+    lColumnPointers[pSize] = lNonZeroCount;
+    uColumnPointers[pSize] = uNonZeroCount;
+
+    // Express the row indices of L in terms of our pivots
+
+    sunindextype *lRowIndices = mLRowIndices.data();
+
+    for (sunindextype i = 0; i < lNonZeroCount; ++i) {
+        lRowIndices[i] = pivots[lRowIndices[i]];
+    }
+
+    mLastFlag = 0;
+
+    return mLastFlag;
+}
+
+//==============================================================================
+
+void SparseLuFactorisation::solve(double *pX, const double *pB)
+{
+    // Solve A*x = b using our LU factorisation, i.e. solve L*U*x = P*b
+
+    const sunindextype *pivots = mPivots.constData();
+    const sunindextype *lColumnPointers = mLColumnPointers.constData();
+    const sunindextype *lRowIndices = mLRowIndices.constData();
+    const double *lValues = mLValues.constData();
+    const sunindextype *uColumnPointers = mUColumnPointers.constData();
+    const sunindextype *uRowIndices = mURowIndices.constData();
+    const double *uValues = mUValues.constData();
+    double *work = mWork.data();
+
+    for (sunindextype i = 0; i < mSize; ++i) {
+        work[pivots[i]] = pB[i];
+    }
+
+    for (sunindextype i = 0; i < mSize; ++i) {
+        double value = work[i];
+
+        for (sunindextype j = lColumnPointers[i]+1, jMax = lColumnPointers[i+1]; j < jMax; ++j) {
+            work[lRowIndices[j]] -= lValues[j]*value;
+        }
+    }
+
+    for (sunindextype i = mSize-1; i >= 0; --i) {
+        sunindextype diagonal = uColumnPointers[i+1]-1;
+
+        work[i] /= uValues[diagonal];
+
+        double value = work[i];
+
+        for (sunindextype j = uColumnPointers[i]; j < diagonal; ++j) {
+            work[uRowIndices[j]] -= uValues[j]*value;
+        }
+    }
+
+    std::copy(work, work+mSize, pX);
+}
+
+//==============================================================================
+
+sunindextype SparseLuFactorisation::lastFlag() const
+{
+    // Return our last flag
+
+    return mLastFlag;
+}
+
+//==============================================================================
+
+sunindextype SparseLuFactorisation::reach(sunindextype pColumn,
+                                          const sunindextype *pColumnPointers,
+                                          const sunindextype *pRowIndices)
+{
+    // Determine the rows of L*x = A(:, pColumn) that are reachable from the
+    // non-zero entries of A(:, pColumn), using a non-recursive depth-first
+    // search through the graph of L
+    // Note: the reachable rows are stored, in topological order, at the end of
+    //       mReach and we return the index of the first one...
+
+    const sunindextype *pivots = mPivots.constData();
+    const sunindextype *lColumnPointers = mLColumnPointers.constData();
+    const sunindextype *lRowIndices = mLRowIndices.constData();
+    sunindextype *reachedRows = mReach.data();
+    sunindextype *stack = mStack.data();
+    sunindextype *positions = mPositions.data();
+    sunindextype *marks = mMarks.data();
+    sunindextype top = mSize;
+
+    for (sunindextype i = pColumnPointers[pColumn], iMax = pColumnPointers[pColumn+1]; i < iMax; ++i) {
+        if (marks[pRowIndices[i]] == pColumn) {
+            continue;
+        }
+
+        sunindextype head = 0;
+
+        stack[0] = pRowIndices[i];
+
+        while (head >= 0) {
+            sunindextype row = stack[head];
+            sunindextype column = pivots[row];
+
+            if (marks[row] != pColumn) {
+                marks[row] = pColumn;
+
+                positions[head] = (column < 0)?0:lColumnPointers[column];
+            }
+
+            bool done = true;
+
+            for (sunindextype j = positions[head], jMax = (column < 0)?0:lColumnPointers[column+1]; j < jMax; ++j) {
+                sunindextype nextRow = lRowIndices[j];
+
+                if (marks[nextRow] != pColumn) {
+                    positions[head] = j+1;
+                    stack[++head] = nextRow;
+
+                    done = false;
+
+                    break;
+                }
+            }
+
+            if (done) {
+                --head;
+
+                reachedRows[--top] = row;
+            }
+        }
+    }
+
+    return top;
+}
+
+//==============================================================================
+
+void SparseLuFactorisation::reserve(QVector<sunindextype> &pRowIndices,
+                                    QVector<double> &pValues,
+                                    sunindextype pSize)
+{
+    // Reserve some space for the row indices and values of L or U
+
+    pRowIndices.resize(int(pSize));
+    pValues.resize(int(pSize));
+}
+
+//==============================================================================
+
+static SparseLuFactorisation * factorisation(SUNLinearSolver pLinearSolver)
+{
+    // Return the LU factorisation associated with the given linear solver
+
+    return static_cast<SparseLuFactorisation *>(pLinearSolver->content);
+}
+
+//==============================================================================
+
+static SUNLinearSolver_Type sparseLinearSolverGetType(SUNLinearSolver pLinearSolver)
+{
+    Q_UNUSED(pLinearSolver)
+
+    // Our linear solver is a direct one
+
+    return SUNLINEARSOLVER_DIRECT;
+}
+
+//==============================================================================
+
+static SUNLinearSolver_ID sparseLinearSolverGetId(SUNLinearSolver pLinearSolver)
+{
+    Q_UNUSED(pLinearSolver)
+
+    // Our linear solver is a custom one
+
+    return SUNLINEARSOLVER_CUSTOM;
+}
+
+//==============================================================================
+
+static int sparseLinearSolverInitialize(SUNLinearSolver pLinearSolver)
+{
+    Q_UNUSED(pLinearSolver)
+
+    // Nothing to initialise
+
+    return SUNLS_SUCCESS;
+}
+
+//==============================================================================
+
+static int sparseLinearSolverSetup(SUNLinearSolver pLinearSolver, SUNMatrix pMatrix)
+{
+    // Factorise the given matrix
+    // Note: a failed factorisation is reported as a recoverable failure, so
+    //       that CVODES/KINSOL can try again with a different matrix...
+
+    if (   (SUNMatGetID(pMatrix) != SUNMATRIX_SPARSE)
+        || (SUNSparseMatrix_SparseType(pMatrix) != CSC_MAT)) {
+        return SUNLS_ILL_INPUT;
+    }
+
+    if (factorisation(pLinearSolver)->factorise(SUNSparseMatrix_Columns(pMatrix),
+                                                SUNSparseMatrix_IndexPointers(pMatrix),
+                                                SUNSparseMatrix_IndexValues(pMatrix),
+                                                SUNSparseMatrix_Data(pMatrix)) != 0) {
+        return SUNLS_LUFACT_FAIL;
+    }
+
+    return SUNLS_SUCCESS;
+}
+
+//==============================================================================
+
+static int sparseLinearSolverSolve(SUNLinearSolver pLinearSolver, SUNMatrix pMatrix,
+                                   N_Vector pX, N_Vector pB, double pTolerance)
+{
+    Q_UNUSED(pMatrix)
+    Q_UNUSED(pTolerance)
+
+    // Solve our linear system using our LU factorisation
+
+    factorisation(pLinearSolver)->solve(N_VGetArrayPointer(pX),
+                                        N_VGetArrayPointer(pB));
+
+    return SUNLS_SUCCESS;
+}
+
+//==============================================================================
+
+static sunindextype sparseLinearSolverLastFlag(SUNLinearSolver pLinearSolver)
+{
+    // Return the last flag of our LU factorisation
+
+    return factorisation(pLinearSolver)->lastFlag();
+}
+
+//==============================================================================
+
+static int sparseLinearSolverFree(SUNLinearSolver pLinearSolver)
+{
+    // Delete our LU factorisation and linear solver
+
+    if (pLinearSolver == nullptr) {
+        return SUNLS_SUCCESS;
+    }
+
+    delete factorisation(pLinearSolver);
+
+    pLinearSolver->content = nullptr;
+
+    SUNLinSolFreeEmpty(pLinearSolver);
+
+    return SUNLS_SUCCESS;
+}
+
+//==============================================================================
+
+SUNLinearSolver sparseLinearSolver(N_Vector pVector, SUNMatrix pMatrix,
+                                   SUNContext pContext)
+{
+    // Make sure that we have been given a square CSC sparse matrix and a
+    // compatible vector
+
+    if (   (SUNMatGetID(pMatrix) != SUNMATRIX_SPARSE)
+        || (SUNSparseMatrix_SparseType(pMatrix) != CSC_MAT)
+        || (SUNSparseMatrix_Rows(pMatrix) != SUNSparseMatrix_Columns(pMatrix))
+        || (N_VGetLength(pVector) != SUNSparseMatrix_Rows(pMatrix))) {
+        return nullptr;
+    }
+
+    // Create and return our linear solver
+
+    SUNLinearSolver res = SUNLinSolNewEmpty(pContext);
+
+    res->ops->gettype = sparseLinearSolverGetType;
+    res->ops->getid = sparseLinearSolverGetId;
+    res->ops->initialize = sparseLinearSolverInitialize;
+    res->ops->setup = sparseLinearSolverSetup;
+    res->ops->solve = sparseLinearSolverSolve;
+    res->ops->lastflag = sparseLinearSolverLastFlag;
+    res->ops->free = sparseLinearSolverFree;
+
+    res->content = new SparseLuFactorisation();
+
+    return res;
+}
+
+//==============================================================================
+
+} // namespace SUNDIALS
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
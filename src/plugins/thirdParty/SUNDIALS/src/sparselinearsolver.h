@@ -0,0 +1,102 @@
+/*******************************************************************************
+
+Copyright (C) The University of Auckland
+
+OpenCOR is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 3 of the License, or
+(at your option) any later version.
+
+OpenCOR is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program. If not, see <https://gnu.org/licenses>.
+
+*******************************************************************************/
+
+//==============================================================================
+// SUNDIALS sparse linear solver
+//==============================================================================
+
+#pragma once
+
+//==============================================================================
+
+#include "sundialsglobal.h"
+
+//==============================================================================
+
+#include <QVector>
+
+//==============================================================================
+
+#include "sundialsbegin.h"
+    #include "sundials/sundials_linearsolver.h"
+    #include "sundials/sundials_matrix.h"
+    #include "sundials/sundials_nvector.h"
+#include "sundialsend.h"
+
+//==============================================================================
+
+namespace OpenCOR {
+namespace SUNDIALS {
+
+//==============================================================================
+
+class SparseLuFactorisation
+{
+public:
+    sunindextype factorise(sunindextype pSize,
+                           const sunindextype *pColumnPointers,
+                           const sunindextype *pRowIndices,
+                           const double *pValues);
+
+    void solve(double *pX, const double *pB);
+
+    sunindextype lastFlag() const;
+
+private:
+    sunindextype mSize = 0;
+    sunindextype mLastFlag = 0;
+
+    QVector<sunindextype> mLColumnPointers;
+    QVector<sunindextype> mLRowIndices;
+    QVector<double> mLValues;
+
+    QVector<sunindextype> mUColumnPointers;
+    QVector<sunindextype> mURowIndices;
+    QVector<double> mUValues;
+
+    QVector<sunindextype> mPivots;
+
+    QVector<sunindextype> mReach;
+    QVector<sunindextype> mStack;
+    QVector<sunindextype> mPositions;
+    QVector<sunindextype> mMarks;
+    QVector<double> mWork;
+
+    sunindextype reach(sunindextype pColumn,
+                       const sunindextype *pColumnPointers,
+                       const sunindextype *pRowIndices);
+
+    static void reserve(QVector<sunindextype> &pRowIndices,
+                        QVector<double> &pValues, sunindextype pSize);
+};
+
+//==============================================================================
+
+SUNDIALSPLUGIN_EXPORT SUNLinearSolver sparseLinearSolver(N_Vector pVector,
+                                                         SUNMatrix pMatrix,
+                                                         SUNContext pContext);
+
+//==============================================================================
+
+} // namespace SUNDIALS
+} // namespace OpenCOR
+
+//==============================================================================
+// End of file
+//==============================================================================
@@ -43,11 +43,15 @@ along with this program. If not, see <https://gnu.org/licenses>.
 
 //==============================================================================
 
+#include <algorithm>
+#include <array>
 #include <cfloat>
+#include <climits>
 
 //==============================================================================
 
 #include "qwtbegin.h"
+    #include "qwt_clipper.h"
     #include "qwt_dyngrid_layout.h"
     #include "qwt_legend_label.h"
     #include "qwt_painter.h"
@@ -187,8 +191,57 @@ QColor GraphPanelPlotGraphProperties::symbolFillColor() const
 
 //==============================================================================
 
+static const QRectF InvalidRect = QRectF(0.0, 0.0, -1.0, -1.0);
+
+//==============================================================================
+
+GraphPanelPlotGraphRunData::GraphPanelPlotGraphRunData(const double *pDataX,
+                                                       const double *pDataY,
+                                                       quint64 pSize,
+                                                       const QRectF &pBoundingRect) :
+    mDataX(pDataX),
+    mDataY(pDataY),
+    mSize(pSize),
+    mBoundingRect(pBoundingRect)
+{
+}
+
+//==============================================================================
+
+size_t GraphPanelPlotGraphRunData::size() const
+{
+    // Return our size
+    // Note: unlike QwtCPointerData, which uses an int, we can hold more than
+    //       INT_MAX samples...
+
+    return size_t(mSize);
+}
+
+//==============================================================================
+
+QPointF GraphPanelPlotGraphRunData::sample(size_t pIndex) const
+{
+    // Return the sample at the given index
+
+    return QPointF(mDataX[pIndex], mDataY[pIndex]);
+}
+
+//==============================================================================
+
+QRectF GraphPanelPlotGraphRunData::boundingRect() const
+{
+    // Return our bounding rectangle, which our run has already computed from
+    // its valid samples, so no need for Qwt to go through all our samples
+
+    return mBoundingRect;
+}
+
+//==============================================================================
+
 GraphPanelPlotGraphRun::GraphPanelPlotGraphRun(GraphPanelPlotGraph *pOwner) :
-    mOwner(pOwner)
+    mOwner(pOwner),
+    mDataRect(InvalidRect),
+    mDataLogRect(InvalidRect)
 {
     // Customise ourselves a bit
 
@@ -211,13 +264,45 @@ GraphPanelPlotGraph * GraphPanelPlotGraphRun::owner() const
 
 void GraphPanelPlotGraphRun::setRawSamples(const double *pDataX,
                                            const double *pDataY,
-                                           int pSize)
+                                           quint64 pSize)
 {
-    // Set the given raw samples and keep track of those that are valid
+    // Set the given raw samples and keep track of those that are valid, as
+    // well as of whether our X values are monotonic, of the extrema of our Y
+    // values, and of the (log) rectangle that contains our valid samples
+    // Note: we normally get new raw samples appended to the ones we already
+    //       have, but if we get completely new ones, then we need to start
+    //       from scratch...
+
+    static const QPair<qint64, qint64> EmptyData = QPair<qint64, qint64>(-1, -1);
+
+    if ((pDataX != mDataX) || (pDataY != mDataY) || (pSize < mSize)) {
+        mDataX = pDataX;
+        mDataY = pDataY;
 
-    static const QPair<int, int> EmptyData = QPair<int, int>(-1, -1);
+        mSize = 0;
+        mValidData.clear();
 
-    QPair<int, int> validData = EmptyData;
+        mMonotonic = true;
+        mHasLastX = false;
+
+        mExtrema.clear();
+
+        mDataRect = InvalidRect;
+        mDataLogRect = InvalidRect;
+    }
+
+    double minX = mDataRect.left();
+    double maxX = mDataRect.right();
+    double minY = mDataRect.top();
+    double maxY = mDataRect.bottom();
+    double minLogX = mDataLogRect.left();
+    double maxLogX = mDataLogRect.right();
+    double minLogY = mDataLogRect.top();
+    double maxLogY = mDataLogRect.bottom();
+    bool hasData = mDataRect != InvalidRect;
+    bool hasLogData = mDataLogRect != InvalidRect;
+
+    QPair<qint64, qint64> validData = EmptyData;
 
     if (!mValidData.isEmpty()) {
         validData = mValidData.last();
@@ -225,7 +310,7 @@ void GraphPanelPlotGraphRun::setRawSamples(const double *pDataX,
         mValidData.removeLast();
     }
 
-    for (int i = mSize; i < pSize; ++i) {
+    for (qint64 i = qint64(mSize), iMax = qint64(pSize); i < iMax; ++i) {
         if (   !qIsInf(pDataX[i]) && !qIsNaN(pDataX[i])
             && !qIsInf(pDataY[i]) && !qIsNaN(pDataY[i])) {
             if (validData == EmptyData) {
@@ -239,6 +324,39 @@ void GraphPanelPlotGraphRun::setRawSamples(const double *pDataX,
                 validData.first = i;
                 validData.second = i;
             }
+
+            if (mHasLastX && (pDataX[i] < mLastX)) {
+                mMonotonic = false;
+            }
+
+            mLastX = pDataX[i];
+            mHasLastX = true;
+
+            if (hasData) {
+                minX = qMin(minX, pDataX[i]);
+                maxX = qMax(maxX, pDataX[i]);
+                minY = qMin(minY, pDataY[i]);
+                maxY = qMax(maxY, pDataY[i]);
+            } else {
+                minX = maxX = pDataX[i];
+                minY = maxY = pDataY[i];
+
+                hasData = true;
+            }
+
+            if ((pDataX[i] > 0.0) && (pDataY[i] > 0.0)) {
+                if (hasLogData) {
+                    minLogX = qMin(minLogX, pDataX[i]);
+                    maxLogX = qMax(maxLogX, pDataX[i]);
+                    minLogY = qMin(minLogY, pDataY[i]);
+                    maxLogY = qMax(maxLogY, pDataY[i]);
+                } else {
+                    minLogX = maxLogX = pDataX[i];
+                    minLogY = maxLogY = pDataY[i];
+
+                    hasLogData = true;
+                }
+            }
         }
     }
 
@@ -246,9 +364,479 @@ void GraphPanelPlotGraphRun::setRawSamples(const double *pDataX,
         mValidData << validData;
     }
 
+    if (hasData) {
+        mDataRect = QRectF(minX, minY, maxX-minX, maxY-minY);
+    }
+
+    if (hasLogData) {
+        mDataLogRect = QRectF(minLogX, minLogY, maxLogX-minLogX, maxLogY-minLogY);
+    }
+
     mSize = pSize;
 
-    QwtPlotCurve::setRawSamples(pDataX, pDataY, pSize);
+    updateExtrema();
+
+    setData(new GraphPanelPlotGraphRunData(pDataX, pDataY, pSize, mDataRect));
+}
+
+//==============================================================================
+
+QRectF GraphPanelPlotGraphRun::dataRect() const
+{
+    // Return the rectangle that contains our valid samples
+
+    return mDataRect;
+}
+
+//==============================================================================
+
+QRectF GraphPanelPlotGraphRun::dataLogRect() const
+{
+    // Return the rectangle that contains our valid samples that can be shown
+    // using a logarithmic scale, i.e. those with strictly positive coordinates
+
+    return mDataLogRect;
+}
+
+//==============================================================================
+
+static const int ExtremaFanout = 16;
+static const int ExtremaMaximumNbOfLevels = 7;
+static const QPair<qint64, qint64> NoExtrema = QPair<qint64, qint64>(-1, -1);
+static const quint32 NoExtremaOffset = UINT_MAX;
+
+//==============================================================================
+
+GraphPanelPlotGraphRun::Extrema GraphPanelPlotGraphRun::pointExtrema(qint64 pIndex) const
+{
+    // Return the extrema for the given point, i.e. the point itself if it is
+    // valid
+
+    return (   !qIsInf(mDataX[pIndex]) && !qIsNaN(mDataX[pIndex])
+            && !qIsInf(mDataY[pIndex]) && !qIsNaN(mDataY[pIndex]))?
+               Extrema(pIndex, pIndex):
+               NoExtrema;
+}
+
+//==============================================================================
+
+GraphPanelPlotGraphRun::Extrema GraphPanelPlotGraphRun::blockExtrema(int pLevel,
+                                                                     qint64 pIndex) const
+{
+    // Return the extrema for the given block of the given level
+    // Note: the extrema of a block are stored as offsets relative to the first
+    //       point of the block, which halves the memory used by our pyramid of
+    //       extrema...
+
+    const BlockExtrema &offsets = mExtrema[size_t(pLevel)][size_t(pIndex)];
+
+    if (offsets.first == NoExtremaOffset) {
+        return NoExtrema;
+    }
+
+    qint64 blockSize = ExtremaFanout;
+
+    for (int i = 0; i < pLevel; ++i) {
+        blockSize *= ExtremaFanout;
+    }
+
+    qint64 blockStart = pIndex*blockSize;
+
+    return Extrema(blockStart+offsets.first, blockStart+offsets.second);
+}
+
+//==============================================================================
+
+void GraphPanelPlotGraphRun::mergeExtrema(Extrema &pExtrema,
+                                          const Extrema &pOtherExtrema) const
+{
+    // Merge the given other extrema into the given extrema
+
+    if (pOtherExtrema == NoExtrema) {
+        return;
+    }
+
+    if (pExtrema == NoExtrema) {
+        pExtrema = pOtherExtrema;
+
+        return;
+    }
+
+    if (mDataY[pOtherExtrema.first] < mDataY[pExtrema.first]) {
+        pExtrema.first = pOtherExtrema.first;
+    }
+
+    if (mDataY[pOtherExtrema.second] > mDataY[pExtrema.second]) {
+        pExtrema.second = pOtherExtrema.second;
+    }
+}
+
+//==============================================================================
+
+void GraphPanelPlotGraphRun::mergeExtrema(Extrema &pExtrema, int pLevel,
+                                          qint64 pFrom, qint64 pTo) const
+{
+    // Merge, into the given extrema, the extrema of the items of the given
+    // level that cover the [pFrom; pTo[ range of points
+    // Note: level 0 is for our points while level n (n > 0) is for blocks of
+    //       ExtremaFanout^n points...
+
+    qint64 itemSize = 1;
+
+    for (int i = 0; i < pLevel; ++i) {
+        itemSize *= ExtremaFanout;
+    }
+
+    for (qint64 i = pFrom/itemSize, iMax = pTo/itemSize; i < iMax; ++i) {
+        mergeExtrema(pExtrema, (pLevel == 0)?
+                                   pointExtrema(i):
+                                   blockExtrema(pLevel-1, i));
+    }
+}
+
+//==============================================================================
+
+void GraphPanelPlotGraphRun::updateExtrema()
+{
+    // Update our pyramid of extrema, i.e. the indexes of the minimum and
+    // maximum Y values for each complete block of ExtremaFanout points, then
+    // for each complete block of ExtremaFanout such blocks, and so on
+    // Note #1: this is done incrementally, i.e. only for the blocks that have
+    //          been completed since our last update...
+    // Note #2: the indexes are stored as 32-bit offsets relative to the first
+    //          point of their block, so we must limit the number of levels of
+    //          our pyramid so that those offsets always fit. With 7 levels,
+    //          our largest blocks have 16^7 = 2^28 points, and only a few of
+    //          them need to be looked at when looking for extrema...
+
+    qint64 nbOfItems = qint64(mSize);
+    qint64 blockSize = 1;
+
+    for (int level = 0;
+         (level < ExtremaMaximumNbOfLevels) && (nbOfItems >= ExtremaFanout);
+         ++level) {
+        qint64 nbOfBlocks = nbOfItems/ExtremaFanout;
+        auto levelIndex = size_t(level);
+
+        blockSize *= ExtremaFanout;
+
+        if (levelIndex == mExtrema.size()) {
+            mExtrema.emplace_back();
+        }
+
+        for (auto i = qint64(mExtrema[levelIndex].size()); i < nbOfBlocks; ++i) {
+            Extrema newExtrema = NoExtrema;
+
+            for (qint64 j = i*ExtremaFanout, jMax = j+ExtremaFanout; j < jMax; ++j) {
+                mergeExtrema(newExtrema, (level == 0)?
+                                             pointExtrema(j):
+                                             blockExtrema(level-1, j));
+            }
+
+            if (newExtrema == NoExtrema) {
+                mExtrema[levelIndex].emplace_back(NoExtremaOffset, NoExtremaOffset);
+            } else {
+                qint64 blockStart = i*blockSize;
+
+                mExtrema[levelIndex].emplace_back(quint32(newExtrema.first-blockStart),
+                                                  quint32(newExtrema.second-blockStart));
+            }
+        }
+
+        nbOfItems = nbOfBlocks;
+    }
+}
+
+//==============================================================================
+
+GraphPanelPlotGraphRun::Extrema GraphPanelPlotGraphRun::extrema(qint64 pFrom,
+                                                                qint64 pTo) const
+{
+    // Return the extrema of our Y values between the given indexes (included)
+    // Note: we use the smallest items at both ends of our range and the largest
+    //       ones in between, meaning that we only have to look at a few items
+    //       for each level of our pyramid of extrema...
+
+    Extrema res = NoExtrema;
+    qint64 from = pFrom;
+    qint64 to = pTo+1;
+    qint64 itemSize = 1;
+
+    for (int level = 0; ; ++level) {
+        qint64 blockSize = itemSize*ExtremaFanout;
+        qint64 blockFrom = (from+blockSize-1)/blockSize*blockSize;
+        qint64 blockTo = to/blockSize*blockSize;
+
+        if ((size_t(level) == mExtrema.size()) || (blockFrom >= blockTo)) {
+            mergeExtrema(res, level, from, to);
+
+            break;
+        }
+
+        mergeExtrema(res, level, from, blockFrom);
+        mergeExtrema(res, level, blockTo, to);
+
+        from = blockFrom;
+        to = blockTo;
+        itemSize = blockSize;
+    }
+
+    return res;
+}
+
+//==============================================================================
+
+void GraphPanelPlotGraphRun::drawDecimatedLines(QPainter *pPainter,
+                                                const QwtScaleMap &pMapX,
+                                                const QwtScaleMap &pMapY,
+                                                const QRectF &pCanvasRect,
+                                                qint64 pFrom, qint64 pTo) const
+{
+    // Draw our lines, but only using the points that are visible, as well as
+    // the one before and the one after them, so that our lines are properly
+    // connected to the edges of our canvas
+
+    const double *first = std::lower_bound(mDataX+pFrom, mDataX+pTo+1,
+                                           qMin(pMapX.s1(), pMapX.s2()));
+    const double *last = std::upper_bound(first, mDataX+pTo+1,
+                                          qMax(pMapX.s1(), pMapX.s2()));
+    qint64 from = qMax(pFrom, qint64(first-mDataX)-1);
+    qint64 to = qMin(pTo, qint64(last-mDataX));
+
+    // Draw our lines as is if there aren't (much) more points than there are
+    // pixel columns or if some of our X values cannot be mapped (e.g. on a
+    // logarithmic scale)
+
+    static const qint64 MaximumPointsPerPixelColumn = 4;
+
+    if (   (to-from+1 <= MaximumPointsPerPixelColumn*qCeil(pCanvasRect.width()))
+        || !qIsFinite(pMapX.transform(mDataX[from]))
+        || !qIsFinite(pMapX.transform(mDataX[to]))) {
+        drawPoints(pPainter, nullptr, pMapX, pMapY, pCanvasRect, from, to);
+
+        return;
+    }
+
+    // Decimate our points using the M4 algorithm, i.e. for each pixel column,
+    // only keep our first and last points, as well as those with the minimum
+    // and maximum Y values
+    // Note: since our X values are monotonic, so are the pixel columns in
+    //       which they fall, which means that we can use a binary search to
+    //       find the last point of a given pixel column...
+
+    QPolygonF polygon;
+
+    for (qint64 i = from; i <= to;) {
+        int column = qFloor(pMapX.transform(mDataX[i]));
+        qint64 low = i+1;
+        qint64 high = to+1;
+
+        while (low < high) {
+            qint64 middle = low+(high-low)/2;
+
+            if (qFloor(pMapX.transform(mDataX[middle])) == column) {
+                low = middle+1;
+            } else {
+                high = middle;
+            }
+        }
+
+        Extrema columnExtrema = extrema(i, low-1);
+        std::array<qint64, 4> indexes = { i, columnExtrema.first,
+                                       columnExtrema.second, low-1 };
+
+        std::sort(indexes.begin(), indexes.end());
+
+        for (size_t j = 0; j < indexes.size(); ++j) {
+            if ((indexes[j] != -1) && ((j == 0) || (indexes[j] != indexes[j-1]))) {
+                polygon << QPointF(pMapX.transform(mDataX[indexes[j]]),
+                                   pMapY.transform(mDataY[indexes[j]]));
+            }
+        }
+
+        i = low;
+    }
+
+    if (testPaintAttribute(ClipPolygons)) {
+        double penWidth = qMax(1.0, pen().widthF());
+
+        polygon = QwtClipper::clipPolygonF(pCanvasRect.adjusted(-penWidth, -penWidth, penWidth, penWidth),
+                                           polygon);
+    }
+
+    QwtPainter::drawPolyline(pPainter, polygon);
+}
+
+//==============================================================================
+
+void GraphPanelPlotGraphRun::drawPoints(QPainter *pPainter,
+                                        const QwtSymbol *pSymbol,
+                                        const QwtScaleMap &pMapX,
+                                        const QwtScaleMap &pMapY,
+                                        const QRectF &pCanvasRect,
+                                        qint64 pFrom, qint64 pTo) const
+{
+    // Draw our lines or, if a symbol is given, our symbols, letting Qwt do it
+    // if our indexes fit in an int
+
+    if (pTo <= INT_MAX) {
+        if (pSymbol != nullptr) {
+            QwtPlotCurve::drawSymbols(pPainter, *pSymbol, pMapX, pMapY,
+                                      pCanvasRect, int(pFrom), int(pTo));
+        } else {
+            QwtPlotCurve::drawLines(pPainter, pMapX, pMapY, pCanvasRect,
+                                    int(pFrom), int(pTo));
+        }
+
+        return;
+    }
+
+    // Our indexes don't fit in an int, so map our points ourselves, doing so
+    // in batches to keep our memory usage in check
+    // Note: a batch of lines starts with the last point of the previous batch,
+    //       so that our batches are properly connected...
+
+    static const qint64 BatchSize = 65536;
+
+    double margin = (pSymbol != nullptr)?
+                        qMax(pSymbol->size().width(), pSymbol->size().height()):
+                        qMax(1.0, pen().widthF());
+    QRectF clipRect = pCanvasRect.adjusted(-margin, -margin, margin, margin);
+    bool clipPolygons = testPaintAttribute(ClipPolygons);
+    QPolygonF polygon;
+
+    for (qint64 i = pFrom; i <= pTo;) {
+        qint64 iMax = qMin(i+BatchSize, pTo+1);
+
+        polygon.clear();
+        polygon.reserve(int(iMax-i));
+
+        for (qint64 j = i; j < iMax; ++j) {
+            QPointF point = QPointF(pMapX.transform(mDataX[j]),
+                                    pMapY.transform(mDataY[j]));
+
+            if ((pSymbol == nullptr) || clipRect.contains(point)) {
+                polygon << point;
+            }
+        }
+
+        if (pSymbol != nullptr) {
+            pSymbol->drawSymbols(pPainter, polygon);
+
+            i = iMax;
+        } else {
+            if (clipPolygons) {
+                polygon = QwtClipper::clipPolygonF(clipRect, polygon);
+            }
+
+            QwtPainter::drawPolyline(pPainter, polygon);
+
+            i = (iMax > pTo)?iMax:iMax-1;
+        }
+    }
+}
+
+//==============================================================================
+
+void GraphPanelPlotGraphRun::drawValidLines(QPainter *pPainter,
+                                            const QwtScaleMap &pMapX,
+                                            const QwtScaleMap &pMapY,
+                                            const QRectF &pCanvasRect,
+                                            qint64 pFrom, qint64 pTo) const
+{
+    // Draw the lines of our valid data between the given indexes
+
+    for (const auto &validData : mValidData) {
+        if ((pFrom <= validData.first) || (pTo >= validData.second)) {
+            qint64 from = (   (pFrom >= validData.first)
+                           && (pFrom <= validData.second))?
+                              pFrom:
+                              validData.first;
+            qint64 to = (   (pTo >= validData.first)
+                         && (pTo <= validData.second))?
+                            pTo:
+                            validData.second;
+
+            if (mMonotonic) {
+                drawDecimatedLines(pPainter, pMapX, pMapY,
+                                   pCanvasRect, from, to);
+            } else {
+                drawPoints(pPainter, nullptr, pMapX, pMapY,
+                           pCanvasRect, from, to);
+            }
+        }
+    }
+}
+
+//==============================================================================
+
+void GraphPanelPlotGraphRun::drawValidSymbols(QPainter *pPainter,
+                                              const QwtSymbol &pSymbol,
+                                              const QwtScaleMap &pMapX,
+                                              const QwtScaleMap &pMapY,
+                                              const QRectF &pCanvasRect,
+                                              qint64 pFrom, qint64 pTo) const
+{
+    // Draw the symbols of our valid data between the given indexes
+
+    for (const auto &validData : mValidData) {
+        if ((pFrom <= validData.first) || (pTo >= validData.second)) {
+            qint64 from = (   (pFrom >= validData.first)
+                           && (pFrom <= validData.second))?
+                              pFrom:
+                              validData.first;
+            qint64 to = (   (pTo >= validData.first)
+                         && (pTo <= validData.second))?
+                            pTo:
+                            validData.second;
+
+            drawPoints(pPainter, &pSymbol, pMapX, pMapY,
+                       pCanvasRect, from, to);
+        }
+    }
+}
+
+//==============================================================================
+
+void GraphPanelPlotGraphRun::drawSeries(QPainter *pPainter,
+                                        const QwtScaleMap &pMapX,
+                                        const QwtScaleMap &pMapY,
+                                        const QRectF &pCanvasRect,
+                                        int pFrom, int pTo) const
+{
+    // Draw our series, letting Qwt do it if our size fits in an int
+    // Note: QwtPlotCurve::drawSeries() checks the given range against our size
+    //       cast to an int, so it would draw nothing (or worse) if we had more
+    //       than INT_MAX samples. In that case, we draw our lines and symbols
+    //       ourselves, knowing that we only ever use the Lines style...
+
+    if (mSize <= quint64(INT_MAX)) {
+        QwtPlotCurve::drawSeries(pPainter, pMapX, pMapY, pCanvasRect,
+                                 pFrom, pTo);
+
+        return;
+    }
+
+    qint64 from = qMax(pFrom, 0);
+    qint64 to = (pTo < 0)?qint64(mSize)-1:pTo;
+
+    if (style() == Lines) {
+        pPainter->save();
+        pPainter->setPen(pen());
+
+        drawValidLines(pPainter, pMapX, pMapY, pCanvasRect, from, to);
+
+        pPainter->restore();
+    }
+
+    if ((symbol() != nullptr) && (symbol()->style() != QwtSymbol::NoSymbol)) {
+        pPainter->save();
+
+        drawValidSymbols(pPainter, *symbol(), pMapX, pMapY, pCanvasRect,
+                         from, to);
+
+        pPainter->restore();
+    }
 }
 
 //==============================================================================
@@ -261,21 +849,7 @@ void GraphPanelPlotGraphRun::drawLines(QPainter *pPainter,
 {
     // Draw our lines
 
-    for (const auto &validData : mValidData) {
-        if ((pFrom <= validData.first) || (pTo >= validData.second)) {
-            int from = (   (pFrom >= validData.first)
-                        && (pFrom <= validData.second))?
-                           pFrom:
-                           validData.first;
-            int to = (   (pTo >= validData.first)
-                      && (pTo <= validData.second))?
-                         pTo:
-                         validData.second;
-
-            QwtPlotCurve::drawLines(pPainter, pMapX, pMapY,
-                                    pCanvasRect, from, to);
-        }
-    }
+    drawValidLines(pPainter, pMapX, pMapY, pCanvasRect, pFrom, pTo);
 }
 
 //==============================================================================
@@ -289,29 +863,12 @@ void GraphPanelPlotGraphRun::drawSymbols(QPainter *pPainter,
 {
     // Draw our symbols
 
-    for (const auto &validData : mValidData) {
-        if ((pFrom <= validData.first) || (pTo >= validData.second)) {
-            int from = (   (pFrom >= validData.first)
-                        && (pFrom <= validData.second))?
-                           pFrom:
-                           validData.first;
-            int to = (   (pTo >= validData.first)
-                      && (pTo <= validData.second))?
-                         pTo:
-                         validData.second;
-
-            QwtPlotCurve::drawSymbols(pPainter, pSymbol, pMapX, pMapY,
-                                      pCanvasRect, from, to);
-        }
-    }
+    drawValidSymbols(pPainter, pSymbol, pMapX, pMapY, pCanvasRect,
+                     pFrom, pTo);
 }
 
 //==============================================================================
 
-static const QRectF InvalidRect = QRectF(0.0, 0.0, -1.0, -1.0);
-
-//==============================================================================
-
 GraphPanelPlotGraph::GraphPanelPlotGraph(void *pParameterX, void *pParameterY,
                                          GraphPanelWidget *pOwner) :
     mParameterX(pParameterX),
@@ -447,13 +1004,17 @@ void GraphPanelPlotGraph::addRun()
 
 void GraphPanelPlotGraph::removeRuns()
 {
-    // Delete all our runs
+    // Delete all our runs and reset the cached version of our bounding
+    // rectangles
 
     for (auto run : qAsConst(mRuns)) {
         delete run;
     }
 
     mRuns.clear();
+
+    mBoundingRect = InvalidRect;
+    mBoundingLogRect = InvalidRect;
 }
 
 //==============================================================================
@@ -725,15 +1286,30 @@ void GraphPanelPlotGraph::setData(double *pDataX, double *pDataY, quint64 pSize,
         return;
     }
 
-    run->setRawSamples(pDataX, pDataY, int(pSize));
+    run->setRawSamples(pDataX, pDataY, pSize);
 
     // Reset the cached version of our bounding rectangles
 
     mBoundingRect = InvalidRect;
     mBoundingLogRect = InvalidRect;
+}
 
-    mBoundingRects.remove(run);
-    mBoundingLogRects.remove(run);
+//==============================================================================
+
+QRectF GraphPanelPlotGraph::dataRect(int pRun) const
+{
+    // Return the rectangle that contains the valid data of the given run, if
+    // it exists
+
+    if (mRuns.isEmpty()) {
+        return InvalidRect;
+    }
+
+    if (pRun == -1) {
+        return mRuns.last()->dataRect();
+    }
+
+    return ((pRun >= 0) && (pRun < mRuns.count()))?mRuns[pRun]->dataRect():InvalidRect;
 }
 
 //==============================================================================
@@ -742,73 +1318,17 @@ QRectF GraphPanelPlotGraph::boundingRect()
 {
     // Return the cached version of our bounding rectangle, if we have one, or
     // compute it and return it
+    // Note: our runs keep track of the rectangle that contains their valid
+    //       data as it gets set, so we only need to unite them...
 
     if ((mBoundingRect == InvalidRect) && !mRuns.isEmpty()) {
         mBoundingRect = QRectF();
 
         for (auto run : qAsConst(mRuns)) {
-            if (run->dataSize() != 0) {
-                QRectF boundingRect = mBoundingRects.value(run, InvalidRect);
-
-                if (boundingRect == InvalidRect) {
-                    bool needInitMinX = true;
-                    bool needInitMaxX = true;
-                    bool needInitMinY = true;
-                    bool needInitMaxY = true;
-                    double minX = 1.0;
-                    double maxX = 1.0;
-                    double minY = 1.0;
-                    double maxY = 1.0;
-
-                    for (size_t i = 0, iMax = run->dataSize(); i < iMax; ++i) {
-                        QPointF sample = run->data()->sample(i);
-
-                        if (   !qIsInf(sample.x()) && !qIsNaN(sample.x())
-                            && !qIsInf(sample.y()) && !qIsNaN(sample.y())) {
-                            if (needInitMinX) {
-                                minX = sample.x();
-
-                                needInitMinX = false;
-                            } else if (sample.x() < minX) {
-                                minX = sample.x();
-                            }
-
-                            if (needInitMaxX) {
-                                maxX = sample.x();
-
-                                needInitMaxX = false;
-                            } else if (sample.x() > maxX) {
-                                maxX = sample.x();
-                            }
-
-                            if (needInitMinY) {
-                                minY = sample.y();
-
-                                needInitMinY = false;
-                            } else if (sample.y() < minY) {
-                                minY = sample.y();
-                            }
-
-                            if (needInitMaxY) {
-                                maxY = sample.y();
-
-                                needInitMaxY = false;
-                            } else if (sample.y() > maxY) {
-                                maxY = sample.y();
-                            }
-                        }
-                    }
-
-                    if (!needInitMinX && !needInitMaxX && !needInitMinY && !needInitMaxY) {
-                        boundingRect = QRectF(minX, minY, maxX-minX, maxY-minY);
+            QRectF dataRect = run->dataRect();
 
-                        mBoundingRects.insert(run, boundingRect);
-                    }
-                }
-
-                if (boundingRect != InvalidRect) {
-                    mBoundingRect |= boundingRect;
-                }
+            if (dataRect != InvalidRect) {
+                mBoundingRect |= dataRect;
             }
         }
     }
@@ -827,70 +1347,10 @@ QRectF GraphPanelPlotGraph::boundingLogRect()
         mBoundingLogRect = QRectF();
 
         for (auto run : qAsConst(mRuns)) {
-            if (run->dataSize() != 0) {
-                QRectF boundingLogRect = mBoundingLogRects.value(run, InvalidRect);
-
-                if (boundingLogRect == InvalidRect) {
-                    bool needInitMinX = true;
-                    bool needInitMaxX = true;
-                    bool needInitMinY = true;
-                    bool needInitMaxY = true;
-                    double minX = 1.0;
-                    double maxX = 1.0;
-                    double minY = 1.0;
-                    double maxY = 1.0;
-
-                    for (size_t i = 0, iMax = run->dataSize(); i < iMax; ++i) {
-                        QPointF sample = run->data()->sample(i);
-
-                        if (   !qIsInf(sample.x()) && !qIsNaN(sample.x())
-                            &&  (sample.x() > 0.0)
-                            && !qIsInf(sample.y()) && !qIsNaN(sample.y())
-                            &&  (sample.y() > 0.0)) {
-                            if (needInitMinX) {
-                                minX = sample.x();
-
-                                needInitMinX = false;
-                            } else if (sample.x() < minX) {
-                                minX = sample.x();
-                            }
-
-                            if (needInitMaxX) {
-                                maxX = sample.x();
-
-                                needInitMaxX = false;
-                            } else if (sample.x() > maxX) {
-                                maxX = sample.x();
-                            }
-
-                            if (needInitMinY) {
-                                minY = sample.y();
-
-                                needInitMinY = false;
-                            } else if (sample.y() < minY) {
-                                minY = sample.y();
-                            }
-
-                            if (needInitMaxY) {
-                                maxY = sample.y();
-
-                                needInitMaxY = false;
-                            } else if (sample.y() > maxY) {
-                                maxY = sample.y();
-                            }
-                        }
-                    }
-
-                    if (!needInitMinX && !needInitMaxX && !needInitMinY && !needInitMaxY) {
-                        boundingLogRect = QRectF(minX, minY, maxX-minX, maxY-minY);
+            QRectF dataLogRect = run->dataLogRect();
 
-                        mBoundingLogRects.insert(run, boundingLogRect);
-                    }
-                }
-
-                if (boundingLogRect != InvalidRect) {
-                    mBoundingLogRect |= boundingLogRect;
-                }
+            if (dataLogRect != InvalidRect) {
+                mBoundingLogRect |= dataLogRect;
             }
         }
     }
@@ -3820,8 +4280,11 @@ bool GraphPanelPlotWidget::drawGraphFrom(GraphPanelPlotGraph *pGraph,
 {
     // Direct paint our graph from the given point unless we can't direct paint
     // (due to the axes having been changed), in which case we replot ourselves
+    // Note: QwtPlotDirectPainter::drawSeries() only accepts int indexes, so we
+    //       also replot ourselves if the given point is beyond INT_MAX, which
+    //       is cheap enough since our runs decimate their lines...
 
-    if (mCanDirectPaint) {
+    if (mCanDirectPaint && (pFrom <= quint64(INT_MAX))) {
         mDirectPainter->drawSeries(pGraph->lastRun(), int(pFrom), -1);
 
         return false;
@@ -36,12 +36,17 @@ along with this program. If not, see <https://gnu.org/licenses>.
     #include "qwt_plot_curve.h"
     #include "qwt_scale_draw.h"
     #include "qwt_scale_widget.h"
+    #include "qwt_series_data.h"
     #include "qwt_symbol.h"
     #include "qwt_text.h"
 #include "qwtend.h"
 
 //==============================================================================
 
+#include <vector>
+
+//==============================================================================
+
 class QMenu;
 
 //==============================================================================
@@ -136,6 +141,28 @@ class GraphPanelPlotGraph;
 
 //==============================================================================
 
+class GraphPanelPlotGraphRunData : public QwtSeriesData<QPointF>
+{
+public:
+    explicit GraphPanelPlotGraphRunData(const double *pDataX,
+                                        const double *pDataY, quint64 pSize,
+                                        const QRectF &pBoundingRect);
+
+    size_t size() const override;
+    QPointF sample(size_t pIndex) const override;
+    QRectF boundingRect() const override;
+
+private:
+    const double *mDataX;
+    const double *mDataY;
+
+    quint64 mSize;
+
+    QRectF mBoundingRect;
+};
+
+//==============================================================================
+
 class GraphPanelPlotGraphRun : public QwtPlotCurve
 {
 public:
@@ -143,9 +170,16 @@ public:
 
     GraphPanelPlotGraph * owner() const;
 
-    void setRawSamples(const double *pDataX, const double *pDataY, int pSize);
+    void setRawSamples(const double *pDataX, const double *pDataY,
+                       quint64 pSize);
+
+    QRectF dataRect() const;
+    QRectF dataLogRect() const;
 
 protected:
+    void drawSeries(QPainter *pPainter, const QwtScaleMap &pMapX,
+                    const QwtScaleMap &pMapY, const QRectF &pCanvasRect,
+                    int pFrom, int pTo) const override;
     void drawLines(QPainter *pPainter, const QwtScaleMap &pMapX,
                    const QwtScaleMap &pMapY, const QRectF &pCanvasRect,
                    int pFrom, int pTo) const override;
@@ -154,10 +188,49 @@ protected:
                      const QRectF &pCanvasRect, int pFrom, int pTo) const override;
 
 private:
+    using Extrema = QPair<qint64, qint64>;
+    using BlockExtrema = std::pair<quint32, quint32>;
+
     GraphPanelPlotGraph *mOwner;
 
-    int mSize = 0;
-    QList<QPair<int, int>> mValidData;
+    const double *mDataX = nullptr;
+    const double *mDataY = nullptr;
+
+    quint64 mSize = 0;
+    QList<QPair<qint64, qint64>> mValidData;
+
+    bool mMonotonic = true;
+    double mLastX = 0.0;
+    bool mHasLastX = false;
+
+    QRectF mDataRect;
+    QRectF mDataLogRect;
+
+    std::vector<std::vector<BlockExtrema>> mExtrema;
+
+    Extrema pointExtrema(qint64 pIndex) const;
+    Extrema blockExtrema(int pLevel, qint64 pIndex) const;
+    void mergeExtrema(Extrema &pExtrema, const Extrema &pOtherExtrema) const;
+    void mergeExtrema(Extrema &pExtrema, int pLevel, qint64 pFrom,
+                      qint64 pTo) const;
+    void updateExtrema();
+    Extrema extrema(qint64 pFrom, qint64 pTo) const;
+
+    void drawValidLines(QPainter *pPainter, const QwtScaleMap &pMapX,
+                        const QwtScaleMap &pMapY, const QRectF &pCanvasRect,
+                        qint64 pFrom, qint64 pTo) const;
+    void drawValidSymbols(QPainter *pPainter, const QwtSymbol &pSymbol,
+                          const QwtScaleMap &pMapX, const QwtScaleMap &pMapY,
+                          const QRectF &pCanvasRect, qint64 pFrom,
+                          qint64 pTo) const;
+    void drawDecimatedLines(QPainter *pPainter, const QwtScaleMap &pMapX,
+                            const QwtScaleMap &pMapY,
+                            const QRectF &pCanvasRect, qint64 pFrom,
+                            qint64 pTo) const;
+    void drawPoints(QPainter *pPainter, const QwtSymbol *pSymbol,
+                    const QwtScaleMap &pMapX, const QwtScaleMap &pMapY,
+                    const QRectF &pCanvasRect, qint64 pFrom,
+                    qint64 pTo) const;
 };
 
 //==============================================================================
@@ -224,6 +297,8 @@ public:
     QwtSeriesData<QPointF> *data(int pRun = -1) const;
     void setData(double *pDataX, double *pDataY, quint64 pSize, int pRun = -1);
 
+    QRectF dataRect(int pRun = -1) const;
+
     QRectF boundingRect();
     QRectF boundingLogRect();
 
@@ -238,10 +313,7 @@ private:
     QColor mColor;
 
     QRectF mBoundingRect;
-    QHash<GraphPanelPlotGraphRun *, QRectF> mBoundingRects;
-
     QRectF mBoundingLogRect;
-    QHash<GraphPanelPlotGraphRun *, QRectF> mBoundingLogRects;
 
     GraphPanelPlotWidget *mPlot = nullptr;
 